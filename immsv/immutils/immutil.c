@@ -29,36 +29,115 @@
 #include <stdarg.h>
 #include <syslog.h>
 #include <errno.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <time.h>
 
 #include "saAis.h"
 #include "logtrace.h"
 #include "osaf_extended_name.h"
 
+extern struct ImmutilWrapperProfile immutilWrapperProfile;
 static const SaVersionT immVersion = {'A', 2, 11};
 
 /* Memory handling functions */
-#define CHUNK 4000
-static struct Chunk *newChunk(struct Chunk *next, size_t size);
-static void *clistMalloc(struct Chunk *clist, size_t size);
-static void deleteClist(struct Chunk *clist);
+struct Arena;
+static struct Arena *arenaCreate(void);
+static void *arenaMalloc(struct Arena *arena, size_t size);
+static void arenaDelete(struct Arena *arena);
 
 /* SA-item duplicate functions */
-static const SaNameT *dupSaNameT(struct Chunk *clist, const SaNameT *original);
-static SaImmClassNameT dupSaImmClassNameT(struct Chunk *clist,
+static const SaNameT *dupSaNameT(struct Arena *arena, const SaNameT *original);
+static SaImmClassNameT dupSaImmClassNameT(struct Arena *arena,
 					  const SaImmClassNameT original);
 static const SaImmAttrValuesT_2 **
-dupSaImmAttrValuesT_array(struct Chunk *clist,
+dupSaImmAttrValuesT_array(struct Arena *arena,
 			  const SaImmAttrValuesT_2 **original);
 static const SaImmAttrModificationT_2 **
-dupSaImmAttrModificationT_array(struct Chunk *clist,
+dupSaImmAttrModificationT_array(struct Arena *arena,
 				const SaImmAttrModificationT_2 **original);
-static char *dupStr(struct Chunk *clist, const char *original);
+static char *dupStr(struct Arena *arena, const char *original);
+static size_t valueTypeSize(SaImmValueTypeT valueType);
+static void copyValue(struct Arena *arena, SaImmValueTypeT valueType,
+		      void *dest, const void *original);
+
+/* Modify coalescing and flat operation serialization */
+struct OperationPriv;
+static void coalesceModify(struct CcbUtilCcbData *ccb,
+			   struct OperationPriv *opp, const char *objectName,
+			   const SaImmAttrModificationT_2 **attrMods);
+static void captureOperation(struct CcbUtilCcbData *ccb,
+			     struct CcbUtilOperationData *op,
+			     const char *objectName, const char *className,
+			     const SaNameT *parentName,
+			     const SaImmAttrValuesT_2 **attrValues,
+			     const SaImmAttrModificationT_2 **attrMods);
+
+/* The retry loop of the wrappers, also used by the internal IMM calls */
+static SaAisErrorT retryStart(struct ImmutilRetry *retry,
+			      enum ImmutilOperation operation);
 
 static void defaultImmutilError(char const *fmt, ...)
     __attribute__((format(printf, 1, 2)));
 
 ImmutilErrorFnT immutilError = defaultImmutilError;
-static struct CcbUtilCcbData *ccbList = NULL;
+
+/* CCB registry; the CCBs are spread over CCB_SHARDS shards, each an
+   open-addressed hash table (linear probing) keyed by ccbId and protected by
+   its own mutex. The table size is always a power of two and the load factor
+   is kept below 1/2. */
+#define CCB_SHARDS 16
+#define CCB_TABLE_MIN_SIZE 16
+struct CcbShard {
+	pthread_mutex_t lock;
+	struct CcbUtilCcbData **table;
+	size_t size;
+	size_t count;
+};
+static struct CcbShard ccbShards[CCB_SHARDS] = {
+    [0 ... CCB_SHARDS - 1] = {.lock = PTHREAD_MUTEX_INITIALIZER}};
+static size_t ccbCount = 0; /* Total over all shards, atomic */
+
+/* Per-CCB index from object DN to the operations on that object. Each entry
+   refers to the first and last operation on a DN, the operations in between
+   are chained through OperationPriv.nextSameDn in list order. Creates added
+   without an object name are indexed on the DN made from the parent and the
+   RDN attribute, or on "" if there is no RDN attribute, see createDn(). */
+#define DN_INDEX_MIN_SIZE 16
+struct DnIndexEntry {
+	SaUint64T hash;
+	const char *dn;
+	struct OperationPriv *first;
+	struct OperationPriv *last;
+};
+
+/* Private part of a CCB object. The public part must be the first member. */
+struct CcbPriv {
+	struct CcbUtilCcbData ccb;
+	pthread_mutex_t lock; /* Protects the arena and the operation list */
+	struct DnIndexEntry *dnIndex;
+	size_t dnIndexSize;
+	size_t dnIndexCount;
+	SaUint64T nOps; /* Operations linked so far */
+};
+
+/* Private part of an operation. The public part must be the first member. */
+struct OperationPriv {
+	struct CcbUtilOperationData op;
+	struct OperationPriv *nextSameDn;
+	SaUint64T seq;	    /* Position in the operation list */
+	const void *packed; /* Set in capture mode */
+	size_t packedSize;
+	struct NetModify *net; /* Set for coalesced modify operations */
+	bool dropped;	       /* Folded away by journal compaction */
+};
+
+static bool captureMode = false;
+static bool coalesceMode = false;
 
 /**
  * Report to stderr and syslog and abort process
@@ -78,32 +157,145 @@ static void defaultImmutilError(char const *fmt, ...)
 	abort();
 }
 
+static size_t ccbHash(SaImmOiCcbIdT ccbId)
+{
+	/* 64-bit finalizer from MurmurHash3, ccbIds are often sequential */
+	SaUint64T h = ccbId;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return (size_t)h;
+}
+
+static struct CcbShard *ccbShard(SaImmOiCcbIdT ccbId)
+{
+	/* The slot index within a shard uses the low bits of the hash */
+	return &ccbShards[ccbHash(ccbId) >> (8 * sizeof(size_t) - 4)];
+}
+
+/**
+ * Return the index of the slot holding the CCB with the passed id, or of the
+ * empty slot terminating the probe sequence if there is no such CCB.
+ */
+static size_t ccbTableProbe(struct CcbShard *shard, SaImmOiCcbIdT ccbId)
+{
+	size_t mask = shard->size - 1;
+	size_t i = ccbHash(ccbId) & mask;
+	while (shard->table[i] != NULL && shard->table[i]->ccbId != ccbId)
+		i = (i + 1) & mask;
+	return i;
+}
+
+static void ccbTableResize(struct CcbShard *shard, size_t size)
+{
+	struct CcbUtilCcbData **old = shard->table;
+	size_t i, oldSize = shard->size;
+
+	shard->table = calloc(size, sizeof(struct CcbUtilCcbData *));
+	if (shard->table == NULL)
+		immutilError("Out of memory");
+	shard->size = size;
+	for (i = 0; i < oldSize; i++) {
+		if (old[i] != NULL)
+			shard->table[ccbTableProbe(shard, old[i]->ccbId)] =
+			    old[i];
+	}
+	free(old);
+}
+
+static void ccbTableInsert(struct CcbShard *shard, struct CcbUtilCcbData *ccb)
+{
+	if (2 * (shard->count + 1) > shard->size)
+		ccbTableResize(shard, shard->size == 0 ? CCB_TABLE_MIN_SIZE
+						       : 2 * shard->size);
+	shard->table[ccbTableProbe(shard, ccb->ccbId)] = ccb;
+	shard->count++;
+	__atomic_add_fetch(&ccbCount, 1, __ATOMIC_RELAXED);
+}
+
+/* Backward-shift deletion, keeps probe sequences intact without tombstones */
+static void ccbTableRemove(struct CcbShard *shard, size_t i)
+{
+	struct CcbUtilCcbData **table = shard->table;
+	size_t mask = shard->size - 1;
+	size_t j = i;
+
+	for (;;) {
+		size_t home;
+		j = (j + 1) & mask;
+		if (table[j] == NULL)
+			break;
+		home = ccbHash(table[j]->ccbId) & mask;
+		/* Move entry j to the hole at i unless its home slot lies
+		   cyclically in (i, j] */
+		if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+		table[i] = table[j];
+		i = j;
+	}
+	table[i] = NULL;
+	shard->count--;
+	__atomic_sub_fetch(&ccbCount, 1, __ATOMIC_RELAXED);
+}
+
+static struct CcbUtilCcbData *ccbTableFind(struct CcbShard *shard,
+					   SaImmOiCcbIdT ccbId)
+{
+	if (shard->count == 0)
+		return NULL;
+	return shard->table[ccbTableProbe(shard, ccbId)];
+}
+
+static void ccbLock(struct CcbUtilCcbData *ccb)
+{
+	if (pthread_mutex_lock(&((struct CcbPriv *)ccb)->lock) != 0)
+		immutilError("pthread_mutex_lock FAILED");
+}
+
+static void ccbUnlock(struct CcbUtilCcbData *ccb)
+{
+	if (pthread_mutex_unlock(&((struct CcbPriv *)ccb)->lock) != 0)
+		immutilError("pthread_mutex_unlock FAILED");
+}
+
+static void shardLock(struct CcbShard *shard)
+{
+	if (pthread_mutex_lock(&shard->lock) != 0)
+		immutilError("pthread_mutex_lock FAILED");
+}
+
+static void shardUnlock(struct CcbShard *shard)
+{
+	if (pthread_mutex_unlock(&shard->lock) != 0)
+		immutilError("pthread_mutex_unlock FAILED");
+}
+
 static struct CcbUtilCcbData *ccbutil_createCcbData(SaImmOiCcbIdT ccbId)
 {
-	struct Chunk *clist = newChunk(NULL, CHUNK);
-	struct CcbUtilCcbData *obj = (struct CcbUtilCcbData *)clistMalloc(
-	    clist, sizeof(struct CcbUtilCcbData));
+	struct Arena *arena = arenaCreate();
+	struct CcbUtilCcbData *obj = (struct CcbUtilCcbData *)arenaMalloc(
+	    arena, sizeof(struct CcbPriv));
 	obj->ccbId = ccbId;
-	obj->memref = clist;
-	obj->next = ccbList;
-	ccbList = obj;
+	obj->memref = arena;
+	pthread_mutex_init(&((struct CcbPriv *)obj)->lock, NULL);
 	return obj;
 }
 
 struct CcbUtilCcbData *ccbutil_findCcbData(SaImmOiCcbIdT ccbId)
 {
-	struct CcbUtilCcbData *ccbitem = ccbList;
-	while (ccbitem != NULL) {
-		if (ccbitem->ccbId == ccbId)
-			return ccbitem;
-		ccbitem = ccbitem->next;
-	}
-	return NULL;
+	struct CcbShard *shard = ccbShard(ccbId);
+	struct CcbUtilCcbData *ccbitem;
+	shardLock(shard);
+	ccbitem = ccbTableFind(shard, ccbId);
+	shardUnlock(shard);
+	return ccbitem;
 }
 
 bool ccbutil_EmptyCcbExists()
 {
-	if (ccbList == NULL) {
+	if (__atomic_load_n(&ccbCount, __ATOMIC_RELAXED) == 0) {
 		return true;
 	}
 	return false;
@@ -111,75 +303,269 @@ bool ccbutil_EmptyCcbExists()
 
 struct CcbUtilCcbData *ccbutil_getCcbData(SaImmOiCcbIdT ccbId)
 {
-	struct CcbUtilCcbData *ccbitem = ccbutil_findCcbData(ccbId);
-	if (ccbitem == NULL)
+	struct CcbShard *shard = ccbShard(ccbId);
+	struct CcbUtilCcbData *ccbitem;
+	shardLock(shard);
+	ccbitem = ccbTableFind(shard, ccbId);
+	if (ccbitem == NULL) {
 		ccbitem = ccbutil_createCcbData(ccbId);
+		ccbTableInsert(shard, ccbitem);
+	}
+	shardUnlock(shard);
 	return ccbitem;
 }
 
 void ccbutil_deleteCcbData(struct CcbUtilCcbData *ccb)
 {
-	struct CcbUtilCcbData *item = ccbList;
-	struct CcbUtilCcbData *prev = NULL;
+	struct CcbShard *shard;
 	struct CcbUtilOperationData *op;
+	size_t i;
 	if (ccb == NULL)
 		return;
-	while (item != NULL) {
-		if (ccb->ccbId == item->ccbId) {
-			if (prev == NULL) {
-				ccbList = item->next;
-			} else {
-				prev->next = item->next;
-			}
+	shard = ccbShard(ccb->ccbId);
+	shardLock(shard);
+	if (shard->count > 0) {
+		i = ccbTableProbe(shard, ccb->ccbId);
+		if (shard->table[i] == ccb)
+			ccbTableRemove(shard, i);
+	}
+	shardUnlock(shard);
+	for (op = ccb->operationListHead; op != NULL; op = op->next)
+		osaf_extended_name_free(&op->objectName);
+	free(((struct CcbPriv *)ccb)->dnIndex);
+	pthread_mutex_destroy(&((struct CcbPriv *)ccb)->lock);
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	arenaDelete(arena);
+}
 
-			op = item->operationListHead;
-			while (op) {
-				osaf_extended_name_free(&op->objectName);
-				op = op->next;
-				if (op == item->operationListTail)
-					break;
-			}
+static SaUint64T hashStr(const char *str)
+{
+	/* FNV-1a */
+	SaUint64T h = 0xcbf29ce484222325ULL;
+	while (*str != 0) {
+		h ^= (unsigned char)*str++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static struct DnIndexEntry *dnIndexProbe(struct CcbPriv *priv, const char *dn,
+					 SaUint64T hash)
+{
+	size_t mask = priv->dnIndexSize - 1;
+	size_t i = (size_t)hash & mask;
+	struct DnIndexEntry *entry;
+	for (;;) {
+		entry = &priv->dnIndex[i];
+		if (entry->dn == NULL ||
+		    (entry->hash == hash && strcmp(entry->dn, dn) == 0))
+			return entry;
+		i = (i + 1) & mask;
+	}
+}
+
+static void dnIndexResize(struct CcbPriv *priv, size_t size)
+{
+	struct DnIndexEntry *old = priv->dnIndex;
+	size_t i, oldSize = priv->dnIndexSize;
+
+	priv->dnIndex = calloc(size, sizeof(struct DnIndexEntry));
+	if (priv->dnIndex == NULL)
+		immutilError("Out of memory");
+	priv->dnIndexSize = size;
+	for (i = 0; i < oldSize; i++) {
+		if (old[i].dn != NULL)
+			*dnIndexProbe(priv, old[i].dn, old[i].hash) = old[i];
+	}
+	free(old);
+}
+
+/**
+ * Find the index entry for a DN.
+ * @return The entry or NULL if there is no operation on the DN in the CCB
+ */
+static struct DnIndexEntry *dnIndexFind(struct CcbUtilCcbData *ccb,
+					const char *dn)
+{
+	struct CcbPriv *priv = (struct CcbPriv *)ccb;
+	struct DnIndexEntry *entry;
+	if (priv->dnIndexCount == 0)
+		return NULL;
+	entry = dnIndexProbe(priv, dn, hashStr(dn));
+	return entry->dn != NULL ? entry : NULL;
+}
+
+/* Index an operation on dn, which must live as long as the operation */
+static void dnIndexAdd(struct CcbUtilCcbData *ccb, struct OperationPriv *opp,
+		       const char *dn)
+{
+	struct CcbPriv *priv = (struct CcbPriv *)ccb;
+	SaUint64T hash = hashStr(dn);
+	struct DnIndexEntry *entry;
+	struct OperationPriv **pp;
+
+	if (2 * (priv->dnIndexCount + 1) > priv->dnIndexSize)
+		dnIndexResize(priv, priv->dnIndexSize == 0
+					? DN_INDEX_MIN_SIZE
+					: 2 * priv->dnIndexSize);
+	entry = dnIndexProbe(priv, dn, hash);
+	if (entry->dn == NULL) {
+		entry->hash = hash;
+		entry->dn = dn;
+		entry->first = opp;
+		entry->last = opp;
+		priv->dnIndexCount++;
+	} else if (entry->first == NULL) {
+		entry->last = opp;
+		__atomic_store_n(&entry->first, opp, __ATOMIC_RELEASE);
+	} else if (entry->last->seq < opp->seq) {
+		__atomic_store_n(&entry->last->nextSameDn, opp,
+				 __ATOMIC_RELEASE);
+		entry->last = opp;
+	} else {
+		/* An operation claimed by dnIndexClaim(), keep list order */
+		for (pp = &entry->first; (*pp)->seq < opp->seq;
+		     pp = &(*pp)->nextSameDn)
+			;
+		opp->nextSameDn = *pp;
+		__atomic_store_n(pp, opp, __ATOMIC_RELEASE);
+	}
+}
+
+/**
+ * Move the operations indexed on "" whose object name the user has set to dn
+ * since they were added to the entry for dn. Must be called with the CCB lock
+ * held.
+ */
+static void dnIndexClaim(struct CcbUtilCcbData *ccb, const char *dn)
+{
+	struct DnIndexEntry *unnamed = dnIndexFind(ccb, "");
+	struct OperationPriv **pp, *opp, *prev = NULL;
+
+	if (unnamed == NULL)
+		return;
+	for (pp = &unnamed->first; (opp = *pp) != NULL;) {
+		const char *name = saAisNameBorrow(&opp->op.objectName);
+		if (strcmp(name, dn) != 0) {
+			prev = opp;
+			pp = &opp->nextSameDn;
+			continue;
 		}
-		prev = item;
-		item = item->next;
+		__atomic_store_n(pp, opp->nextSameDn, __ATOMIC_RELEASE);
+		if (unnamed->last == opp)
+			unnamed->last = prev;
+		opp->nextSameDn = NULL;
+		dnIndexAdd(ccb, opp, name);
+	}
+}
+
+/**
+ * Make the DN of an object created under parentName from its RDN attribute,
+ * the single SaStringT or SaNameT value that starts with the attribute name
+ * and '=', e.g. safComp="safComp=comp1".
+ * @return The DN in the arena, or NULL if there is no such attribute
+ */
+static const char *createDn(struct Arena *arena, const SaNameT *parentName,
+			    const SaImmAttrValuesT_2 **attrValues)
+{
+	const char *parent = parentName != NULL ? saAisNameBorrow(parentName)
+						: "";
+	size_t rdnLen, parentLen = strlen(parent);
+	const char *rdn = NULL;
+	char *dn;
+
+	for (; attrValues != NULL && *attrValues != NULL && rdn == NULL;
+	     attrValues++) {
+		const SaImmAttrValuesT_2 *attr = *attrValues;
+		const char *value;
+		size_t nameLen = strlen(attr->attrName);
+		if (attr->attrValuesNumber != 1)
+			continue;
+		if (attr->attrValueType == SA_IMM_ATTR_SASTRINGT)
+			value = *(SaStringT *)attr->attrValues[0];
+		else if (attr->attrValueType == SA_IMM_ATTR_SANAMET)
+			value = saAisNameBorrow(attr->attrValues[0]);
+		else
+			continue;
+		if (value != NULL &&
+		    strncmp(value, attr->attrName, nameLen) == 0 &&
+		    value[nameLen] == '=')
+			rdn = value;
+	}
+	if (rdn == NULL)
+		return NULL;
+	rdnLen = strlen(rdn);
+	dn = arenaMalloc(arena, rdnLen + parentLen + 2);
+	memcpy(dn, rdn, rdnLen);
+	if (parentLen > 0) {
+		dn[rdnLen++] = ',';
+		memcpy(dn + rdnLen, parent, parentLen);
 	}
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
-	deleteClist(clist);
+	dn[rdnLen + parentLen] = '\0';
+	return dn;
 }
 
 static struct CcbUtilOperationData *
 newOperationData(struct CcbUtilCcbData *ccb, enum CcbUtilOperationType type)
 {
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
+	struct Arena *arena = (struct Arena *)ccb->memref;
 	struct CcbUtilOperationData *operation =
-	    (struct CcbUtilOperationData *)clistMalloc(
-		clist, sizeof(struct CcbUtilOperationData));
+	    (struct CcbUtilOperationData *)arenaMalloc(
+		arena, sizeof(struct OperationPriv));
 	operation->operationType = type;
+	operation->ccbId = ccb->ccbId;
+	return operation;
+}
+
+/**
+ * Append an operation to the CCB and index it on dn, which must live as long
+ * as the operation. Must be called with the CCB lock held. The links are
+ * published with release semantics so that lock-free readers of the list see
+ * complete operations.
+ */
+static void linkOperationData(struct CcbUtilCcbData *ccb,
+			      struct CcbUtilOperationData *operation,
+			      const char *dn)
+{
+	((struct OperationPriv *)operation)->seq =
+	    ((struct CcbPriv *)ccb)->nOps++;
 	if (ccb->operationListTail == NULL) {
 		ccb->operationListTail = operation;
-		ccb->operationListHead = operation;
+		__atomic_store_n(&ccb->operationListHead, operation,
+				 __ATOMIC_RELEASE);
 	} else {
-		ccb->operationListTail->next = operation;
+		__atomic_store_n(&ccb->operationListTail->next, operation,
+				 __ATOMIC_RELEASE);
 		ccb->operationListTail = operation;
 	}
-
-	operation->ccbId = ccb->ccbId;
-	return operation;
+	dnIndexAdd(ccb, (struct OperationPriv *)operation, dn);
 }
 
 CcbUtilOperationData_t *ccbutil_ccbAddCreateOperation(
     struct CcbUtilCcbData *ccb, const SaImmClassNameT className,
     const SaNameT *parentName, const SaImmAttrValuesT_2 **attrValues)
 {
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
-	struct CcbUtilOperationData *operation =
-	    newOperationData(ccb, CCBUTIL_CREATE);
-	operation->param.create.className =
-	    dupSaImmClassNameT(clist, className);
-	operation->param.create.parentName = dupSaNameT(clist, parentName);
-	operation->param.create.attrValues =
-	    dupSaImmAttrValuesT_array(clist, attrValues);
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	struct CcbUtilOperationData *operation;
+	const char *dn;
+
+	ccbLock(ccb);
+	operation = newOperationData(ccb, CCBUTIL_CREATE);
+	if (__atomic_load_n(&captureMode, __ATOMIC_RELAXED)) {
+		captureOperation(ccb, operation, "", className, parentName,
+				 attrValues, NULL);
+	} else {
+		operation->param.create.className =
+		    dupSaImmClassNameT(arena, className);
+		operation->param.create.parentName =
+		    dupSaNameT(arena, parentName);
+		operation->param.create.attrValues =
+		    dupSaImmAttrValuesT_array(arena, attrValues);
+	}
+	dn = createDn(arena, parentName, attrValues);
 	saAisNameLend("", &operation->objectName);
+	linkOperationData(ccb, operation, dn != NULL ? dn : "");
+	ccbUnlock(ccb);
 	return operation;
 }
 
@@ -190,20 +576,30 @@ CcbUtilOperationData_t *ccbutil_ccbAddCreateOperation_2(
 {
 	const char *str;
 	size_t len;
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
-	struct CcbUtilOperationData *operation =
-	    newOperationData(ccb, CCBUTIL_CREATE);
-	operation->param.create.className =
-	    dupSaImmClassNameT(clist, className);
-	operation->param.create.parentName = dupSaNameT(clist, parentName);
-	operation->param.create.attrValues =
-	    dupSaImmAttrValuesT_array(clist, attrValues);
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	struct CcbUtilOperationData *operation;
 
 	str = saAisNameBorrow(objectName);
 	assert(str != NULL);
+	ccbLock(ccb);
+	operation = newOperationData(ccb, CCBUTIL_CREATE);
+	if (__atomic_load_n(&captureMode, __ATOMIC_RELAXED)) {
+		captureOperation(ccb, operation, str, className, parentName,
+				 attrValues, NULL);
+	} else {
+		operation->param.create.className =
+		    dupSaImmClassNameT(arena, className);
+		operation->param.create.parentName =
+		    dupSaNameT(arena, parentName);
+		operation->param.create.attrValues =
+		    dupSaImmAttrValuesT_array(arena, attrValues);
+	}
 	len = strlen(str);
 	saAisNameLend(len < SA_MAX_UNEXTENDED_NAME_LENGTH ? str : strdup(str),
 		      &operation->objectName);
+	linkOperationData(ccb, operation,
+			  saAisNameBorrow(&operation->objectName));
+	ccbUnlock(ccb);
 
 	return operation;
 }
@@ -213,16 +609,24 @@ void ccbutil_ccbAddDeleteOperation(struct CcbUtilCcbData *ccb,
 {
 	const char *str;
 	size_t len;
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
-	struct CcbUtilOperationData *operation =
-	    newOperationData(ccb, CCBUTIL_DELETE);
-	operation->param.delete_.objectName = dupSaNameT(clist, objectName);
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	struct CcbUtilOperationData *operation;
 
 	str = saAisNameBorrow(objectName);
 	assert(str != NULL);
+	ccbLock(ccb);
+	operation = newOperationData(ccb, CCBUTIL_DELETE);
+	if (__atomic_load_n(&captureMode, __ATOMIC_RELAXED))
+		captureOperation(ccb, operation, str, NULL, NULL, NULL, NULL);
+	else
+		operation->param.delete_.objectName =
+		    dupSaNameT(arena, objectName);
 	len = strlen(str);
 	saAisNameLend(len < SA_MAX_UNEXTENDED_NAME_LENGTH ? str : strdup(str),
 		      &operation->objectName);
+	linkOperationData(ccb, operation,
+			  saAisNameBorrow(&operation->objectName));
+	ccbUnlock(ccb);
 }
 
 int ccbutil_ccbAddModifyOperation(struct CcbUtilCcbData *ccb,
@@ -231,23 +635,41 @@ int ccbutil_ccbAddModifyOperation(struct CcbUtilCcbData *ccb,
 {
 	const char *str;
 	size_t len;
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
+	struct Arena *arena = (struct Arena *)ccb->memref;
 	struct CcbUtilOperationData *operation;
 
 	///* Do not allow multiple operations on object in same CCB */
 	//	if (ccbutil_getCcbOpDataByDN(ccb->ccbId, objectName) != NULL)
 	//		return -1;
 
-	operation = newOperationData(ccb, CCBUTIL_MODIFY);
-	operation->param.modify.objectName = dupSaNameT(clist, objectName);
-	operation->param.modify.attrMods =
-	    dupSaImmAttrModificationT_array(clist, attrMods);
-
 	str = saAisNameBorrow(objectName);
 	assert(str != NULL);
+	ccbLock(ccb);
+	if (__atomic_load_n(&coalesceMode, __ATOMIC_RELAXED)) {
+		struct DnIndexEntry *entry = dnIndexFind(ccb, str);
+		if (entry != NULL &&
+		    entry->last->op.operationType == CCBUTIL_MODIFY) {
+			coalesceModify(ccb, entry->last, str, attrMods);
+			ccbUnlock(ccb);
+			return 0;
+		}
+	}
+	operation = newOperationData(ccb, CCBUTIL_MODIFY);
+	if (__atomic_load_n(&captureMode, __ATOMIC_RELAXED)) {
+		captureOperation(ccb, operation, str, NULL, NULL, NULL,
+				 attrMods);
+	} else {
+		operation->param.modify.objectName =
+		    dupSaNameT(arena, objectName);
+		operation->param.modify.attrMods =
+		    dupSaImmAttrModificationT_array(arena, attrMods);
+	}
 	len = strlen(str);
 	saAisNameLend(len < SA_MAX_UNEXTENDED_NAME_LENGTH ? str : strdup(str),
 		      &operation->objectName);
+	linkOperationData(ccb, operation,
+			  saAisNameBorrow(&operation->objectName));
+	ccbUnlock(ccb);
 
 	return 0;
 }
@@ -257,26 +679,35 @@ CcbUtilOperationData_t *ccbutil_getNextCcbOp(SaImmOiCcbIdT ccbId,
 {
 	if (opData == NULL) {
 		CcbUtilCcbData_t *ccb = ccbutil_getCcbData(ccbId);
-		return ccb->operationListHead;
+		return __atomic_load_n(&ccb->operationListHead,
+				       __ATOMIC_ACQUIRE);
 	} else
-		return opData->next;
+		return __atomic_load_n(&opData->next, __ATOMIC_ACQUIRE);
 }
 
 CcbUtilOperationData_t *ccbutil_getCcbOpDataByDN(SaImmOiCcbIdT ccbId,
 						 const SaNameT *dn)
 {
-	CcbUtilOperationData_t *opData = ccbutil_getNextCcbOp(ccbId, NULL);
+	CcbUtilCcbData_t *ccb = ccbutil_getCcbData(ccbId);
 	const char *dnStr = saAisNameBorrow(dn);
+	struct DnIndexEntry *entry;
+	struct CcbUtilOperationData *op;
 	assert(dnStr != NULL);
 
-	while (opData != NULL) {
-		if (strcmp(dnStr, saAisNameBorrow(&opData->objectName)) == 0)
-			break;
-
-		opData = ccbutil_getNextCcbOp(ccbId, opData);
-	}
+	ccbLock(ccb);
+	if (dnStr[0] != '\0')
+		dnIndexClaim(ccb, dnStr);
+	entry = dnIndexFind(ccb, dnStr);
+	op = entry != NULL && entry->first != NULL ? &entry->first->op : NULL;
+	ccbUnlock(ccb);
+	return op;
+}
 
-	return opData;
+CcbUtilOperationData_t *ccbutil_getNextCcbOpByDN(CcbUtilOperationData_t *opData)
+{
+	struct OperationPriv *next = __atomic_load_n(
+	    &((struct OperationPriv *)opData)->nextSameDn, __ATOMIC_ACQUIRE);
+	return next != NULL ? &next->op : NULL;
 }
 
 /* ----------------------------------------------------------------------
@@ -285,294 +716,686 @@ CcbUtilOperationData_t *ccbutil_getCcbOpDataByDN(SaImmOiCcbIdT ccbId,
 
 char *immutil_strdup(struct CcbUtilCcbData *ccb, char const *source)
 {
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
-	return dupStr(clist, source);
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	char *copy;
+	ccbLock(ccb);
+	copy = dupStr(arena, source);
+	ccbUnlock(ccb);
+	return copy;
 }
 
-char const *immutil_getClassName(struct CcbUtilCcbData *ccb,
-				 SaImmHandleT immHandle,
-				 const SaNameT *objectName)
-{
-	struct Chunk *clist = (struct Chunk *)ccb->memref;
-	SaImmAccessorHandleT accessorHandle;
-	SaImmAttrValuesT_2 **attributes;
-	SaImmAttrValuesT_2 *cnameattr;
-	SaImmAttrNameT classNameAttr[2] = {SA_IMM_ATTR_CLASS_NAME, NULL};
-	char *cname = NULL;
-
-	if (objectName == NULL)
-		return NULL;
-	if (immutil_saImmOmAccessorInitialize(immHandle, &accessorHandle) !=
-	    SA_AIS_OK)
-		return NULL;
+/*
+ * OM handle pool. An entry is an accessor on either an OM handle owned by
+ * the pool or one passed by the caller; the latter are matched on the handle.
+ * At most OM_POOL_SIZE idle owned entries and OM_POOL_CALLER_SIZE entries
+ * on caller handles are kept, the oldest of the latter is finalized to make
+ * room as the caller may have finalized its handle. An entry that gets
+ * SA_AIS_ERR_BAD_HANDLE, e.g. after a controller failover, is finalized
+ * together with all idle owned entries, they are set up again on demand.
+ */
 
-	if (immutil_saImmOmAccessorGet_2(accessorHandle, objectName,
-					 classNameAttr,
-					 &attributes) != SA_AIS_OK)
-		goto finalize;
-	if (attributes == NULL || *attributes == NULL)
-		goto finalize;
+#define OM_POOL_SIZE 16
+#define OM_POOL_CALLER_SIZE 8
 
-	cnameattr = *attributes;
-	if (strcmp(cnameattr->attrName, SA_IMM_ATTR_CLASS_NAME) != 0)
-		goto finalize;
-	assert(cnameattr->attrValueType == SA_IMM_ATTR_SASTRINGT);
-	assert(cnameattr->attrValuesNumber == 1);
+struct OmHandles {
+	struct OmHandles *next;
+	SaImmHandleT omHandle;
+	SaImmAccessorHandleT accessorHandle;
+	bool omOwned;
+};
 
-	cname = dupStr(clist, *((char **)*(cnameattr->attrValues)));
+static pthread_mutex_t omPoolLock = PTHREAD_MUTEX_INITIALIZER;
+static struct OmHandles *omPool;
+static unsigned int omPoolCount[2]; /* Idle entries, by omOwned */
 
-finalize:
-	(void)immutil_saImmOmAccessorFinalize(accessorHandle);
-	return cname;
+static void omHandlesFinalize(struct OmHandles *h)
+{
+	while (h != NULL) {
+		struct OmHandles *next = h->next;
+		(void)saImmOmAccessorFinalize(h->accessorHandle);
+		if (h->omOwned)
+			(void)saImmOmFinalize(h->omHandle);
+		free(h);
+		h = next;
+	}
 }
 
-char const *immutil_getStringValue(char const *key, SaNameT const *name)
+/* Check out an entry for immHandle, or for a pool owned handle if 0 */
+static struct OmHandles *omHandlesGet(SaImmHandleT immHandle)
 {
-	const char *buffer = saAisNameBorrow(name);
-	unsigned int klen;
-	char *cp;
+	struct OmHandles *h, **pp;
+
+	pthread_mutex_lock(&omPoolLock);
+	for (pp = &omPool; (h = *pp) != NULL; pp = &h->next) {
+		if (immHandle == 0 ? h->omOwned
+				   : !h->omOwned && h->omHandle == immHandle) {
+			*pp = h->next;
+			omPoolCount[h->omOwned]--;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&omPoolLock);
+	if (h != NULL)
+		return h;
 
-	assert(buffer != NULL);
-	assert(key != NULL);
-	klen = strlen(key);
-	assert(klen > 1 || key[klen - 1] == '=');
+	h = calloc(1, sizeof(struct OmHandles));
+	if (h == NULL)
+		immutilError("Out of memory");
+	h->omHandle = immHandle;
+	h->omOwned = immHandle == 0;
+	if (h->omOwned &&
+	    immutil_saImmOmInitialize(&h->omHandle, NULL, &immVersion) !=
+		SA_AIS_OK) {
+		free(h);
+		return NULL;
+	}
+	if (immutil_saImmOmAccessorInitialize(h->omHandle,
+					      &h->accessorHandle) !=
+	    SA_AIS_OK) {
+		if (h->omOwned)
+			(void)saImmOmFinalize(h->omHandle);
+		free(h);
+		return NULL;
+	}
+	return h;
+}
 
-	cp = strstr(buffer, key);
-	while (cp != NULL) {
-		if (cp == buffer || cp[-1] == ',') {
-			char *value = cp + klen;
-			if (*value == 0 || *value == ',')
-				return NULL;
-			cp = strchr(value, ',');
-			if (cp != NULL)
-				*cp = 0;
-			return value;
+/* Return an entry after a call that returned rc */
+static void omHandlesPut(struct OmHandles *h, SaAisErrorT rc)
+{
+	struct OmHandles *stale = NULL, *e, **pp;
+
+	pthread_mutex_lock(&omPoolLock);
+	if (rc == SA_AIS_ERR_BAD_HANDLE) {
+		/* Idle owned entries share the bad OM handle's fate */
+		bool purge = h->omOwned;
+		h->next = NULL;
+		stale = h;
+		pp = &omPool;
+		while (purge && (e = *pp) != NULL) {
+			if (e->omOwned) {
+				*pp = e->next;
+				e->next = stale;
+				stale = e;
+				omPoolCount[true]--;
+			} else {
+				pp = &e->next;
+			}
 		}
-		cp += klen;
-		cp = strstr(cp, key);
+	} else if (!h->omOwned) {
+		h->next = omPool;
+		omPool = h;
+		if (++omPoolCount[false] > OM_POOL_CALLER_SIZE) {
+			/* Evict the oldest, the last in the pool */
+			struct OmHandles **last = NULL;
+			for (pp = &omPool; (e = *pp) != NULL; pp = &e->next)
+				if (!e->omOwned)
+					last = pp;
+			stale = *last;
+			*last = stale->next;
+			stale->next = NULL;
+			omPoolCount[false]--;
+		}
+	} else if (omPoolCount[true] < OM_POOL_SIZE) {
+		h->next = omPool;
+		omPool = h;
+		omPoolCount[true]++;
+	} else {
+		h->next = NULL;
+		stale = h;
 	}
-	return NULL;
+	pthread_mutex_unlock(&omPoolLock);
+	omHandlesFinalize(stale);
 }
 
-char const *immutil_getDnItem(SaNameT const *name, unsigned int index)
+/*
+ * DN to class name cache; a direct mapped table on DN hash, each slot holds
+ * one "dn\0className" string and is replaced on collision. The class of an
+ * object never changes, but a DN may be deleted and created again with
+ * another class, see immutil_classNameCacheFlush().
+ */
+
+#define CLASS_CACHE_SIZE 4096
+
+struct ClassCacheSlot {
+	SaUint64T hash;
+	char *entry;
+};
+
+static pthread_rwlock_t classCacheLock = PTHREAD_RWLOCK_INITIALIZER;
+static struct ClassCacheSlot classCache[CLASS_CACHE_SIZE];
+
+/* Return a malloc'ed copy of the cached class name of dn, or NULL */
+static char *classCacheLookup(const char *dn, SaUint64T hash)
 {
-	static char *buffer = NULL;
-	char *cp;
-	char *value;
-	size_t size;
-	const char *objName = saAisNameBorrow(name);
-	assert(objName != NULL);
-
-	size = strlen(objName) + 1;
-	buffer = realloc(buffer, size);
-	memcpy(buffer, objName, size);
-	value = buffer;
-	cp = strchr(value, ',');
-	while (index > 0) {
-		if (cp == NULL)
-			return NULL;
-		value = cp + 1;
-		cp = strchr(value, ',');
-		index--;
+	struct ClassCacheSlot *slot = &classCache[hash & (CLASS_CACHE_SIZE - 1)];
+	char *className = NULL;
+
+	pthread_rwlock_rdlock(&classCacheLock);
+	if (slot->entry != NULL && slot->hash == hash &&
+	    strcmp(slot->entry, dn) == 0) {
+		className = strdup(slot->entry + strlen(dn) + 1);
+		if (className == NULL)
+			immutilError("Out of memory");
 	}
-	if (cp != NULL)
-		*cp = 0;
-	return value;
+	pthread_rwlock_unlock(&classCacheLock);
+	return className;
 }
 
-long immutil_getNumericValue(char const *key, SaNameT const *name)
+static void classCacheInsert(const char *dn, SaUint64T hash,
+			     const char *className)
 {
-	char const *vp = immutil_getStringValue(key, name);
-	char *endptr;
-	long value;
+	struct ClassCacheSlot *slot = &classCache[hash & (CLASS_CACHE_SIZE - 1)];
+	size_t dnSize = strlen(dn) + 1, classSize = strlen(className) + 1;
+	char *entry = malloc(dnSize + classSize), *old;
 
-	if (vp == NULL)
-		return LONG_MIN;
-	value = strtol(vp, &endptr, 0);
-	if (endptr == NULL || endptr == vp || (*endptr != 0 && *endptr != ','))
-		return LONG_MIN;
-	return value;
+	if (entry == NULL)
+		immutilError("Out of memory");
+	memcpy(entry, dn, dnSize);
+	memcpy(entry + dnSize, className, classSize);
+	pthread_rwlock_wrlock(&classCacheLock);
+	old = slot->entry;
+	slot->hash = hash;
+	slot->entry = entry;
+	pthread_rwlock_unlock(&classCacheLock);
+	free(old);
 }
 
-char const *immutil_strnchr(char const *str, int c, size_t length)
+void immutil_classNameCacheFlush(const SaNameT *objectName)
 {
-	while (length > 0 && *str != 0) {
-		if (*str == c)
-			return str;
-		str++;
-		length--;
+	size_t i;
+
+	pthread_rwlock_wrlock(&classCacheLock);
+	if (objectName != NULL) {
+		const char *dn = saAisNameBorrow(objectName);
+		SaUint64T hash = hashStr(dn);
+		struct ClassCacheSlot *slot =
+		    &classCache[hash & (CLASS_CACHE_SIZE - 1)];
+		if (slot->entry != NULL && slot->hash == hash &&
+		    strcmp(slot->entry, dn) == 0) {
+			free(slot->entry);
+			slot->entry = NULL;
+		}
+	} else {
+		for (i = 0; i < CLASS_CACHE_SIZE; i++) {
+			free(classCache[i].entry);
+			classCache[i].entry = NULL;
+		}
 	}
-	return NULL;
+	pthread_rwlock_unlock(&classCacheLock);
 }
 
-const SaNameT *immutil_getNameAttr(const SaImmAttrValuesT_2 **attr,
-				   char const *name, unsigned int index)
+/*
+ * Return a malloc'ed copy of the class name of an object, from the cache or
+ * read with a pooled accessor on immHandle (0 for a pool owned OM handle).
+ */
+static char *classNameGet(SaImmHandleT immHandle, const SaNameT *objectName)
 {
-	unsigned int i;
-	if (attr == NULL || attr[0] == NULL)
-		return NULL;
-	for (i = 0; attr[i] != NULL; i++) {
-		if (strcmp(attr[i]->attrName, name) == 0) {
-			if (index >= attr[i]->attrValuesNumber ||
-			    attr[i]->attrValues == NULL ||
-			    attr[i]->attrValueType != SA_IMM_ATTR_SANAMET)
-				return NULL;
-			return (SaNameT *)attr[i]->attrValues[index];
+	SaImmAttrNameT attrNames[] = {SA_IMM_ATTR_CLASS_NAME, NULL};
+	const char *dn = saAisNameBorrow(objectName);
+	SaUint64T hash = hashStr(dn);
+	SaImmAttrValuesT_2 **attributes;
+	SaAisErrorT rc = SA_AIS_ERR_BAD_HANDLE;
+	char *className;
+	int attempt;
+
+	if ((className = classCacheLookup(dn, hash)) != NULL)
+		return className;
+
+	/* One retry with new handles on SA_AIS_ERR_BAD_HANDLE */
+	for (attempt = 0; attempt < 2 && rc == SA_AIS_ERR_BAD_HANDLE;
+	     attempt++) {
+		struct OmHandles *h = omHandlesGet(immHandle);
+		struct ImmutilRetry retry;
+		if (h == NULL)
+			return NULL;
+		rc = retryStart(&retry, IMMUTIL_OP_OM_ACCESSOR_GET_2);
+		if (rc == SA_AIS_OK)
+			do {
+				rc = saImmOmAccessorGet_2(h->accessorHandle,
+							  objectName, attrNames,
+							  &attributes);
+			} while (immutil_retry(&retry, rc));
+		if (rc == SA_AIS_OK && attributes != NULL &&
+		    attributes[0] != NULL &&
+		    attributes[0]->attrValuesNumber == 1) {
+			className =
+			    strdup(*((char **)attributes[0]->attrValues[0]));
+			if (className == NULL)
+				immutilError("Out of memory");
 		}
+		omHandlesPut(h, rc);
 	}
-	return NULL;
+	if (rc != SA_AIS_OK && rc != SA_AIS_ERR_NOT_EXIST &&
+	    immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAccessorGet_2 FAILED, rc = %d", (int)rc);
+	if (className != NULL)
+		classCacheInsert(dn, hash, className);
+	return className;
 }
 
-char const *immutil_getStringAttr(const SaImmAttrValuesT_2 **attr,
-				  char const *name, unsigned int index)
+char const *immutil_getClassName(struct CcbUtilCcbData *ccb,
+				 SaImmHandleT immHandle,
+				 const SaNameT *objectName)
 {
-	unsigned int i;
-	if (attr == NULL || attr[0] == NULL)
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	char *className, *cname;
+
+	if (objectName == NULL || immHandle == 0)
 		return NULL;
-	for (i = 0; attr[i] != NULL; i++) {
-		if (strcmp(attr[i]->attrName, name) == 0) {
-			if (index >= attr[i]->attrValuesNumber ||
-			    attr[i]->attrValues == NULL ||
-			    attr[i]->attrValueType != SA_IMM_ATTR_SASTRINGT)
-				return NULL;
-			return *((const SaStringT *)attr[i]->attrValues[index]);
-		}
+	if ((className = classNameGet(immHandle, objectName)) == NULL)
+		return NULL;
+	ccbLock(ccb);
+	cname = dupStr(arena, className);
+	ccbUnlock(ccb);
+	free(className);
+	return cname;
+}
+
+/*
+ * DN scanning. RDNs are separated by ',' and a ',' preceded by an odd number
+ * of '\' is escaped. The delimiter search uses memchr, which is vectorized in
+ * the C library.
+ */
+
+/* Find the first unescaped ',' in [p, end), p is the start of an RDN */
+static const char *dnFindComma(const char *p, const char *end)
+{
+	const char *start = p;
+	while ((p = memchr(p, ',', end - p)) != NULL) {
+		const char *q = p;
+		while (q > start && q[-1] == '\\')
+			q--;
+		if (((p - q) & 1) == 0)
+			return p;
+		p++;
 	}
 	return NULL;
 }
 
-SaAisErrorT immutil_getAttrValuesNumber(const char *attrName,
-					const SaImmAttrValuesT_2 **attr,
-					SaUint32T *attrValuesNumber)
+void immutil_dnIterInit(struct ImmutilDnIter *iter, SaNameT const *dn)
 {
-	SaAisErrorT error = SA_AIS_ERR_NAME_NOT_FOUND;
-	int i;
-
-	if (attr == NULL || attr[0] == NULL)
-		return SA_AIS_ERR_INVALID_PARAM;
+	const char *str = saAisNameBorrow(dn);
+	assert(str != NULL);
+	iter->end = str + strlen(str);
+	iter->pos = iter->end > str ? str : NULL;
+}
 
-	for (i = 0; attr[i] != NULL; i++) {
-		if (strcmp(attr[i]->attrName, attrName) == 0) {
-			*attrValuesNumber = attr[i]->attrValuesNumber;
-			error = SA_AIS_OK;
-			break;
-		}
+bool immutil_dnNext(struct ImmutilDnIter *iter, struct ImmutilDnSlice *rdn)
+{
+	const char *comma;
+	if (iter->pos == NULL)
+		return false;
+	comma = dnFindComma(iter->pos, iter->end);
+	rdn->value = iter->pos;
+	if (comma == NULL) {
+		rdn->length = iter->end - iter->pos;
+		iter->pos = NULL;
+	} else {
+		rdn->length = comma - iter->pos;
+		iter->pos = comma + 1;
 	}
-
-	return error;
+	return true;
 }
 
-/* note: SA_IMM_ATTR_SASTRINGT is intentionally not supported */
-SaAisErrorT immutil_getAttr(const char *attrName,
-			    const SaImmAttrValuesT_2 **attr, SaUint32T index,
-			    void *param)
+bool immutil_dnGetItem(SaNameT const *dn, unsigned int index,
+		       struct ImmutilDnSlice *item)
 {
-	SaAisErrorT error = SA_AIS_ERR_NAME_NOT_FOUND;
-	int i;
+	struct ImmutilDnIter iter;
+	immutil_dnIterInit(&iter, dn);
+	while (immutil_dnNext(&iter, item)) {
+		if (index-- == 0)
+			return true;
+	}
+	return false;
+}
 
-	if (attr == NULL || attr[0] == NULL)
-		return SA_AIS_ERR_INVALID_PARAM;
+bool immutil_dnGetValue(SaNameT const *dn, char const *key,
+			struct ImmutilDnSlice *value)
+{
+	struct ImmutilDnIter iter;
+	struct ImmutilDnSlice rdn;
+	size_t klen = strlen(key);
+
+	immutil_dnIterInit(&iter, dn);
+	while (immutil_dnNext(&iter, &rdn)) {
+		if (rdn.length >= klen && memcmp(rdn.value, key, klen) == 0) {
+			value->value = rdn.value + klen;
+			value->length = rdn.length - klen;
+			return true;
+		}
+	}
+	return false;
+}
 
-	for (i = 0; attr[i] != NULL; i++) {
-		/*
-		  LOG_NO("TESTING immutil_getAttr1 attr[i]->attrName=%s
-		  attrName=%s i=%d " "attr[i]->attrValuesNumber=%d",
-		  attr[i]->attrName, attrName, i, attr[i]->attrValuesNumber);
-		*/
-		if (strcmp(attr[i]->attrName, attrName) == 0) {
-			if ((index >= attr[i]->attrValuesNumber) ||
-			    (attr[i]->attrValues == NULL)) {
-				error = SA_AIS_ERR_INVALID_PARAM;
-				goto done;
-			}
-			/*
-			  LOG_NO("TESTING immutil_getAttr2 attrName=%s i=%d "
-			  "attr[i]->attrValuesNumber=%d", attrName, i,
-			  attr[i]->attrValuesNumber);
-			*/
-			switch (attr[i]->attrValueType) {
-			case SA_IMM_ATTR_SAINT32T:
-				*((SaInt32T *)param) =
-				    *((SaInt32T *)attr[i]->attrValues[index]);
-				break;
-			case SA_IMM_ATTR_SAUINT32T:
-				*((SaUint32T *)param) =
-				    *((SaUint32T *)attr[i]->attrValues[index]);
-				break;
-			case SA_IMM_ATTR_SAINT64T:
-				*((SaInt64T *)param) =
-				    *((SaInt64T *)attr[i]->attrValues[index]);
-				break;
-			case SA_IMM_ATTR_SAUINT64T:
-				*((SaUint64T *)param) =
-				    *((SaUint64T *)attr[i]->attrValues[index]);
-				break;
-			case SA_IMM_ATTR_SATIMET:
-				*((SaTimeT *)param) =
-				    *((SaTimeT *)attr[i]->attrValues[index]);
-				break;
-			case SA_IMM_ATTR_SANAMET:
-				*((SaNameT *)param) =
-				    *((SaNameT *)attr[i]->attrValues[index]);
-				break;
-			case SA_IMM_ATTR_SAFLOATT:
-				*((SaFloatT *)param) =
-				    *((SaFloatT *)attr[i]->attrValues[index]);
-				break;
-			case SA_IMM_ATTR_SADOUBLET:
-				*((SaDoubleT *)param) =
-				    *((SaDoubleT *)attr[i]->attrValues[index]);
-				break;
-			default:
-				error = SA_AIS_ERR_INVALID_PARAM;
-				abort();
-				goto done;
-				break;
-			}
+bool immutil_rdnSplit(struct ImmutilDnSlice const *rdn,
+		      struct ImmutilDnSlice *key, struct ImmutilDnSlice *value)
+{
+	const char *eq = memchr(rdn->value, '=', rdn->length);
+	if (eq == NULL)
+		return false;
+	key->value = rdn->value;
+	key->length = eq - rdn->value;
+	value->value = eq + 1;
+	value->length = rdn->length - key->length - 1;
+	return true;
+}
 
-			error = SA_AIS_OK;
-			break;
-		}
+/* Per-thread buffer for the string returned by the functions below */
+struct ThreadBuffer {
+	size_t size;
+	char data[];
+};
+
+static pthread_key_t threadBufferKey;
+static pthread_once_t threadBufferOnce = PTHREAD_ONCE_INIT;
+
+static void threadBufferInit(void)
+{
+	if (pthread_key_create(&threadBufferKey, free) != 0)
+		immutilError("pthread_key_create FAILED");
+}
+
+/* Return a NUL terminated copy of a slice in the per-thread buffer */
+static const char *threadCopy(const struct ImmutilDnSlice *slice)
+{
+	struct ThreadBuffer *buf;
+
+	pthread_once(&threadBufferOnce, threadBufferInit);
+	buf = pthread_getspecific(threadBufferKey);
+	if (buf == NULL || buf->size <= slice->length) {
+		size_t size = slice->length < 256 ? 256 : slice->length + 1;
+		free(buf);
+		buf = malloc(sizeof(struct ThreadBuffer) + size);
+		if (buf == NULL)
+			immutilError("Out of memory");
+		buf->size = size;
+		if (pthread_setspecific(threadBufferKey, buf) != 0)
+			immutilError("pthread_setspecific FAILED");
 	}
+	memcpy(buf->data, slice->value, slice->length);
+	buf->data[slice->length] = 0;
+	return buf->data;
+}
 
-done:
-	return error;
+char const *immutil_getStringValue(char const *key, SaNameT const *name)
+{
+	struct ImmutilDnSlice value;
+	unsigned int klen;
+
+	assert(key != NULL);
+	klen = strlen(key);
+	assert(klen > 1 || key[klen - 1] == '=');
+
+	if (!immutil_dnGetValue(name, key, &value) || value.length == 0)
+		return NULL;
+	return threadCopy(&value);
 }
 
-const SaTimeT *immutil_getTimeAttr(const SaImmAttrValuesT_2 **attr,
-				   char const *name, unsigned int index)
+char const *immutil_getDnItem(SaNameT const *name, unsigned int index)
+{
+	struct ImmutilDnSlice item;
+	if (!immutil_dnGetItem(name, index, &item))
+		return NULL;
+	return threadCopy(&item);
+}
+
+long immutil_getNumericValue(char const *key, SaNameT const *name)
+{
+	char const *vp = immutil_getStringValue(key, name);
+	char *endptr;
+	long value;
+
+	if (vp == NULL)
+		return LONG_MIN;
+	value = strtol(vp, &endptr, 0);
+	if (endptr == NULL || endptr == vp || (*endptr != 0 && *endptr != ','))
+		return LONG_MIN;
+	return value;
+}
+
+char const *immutil_strnchr(char const *str, int c, size_t length)
+{
+	while (length > 0 && *str != 0) {
+		if (*str == c)
+			return str;
+		str++;
+		length--;
+	}
+	return NULL;
+}
+
+/* Linear scan for an attribute, the first one with the name is returned */
+static const SaImmAttrValuesT_2 *findAttr(const SaImmAttrValuesT_2 **attr,
+					  char const *name)
 {
 	unsigned int i;
-	if (attr == NULL || attr[0] == NULL)
+	if (attr == NULL)
 		return NULL;
 	for (i = 0; attr[i] != NULL; i++) {
-		if (strcmp(attr[i]->attrName, name) == 0) {
-			if (index >= attr[i]->attrValuesNumber ||
-			    attr[i]->attrValues == NULL ||
-			    attr[i]->attrValueType != SA_IMM_ATTR_SATIMET)
-				return NULL;
-			return (SaTimeT *)attr[i]->attrValues[index];
-		}
+		if (strcmp(attr[i]->attrName, name) == 0)
+			return attr[i];
 	}
 	return NULL;
 }
 
+/* Return value number index of an attribute if it has the passed type */
+static const void *attrValue(const SaImmAttrValuesT_2 *attr,
+			     SaImmValueTypeT valueType, unsigned int index)
+{
+	if (attr == NULL || index >= attr->attrValuesNumber ||
+	    attr->attrValues == NULL || attr->attrValueType != valueType)
+		return NULL;
+	return attr->attrValues[index];
+}
+
+static SaAisErrorT copyAttrValue(const SaImmAttrValuesT_2 *attr,
+				 SaUint32T index, void *param)
+{
+	if ((index >= attr->attrValuesNumber) || (attr->attrValues == NULL))
+		return SA_AIS_ERR_INVALID_PARAM;
+	switch (attr->attrValueType) {
+	case SA_IMM_ATTR_SAINT32T:
+		*((SaInt32T *)param) = *((SaInt32T *)attr->attrValues[index]);
+		break;
+	case SA_IMM_ATTR_SAUINT32T:
+		*((SaUint32T *)param) = *((SaUint32T *)attr->attrValues[index]);
+		break;
+	case SA_IMM_ATTR_SAINT64T:
+		*((SaInt64T *)param) = *((SaInt64T *)attr->attrValues[index]);
+		break;
+	case SA_IMM_ATTR_SAUINT64T:
+		*((SaUint64T *)param) = *((SaUint64T *)attr->attrValues[index]);
+		break;
+	case SA_IMM_ATTR_SATIMET:
+		*((SaTimeT *)param) = *((SaTimeT *)attr->attrValues[index]);
+		break;
+	case SA_IMM_ATTR_SANAMET:
+		*((SaNameT *)param) = *((SaNameT *)attr->attrValues[index]);
+		break;
+	case SA_IMM_ATTR_SAFLOATT:
+		*((SaFloatT *)param) = *((SaFloatT *)attr->attrValues[index]);
+		break;
+	case SA_IMM_ATTR_SADOUBLET:
+		*((SaDoubleT *)param) = *((SaDoubleT *)attr->attrValues[index]);
+		break;
+	default:
+		abort();
+		return SA_AIS_ERR_INVALID_PARAM;
+	}
+	return SA_AIS_OK;
+}
+
+const SaNameT *immutil_getNameAttr(const SaImmAttrValuesT_2 **attr,
+				   char const *name, unsigned int index)
+{
+	return attrValue(findAttr(attr, name), SA_IMM_ATTR_SANAMET, index);
+}
+
+char const *immutil_getStringAttr(const SaImmAttrValuesT_2 **attr,
+				  char const *name, unsigned int index)
+{
+	const SaStringT *value =
+	    attrValue(findAttr(attr, name), SA_IMM_ATTR_SASTRINGT, index);
+	return value != NULL ? *value : NULL;
+}
+
+SaAisErrorT immutil_getAttrValuesNumber(const char *attrName,
+					const SaImmAttrValuesT_2 **attr,
+					SaUint32T *attrValuesNumber)
+{
+	const SaImmAttrValuesT_2 *found;
+
+	if (attr == NULL || attr[0] == NULL)
+		return SA_AIS_ERR_INVALID_PARAM;
+	found = findAttr(attr, attrName);
+	if (found == NULL)
+		return SA_AIS_ERR_NAME_NOT_FOUND;
+	*attrValuesNumber = found->attrValuesNumber;
+	return SA_AIS_OK;
+}
+
+/* note: SA_IMM_ATTR_SASTRINGT is intentionally not supported */
+SaAisErrorT immutil_getAttr(const char *attrName,
+			    const SaImmAttrValuesT_2 **attr, SaUint32T index,
+			    void *param)
+{
+	const SaImmAttrValuesT_2 *found;
+
+	if (attr == NULL || attr[0] == NULL)
+		return SA_AIS_ERR_INVALID_PARAM;
+	found = findAttr(attr, attrName);
+	if (found == NULL)
+		return SA_AIS_ERR_NAME_NOT_FOUND;
+	return copyAttrValue(found, index, param);
+}
+
+const SaTimeT *immutil_getTimeAttr(const SaImmAttrValuesT_2 **attr,
+				   char const *name, unsigned int index)
+{
+	return attrValue(findAttr(attr, name), SA_IMM_ATTR_SATIMET, index);
+}
+
 const SaUint32T *immutil_getUint32Attr(const SaImmAttrValuesT_2 **attr,
 				       char const *name, unsigned int index)
 {
-	unsigned int i;
-	if (attr == NULL || attr[0] == NULL)
-		return NULL;
-	for (i = 0; attr[i] != NULL; i++) {
-		if (strcmp(attr[i]->attrName, name) == 0) {
-			if (index >= attr[i]->attrValuesNumber ||
-			    attr[i]->attrValues == NULL ||
-			    attr[i]->attrValueType != SA_IMM_ATTR_SAUINT32T)
-				return NULL;
-			return (SaUint32T *)attr[i]->attrValues[index];
+	return attrValue(findAttr(attr, name), SA_IMM_ATTR_SAUINT32T, index);
+}
+
+/*
+ * Attribute index; an open-addressed hash table (linear probing) on attribute
+ * name, allocated in one piece with the index. The table size is a power of
+ * two at least twice the number of attributes.
+ */
+
+struct AttrSlot {
+	SaUint64T hash;
+	const SaImmAttrValuesT_2 *attr;
+};
+
+struct ImmutilAttrIndex {
+	size_t mask;
+	struct AttrSlot slots[];
+};
+
+static struct AttrSlot *attrIndexProbe(const struct ImmutilAttrIndex *index,
+				       char const *name, SaUint64T hash)
+{
+	size_t i = hash & index->mask;
+	while (index->slots[i].attr != NULL &&
+	       (index->slots[i].hash != hash ||
+		strcmp(index->slots[i].attr->attrName, name) != 0))
+		i = (i + 1) & index->mask;
+	return (struct AttrSlot *)&index->slots[i];
+}
+
+ImmutilAttrIndex_t *immutil_attrIndexCreate(const SaImmAttrValuesT_2 **attr)
+{
+	struct ImmutilAttrIndex *index;
+	size_t i, n = 0, size = 4;
+
+	while (attr != NULL && attr[n] != NULL)
+		n++;
+	while (size < 2 * n)
+		size *= 2;
+	index = calloc(1, sizeof(struct ImmutilAttrIndex) +
+			      size * sizeof(struct AttrSlot));
+	if (index == NULL)
+		immutilError("Out of memory");
+	index->mask = size - 1;
+	for (i = 0; i < n; i++) {
+		SaUint64T hash = hashStr(attr[i]->attrName);
+		struct AttrSlot *slot =
+		    attrIndexProbe(index, attr[i]->attrName, hash);
+		if (slot->attr == NULL) {
+			slot->hash = hash;
+			slot->attr = attr[i];
 		}
 	}
-	return NULL;
+	return index;
+}
+
+void immutil_attrIndexDelete(ImmutilAttrIndex_t *index)
+{
+	free(index);
+}
+
+const SaImmAttrValuesT_2 *
+immutil_attrIndexFind(const ImmutilAttrIndex_t *index, char const *name)
+{
+	return attrIndexProbe(index, name, hashStr(name))->attr;
+}
+
+const SaNameT *immutil_attrIndexGetName(const ImmutilAttrIndex_t *index,
+					char const *name, unsigned int i)
+{
+	return attrValue(immutil_attrIndexFind(index, name),
+			 SA_IMM_ATTR_SANAMET, i);
+}
+
+char const *immutil_attrIndexGetString(const ImmutilAttrIndex_t *index,
+				       char const *name, unsigned int i)
+{
+	const SaStringT *value = attrValue(immutil_attrIndexFind(index, name),
+					   SA_IMM_ATTR_SASTRINGT, i);
+	return value != NULL ? *value : NULL;
+}
+
+const SaTimeT *immutil_attrIndexGetTime(const ImmutilAttrIndex_t *index,
+					char const *name, unsigned int i)
+{
+	return attrValue(immutil_attrIndexFind(index, name),
+			 SA_IMM_ATTR_SATIMET, i);
+}
+
+const SaUint32T *immutil_attrIndexGetUint32(const ImmutilAttrIndex_t *index,
+					    char const *name, unsigned int i)
+{
+	return attrValue(immutil_attrIndexFind(index, name),
+			 SA_IMM_ATTR_SAUINT32T, i);
+}
+
+SaAisErrorT immutil_attrIndexGetValuesNumber(const ImmutilAttrIndex_t *index,
+					     const char *attrName,
+					     SaUint32T *attrValuesNumber)
+{
+	const SaImmAttrValuesT_2 *found =
+	    immutil_attrIndexFind(index, attrName);
+	if (found == NULL)
+		return SA_AIS_ERR_NAME_NOT_FOUND;
+	*attrValuesNumber = found->attrValuesNumber;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT immutil_attrIndexGetAttr(const ImmutilAttrIndex_t *index,
+				     const char *attrName, SaUint32T i,
+				     void *param)
+{
+	const SaImmAttrValuesT_2 *found =
+	    immutil_attrIndexFind(index, attrName);
+	if (found == NULL)
+		return SA_AIS_ERR_NAME_NOT_FOUND;
+	return copyAttrValue(found, i, param);
 }
 
 int immutil_matchName(SaNameT const *name, regex_t const *preg)
@@ -584,6 +1407,202 @@ int immutil_matchName(SaNameT const *name, regex_t const *preg)
 	return regexec(preg, buffer, 0, NULL, 0);
 }
 
+/*
+ * Compiled DN patterns. A pattern is a DN where each RDN may contain one '*'
+ * matching any characters within that RDN, and may start with "**" matching
+ * any number of RDNs. The longest run of trailing RDNs without '*' is kept as
+ * one literal that is compared against the end of the DN with memcmp before
+ * the rest of the DN is split in RDNs.
+ */
+
+#define DN_PATTERN_RDNS 32
+
+struct DnPatternRdn {
+	const char *prefix;
+	SaUint32T prefixLength;
+	const char *suffix; /* NULL if there is no '*' */
+	SaUint32T suffixLength;
+};
+
+struct ImmutilDnPattern {
+	bool subtree;	/* Leading "**" */
+	const char *tail; /* Trailing literal RDNs */
+	size_t tailLength;
+	SaUint32T nRdns; /* Pattern RDNs before the tail, without "**" */
+	struct DnPatternRdn rdns[];
+};
+
+ImmutilDnPattern_t *immutil_dnPatternCompile(const char *pattern)
+{
+	struct ImmutilDnPattern *p;
+	const char *pos = pattern, *end = pattern + strlen(pattern);
+	const char *tailStart = NULL;
+	SaUint32T n = 1, i;
+	char *copy;
+
+	while ((pos = dnFindComma(pos, end)) != NULL) {
+		pos++;
+		n++;
+	}
+	p = calloc(1, sizeof(struct ImmutilDnPattern) +
+			  n * sizeof(struct DnPatternRdn) + (end - pattern) + 1);
+	if (p == NULL)
+		immutilError("Out of memory");
+	copy = (char *)&p->rdns[n];
+	memcpy(copy, pattern, end - pattern + 1);
+	end = copy + (end - pattern);
+
+	for (pos = copy, i = 0; pos != NULL; i++) {
+		const char *comma = dnFindComma(pos, end);
+		const char *rdnEnd = comma != NULL ? comma : end;
+		const char *star = memchr(pos, '*', rdnEnd - pos);
+		struct DnPatternRdn *rdn = &p->rdns[p->nRdns];
+
+		if (rdnEnd == pos)
+			goto invalid; /* Empty RDN */
+		if (rdnEnd - pos == 2 && pos[0] == '*' && pos[1] == '*') {
+			if (i != 0)
+				goto invalid; /* Only allowed first */
+			p->subtree = true;
+		} else if (star == NULL) {
+			if (tailStart == NULL)
+				tailStart = pos;
+			rdn->prefix = pos;
+			rdn->prefixLength = rdnEnd - pos;
+			p->nRdns++;
+		} else {
+			if (memchr(star + 1, '*', rdnEnd - star - 1) != NULL)
+				goto invalid; /* One '*' per RDN */
+			tailStart = NULL;
+			rdn->prefix = pos;
+			rdn->prefixLength = star - pos;
+			rdn->suffix = star + 1;
+			rdn->suffixLength = rdnEnd - star - 1;
+			p->nRdns++;
+		}
+		pos = comma != NULL ? comma + 1 : NULL;
+	}
+
+	if (tailStart != NULL) {
+		/* Drop the literal RDNs from rdns, they are matched by tail */
+		while (p->nRdns > 0 && p->rdns[p->nRdns - 1].suffix == NULL &&
+		       p->rdns[p->nRdns - 1].prefix >= tailStart)
+			p->nRdns--;
+		p->tail = tailStart;
+		p->tailLength = end - tailStart;
+	}
+	return p;
+
+invalid:
+	free(p);
+	return NULL;
+}
+
+void immutil_dnPatternDelete(ImmutilDnPattern_t *pattern)
+{
+	free(pattern);
+}
+
+static bool dnPatternRdnMatch(const struct DnPatternRdn *p,
+			      const struct ImmutilDnSlice *rdn)
+{
+	if (p->suffix == NULL)
+		return rdn->length == p->prefixLength &&
+		       memcmp(rdn->value, p->prefix, p->prefixLength) == 0;
+	return rdn->length >= p->prefixLength + p->suffixLength &&
+	       memcmp(rdn->value, p->prefix, p->prefixLength) == 0 &&
+	       memcmp(rdn->value + rdn->length - p->suffixLength, p->suffix,
+		      p->suffixLength) == 0;
+}
+
+static bool dnPatternMatch(const struct ImmutilDnPattern *p, const char *dn,
+			   size_t length)
+{
+	struct ImmutilDnSlice stackRdns[DN_PATTERN_RDNS];
+	struct ImmutilDnSlice *rdns = stackRdns;
+	const char *pos, *end;
+	SaUint32T n = 0, i;
+	bool match;
+
+	if (p->tailLength > 0) {
+		const char *q;
+		if (length < p->tailLength ||
+		    memcmp(dn + length - p->tailLength, p->tail,
+			   p->tailLength) != 0)
+			return false;
+		length -= p->tailLength;
+		if (length > 0) {
+			/* The tail must start after an unescaped ',' */
+			if (dn[length - 1] != ',')
+				return false;
+			for (q = dn + length - 1; q > dn && q[-1] == '\\'; q--)
+				;
+			if (((dn + length - 1 - q) & 1) != 0)
+				return false;
+			length--;
+		} else if (p->nRdns > 0) {
+			return false;
+		}
+	}
+	if (p->nRdns == 0)
+		return length == 0 || p->subtree;
+	if (length == 0)
+		return false;
+
+	/* Keep the last nRdns RDNs of the DN in a ring */
+	if (p->nRdns > DN_PATTERN_RDNS) {
+		rdns = malloc(p->nRdns * sizeof(struct ImmutilDnSlice));
+		if (rdns == NULL)
+			immutilError("Out of memory");
+	}
+	pos = dn;
+	end = dn + length;
+	while (pos != NULL) {
+		const char *comma;
+		if (n == p->nRdns && !p->subtree) {
+			n++; /* Deeper than the pattern */
+			break;
+		}
+		comma = dnFindComma(pos, end);
+		rdns[n % p->nRdns].value = pos;
+		rdns[n % p->nRdns].length = (comma != NULL ? comma : end) - pos;
+		n++;
+		pos = comma != NULL ? comma + 1 : NULL;
+	}
+
+	match = p->subtree ? n >= p->nRdns : n == p->nRdns;
+	for (i = 1; match && i <= p->nRdns; i++)
+		match = dnPatternRdnMatch(&p->rdns[p->nRdns - i],
+					  &rdns[(n - i) % p->nRdns]);
+	if (rdns != stackRdns)
+		free(rdns);
+	return match;
+}
+
+bool immutil_dnPatternMatch(const ImmutilDnPattern_t *pattern,
+			    SaNameT const *name)
+{
+	const char *dn = saAisNameBorrow(name);
+	assert(dn != NULL);
+	return dnPatternMatch(pattern, dn, strlen(dn));
+}
+
+size_t immutil_dnPatternMatchBulk(const ImmutilDnPattern_t *pattern,
+				  SaNameT const *names, size_t n, bool *matches)
+{
+	size_t i, count = 0;
+	for (i = 0; i < n; i++) {
+		const char *dn = saAisNameBorrow(&names[i]);
+		bool match;
+		assert(dn != NULL);
+		match = dnPatternMatch(pattern, dn, strlen(dn));
+		if (matches != NULL)
+			matches[i] = match;
+		count += match;
+	}
+	return count;
+}
+
 SaAisErrorT immutil_update_one_rattr(SaImmOiHandleT immOiHandle, const char *dn,
 				     SaImmAttrNameT attributeName,
 				     SaImmValueTypeT attrValueType, void *value)
@@ -604,70 +1623,471 @@ SaAisErrorT immutil_update_one_rattr(SaImmOiHandleT immOiHandle, const char *dn,
 					       attrMods);
 }
 
-SaImmClassNameT immutil_get_className(const SaNameT *objectName)
-{
-	SaImmHandleT omHandle;
-	SaImmClassNameT className = NULL;
-	SaImmAccessorHandleT accessorHandle;
-	SaImmAttrValuesT_2 **attributes;
-	SaImmAttrNameT attributeNames[] = {"SaImmAttrClassName", NULL};
+/* ----------------------------------------------------------------------
+ * Runtime attribute update accumulator
+ *
+ * Updates are collected per object in an arena that is recycled on each
+ * flush. Objects are found through an open-addressed hash table on DN and
+ * flushed in the order they were first updated.
+ */
 
-	if (immutil_saImmOmInitialize(&omHandle, NULL, &immVersion) !=
-	    SA_AIS_OK)
-		goto done;
-	if (immutil_saImmOmAccessorInitialize(omHandle, &accessorHandle) !=
-	    SA_AIS_OK)
-		goto finalize_om_handle;
-	if (immutil_saImmOmAccessorGet_2(accessorHandle, objectName,
-					 attributeNames,
-					 &attributes) == SA_AIS_OK)
-		className = strdup(*((char **)attributes[0]->attrValues[0]));
-	(void)immutil_saImmOmAccessorFinalize(accessorHandle);
-
-finalize_om_handle:
-	(void)immutil_saImmOmFinalize(omHandle);
+#define RT_TABLE_MIN_SIZE 64
 
-done:
-	return className;
+struct RtAttr {
+	struct RtAttr *next;
+	SaImmAttrModificationT_2 mod;
+	SaImmAttrValueT value;
+};
+
+struct RtObject {
+	struct RtObject *next; /* In update order */
+	SaUint64T hash;
+	const char *dn;
+	struct RtAttr *attrs;
+	struct RtAttr *attrsTail;
+	SaUint32T nAttrs;
+};
+
+struct ImmutilRtUpdater {
+	pthread_mutex_t lock;
+	SaImmOiHandleT immOiHandle;
+	size_t maxPending;
+	SaTimeT maxAge;
+	struct Arena *arena;
+	struct RtObject **table;
+	size_t tableSize;
+	size_t nObjects;
+	struct RtObject *objects;
+	struct RtObject *objectsTail;
+	size_t nPending;	 /* Pending attributes */
+	SaUint64T nBatchUpdates; /* Updates since the last flush */
+	SaTimeT firstUpdate;
+	struct ImmutilRtUpdaterStats stats;
+};
+
+static SaTimeT monotonicTime(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (SaTimeT)ts.tv_sec * 1000000000 + ts.tv_nsec;
 }
 
-SaAisErrorT immutil_get_attrValueType(const SaImmClassNameT className,
-				      SaImmAttrNameT attrName,
-				      SaImmValueTypeT *attrValueType)
+static struct RtObject **rtTableProbe(struct ImmutilRtUpdater *u,
+				      const char *dn, SaUint64T hash)
 {
-	SaAisErrorT rc;
-	SaImmHandleT omHandle;
-	SaImmClassCategoryT classCategory;
-	SaImmAttrDefinitionT_2 *attrDef;
-	SaImmAttrDefinitionT_2 **attrDefinitions;
-	int i = 0;
+	size_t mask = u->tableSize - 1;
+	size_t i = hash & mask;
+	while (u->table[i] != NULL &&
+	       (u->table[i]->hash != hash || strcmp(u->table[i]->dn, dn) != 0))
+		i = (i + 1) & mask;
+	return &u->table[i];
+}
 
-	if ((rc = immutil_saImmOmInitialize(&omHandle, NULL, &immVersion)) !=
-	    SA_AIS_OK) {
-		return rc;
+static struct RtObject *rtObjectGet(struct ImmutilRtUpdater *u,
+				    const char *dn)
+{
+	SaUint64T hash = hashStr(dn);
+	struct RtObject **slot;
+	struct RtObject *obj;
+
+	if (2 * (u->nObjects + 1) > u->tableSize) {
+		struct RtObject **old = u->table;
+		size_t i, oldSize = u->tableSize;
+		u->tableSize =
+		    oldSize == 0 ? RT_TABLE_MIN_SIZE : 2 * oldSize;
+		u->table = calloc(u->tableSize, sizeof(struct RtObject *));
+		if (u->table == NULL)
+			immutilError("Out of memory");
+		for (i = 0; i < oldSize; i++) {
+			if (old[i] != NULL)
+				*rtTableProbe(u, old[i]->dn, old[i]->hash) =
+				    old[i];
+		}
+		free(old);
 	}
+	slot = rtTableProbe(u, dn, hash);
+	if (*slot != NULL)
+		return *slot;
+
+	obj = arenaMalloc(u->arena, sizeof(struct RtObject));
+	obj->hash = hash;
+	obj->dn = dupStr(u->arena, dn);
+	*slot = obj;
+	u->nObjects++;
+	if (u->objectsTail == NULL)
+		u->objects = obj;
+	else
+		u->objectsTail->next = obj;
+	u->objectsTail = obj;
+	return obj;
+}
 
-	if ((rc = saImmOmClassDescriptionGet_2(omHandle, className,
-					       &classCategory,
-					       &attrDefinitions)) != SA_AIS_OK)
-		goto done;
+/* Send the pending updates, one saImmOiRtObjectUpdate_2 per object */
+static SaAisErrorT rtUpdaterFlush(struct ImmutilRtUpdater *u)
+{
+	SaAisErrorT rc = SA_AIS_OK;
+	struct RtObject *obj;
+
+	for (obj = u->objects; obj != NULL; obj = obj->next) {
+		const SaImmAttrModificationT_2 **attrMods;
+		struct RtAttr *attr;
+		SaNameT objectName;
+		SaAisErrorT err;
+		size_t i = 0;
+
+		attrMods = arenaMalloc(u->arena,
+				       (obj->nAttrs + 1) *
+					   sizeof(SaImmAttrModificationT_2 *));
+		for (attr = obj->attrs; attr != NULL; attr = attr->next)
+			attrMods[i++] = &attr->mod;
+		attrMods[i] = NULL;
+
+		saAisNameLend(obj->dn, &objectName);
+		err = immutil_saImmOiRtObjectUpdate_2(u->immOiHandle,
+						      &objectName, attrMods);
+		u->stats.calls++;
+		if (err != SA_AIS_OK) {
+			u->stats.errors++;
+			if (rc == SA_AIS_OK)
+				rc = err;
+		}
+	}
 
-	rc = SA_AIS_ERR_INVALID_PARAM;
-	while ((attrDef = attrDefinitions[i++]) != NULL) {
-		if (!strcmp(attrName, attrDef->attrName)) {
-			*attrValueType = attrDef->attrValueType;
-			rc = SA_AIS_OK;
+	u->stats.saved += u->nBatchUpdates - u->nObjects;
+	u->nBatchUpdates = 0;
+	arenaDelete(u->arena);
+	u->arena = arenaCreate();
+	if (u->nObjects > 0)
+		memset(u->table, 0, u->tableSize * sizeof(struct RtObject *));
+	u->nObjects = 0;
+	u->objects = NULL;
+	u->objectsTail = NULL;
+	u->nPending = 0;
+	return rc;
+}
+
+static bool rtUpdaterExpired(const struct ImmutilRtUpdater *u)
+{
+	return u->nPending > 0 && u->maxAge > 0 &&
+	       monotonicTime() - u->firstUpdate >= u->maxAge;
+}
+
+ImmutilRtUpdater_t *immutil_rtUpdaterCreate(SaImmOiHandleT immOiHandle,
+					    size_t maxPending, SaTimeT maxAge)
+{
+	struct ImmutilRtUpdater *u = calloc(1, sizeof(struct ImmutilRtUpdater));
+	if (u == NULL)
+		immutilError("Out of memory");
+	pthread_mutex_init(&u->lock, NULL);
+	u->immOiHandle = immOiHandle;
+	u->maxPending = maxPending;
+	u->maxAge = maxAge;
+	u->arena = arenaCreate();
+	return u;
+}
+
+void immutil_rtUpdaterDelete(ImmutilRtUpdater_t *updater)
+{
+	if (updater == NULL)
+		return;
+	arenaDelete(updater->arena);
+	free(updater->table);
+	pthread_mutex_destroy(&updater->lock);
+	free(updater);
+}
+
+SaAisErrorT immutil_rtUpdaterAdd(ImmutilRtUpdater_t *updater, const char *dn,
+				 SaImmAttrNameT attributeName,
+				 SaImmValueTypeT attrValueType, void *value)
+{
+	struct ImmutilRtUpdater *u = updater;
+	SaAisErrorT rc = SA_AIS_OK;
+	struct RtObject *obj;
+	struct RtAttr *attr;
+	void *copy;
+
+	pthread_mutex_lock(&u->lock);
+	if (u->nPending == 0)
+		u->firstUpdate = monotonicTime();
+	u->stats.updates++;
+	u->nBatchUpdates++;
+
+	obj = rtObjectGet(u, dn);
+	for (attr = obj->attrs; attr != NULL; attr = attr->next) {
+		if (strcmp(attr->mod.modAttr.attrName, attributeName) == 0)
 			break;
+	}
+	if (attr != NULL) {
+		/* A REPLACE, the latest value wins */
+		u->stats.merged++;
+	} else {
+		attr = arenaMalloc(u->arena, sizeof(struct RtAttr));
+		attr->mod.modType = SA_IMM_ATTR_VALUES_REPLACE;
+		attr->mod.modAttr.attrName = dupStr(u->arena, attributeName);
+		attr->mod.modAttr.attrValuesNumber = 1;
+		attr->mod.modAttr.attrValues = &attr->value;
+		if (obj->attrsTail == NULL)
+			obj->attrs = attr;
+		else
+			obj->attrsTail->next = attr;
+		obj->attrsTail = attr;
+		obj->nAttrs++;
+		u->nPending++;
+	}
+	attr->mod.modAttr.attrValueType = attrValueType;
+	copy = arenaMalloc(u->arena, valueTypeSize(attrValueType));
+	copyValue(u->arena, attrValueType, copy, value);
+	attr->value = copy;
+
+	if ((u->maxPending > 0 && u->nPending >= u->maxPending) ||
+	    rtUpdaterExpired(u))
+		rc = rtUpdaterFlush(u);
+	pthread_mutex_unlock(&u->lock);
+	return rc;
+}
+
+SaAisErrorT immutil_rtUpdaterPoll(ImmutilRtUpdater_t *updater)
+{
+	SaAisErrorT rc = SA_AIS_OK;
+	pthread_mutex_lock(&updater->lock);
+	if (rtUpdaterExpired(updater))
+		rc = rtUpdaterFlush(updater);
+	pthread_mutex_unlock(&updater->lock);
+	return rc;
+}
+
+SaAisErrorT immutil_rtUpdaterFlush(ImmutilRtUpdater_t *updater)
+{
+	SaAisErrorT rc;
+	pthread_mutex_lock(&updater->lock);
+	rc = rtUpdaterFlush(updater);
+	pthread_mutex_unlock(&updater->lock);
+	return rc;
+}
+
+void immutil_rtUpdaterGetStats(ImmutilRtUpdater_t *updater,
+			       struct ImmutilRtUpdaterStats *stats)
+{
+	pthread_mutex_lock(&updater->lock);
+	*stats = updater->stats;
+	pthread_mutex_unlock(&updater->lock);
+}
+
+/*
+ * Class schema cache; a chained hash table on class name, protected by
+ * schemaLock. Each class holds an open-addressed table (linear probing) on
+ * attribute name, allocated in one piece with the class and the names. A
+ * class is fetched from IMM on the first lookup and kept until flushed.
+ */
+
+struct SchemaAttr {
+	SaUint64T hash;
+	const char *name;
+	SaImmValueTypeT valueType;
+	SaImmAttrFlagsT flags;
+};
+
+struct SchemaClass {
+	struct SchemaClass *next;
+	SaUint64T hash;
+	const char *name;
+	size_t mask;
+	struct SchemaAttr attrs[];
+};
+
+static pthread_rwlock_t schemaLock = PTHREAD_RWLOCK_INITIALIZER;
+static struct SchemaClass **schemaTable;
+static size_t schemaTableSize;
+static size_t schemaCount;
+
+static struct SchemaClass *schemaFind(const char *className, SaUint64T hash)
+{
+	struct SchemaClass *c;
+	if (schemaTableSize == 0)
+		return NULL;
+	for (c = schemaTable[hash & (schemaTableSize - 1)]; c != NULL;
+	     c = c->next)
+		if (c->hash == hash && strcmp(c->name, className) == 0)
+			return c;
+	return NULL;
+}
+
+static const struct SchemaAttr *schemaAttrFind(const struct SchemaClass *c,
+					       const char *attrName)
+{
+	SaUint64T hash = hashStr(attrName);
+	size_t i = hash & c->mask;
+	while (c->attrs[i].name != NULL) {
+		if (c->attrs[i].hash == hash &&
+		    strcmp(c->attrs[i].name, attrName) == 0)
+			return &c->attrs[i];
+		i = (i + 1) & c->mask;
+	}
+	return NULL;
+}
+
+static struct SchemaClass *
+schemaClassCreate(const char *className, SaUint64T hash,
+		  const SaImmAttrDefinitionT_2 **attrDefinitions)
+{
+	struct SchemaClass *c;
+	size_t i, n = 0, size = 4, nameSize = strlen(className) + 1;
+	char *names;
+
+	for (n = 0; attrDefinitions[n] != NULL; n++)
+		nameSize += strlen(attrDefinitions[n]->attrName) + 1;
+	while (size < 2 * n)
+		size *= 2;
+	c = calloc(1, sizeof(struct SchemaClass) +
+			  size * sizeof(struct SchemaAttr) + nameSize);
+	if (c == NULL)
+		immutilError("Out of memory");
+	names = (char *)&c->attrs[size];
+	c->hash = hash;
+	c->mask = size - 1;
+	c->name = strcpy(names, className);
+	names += strlen(names) + 1;
+	for (i = 0; i < n; i++) {
+		const SaImmAttrDefinitionT_2 *def = attrDefinitions[i];
+		SaUint64T h = hashStr(def->attrName);
+		size_t j = h & c->mask;
+		while (c->attrs[j].name != NULL)
+			j = (j + 1) & c->mask;
+		c->attrs[j].hash = h;
+		c->attrs[j].name = strcpy(names, def->attrName);
+		c->attrs[j].valueType = def->attrValueType;
+		c->attrs[j].flags = def->attrFlags;
+		names += strlen(names) + 1;
+	}
+	return c;
+}
+
+/* Insert a class, or return the one another thread inserted first */
+static struct SchemaClass *schemaInsert(struct SchemaClass *c)
+{
+	struct SchemaClass *old;
+	size_t i;
+
+	pthread_rwlock_wrlock(&schemaLock);
+	if ((old = schemaFind(c->name, c->hash)) != NULL) {
+		pthread_rwlock_unlock(&schemaLock);
+		free(c);
+		return old;
+	}
+	if (schemaCount >= schemaTableSize) {
+		size_t size = schemaTableSize == 0 ? 64 : 2 * schemaTableSize;
+		struct SchemaClass **table = calloc(size, sizeof(*table));
+		if (table == NULL)
+			immutilError("Out of memory");
+		for (i = 0; i < schemaTableSize; i++) {
+			while ((old = schemaTable[i]) != NULL) {
+				schemaTable[i] = old->next;
+				old->next = table[old->hash & (size - 1)];
+				table[old->hash & (size - 1)] = old;
+			}
 		}
+		free(schemaTable);
+		schemaTable = table;
+		schemaTableSize = size;
 	}
+	i = c->hash & (schemaTableSize - 1);
+	c->next = schemaTable[i];
+	schemaTable[i] = c;
+	schemaCount++;
+	pthread_rwlock_unlock(&schemaLock);
+	return c;
+}
 
-	(void)saImmOmClassDescriptionMemoryFree_2(omHandle, attrDefinitions);
+/* Fetch a class description from IMM and cache it */
+static SaAisErrorT schemaLoad(const char *className, SaUint64T hash)
+{
+	SaAisErrorT rc;
+	SaImmHandleT omHandle;
+	SaImmClassCategoryT classCategory;
+	SaImmAttrDefinitionT_2 **attrDefinitions;
 
-done:
+	if ((rc = immutil_saImmOmInitialize(&omHandle, NULL, &immVersion)) !=
+	    SA_AIS_OK)
+		return rc;
+	if ((rc = saImmOmClassDescriptionGet_2(omHandle,
+					       (SaImmClassNameT)className,
+					       &classCategory,
+					       &attrDefinitions)) == SA_AIS_OK) {
+		schemaInsert(schemaClassCreate(
+		    className, hash,
+		    (const SaImmAttrDefinitionT_2 **)attrDefinitions));
+		(void)saImmOmClassDescriptionMemoryFree_2(omHandle,
+							  attrDefinitions);
+	}
 	(void)immutil_saImmOmFinalize(omHandle);
 	return rc;
 }
 
+SaAisErrorT immutil_get_attrDefinition(const SaImmClassNameT className,
+				       SaImmAttrNameT attrName,
+				       SaImmValueTypeT *attrValueType,
+				       SaImmAttrFlagsT *attrFlags)
+{
+	SaUint64T hash = hashStr(className);
+	const struct SchemaClass *c;
+	const struct SchemaAttr *attr;
+	SaAisErrorT rc = SA_AIS_OK;
+
+	for (;;) {
+		pthread_rwlock_rdlock(&schemaLock);
+		if ((c = schemaFind(className, hash)) != NULL)
+			break;
+		pthread_rwlock_unlock(&schemaLock);
+		if ((rc = schemaLoad(className, hash)) != SA_AIS_OK)
+			return rc;
+	}
+	if ((attr = schemaAttrFind(c, attrName)) == NULL) {
+		rc = SA_AIS_ERR_INVALID_PARAM;
+	} else {
+		if (attrValueType != NULL)
+			*attrValueType = attr->valueType;
+		if (attrFlags != NULL)
+			*attrFlags = attr->flags;
+	}
+	pthread_rwlock_unlock(&schemaLock);
+	return rc;
+}
+
+void immutil_schemaCacheFlush(const SaImmClassNameT className)
+{
+	struct SchemaClass *c, **pp;
+	size_t i;
+
+	pthread_rwlock_wrlock(&schemaLock);
+	for (i = 0; i < schemaTableSize; i++) {
+		pp = &schemaTable[i];
+		while ((c = *pp) != NULL) {
+			if (className == NULL ||
+			    strcmp(c->name, className) == 0) {
+				*pp = c->next;
+				free(c);
+				schemaCount--;
+			} else {
+				pp = &c->next;
+			}
+		}
+	}
+	pthread_rwlock_unlock(&schemaLock);
+}
+
+SaImmClassNameT immutil_get_className(const SaNameT *objectName)
+{
+	return classNameGet(0, objectName);
+}
+
+SaAisErrorT immutil_get_attrValueType(const SaImmClassNameT className,
+				      SaImmAttrNameT attrName,
+				      SaImmValueTypeT *attrValueType)
+{
+	return immutil_get_attrDefinition(className, attrName, attrValueType,
+					  NULL);
+}
+
 void *immutil_new_attrValue(SaImmValueTypeT attrValueType, const char *str)
 {
 	void *attrValue = NULL;
@@ -816,40 +2236,297 @@ void *immutil_new_attrValue(SaImmValueTypeT attrValueType, const char *str)
 	return attrValue;
 }
 
+/*
+ * Bulk value parsing. The values are stored in one block:
+ *
+ *   SaImmAttrValueT[n]		pointers to the values
+ *   values, 8-byte aligned	the SaImmValueTypeT C types
+ *   data			strings, long names and SaAnyT buffers
+ */
+
+/* Hex digit value + 1, 0 for non hex characters */
+static const unsigned char hexTable[256] = {
+    ['0'] = 1,	['1'] = 2,  ['2'] = 3,	['3'] = 4,  ['4'] = 5,	['5'] = 6,
+    ['6'] = 7,	['7'] = 8,  ['8'] = 9,	['9'] = 10, ['a'] = 11, ['b'] = 12,
+    ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16, ['A'] = 11, ['B'] = 12,
+    ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16};
+
+/**
+ * Decode hex digits to bytes, an odd number of digits is padded with a '0'.
+ * Return false if str contains a non hex character.
+ */
+static bool hexDecode(SaUint8T *dest, const char *str, size_t len)
+{
+	const unsigned char *s = (const unsigned char *)str;
+	unsigned char bad = 0;
+	size_t i;
+
+	for (i = 0; i + 1 < len; i += 2) {
+		unsigned char hi = hexTable[s[i]], lo = hexTable[s[i + 1]];
+		bad |= (hi == 0) | (lo == 0);
+		*dest++ = ((hi - 1) & 0xf) << 4 | ((lo - 1) & 0xf);
+	}
+	if (i < len) {
+		unsigned char hi = hexTable[s[i]];
+		bad |= hi == 0;
+		*dest = ((hi - 1) & 0xf) << 4;
+	}
+	return bad == 0;
+}
+
+/**
+ * Parse a decimal integer without leading zeros or white space, the common
+ * case. Return false if str has any other format; the caller then falls back
+ * to strtoll/strtoull which handle all formats.
+ */
+static bool parseDecimal(const char *str, bool isSigned, SaUint64T *magnitude,
+			 bool *negative)
+{
+	const char *p = str;
+	SaUint64T value = 0;
+
+	*negative = false;
+	if (*p == '-') {
+		if (!isSigned)
+			return false;
+		*negative = true;
+		p++;
+	}
+	if (p[0] == '0' && p[1] == '\0') {
+		*magnitude = 0;
+		return true;
+	}
+	if (*p < '1' || *p > '9')
+		return false;
+	while (*p >= '0' && *p <= '9') {
+		SaUint64T digit = *p++ - '0';
+		if (value > (UINT64_MAX - digit) / 10)
+			return false; /* Overflow, let strto* report it */
+		value = value * 10 + digit;
+	}
+	if (*p != '\0')
+		return false;
+	*magnitude = value;
+	return true;
+}
+
+static int parseInt64(const char *str, SaInt64T min, SaInt64T max,
+		      SaInt64T *result)
+{
+	SaUint64T magnitude;
+	bool negative;
+	long long value;
+	char *endptr;
+
+	if (parseDecimal(str, true, &magnitude, &negative)) {
+		if (magnitude > (SaUint64T)max + negative)
+			return ERANGE;
+		value = negative ? (long long)(0 - magnitude) : (long long)magnitude;
+	} else {
+		errno = 0;
+		value = strtoll(str, &endptr, 0);
+		if (endptr == str || *endptr != '\0')
+			return EINVAL;
+		if (errno != 0)
+			return errno;
+	}
+	if (value < min || value > max)
+		return ERANGE;
+	*result = value;
+	return 0;
+}
+
+static int parseUint64(const char *str, SaUint64T max, SaUint64T *result)
+{
+	SaUint64T value;
+	bool negative;
+	char *endptr;
+
+	if (!parseDecimal(str, false, &value, &negative)) {
+		errno = 0;
+		value = strtoull(str, &endptr, 0);
+		if (endptr == str || *endptr != '\0')
+			return EINVAL;
+		if (errno != 0)
+			return errno;
+	}
+	if (value > max)
+		return ERANGE;
+	*result = value;
+	return 0;
+}
+
+static int parseValue(SaImmValueTypeT valueType, const char *str, void *value,
+		      char **data)
+{
+	SaInt64T i64;
+	SaUint64T u64;
+	char *endptr;
+	size_t len;
+	int err;
+
+	switch (valueType) {
+	case SA_IMM_ATTR_SAINT32T:
+		if ((err = parseInt64(str, INT32_MIN, INT32_MAX, &i64)) == 0)
+			*(SaInt32T *)value = i64;
+		return err;
+	case SA_IMM_ATTR_SAUINT32T:
+		if ((err = parseUint64(str, UINT32_MAX, &u64)) == 0)
+			*(SaUint32T *)value = u64;
+		return err;
+	case SA_IMM_ATTR_SAINT64T:
+	case SA_IMM_ATTR_SATIMET:
+		if ((err = parseInt64(str, INT64_MIN, INT64_MAX, &i64)) == 0)
+			*(SaInt64T *)value = i64;
+		return err;
+	case SA_IMM_ATTR_SAUINT64T:
+		if ((err = parseUint64(str, UINT64_MAX, &u64)) == 0)
+			*(SaUint64T *)value = u64;
+		return err;
+	case SA_IMM_ATTR_SAFLOATT:
+		errno = 0;
+		*(SaFloatT *)value = strtof(str, &endptr);
+		if (endptr == str || *endptr != '\0')
+			return EINVAL;
+		return errno == ERANGE ? ERANGE : 0;
+	case SA_IMM_ATTR_SADOUBLET:
+		errno = 0;
+		*(SaDoubleT *)value = strtod(str, &endptr);
+		if (endptr == str || *endptr != '\0')
+			return EINVAL;
+		return errno == ERANGE ? ERANGE : 0;
+	case SA_IMM_ATTR_SANAMET:
+		len = strlen(str);
+		if (len < SA_MAX_UNEXTENDED_NAME_LENGTH) {
+			saAisNameLend(str, (SaNameT *)value);
+		} else {
+			memcpy(*data, str, len + 1);
+			saAisNameLend(*data, (SaNameT *)value);
+			*data += len + 1;
+		}
+		return 0;
+	case SA_IMM_ATTR_SASTRINGT:
+		len = strlen(str) + 1;
+		memcpy(*data, str, len);
+		*(SaStringT *)value = *data;
+		*data += len;
+		return 0;
+	case SA_IMM_ATTR_SAANYT: {
+		SaAnyT *any = value;
+		len = strlen(str);
+		any->bufferSize = (len + 1) / 2;
+		any->bufferAddr = any->bufferSize > 0 ? (SaUint8T *)*data : NULL;
+		*data += any->bufferSize;
+		return hexDecode(any->bufferAddr, str, len) ? 0 : EINVAL;
+	}
+	}
+	return EINVAL;
+}
+
+/* Size of the data part of a value */
+static size_t valueDataSize(SaImmValueTypeT valueType, const char *str)
+{
+	size_t len;
+	switch (valueType) {
+	case SA_IMM_ATTR_SANAMET:
+		len = strlen(str);
+		return len < SA_MAX_UNEXTENDED_NAME_LENGTH ? 0 : len + 1;
+	case SA_IMM_ATTR_SASTRINGT:
+		return strlen(str) + 1;
+	case SA_IMM_ATTR_SAANYT:
+		return (strlen(str) + 1) / 2;
+	default:
+		return 0;
+	}
+}
+
+size_t immutil_parse_attrValues(SaImmValueTypeT attrValueType,
+				const char *const *strs, size_t n, void *buf,
+				size_t size, int *errors)
+{
+	size_t i, stride = (valueTypeSize(attrValueType) + 7) & ~(size_t)7;
+	size_t need = n * (sizeof(SaImmAttrValueT) + stride);
+	SaImmAttrValueT *values = buf;
+	unsigned char *value;
+	char *data;
+	int failed = 0;
+
+	if (stride == 0)
+		return 0;
+	for (i = 0; i < n; i++)
+		need += valueDataSize(attrValueType, strs[i]);
+	if (need > size)
+		return need;
+
+	value = (unsigned char *)&values[n];
+	data = (char *)value + n * stride;
+	for (i = 0; i < n; i++, value += stride) {
+		int err = parseValue(attrValueType, strs[i], value, &data);
+		values[i] = err == 0 ? value : NULL;
+		if (errors != NULL)
+			errors[i] = err;
+		failed |= err;
+	}
+	if (failed != 0 && errors == NULL)
+		return 0;
+	return need;
+}
+
+SaImmAttrValueT *immutil_new_attrValues(SaImmValueTypeT attrValueType,
+					const char *const *strs, size_t n,
+					int *errors)
+{
+	size_t size = immutil_parse_attrValues(attrValueType, strs, n, NULL, 0,
+					       NULL);
+	void *buf;
+
+	if (size == 0)
+		return NULL;
+	buf = malloc(size);
+	if (buf == NULL)
+		immutilError("Out of memory");
+	if (immutil_parse_attrValues(attrValueType, strs, n, buf, size,
+				     errors) == 0) {
+		free(buf);
+		return NULL;
+	}
+	return buf;
+}
+
 /* ----------------------------------------------------------------------
  * SA-item duplicate functions
  */
 
-static char *dupStr(struct Chunk *clist, const char *original)
+static char *dupStr(struct Arena *arena, const char *original)
 {
 	unsigned int len;
 	if (original == NULL)
 		return NULL;
 	len = strlen(original) + 1;
-	SaImmClassNameT copy = (SaImmClassNameT)clistMalloc(clist, len);
+	SaImmClassNameT copy = (SaImmClassNameT)arenaMalloc(arena, len);
 	memcpy(copy, original, len);
 	return copy;
 }
 
-static const SaNameT *dupSaNameT(struct Chunk *clist, const SaNameT *original)
+static const SaNameT *dupSaNameT(struct Arena *arena, const SaNameT *original)
 {
 	SaNameT *copy;
 	if (original == NULL)
 		return NULL;
 	const char *value = saAisNameBorrow(original);
 	assert(value != NULL);
-	copy = (SaNameT *)clistMalloc(clist, sizeof(SaNameT));
+	copy = (SaNameT *)arenaMalloc(arena, sizeof(SaNameT));
 	saAisNameLend(strlen(value) < SA_MAX_UNEXTENDED_NAME_LENGTH
 			  ? value
-			  : dupStr(clist, value),
+			  : dupStr(arena, value),
 		      copy);
 	return copy;
 }
 
-static SaImmClassNameT dupSaImmClassNameT(struct Chunk *clist,
+static SaImmClassNameT dupSaImmClassNameT(struct Arena *arena,
 					  const SaImmClassNameT original)
 {
-	return dupStr(clist, (const char *)original);
+	return dupStr(arena, (const char *)original);
 }
 
 /*
@@ -872,110 +2549,110 @@ static SaImmClassNameT dupSaImmClassNameT(struct Chunk *clist,
  *
  */
 
-static void copySaImmAttrValuesT(struct Chunk *clist, SaImmAttrValuesT_2 *copy,
-				 const SaImmAttrValuesT_2 *original)
+static size_t valueTypeSize(SaImmValueTypeT valueType)
 {
-	size_t valueSize = 0;
-	unsigned int i, valueCount = original->attrValuesNumber;
-	char *databuffer;
-	copy->attrName = dupStr(clist, (const char *)original->attrName);
-	copy->attrValuesNumber = valueCount;
-	copy->attrValueType = original->attrValueType;
-	if (valueCount == 0)
-		return; /* (just in case...) */
-	copy->attrValues =
-	    clistMalloc(clist, valueCount * sizeof(SaImmAttrValueT));
-
-	switch (original->attrValueType) {
+	switch (valueType) {
 	case SA_IMM_ATTR_SAINT32T:
-		valueSize = sizeof(SaInt32T);
-		break;
+		return sizeof(SaInt32T);
 	case SA_IMM_ATTR_SAUINT32T:
-		valueSize = sizeof(SaUint32T);
-		break;
+		return sizeof(SaUint32T);
 	case SA_IMM_ATTR_SAINT64T:
-		valueSize = sizeof(SaInt64T);
-		break;
+		return sizeof(SaInt64T);
 	case SA_IMM_ATTR_SAUINT64T:
-		valueSize = sizeof(SaUint64T);
-		break;
+		return sizeof(SaUint64T);
 	case SA_IMM_ATTR_SATIMET:
-		valueSize = sizeof(SaTimeT);
-		break;
+		return sizeof(SaTimeT);
 	case SA_IMM_ATTR_SANAMET:
-		valueSize = sizeof(SaNameT);
-		break;
+		return sizeof(SaNameT);
 	case SA_IMM_ATTR_SAFLOATT:
-		valueSize = sizeof(SaFloatT);
-		break;
+		return sizeof(SaFloatT);
 	case SA_IMM_ATTR_SADOUBLET:
-		valueSize = sizeof(SaDoubleT);
-		break;
+		return sizeof(SaDoubleT);
 	case SA_IMM_ATTR_SASTRINGT:
-		valueSize = sizeof(SaStringT);
-		break;
+		return sizeof(SaStringT);
 	case SA_IMM_ATTR_SAANYT:
-		valueSize = sizeof(SaAnyT);
-		break;
+		return sizeof(SaAnyT);
+	}
+	return 0;
+}
+
+/* Deep copy one value of the passed type to dest */
+static void copyValue(struct Arena *arena, SaImmValueTypeT valueType,
+		      void *dest, const void *original)
+{
+	if (valueType == SA_IMM_ATTR_SASTRINGT) {
+		char *cporig = *((char **)original);
+		char **cpp = (char **)dest;
+		*cpp = dupStr(arena, cporig);
+	} else if (valueType == SA_IMM_ATTR_SANAMET) {
+		const char *value = saAisNameBorrow((const SaNameT *)original);
+		assert(value != NULL);
+		saAisNameLend(strlen(value) < SA_MAX_UNEXTENDED_NAME_LENGTH
+				  ? value
+				  : dupStr(arena, value),
+			      (SaNameT *)dest);
+	} else if (valueType == SA_IMM_ATTR_SAANYT) {
+		const SaAnyT *cporig = (const SaAnyT *)original;
+		SaAnyT *cpdest = (SaAnyT *)dest;
+		cpdest->bufferSize = cporig->bufferSize;
+		if (cpdest->bufferSize) {
+			cpdest->bufferAddr =
+			    arenaMalloc(arena, cpdest->bufferSize);
+			memcpy(cpdest->bufferAddr, cporig->bufferAddr,
+			       cpdest->bufferSize);
+		}
+	} else {
+		memcpy(dest, original, valueTypeSize(valueType));
 	}
+}
+
+static void copySaImmAttrValuesT(struct Arena *arena, SaImmAttrValuesT_2 *copy,
+				 const SaImmAttrValuesT_2 *original)
+{
+	size_t valueSize;
+	unsigned int i, valueCount = original->attrValuesNumber;
+	char *databuffer;
+	copy->attrName = dupStr(arena, (const char *)original->attrName);
+	copy->attrValuesNumber = valueCount;
+	copy->attrValueType = original->attrValueType;
+	if (valueCount == 0)
+		return; /* (just in case...) */
+	copy->attrValues =
+	    arenaMalloc(arena, valueCount * sizeof(SaImmAttrValueT));
+	valueSize = valueTypeSize(original->attrValueType);
 
-	databuffer = (char *)clistMalloc(clist, valueCount * valueSize);
+	databuffer = (char *)arenaMalloc(arena, valueCount * valueSize);
 	for (i = 0; i < valueCount; i++) {
 		copy->attrValues[i] = databuffer;
-		if (original->attrValueType == SA_IMM_ATTR_SASTRINGT) {
-			char *cporig = *((char **)original->attrValues[i]);
-			char **cpp = (char **)databuffer;
-			*cpp = dupStr(clist, cporig);
-		} else if (original->attrValueType == SA_IMM_ATTR_SANAMET) {
-			SaNameT *cporig = (SaNameT *)original->attrValues[i];
-			SaNameT *cpdest = (SaNameT *)copy->attrValues[i];
-			const char *value = saAisNameBorrow(cporig);
-			assert(value != NULL);
-			saAisNameLend(strlen(value) <
-					      SA_MAX_UNEXTENDED_NAME_LENGTH
-					  ? value
-					  : dupStr(clist, value),
-				      cpdest);
-		} else if (original->attrValueType == SA_IMM_ATTR_SAANYT) {
-			SaAnyT *cporig = (SaAnyT *)original->attrValues[i];
-			SaAnyT *cpdest = (SaAnyT *)copy->attrValues[i];
-			cpdest->bufferSize = cporig->bufferSize;
-			if (cpdest->bufferSize) {
-				cpdest->bufferAddr =
-				    clistMalloc(clist, cpdest->bufferSize);
-				memcpy(cpdest->bufferAddr, cporig->bufferAddr,
-				       cpdest->bufferSize);
-			}
-		} else {
-			memcpy(databuffer, original->attrValues[i], valueSize);
-		}
+		copyValue(arena, original->attrValueType, databuffer,
+			  original->attrValues[i]);
 		databuffer += valueSize;
 	}
 }
 
 static const SaImmAttrValuesT_2 *
-dupSaImmAttrValuesT(struct Chunk *clist, const SaImmAttrValuesT_2 *original)
+dupSaImmAttrValuesT(struct Arena *arena, const SaImmAttrValuesT_2 *original)
 {
-	SaImmAttrValuesT_2 *copy = (SaImmAttrValuesT_2 *)clistMalloc(
-	    clist, sizeof(SaImmAttrValuesT_2));
-	copySaImmAttrValuesT(clist, copy, original);
+	SaImmAttrValuesT_2 *copy = (SaImmAttrValuesT_2 *)arenaMalloc(
+	    arena, sizeof(SaImmAttrValuesT_2));
+	copySaImmAttrValuesT(arena, copy, original);
 	return copy;
 }
 
 static const SaImmAttrModificationT_2 *
-dupSaImmAttrModificationT(struct Chunk *clist,
+dupSaImmAttrModificationT(struct Arena *arena,
 			  const SaImmAttrModificationT_2 *original)
 {
 	SaImmAttrModificationT_2 *copy =
-	    (SaImmAttrModificationT_2 *)clistMalloc(
-		clist, sizeof(SaImmAttrModificationT_2));
+	    (SaImmAttrModificationT_2 *)arenaMalloc(
+		arena, sizeof(SaImmAttrModificationT_2));
 	copy->modType = original->modType;
-	copySaImmAttrValuesT(clist, &(copy->modAttr), &(original->modAttr));
+	copySaImmAttrValuesT(arena, &(copy->modAttr), &(original->modAttr));
 	return copy;
 }
 
 static const SaImmAttrValuesT_2 **
-dupSaImmAttrValuesT_array(struct Chunk *clist,
+dupSaImmAttrValuesT_array(struct Arena *arena,
 			  const SaImmAttrValuesT_2 **original)
 {
 	const SaImmAttrValuesT_2 **copy;
@@ -984,16 +2661,16 @@ dupSaImmAttrValuesT_array(struct Chunk *clist,
 		return NULL;
 	while (original[alen] != NULL)
 		alen++;
-	copy = (const SaImmAttrValuesT_2 **)clistMalloc(
-	    clist, (alen + 1) * sizeof(SaImmAttrValuesT_2 *));
+	copy = (const SaImmAttrValuesT_2 **)arenaMalloc(
+	    arena, (alen + 1) * sizeof(SaImmAttrValuesT_2 *));
 	for (i = 0; i < alen; i++) {
-		copy[i] = dupSaImmAttrValuesT(clist, original[i]);
+		copy[i] = dupSaImmAttrValuesT(arena, original[i]);
 	}
 	return copy;
 }
 
 static const SaImmAttrModificationT_2 **
-dupSaImmAttrModificationT_array(struct Chunk *clist,
+dupSaImmAttrModificationT_array(struct Arena *arena,
 				const SaImmAttrModificationT_2 **original)
 {
 	const SaImmAttrModificationT_2 **copy;
@@ -1002,1606 +2679,6507 @@ dupSaImmAttrModificationT_array(struct Chunk *clist,
 		return NULL;
 	while (original[alen] != NULL)
 		alen++;
-	copy = (const SaImmAttrModificationT_2 **)clistMalloc(
-	    clist, (alen + 1) * sizeof(SaImmAttrModificationT_2 *));
+	copy = (const SaImmAttrModificationT_2 **)arenaMalloc(
+	    arena, (alen + 1) * sizeof(SaImmAttrModificationT_2 *));
 	for (i = 0; i < alen; i++) {
-		copy[i] = dupSaImmAttrModificationT(clist, original[i]);
+		copy[i] = dupSaImmAttrModificationT(arena, original[i]);
 	}
 	return copy;
 }
 
 /* ----------------------------------------------------------------------
- * Memory handling
+ * Modify coalescing
+ *
+ * When enabled, a modify of an object whose latest operation in the CCB is a
+ * modify is merged into that operation. The merged operation holds the net
+ * effect per attribute, either one REPLACE or a DELETE followed by an ADD:
+ *
+ *   REPLACE(V)             any earlier state      -> REPLACE(V)
+ *   ADD(a)                 REPLACE(V)             -> REPLACE(V + a)
+ *   DELETE(d)              REPLACE(V)             -> REPLACE(V - d)
+ *   ADD(a)                 DELETE(D), ADD(A)      -> DELETE(D), ADD(A + a)
+ *   DELETE(d)              DELETE(D), ADD(A)      -> DELETE(D + d), ADD(A - d)
+ *
+ * An ADD followed by a DELETE of the same value thus cancels in the ADD set.
+ * The DELETE is kept since the value may have been present before the CCB.
  */
 
-struct Chunk {
-	struct Chunk *next;
-	unsigned int capacity;
-	unsigned int free;
-	unsigned char data[1];
+/* A growable set of values, in the SaImmAttrValueT array format */
+struct ValueSet {
+	SaImmAttrValueT *values;
+	SaUint32T n;
+	SaUint32T cap;
 };
 
-static struct Chunk *newChunk(struct Chunk *next, size_t size)
+/* Net modification of one attribute */
+struct NetMod {
+	SaImmAttrNameT attrName;
+	SaImmValueTypeT valueType;
+	bool replace;
+	struct ValueSet del; /* The REPLACE values if replace is set */
+	struct ValueSet add;
+};
+
+/* Net modification of an object, hangs off the merged operation */
+struct NetModify {
+	struct NetMod **attrs;
+	size_t n;
+	size_t cap;
+};
+
+static bool valueEqual(SaImmValueTypeT valueType, const void *a, const void *b)
 {
-	struct Chunk *chunk =
-	    (struct Chunk *)malloc(sizeof(struct Chunk) + size);
-	if (chunk == NULL)
-		immutilError("Out of memory");
-	chunk->next = next;
-	chunk->capacity = size;
-	chunk->free = size;
-	return chunk;
+	switch (valueType) {
+	case SA_IMM_ATTR_SASTRINGT: {
+		const char *sa = *(char *const *)a;
+		const char *sb = *(char *const *)b;
+		if (sa == NULL || sb == NULL)
+			return sa == sb;
+		return strcmp(sa, sb) == 0;
+	}
+	case SA_IMM_ATTR_SANAMET:
+		return strcmp(saAisNameBorrow((const SaNameT *)a),
+			      saAisNameBorrow((const SaNameT *)b)) == 0;
+	case SA_IMM_ATTR_SAANYT: {
+		const SaAnyT *aa = (const SaAnyT *)a;
+		const SaAnyT *ab = (const SaAnyT *)b;
+		return aa->bufferSize == ab->bufferSize &&
+		       (aa->bufferSize == 0 ||
+			memcmp(aa->bufferAddr, ab->bufferAddr,
+			       aa->bufferSize) == 0);
+	}
+	case SA_IMM_ATTR_SAFLOATT:
+		return *(const SaFloatT *)a == *(const SaFloatT *)b;
+	case SA_IMM_ATTR_SADOUBLET:
+		return *(const SaDoubleT *)a == *(const SaDoubleT *)b;
+	default:
+		return memcmp(a, b, valueTypeSize(valueType)) == 0;
+	}
+}
+
+static void valueSetAppend(struct Arena *arena, struct ValueSet *set,
+			   SaImmValueTypeT valueType, const void *value)
+{
+	void *copy;
+	if (set->n == set->cap) {
+		/* The old array is left in the arena */
+		SaUint32T cap = set->cap == 0 ? 4 : 2 * set->cap;
+		SaImmAttrValueT *values =
+		    arenaMalloc(arena, cap * sizeof(SaImmAttrValueT));
+		if (set->n > 0)
+			memcpy(values, set->values,
+			       set->n * sizeof(SaImmAttrValueT));
+		set->values = values;
+		set->cap = cap;
+	}
+	copy = arenaMalloc(arena, valueTypeSize(valueType));
+	copyValue(arena, valueType, copy, value);
+	set->values[set->n++] = copy;
+}
+
+static bool valueSetContains(const struct ValueSet *set,
+			     SaImmValueTypeT valueType, const void *value)
+{
+	SaUint32T i;
+	for (i = 0; i < set->n; i++) {
+		if (valueEqual(valueType, set->values[i], value))
+			return true;
+	}
+	return false;
+}
+
+/* Remove all occurrences of value from the set */
+static void valueSetRemove(struct ValueSet *set, SaImmValueTypeT valueType,
+			   const void *value)
+{
+	SaUint32T i, j = 0;
+	for (i = 0; i < set->n; i++) {
+		if (!valueEqual(valueType, set->values[i], value))
+			set->values[j++] = set->values[i];
+	}
+	set->n = j;
+}
+
+/**
+ * Get the net modification of an attribute. A new one starts as a REPLACE
+ * with no values if replace is set, which is the state of an attribute of an
+ * object created in the same CCB.
+ */
+static struct NetMod *netModFind(const struct NetModify *net,
+				 const char *attrName)
+{
+	size_t i;
+
+	for (i = 0; i < net->n; i++) {
+		if (strcmp(net->attrs[i]->attrName, attrName) == 0)
+			return net->attrs[i];
+	}
+	return NULL;
+}
+
+static struct NetMod *netModGet(struct Arena *arena, struct NetModify *net,
+				const SaImmAttrValuesT_2 *attr, bool replace)
+{
+	struct NetMod *mod = netModFind(net, attr->attrName);
+
+	if (mod != NULL)
+		return mod;
+	if (net->n == net->cap) {
+		size_t cap = net->cap == 0 ? 8 : 2 * net->cap;
+		struct NetMod **attrs =
+		    arenaMalloc(arena, cap * sizeof(struct NetMod *));
+		if (net->n > 0)
+			memcpy(attrs, net->attrs,
+			       net->n * sizeof(struct NetMod *));
+		net->attrs = attrs;
+		net->cap = cap;
+	}
+	mod = arenaMalloc(arena, sizeof(struct NetMod));
+	mod->attrName = dupStr(arena, attr->attrName);
+	mod->valueType = attr->attrValueType;
+	mod->replace = replace;
+	net->attrs[net->n++] = mod;
+	return mod;
+}
+
+static void netModApply(struct Arena *arena, struct NetModify *net,
+			const SaImmAttrModificationT_2 *attrMod, bool replace)
+{
+	const SaImmAttrValuesT_2 *attr = &attrMod->modAttr;
+	struct NetMod *mod = netModGet(arena, net, attr, replace);
+	SaUint32T i;
+
+	switch (attrMod->modType) {
+	case SA_IMM_ATTR_VALUES_REPLACE:
+		mod->replace = true;
+		mod->del.n = 0;
+		mod->add.n = 0;
+		for (i = 0; i < attr->attrValuesNumber; i++)
+			valueSetAppend(arena, &mod->del, mod->valueType,
+				       attr->attrValues[i]);
+		break;
+	case SA_IMM_ATTR_VALUES_ADD:
+		for (i = 0; i < attr->attrValuesNumber; i++)
+			valueSetAppend(arena,
+				       mod->replace ? &mod->del : &mod->add,
+				       mod->valueType, attr->attrValues[i]);
+		break;
+	case SA_IMM_ATTR_VALUES_DELETE:
+		for (i = 0; i < attr->attrValuesNumber; i++) {
+			const void *value = attr->attrValues[i];
+			if (mod->replace) {
+				valueSetRemove(&mod->del, mod->valueType,
+					       value);
+				continue;
+			}
+			valueSetRemove(&mod->add, mod->valueType, value);
+			if (!valueSetContains(&mod->del, mod->valueType, value))
+				valueSetAppend(arena, &mod->del, mod->valueType,
+					       value);
+		}
+		break;
+	default:
+		immutilError("Invalid modType %d", (int)attrMod->modType);
+	}
+}
+
+/*
+ * Set out to modType with a copy of the values in set, so the published
+ * modification is not changed when the set is.
+ */
+static void setNetModAttr(struct Arena *arena, struct NetMod *mod,
+			  SaImmAttrModificationT_2 *out,
+			  SaImmAttrModificationTypeT modType,
+			  const struct ValueSet *set)
+{
+	SaImmAttrValueT *values = NULL;
+
+	if (set->n > 0) {
+		values = arenaMalloc(arena, set->n * sizeof(SaImmAttrValueT));
+		memcpy(values, set->values, set->n * sizeof(SaImmAttrValueT));
+	}
+	out->modType = modType;
+	out->modAttr.attrName = mod->attrName;
+	out->modAttr.attrValueType = mod->valueType;
+	out->modAttr.attrValuesNumber = set->n;
+	out->modAttr.attrValues = values;
+}
+
+/*
+ * Build a new modification array from the net modification. Arrays built
+ * earlier are left untouched in the arena, a reader that loaded one of them
+ * before a merge can still use it.
+ */
+static const SaImmAttrModificationT_2 **netModBuild(struct Arena *arena,
+						   struct NetModify *net)
+{
+	const SaImmAttrModificationT_2 **attrMods;
+	SaImmAttrModificationT_2 *mods;
+	size_t i, n = 0;
+
+	attrMods = arenaMalloc(arena, (2 * net->n + 1) *
+					  sizeof(SaImmAttrModificationT_2 *));
+	mods = arenaMalloc(arena,
+			   (2 * net->n + 1) * sizeof(SaImmAttrModificationT_2));
+	for (i = 0; i < net->n; i++) {
+		struct NetMod *mod = net->attrs[i];
+		if (mod->replace) {
+			setNetModAttr(arena, mod, &mods[n],
+				      SA_IMM_ATTR_VALUES_REPLACE, &mod->del);
+			attrMods[n] = &mods[n];
+			n++;
+			continue;
+		}
+		if (mod->del.n > 0) {
+			setNetModAttr(arena, mod, &mods[n],
+				      SA_IMM_ATTR_VALUES_DELETE, &mod->del);
+			attrMods[n] = &mods[n];
+			n++;
+		}
+		if (mod->add.n > 0) {
+			setNetModAttr(arena, mod, &mods[n],
+				      SA_IMM_ATTR_VALUES_ADD, &mod->add);
+			attrMods[n] = &mods[n];
+			n++;
+		}
+	}
+	attrMods[n] = NULL;
+	return attrMods;
+}
+
+/**
+ * Merge attrMods into the modify operation opp. Must be called with the CCB
+ * lock held.
+ */
+static void coalesceModify(struct CcbUtilCcbData *ccb,
+			   struct OperationPriv *opp, const char *objectName,
+			   const SaImmAttrModificationT_2 **attrMods)
+{
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	const SaImmAttrModificationT_2 **merged;
+	struct NetModify *net = opp->net;
+
+	if (net == NULL) {
+		const SaImmAttrModificationT_2 **seed =
+		    opp->op.param.modify.attrMods;
+		net = arenaMalloc(arena, sizeof(struct NetModify));
+		for (; seed != NULL && *seed != NULL; seed++)
+			netModApply(arena, net, *seed, false);
+		opp->net = net;
+	}
+	for (; attrMods != NULL && *attrMods != NULL; attrMods++)
+		netModApply(arena, net, *attrMods, false);
+
+	merged = netModBuild(arena, net);
+	if (opp->packed != NULL)
+		captureOperation(ccb, &opp->op, objectName, NULL, NULL, NULL,
+				 merged);
+	else
+		__atomic_store_n(&opp->op.param.modify.attrMods, merged,
+				 __ATOMIC_RELEASE);
+}
+
+void ccbutil_setModifyCoalescing(bool enable)
+{
+	__atomic_store_n(&coalesceMode, enable, __ATOMIC_RELAXED);
+}
+
+/* ----------------------------------------------------------------------
+ * Flat operation serialization
+ *
+ * A packed operation is one contiguous buffer where all references are byte
+ * offsets from the start of the buffer (0 means none), so it can be copied,
+ * written to disk or sent on a socket as is. Numbers are in host byte order.
+ * Value arrays are 8-byte aligned relative to the start of the buffer and the
+ * total size is a multiple of 8, so packed operations can be concatenated.
+ *
+ *   PackedOpHeader
+ *   PackedAttr[nAttrs]
+ *   attribute names, value arrays and string data
+ *
+ * Fixed size values are stored as an array of the C type. SaStringT and
+ * SaNameT values are stored as an array of offsets to NUL terminated
+ * strings, SaAnyT values as an array of PackedAny.
+ */
+
+#define PACKED_MAGIC 0x50424343 /* "CCBP" */
+#define PACKED_VERSION 1
+
+struct PackedOpHeader {
+	SaUint32T magic;
+	SaUint16T version;
+	SaUint16T operationType;
+	SaUint32T size;
+	SaUint32T nAttrs;
+	SaUint64T ccbId;
+	SaUint32T objectName;
+	SaUint32T className;
+	SaUint32T parentName;
+	SaUint32T attrs;
+};
+
+struct PackedAttr {
+	SaUint32T name;
+	SaUint32T valueType;
+	SaUint32T modType; /* 0 for the attributes of a create */
+	SaUint32T nValues;
+	SaUint32T values;
+	SaUint32T reserved;
+};
+
+struct PackedAny {
+	SaUint32T data;
+	SaUint32T size;
+};
+
+/* The writer only stores data that fits in the buffer but always advances,
+   so a single pass both packs and computes the required size. */
+struct PackWriter {
+	unsigned char *buf;
+	size_t size;
+	size_t pos;
+};
+
+static SaUint32T packReserve(struct PackWriter *w, size_t len, size_t align)
+{
+	size_t off = (w->pos + align - 1) & ~(align - 1);
+	w->pos = off + len;
+	return (SaUint32T)off;
+}
+
+static void *packAt(struct PackWriter *w, SaUint32T off, size_t len)
+{
+	if (off + len > w->size)
+		return NULL;
+	return w->buf + off;
+}
+
+static SaUint32T packBytes(struct PackWriter *w, const void *data, size_t len,
+			   size_t align)
+{
+	SaUint32T off = packReserve(w, len, align);
+	void *mem = packAt(w, off, len);
+	if (mem != NULL && len > 0)
+		memcpy(mem, data, len);
+	return off;
+}
+
+static SaUint32T packStr(struct PackWriter *w, const char *str)
+{
+	if (str == NULL)
+		return 0;
+	return packBytes(w, str, strlen(str) + 1, 1);
+}
+
+static void packAttr(struct PackWriter *w, SaUint32T attrOff,
+		     const SaImmAttrValuesT_2 *attr, SaUint32T modType)
+{
+	struct PackedAttr packed;
+	struct PackedAttr *dest;
+	SaUint32T i, n = attr->attrValuesNumber;
+	size_t valueSize;
+
+	if (attr->attrValues == NULL)
+		n = 0;
+	memset(&packed, 0, sizeof(packed));
+	packed.name = packStr(w, attr->attrName);
+	packed.valueType = attr->attrValueType;
+	packed.modType = modType;
+	packed.nValues = n;
+
+	if (n > 0) {
+		switch (attr->attrValueType) {
+		case SA_IMM_ATTR_SASTRINGT:
+		case SA_IMM_ATTR_SANAMET:
+			packed.values = packReserve(w, n * sizeof(SaUint32T),
+						    sizeof(SaUint32T));
+			for (i = 0; i < n; i++) {
+				const char *str;
+				SaUint32T *slot;
+				if (attr->attrValueType == SA_IMM_ATTR_SASTRINGT)
+					str = *(SaStringT *)attr->attrValues[i];
+				else
+					str = saAisNameBorrow(
+					    (SaNameT *)attr->attrValues[i]);
+				SaUint32T off = packStr(w, str);
+				slot = packAt(w,
+					      packed.values +
+						  i * sizeof(SaUint32T),
+					      sizeof(SaUint32T));
+				if (slot != NULL)
+					*slot = off;
+			}
+			break;
+		case SA_IMM_ATTR_SAANYT:
+			packed.values = packReserve(
+			    w, n * sizeof(struct PackedAny), sizeof(SaUint32T));
+			for (i = 0; i < n; i++) {
+				const SaAnyT *any =
+				    (const SaAnyT *)attr->attrValues[i];
+				struct PackedAny pany;
+				struct PackedAny *slot;
+				pany.size = any->bufferSize;
+				pany.data = any->bufferSize > 0
+						? packBytes(w, any->bufferAddr,
+							    any->bufferSize, 1)
+						: 0;
+				slot = packAt(w,
+					      packed.values +
+						  i * sizeof(struct PackedAny),
+					      sizeof(struct PackedAny));
+				if (slot != NULL)
+					*slot = pany;
+			}
+			break;
+		default:
+			valueSize = valueTypeSize(attr->attrValueType);
+			packed.values = packReserve(w, n * valueSize, 8);
+			for (i = 0; i < n; i++) {
+				void *mem = packAt(w,
+						   packed.values +
+						       i * valueSize,
+						   valueSize);
+				if (mem != NULL)
+					memcpy(mem, attr->attrValues[i],
+					       valueSize);
+			}
+			break;
+		}
+	}
+
+	dest = packAt(w, attrOff, sizeof(*dest));
+	if (dest != NULL)
+		*dest = packed;
+}
+
+/**
+ * Pack the parts of an operation into a buffer.
+ * @return The size of the packed operation, 0 if it exceeds 4 GiB. Nothing
+ *         useful is stored unless the size is less or equal to bufSize.
+ */
+static size_t packOperationData(void *buf, size_t bufSize,
+				enum CcbUtilOperationType type,
+				SaImmOiCcbIdT ccbId, const char *objectName,
+				const char *className, const char *parentName,
+				const SaImmAttrValuesT_2 **attrValues,
+				const SaImmAttrModificationT_2 **attrMods)
+{
+	struct PackWriter w = {(unsigned char *)buf, bufSize, 0};
+	struct PackedOpHeader hdr;
+	SaUint32T i, n = 0;
+
+	if (attrValues != NULL) {
+		while (attrValues[n] != NULL)
+			n++;
+	} else if (attrMods != NULL) {
+		while (attrMods[n] != NULL)
+			n++;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	packReserve(&w, sizeof(hdr), 8);
+	if (n > 0)
+		hdr.attrs =
+		    packReserve(&w, n * sizeof(struct PackedAttr), 8);
+	hdr.objectName = packStr(&w, objectName);
+	hdr.className = packStr(&w, className);
+	hdr.parentName = packStr(&w, parentName);
+	for (i = 0; i < n; i++) {
+		SaUint32T attrOff = hdr.attrs + i * sizeof(struct PackedAttr);
+		if (attrValues != NULL)
+			packAttr(&w, attrOff, attrValues[i], 0);
+		else
+			packAttr(&w, attrOff, &attrMods[i]->modAttr,
+				 attrMods[i]->modType);
+	}
+	packReserve(&w, 0, 8);
+	if (w.pos > UINT32_MAX)
+		return 0;
+
+	hdr.magic = PACKED_MAGIC;
+	hdr.version = PACKED_VERSION;
+	hdr.operationType = type;
+	hdr.size = w.pos;
+	hdr.nAttrs = n;
+	hdr.ccbId = ccbId;
+	if (bufSize >= sizeof(hdr))
+		memcpy(buf, &hdr, sizeof(hdr));
+	return w.pos;
+}
+
+static bool packedStrValid(const unsigned char *buf, size_t size,
+			   SaUint32T off)
+{
+	return off == 0 ||
+	       (off < size && memchr(buf + off, 0, size - off) != NULL);
+}
+
+static bool packedRangeValid(size_t size, SaUint32T off, size_t count,
+			     size_t elemSize)
+{
+	if (count == 0)
+		return true;
+	if (off == 0 || off > size || count > (size - off) / elemSize)
+		return false;
+	return true;
+}
+
+/**
+ * Check that a buffer holds a well-formed packed operation. Everything is
+ * checked so the buffer may come from an untrusted source.
+ */
+static bool packedValid(const unsigned char *buf, size_t size)
+{
+	const struct PackedOpHeader *hdr = (const struct PackedOpHeader *)buf;
+	const struct PackedAttr *attrs;
+	SaUint32T i, j;
+
+	if (size < sizeof(*hdr) || ((uintptr_t)buf & 7) != 0)
+		return false;
+	if (hdr->magic != PACKED_MAGIC || hdr->version != PACKED_VERSION ||
+	    hdr->size > size || hdr->size < sizeof(*hdr))
+		return false;
+	size = hdr->size;
+	if (hdr->operationType > CCBUTIL_MODIFY)
+		return false;
+	if (!packedStrValid(buf, size, hdr->objectName) ||
+	    !packedStrValid(buf, size, hdr->className) ||
+	    !packedStrValid(buf, size, hdr->parentName))
+		return false;
+	if ((hdr->attrs & 7) != 0 ||
+	    !packedRangeValid(size, hdr->attrs, hdr->nAttrs,
+			      sizeof(struct PackedAttr)))
+		return false;
+
+	attrs = (const struct PackedAttr *)(buf + hdr->attrs);
+	for (i = 0; i < hdr->nAttrs; i++) {
+		const struct PackedAttr *pa = &attrs[i];
+		if (pa->name == 0 || !packedStrValid(buf, size, pa->name))
+			return false;
+		if (valueTypeSize(pa->valueType) == 0 || pa->modType > 3)
+			return false;
+		switch (pa->valueType) {
+		case SA_IMM_ATTR_SASTRINGT:
+		case SA_IMM_ATTR_SANAMET: {
+			const SaUint32T *offs;
+			if ((pa->values & 3) != 0 ||
+			    !packedRangeValid(size, pa->values, pa->nValues,
+					      sizeof(SaUint32T)))
+				return false;
+			offs = (const SaUint32T *)(buf + pa->values);
+			for (j = 0; j < pa->nValues; j++) {
+				if (!packedStrValid(buf, size, offs[j]))
+					return false;
+			}
+			break;
+		}
+		case SA_IMM_ATTR_SAANYT: {
+			const struct PackedAny *anys;
+			if ((pa->values & 3) != 0 ||
+			    !packedRangeValid(size, pa->values, pa->nValues,
+					      sizeof(struct PackedAny)))
+				return false;
+			anys = (const struct PackedAny *)(buf + pa->values);
+			for (j = 0; j < pa->nValues; j++) {
+				if (!packedRangeValid(size, anys[j].data,
+						      anys[j].size, 1))
+					return false;
+			}
+			break;
+		}
+		default:
+			if ((pa->values & 7) != 0 ||
+			    !packedRangeValid(size, pa->values, pa->nValues,
+					      valueTypeSize(pa->valueType)))
+				return false;
+			break;
+		}
+	}
+	return true;
+}
+
+static const char *packedStr(const unsigned char *buf, SaUint32T off)
+{
+	return off == 0 ? NULL : (const char *)(buf + off);
+}
+
+/* Build the pointer structure for one attribute. Values that have the
+   right representation in the buffer are referred to, not copied. */
+static void unpackAttr(struct Arena *arena, const unsigned char *buf,
+		       const struct PackedAttr *pa, SaImmAttrValuesT_2 *attr)
+{
+	SaUint32T i, n = pa->nValues;
+	size_t valueSize;
+
+	attr->attrName = (SaImmAttrNameT)packedStr(buf, pa->name);
+	attr->attrValueType = pa->valueType;
+	attr->attrValuesNumber = n;
+	if (n == 0)
+		return;
+	attr->attrValues = arenaMalloc(arena, n * sizeof(SaImmAttrValueT));
+
+	switch (pa->valueType) {
+	case SA_IMM_ATTR_SASTRINGT: {
+		const SaUint32T *offs = (const SaUint32T *)(buf + pa->values);
+		SaStringT *strs = arenaMalloc(arena, n * sizeof(SaStringT));
+		for (i = 0; i < n; i++) {
+			strs[i] = (SaStringT)packedStr(buf, offs[i]);
+			attr->attrValues[i] = &strs[i];
+		}
+		break;
+	}
+	case SA_IMM_ATTR_SANAMET: {
+		const SaUint32T *offs = (const SaUint32T *)(buf + pa->values);
+		SaNameT *names = arenaMalloc(arena, n * sizeof(SaNameT));
+		for (i = 0; i < n; i++) {
+			const char *str = packedStr(buf, offs[i]);
+			saAisNameLend(str != NULL ? str : "", &names[i]);
+			attr->attrValues[i] = &names[i];
+		}
+		break;
+	}
+	case SA_IMM_ATTR_SAANYT: {
+		const struct PackedAny *pany =
+		    (const struct PackedAny *)(buf + pa->values);
+		SaAnyT *anys = arenaMalloc(arena, n * sizeof(SaAnyT));
+		for (i = 0; i < n; i++) {
+			anys[i].bufferSize = pany[i].size;
+			anys[i].bufferAddr =
+			    pany[i].size > 0
+				? (SaUint8T *)(buf + pany[i].data)
+				: NULL;
+			attr->attrValues[i] = &anys[i];
+		}
+		break;
+	}
+	default:
+		valueSize = valueTypeSize(pa->valueType);
+		for (i = 0; i < n; i++)
+			attr->attrValues[i] =
+			    (void *)(buf + pa->values + i * valueSize);
+		break;
+	}
+}
+
+/**
+ * Set the param member of an operation to refer to a valid packed buffer.
+ * The objectName member is left as is.
+ */
+static void unpackParams(struct Arena *arena, const unsigned char *buf,
+			 struct CcbUtilOperationData *op)
+{
+	const struct PackedOpHeader *hdr = (const struct PackedOpHeader *)buf;
+	const struct PackedAttr *attrs =
+	    (const struct PackedAttr *)(buf + hdr->attrs);
+	SaUint32T i, n = hdr->nAttrs;
+
+	switch (op->operationType) {
+	case CCBUTIL_CREATE: {
+		const SaImmAttrValuesT_2 **attrValues;
+		SaImmAttrValuesT_2 *values;
+		const char *parentName = packedStr(buf, hdr->parentName);
+		op->param.create.className =
+		    (SaImmClassNameT)packedStr(buf, hdr->className);
+		if (parentName != NULL) {
+			SaNameT *name = arenaMalloc(arena, sizeof(SaNameT));
+			saAisNameLend(parentName, name);
+			op->param.create.parentName = name;
+		}
+		attrValues = arenaMalloc(
+		    arena, (n + 1) * sizeof(SaImmAttrValuesT_2 *));
+		values = arenaMalloc(arena, n * sizeof(SaImmAttrValuesT_2));
+		for (i = 0; i < n; i++) {
+			unpackAttr(arena, buf, &attrs[i], &values[i]);
+			attrValues[i] = &values[i];
+		}
+		op->param.create.attrValues = attrValues;
+		break;
+	}
+	case CCBUTIL_DELETE:
+		op->param.delete_.objectName = &op->objectName;
+		break;
+	case CCBUTIL_MODIFY: {
+		const SaImmAttrModificationT_2 **attrMods;
+		SaImmAttrModificationT_2 *mods;
+		attrMods = arenaMalloc(
+		    arena, (n + 1) * sizeof(SaImmAttrModificationT_2 *));
+		mods = arenaMalloc(arena, n * sizeof(SaImmAttrModificationT_2));
+		for (i = 0; i < n; i++) {
+			mods[i].modType = attrs[i].modType;
+			unpackAttr(arena, buf, &attrs[i], &mods[i].modAttr);
+			attrMods[i] = &mods[i];
+		}
+		op->param.modify.objectName = &op->objectName;
+		/* A coalesced operation may be read while it is replaced */
+		__atomic_store_n(&op->param.modify.attrMods, attrMods,
+				 __ATOMIC_RELEASE);
+		break;
+	}
+	}
+}
+
+/**
+ * Capture mode; store the parameters of an operation packed in the CCB arena
+ * and let the param member refer into the packed buffer.
+ */
+static void captureOperation(struct CcbUtilCcbData *ccb,
+			     struct CcbUtilOperationData *op,
+			     const char *objectName, const char *className,
+			     const SaNameT *parentName,
+			     const SaImmAttrValuesT_2 **attrValues,
+			     const SaImmAttrModificationT_2 **attrMods)
+{
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	struct OperationPriv *opp = (struct OperationPriv *)op;
+	const char *parent =
+	    parentName != NULL ? saAisNameBorrow(parentName) : NULL;
+	size_t size;
+	void *buf;
+
+	size = packOperationData(NULL, 0, op->operationType, op->ccbId,
+				 objectName, className, parent, attrValues,
+				 attrMods);
+	if (size == 0)
+		immutilError("Operation too large to pack");
+	buf = arenaMalloc(arena, size);
+	packOperationData(buf, size, op->operationType, op->ccbId, objectName,
+			  className, parent, attrValues, attrMods);
+	opp->packed = buf;
+	opp->packedSize = size;
+	unpackParams(arena, buf, op);
+}
+
+void ccbutil_setCaptureMode(bool enable)
+{
+	__atomic_store_n(&captureMode, enable, __ATOMIC_RELAXED);
+}
+
+size_t ccbutil_packOperation(const CcbUtilOperationData_t *opData, void *buf,
+			     size_t size)
+{
+	const struct OperationPriv *opp = (const struct OperationPriv *)opData;
+	const char *parentName = NULL;
+
+	if (opp->packed != NULL) {
+		if (opp->packedSize <= size)
+			memcpy(buf, opp->packed, opp->packedSize);
+		return opp->packedSize;
+	}
+
+	switch (opData->operationType) {
+	case CCBUTIL_CREATE:
+		if (opData->param.create.parentName != NULL)
+			parentName =
+			    saAisNameBorrow(opData->param.create.parentName);
+		return packOperationData(
+		    buf, size, CCBUTIL_CREATE, opData->ccbId,
+		    saAisNameBorrow(&opData->objectName),
+		    opData->param.create.className, parentName,
+		    opData->param.create.attrValues, NULL);
+	case CCBUTIL_DELETE:
+		return packOperationData(buf, size, CCBUTIL_DELETE,
+					 opData->ccbId,
+					 saAisNameBorrow(&opData->objectName),
+					 NULL, NULL, NULL, NULL);
+	case CCBUTIL_MODIFY:
+		return packOperationData(buf, size, CCBUTIL_MODIFY,
+					 opData->ccbId,
+					 saAisNameBorrow(&opData->objectName),
+					 NULL, NULL, NULL,
+					 opData->param.modify.attrMods);
+	}
+	return 0;
+}
+
+const void *ccbutil_getPackedOperation(const CcbUtilOperationData_t *opData,
+				       size_t *size)
+{
+	const struct OperationPriv *opp = (const struct OperationPriv *)opData;
+	*size = opp->packedSize;
+	return opp->packed;
+}
+
+struct CcbUtilPackedView {
+	struct Arena *arena;
+	const unsigned char *buf;
+	struct CcbUtilOperationData *op;
+};
+
+CcbUtilPackedView_t *ccbutil_packedViewCreate(const void *buf, size_t size)
+{
+	struct Arena *arena;
+	struct CcbUtilPackedView *view;
+
+	if (buf == NULL || !packedValid(buf, size))
+		return NULL;
+	arena = arenaCreate();
+	view = arenaMalloc(arena, sizeof(struct CcbUtilPackedView));
+	view->arena = arena;
+	view->buf = buf;
+	return view;
+}
+
+void ccbutil_packedViewDelete(CcbUtilPackedView_t *view)
+{
+	if (view != NULL)
+		arenaDelete(view->arena);
+}
+
+size_t ccbutil_packedViewSize(const CcbUtilPackedView_t *view)
+{
+	return ((const struct PackedOpHeader *)view->buf)->size;
+}
+
+/**
+ * Build an operation, not part of any CCB, from a valid packed buffer. The
+ * operation refers into the buffer.
+ */
+static struct CcbUtilOperationData *unpackOperation(struct Arena *arena,
+						    const unsigned char *buf)
+{
+	const struct PackedOpHeader *hdr = (const struct PackedOpHeader *)buf;
+	struct CcbUtilOperationData *op;
+	const char *objectName;
+
+	op = arenaMalloc(arena, sizeof(struct OperationPriv));
+	op->operationType = hdr->operationType;
+	op->ccbId = hdr->ccbId;
+	objectName = packedStr(buf, hdr->objectName);
+	saAisNameLend(objectName != NULL ? objectName : "", &op->objectName);
+	unpackParams(arena, buf, op);
+	return op;
+}
+
+const CcbUtilOperationData_t *
+ccbutil_packedViewGetOperation(CcbUtilPackedView_t *view)
+{
+	if (view->op == NULL)
+		view->op = unpackOperation(view->arena, view->buf);
+	return view->op;
+}
+
+const SaImmAttrValuesT_2 **
+ccbutil_packedViewGetAttrValues(CcbUtilPackedView_t *view)
+{
+	const CcbUtilOperationData_t *op = ccbutil_packedViewGetOperation(view);
+	if (op->operationType != CCBUTIL_CREATE)
+		return NULL;
+	return op->param.create.attrValues;
+}
+
+const SaImmAttrModificationT_2 **
+ccbutil_packedViewGetAttrMods(CcbUtilPackedView_t *view)
+{
+	const CcbUtilOperationData_t *op = ccbutil_packedViewGetOperation(view);
+	if (op->operationType != CCBUTIL_MODIFY)
+		return NULL;
+	return op->param.modify.attrMods;
+}
+
+/* ----------------------------------------------------------------------
+ * Journal
+ *
+ * An append-only file of applied CCBs, accessed through a shared mapping.
+ *
+ *   JournalFileHeader
+ *   JournalRecord, packed operations	(one record per CCB)
+ *   ...
+ *   zero fill up to the file size
+ *
+ * Each record holds a sequence number and a CRC32 over everything after the
+ * crc field. Records are read up to the first one that is incomplete, has a
+ * bad checksum or is out of sequence, so a crash while appending loses at
+ * most the CCB being written. Compaction folds the journal into the net
+ * operations per object in a new file which then replaces the old one.
+ */
+
+#define JOURNAL_MAGIC 0x4a424343	/* "CCBJ" */
+#define JOURNAL_RECORD_MAGIC 0x52424343 /* "CCBR" */
+#define JOURNAL_VERSION 1
+#define JOURNAL_MIN_SIZE (1 << 20)
+#define JOURNAL_COMPACT_MIN (4 << 20)
+
+struct JournalFileHeader {
+	SaUint32T magic;
+	SaUint32T version;
+	SaUint64T reserved;
+};
+
+struct JournalRecord {
+	SaUint32T magic;
+	SaUint32T crc;
+	SaUint64T size; /* Including this header, a multiple of 8 */
+	SaUint64T seq;
+	SaUint64T ccbId;
+	SaUint32T nOps;
+	SaUint32T reserved;
+};
+
+struct CcbUtilJournal {
+	pthread_mutex_t lock;
+	char *path;
+	int fd;
+	bool sync;
+	unsigned char *map;
+	size_t mapSize;
+	size_t end;	      /* End of the last valid record */
+	size_t compactedSize; /* End after open or the last compaction */
+	SaUint64T nextSeq;
+};
+
+static SaUint32T crcTable[256];
+static pthread_once_t crcTableOnce = PTHREAD_ONCE_INIT;
+
+static void crcTableInit(void)
+{
+	SaUint32T c, n, k;
+	for (n = 0; n < 256; n++) {
+		c = n;
+		for (k = 0; k < 8; k++)
+			c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+		crcTable[n] = c;
+	}
+}
+
+static SaUint32T journalCrc(const unsigned char *buf, size_t len)
+{
+	SaUint32T c = 0xffffffff;
+	pthread_once(&crcTableOnce, crcTableInit);
+	while (len-- > 0)
+		c = crcTable[(c ^ *buf++) & 0xff] ^ (c >> 8);
+	return c ^ 0xffffffff;
+}
+
+/* Set the file size and map all of it */
+static int journalMap(struct CcbUtilJournal *j, size_t size)
+{
+	void *map;
+
+	if (ftruncate(j->fd, size) != 0)
+		return -1;
+	if (j->map == NULL)
+		map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			   j->fd, 0);
+	else
+		map = mremap(j->map, j->mapSize, size, MREMAP_MAYMOVE);
+	if (map == MAP_FAILED)
+		return -1;
+	j->map = map;
+	j->mapSize = size;
+	return 0;
+}
+
+static int journalSync(struct CcbUtilJournal *j, size_t off, size_t len)
+{
+	size_t start = off & ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+	return msync(j->map + start, off + len - start, MS_SYNC);
+}
+
+static const struct JournalRecord *journalRecord(struct CcbUtilJournal *j,
+						 size_t pos)
+{
+	return (const struct JournalRecord *)(j->map + pos);
+}
+
+static bool journalRecordValid(struct CcbUtilJournal *j, size_t pos)
+{
+	const struct JournalRecord *rec = journalRecord(j, pos);
+	const unsigned char *p, *end;
+	SaUint32T i;
+
+	if (j->mapSize - pos < sizeof(*rec))
+		return false;
+	if (rec->magic != JOURNAL_RECORD_MAGIC || rec->seq != j->nextSeq ||
+	    rec->size < sizeof(*rec) || rec->size > j->mapSize - pos ||
+	    (rec->size & 7) != 0)
+		return false;
+	if (journalCrc((const unsigned char *)rec + 8, rec->size - 8) != rec->crc)
+		return false;
+	p = (const unsigned char *)(rec + 1);
+	end = (const unsigned char *)rec + rec->size;
+	for (i = 0; i < rec->nOps; i++) {
+		if (!packedValid(p, end - p))
+			return false;
+		p += ((const struct PackedOpHeader *)p)->size;
+	}
+	return p == end;
+}
+
+static void journalFree(struct CcbUtilJournal *j)
+{
+	if (j->map != NULL)
+		munmap(j->map, j->mapSize);
+	if (j->fd != -1)
+		close(j->fd);
+	pthread_mutex_destroy(&j->lock);
+	free(j->path);
+	free(j);
+}
+
+static int journalAppend(struct CcbUtilJournal *j,
+			 const struct CcbUtilCcbData *ccb)
+{
+	const struct CcbUtilOperationData *op;
+	struct JournalRecord *rec;
+	size_t pos, size = sizeof(*rec);
+	SaUint32T nOps = 0;
+
+	for (op = ccb->operationListHead; op != NULL; op = op->next) {
+		size_t opSize;
+		if (((const struct OperationPriv *)op)->dropped)
+			continue;
+		opSize = ccbutil_packOperation(op, NULL, 0);
+		if (opSize == 0) {
+			errno = EOVERFLOW;
+			return -1;
+		}
+		size += opSize;
+		nOps++;
+	}
+	if (j->mapSize - j->end < size) {
+		size_t mapSize = j->mapSize;
+		while (mapSize - j->end < size)
+			mapSize *= 2;
+		if (journalMap(j, mapSize) != 0)
+			return -1;
+	}
+
+	rec = (struct JournalRecord *)(j->map + j->end);
+	pos = sizeof(*rec);
+	for (op = ccb->operationListHead; op != NULL; op = op->next) {
+		if (((const struct OperationPriv *)op)->dropped)
+			continue;
+		pos += ccbutil_packOperation(op, (unsigned char *)rec + pos,
+					     size - pos);
+	}
+	rec->size = size;
+	rec->seq = j->nextSeq;
+	rec->ccbId = ccb->ccbId;
+	rec->nOps = nOps;
+	rec->reserved = 0;
+	rec->crc = journalCrc((const unsigned char *)rec + 8, size - 8);
+	rec->magic = JOURNAL_RECORD_MAGIC;
+	if (j->sync && journalSync(j, j->end, size) != 0)
+		return -1;
+	j->end += size;
+	j->nextSeq++;
+	return 0;
+}
+
+/*
+ * Fold a modify into a create of the same object. Only modifications of
+ * attributes given in the create are folded, the others may have class
+ * defaults the create does not know of. They are returned in a new array to
+ * be kept as a modify after the create, or NULL if all were folded.
+ */
+static const SaImmAttrModificationT_2 **
+foldIntoCreate(struct Arena *arena, struct OperationPriv *opp,
+	       const SaImmAttrModificationT_2 **attrMods)
+{
+	struct NetModify *net = opp->net;
+	const SaImmAttrValuesT_2 **attrValues;
+	const SaImmAttrModificationT_2 **rest = NULL;
+	SaImmAttrValuesT_2 *values;
+	size_t i, n = 0;
+
+	if (net == NULL) {
+		const SaImmAttrValuesT_2 **seed =
+		    opp->op.param.create.attrValues;
+		net = arenaMalloc(arena, sizeof(struct NetModify));
+		for (; seed != NULL && *seed != NULL; seed++) {
+			SaImmAttrModificationT_2 mod = {
+			    SA_IMM_ATTR_VALUES_REPLACE, **seed};
+			netModApply(arena, net, &mod, true);
+		}
+		opp->net = net;
+	}
+	for (i = 0; attrMods != NULL && attrMods[i] != NULL; i++)
+		;
+	for (; attrMods != NULL && *attrMods != NULL; attrMods++) {
+		if (netModFind(net, (*attrMods)->modAttr.attrName) != NULL) {
+			netModApply(arena, net, *attrMods, true);
+			continue;
+		}
+		if (rest == NULL)
+			rest = arenaMalloc(arena, (i + 1) *
+					   sizeof(SaImmAttrModificationT_2 *));
+		rest[n++] = *attrMods;
+	}
+	if (rest != NULL)
+		rest[n] = NULL;
+
+	attrValues =
+	    arenaMalloc(arena, (net->n + 1) * sizeof(SaImmAttrValuesT_2 *));
+	values = arenaMalloc(arena, net->n * sizeof(SaImmAttrValuesT_2));
+	for (i = 0; i < net->n; i++) {
+		struct NetMod *mod = net->attrs[i];
+		values[i].attrName = mod->attrName;
+		values[i].attrValueType = mod->valueType;
+		values[i].attrValuesNumber = mod->del.n;
+		values[i].attrValues = mod->del.n > 0 ? mod->del.values : NULL;
+		attrValues[i] = &values[i];
+	}
+	opp->op.param.create.attrValues = attrValues;
+	return rest;
+}
+
+/**
+ * Fold an operation into the net operations per object kept in ccb. A modify
+ * is merged into an earlier create or modify of the object, and a delete
+ * drops an earlier create or modify.
+ */
+static void journalFold(struct CcbUtilCcbData *ccb,
+			const struct CcbUtilOperationData *op)
+{
+	struct Arena *arena = (struct Arena *)ccb->memref;
+	const char *dn = saAisNameBorrow(&op->objectName);
+	struct DnIndexEntry *entry = dn[0] != '\0' ? dnIndexFind(ccb, dn) : NULL;
+	struct OperationPriv *last = NULL;
+	const SaImmAttrModificationT_2 **attrMods;
+	struct CcbUtilOperationData *copy;
+	size_t len;
+
+	if (entry != NULL && !entry->last->dropped)
+		last = entry->last;
+
+	switch (op->operationType) {
+	case CCBUTIL_CREATE:
+		copy = newOperationData(ccb, CCBUTIL_CREATE);
+		copy->param.create.className =
+		    dupSaImmClassNameT(arena, op->param.create.className);
+		copy->param.create.parentName =
+		    dupSaNameT(arena, op->param.create.parentName);
+		copy->param.create.attrValues = dupSaImmAttrValuesT_array(
+		    arena, op->param.create.attrValues);
+		break;
+	case CCBUTIL_MODIFY:
+		attrMods = op->param.modify.attrMods;
+		if (last != NULL && last->op.operationType == CCBUTIL_CREATE) {
+			attrMods = foldIntoCreate(arena, last, attrMods);
+			if (attrMods == NULL)
+				return;
+		} else if (last != NULL &&
+			   last->op.operationType == CCBUTIL_MODIFY) {
+			coalesceModify(ccb, last, dn, attrMods);
+			return;
+		}
+		copy = newOperationData(ccb, CCBUTIL_MODIFY);
+		copy->param.modify.objectName = &copy->objectName;
+		copy->param.modify.attrMods =
+		    dupSaImmAttrModificationT_array(arena, attrMods);
+		break;
+	case CCBUTIL_DELETE:
+		if (entry != NULL && last == NULL)
+			return; /* Created and deleted in the journal */
+		if (last != NULL) {
+			/* Drop all since the last delete, e.g. a create and
+			 * the modify kept after it */
+			struct OperationPriv *p, *from = entry->first;
+			bool created = false;
+			if (last->op.operationType == CCBUTIL_DELETE)
+				return;
+			for (p = entry->first; p != NULL; p = p->nextSameDn) {
+				if (!p->dropped &&
+				    p->op.operationType == CCBUTIL_DELETE)
+					from = p->nextSameDn;
+			}
+			for (p = from; p != NULL; p = p->nextSameDn) {
+				if (p->dropped)
+					continue;
+				p->dropped = true;
+				created = created ||
+					  p->op.operationType == CCBUTIL_CREATE;
+			}
+			if (created)
+				return;
+		}
+		copy = newOperationData(ccb, CCBUTIL_DELETE);
+		copy->param.delete_.objectName = &copy->objectName;
+		break;
+	default:
+		return;
+	}
+	copy->ccbId = op->ccbId;
+	len = strlen(dn);
+	saAisNameLend(len < SA_MAX_UNEXTENDED_NAME_LENGTH ? dn : strdup(dn),
+		      &copy->objectName);
+	linkOperationData(ccb, copy, saAisNameBorrow(&copy->objectName));
+}
+
+static int journalCompact(struct CcbUtilJournal *j)
+{
+	struct CcbUtilCcbData *net = ccbutil_createCcbData(0);
+	struct CcbUtilJournal *compacted = NULL;
+	size_t pos = sizeof(struct JournalFileHeader);
+	char *tmpPath = NULL;
+	int rc = -1;
+
+	/* The net CCB is not in the CCB table */
+	while (pos < j->end) {
+		const struct JournalRecord *rec = journalRecord(j, pos);
+		const unsigned char *p = (const unsigned char *)(rec + 1);
+		struct Arena *arena = arenaCreate();
+		SaUint32T i;
+		for (i = 0; i < rec->nOps; i++) {
+			journalFold(net, unpackOperation(arena, p));
+			p += ((const struct PackedOpHeader *)p)->size;
+		}
+		arenaDelete(arena);
+		pos += rec->size;
+	}
+
+	if (asprintf(&tmpPath, "%s.tmp", j->path) == -1) {
+		tmpPath = NULL;
+		goto done;
+	}
+	unlink(tmpPath);
+	compacted = ccbutil_journalOpen(tmpPath, false);
+	if (compacted == NULL)
+		goto done;
+	if (journalAppend(compacted, net) != 0 ||
+	    journalSync(compacted, 0, compacted->end) != 0 ||
+	    fsync(compacted->fd) != 0 || rename(tmpPath, j->path) != 0) {
+		int err = errno;
+		unlink(tmpPath);
+		journalFree(compacted);
+		errno = err;
+		goto done;
+	}
+
+	munmap(j->map, j->mapSize);
+	close(j->fd);
+	j->fd = compacted->fd;
+	j->map = compacted->map;
+	j->mapSize = compacted->mapSize;
+	j->end = compacted->end;
+	j->compactedSize = compacted->end;
+	j->nextSeq = compacted->nextSeq;
+	compacted->fd = -1;
+	compacted->map = NULL;
+	journalFree(compacted);
+	rc = 0;
+
+done:
+	free(tmpPath);
+	ccbutil_deleteCcbData(net);
+	return rc;
+}
+
+CcbUtilJournal_t *ccbutil_journalOpen(const char *path, bool sync)
+{
+	struct CcbUtilJournal *j;
+	struct JournalFileHeader *hdr;
+	struct stat st;
+	size_t pos;
+	int err;
+
+	j = calloc(1, sizeof(struct CcbUtilJournal));
+	if (j == NULL)
+		immutilError("Out of memory");
+	pthread_mutex_init(&j->lock, NULL);
+	j->sync = sync;
+	j->path = strdup(path);
+	if (j->path == NULL)
+		immutilError("Out of memory");
+	j->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (j->fd == -1 || fstat(j->fd, &st) != 0)
+		goto error;
+	if (journalMap(j, st.st_size < JOURNAL_MIN_SIZE ? JOURNAL_MIN_SIZE
+							: st.st_size) != 0)
+		goto error;
+
+	hdr = (struct JournalFileHeader *)j->map;
+	if (st.st_size == 0) {
+		hdr->magic = JOURNAL_MAGIC;
+		hdr->version = JOURNAL_VERSION;
+	} else if (hdr->magic != JOURNAL_MAGIC ||
+		   hdr->version != JOURNAL_VERSION) {
+		errno = EINVAL;
+		goto error;
+	}
+
+	pos = sizeof(*hdr);
+	j->nextSeq = 1;
+	while (journalRecordValid(j, pos)) {
+		pos += journalRecord(j, pos)->size;
+		j->nextSeq++;
+	}
+	j->end = pos;
+	j->compactedSize = pos;
+	return j;
+
+error:
+	err = errno;
+	journalFree(j);
+	errno = err;
+	return NULL;
+}
+
+void ccbutil_journalClose(CcbUtilJournal_t *journal)
+{
+	if (journal == NULL)
+		return;
+	if (journal->sync)
+		(void)journalSync(journal, 0, journal->end);
+	journalFree(journal);
+}
+
+int ccbutil_journalAppend(CcbUtilJournal_t *journal,
+			  const CcbUtilCcbData_t *ccb)
+{
+	int rc;
+	pthread_mutex_lock(&journal->lock);
+	rc = journalAppend(journal, ccb);
+	if (rc == 0 && journal->end >= JOURNAL_COMPACT_MIN &&
+	    journal->end >= 2 * journal->compactedSize &&
+	    journalCompact(journal) != 0) {
+		syslog(LOG_WARNING, "immutil: compaction of %s failed: %s",
+		       journal->path, strerror(errno));
+		/* Try again when the journal has doubled again */
+		journal->compactedSize = journal->end;
+	}
+	pthread_mutex_unlock(&journal->lock);
+	return rc;
+}
+
+int ccbutil_journalCompact(CcbUtilJournal_t *journal)
+{
+	int rc;
+	pthread_mutex_lock(&journal->lock);
+	rc = journalCompact(journal);
+	pthread_mutex_unlock(&journal->lock);
+	return rc;
+}
+
+SaUint64T ccbutil_journalReplay(CcbUtilJournal_t *journal,
+				CcbUtilJournalReplayFnT replayFn, void *arg)
+{
+	size_t pos = sizeof(struct JournalFileHeader);
+	SaUint64T nOps = 0;
+
+	pthread_mutex_lock(&journal->lock);
+	while (pos < journal->end) {
+		const struct JournalRecord *rec = journalRecord(journal, pos);
+		const unsigned char *p = (const unsigned char *)(rec + 1);
+		struct Arena *arena = arenaCreate();
+		SaUint32T i;
+		for (i = 0; i < rec->nOps; i++) {
+			replayFn(unpackOperation(arena, p), arg);
+			p += ((const struct PackedOpHeader *)p)->size;
+		}
+		arenaDelete(arena);
+		nOps += rec->nOps;
+		pos += rec->size;
+	}
+	pthread_mutex_unlock(&journal->lock);
+	return nOps;
+}
+
+/* ----------------------------------------------------------------------
+ * Memory handling
+ */
+
+/*
+ * A CCB owns an arena, a list of chunks where memory is handed out by bumping
+ * a pointer in the current (first) chunk. Chunk sizes grow geometrically from
+ * CHUNK_MIN to CHUNK_MAX. All memory is freed at once when the arena is
+ * deleted, and chunks of the standard sizes are then put in a process-wide
+ * recycle pool for the next arena. Memory handed out is always zeroed;
+ * fresh chunks come from calloc() and pooled chunks are cleared on release.
+ */
+
+#define ARENA_ALIGN 8
+#define CHUNK_MIN_SHIFT 12
+#define CHUNK_MAX_SHIFT 18
+#define CHUNK_MIN (1 << CHUNK_MIN_SHIFT)
+#define CHUNK_MAX (1 << CHUNK_MAX_SHIFT)
+#define CHUNK_CLASSES (CHUNK_MAX_SHIFT - CHUNK_MIN_SHIFT + 1)
+#define CHUNK_POOL_MAX_BYTES (4 * 1024 * 1024)
+
+struct Chunk {
+	struct Chunk *next;
+	size_t capacity;
+	size_t used;
+	unsigned char data[];
+};
+
+struct Arena {
+	struct Chunk *chunks; /* The current chunk first */
+	size_t nextSize;
+	SaUint64T allocations;
+	SaUint64T bytes;
+	SaUint64T reserved;
+};
+
+/* Recycle pool, one free list per chunk size class, protected by
+   chunkPoolLock */
+static pthread_mutex_t chunkPoolLock = PTHREAD_MUTEX_INITIALIZER;
+static struct Chunk *chunkPool[CHUNK_CLASSES];
+static size_t chunkPoolBytes;
+static struct CcbUtilMemPoolStats chunkPoolStats;
+
+static size_t alignSize(size_t size)
+{
+	return (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+}
+
+/**
+ * Return the size class of a chunk with the passed capacity, or -1 if it
+ * is not one of the standard sizes.
+ */
+static int chunkClass(size_t capacity)
+{
+	int c;
+	for (c = 0; c < CHUNK_CLASSES; c++) {
+		if (capacity == ((size_t)CHUNK_MIN << c))
+			return c;
+	}
+	return -1;
+}
+
+static struct Chunk *getChunk(size_t size)
+{
+	struct Chunk *chunk = NULL;
+	int c = chunkClass(size);
+
+	pthread_mutex_lock(&chunkPoolLock);
+	if (c >= 0 && chunkPool[c] != NULL) {
+		chunk = chunkPool[c];
+		chunkPool[c] = chunk->next;
+		chunkPoolBytes -= chunk->capacity;
+		chunkPoolStats.chunkReuses++;
+	} else {
+		chunkPoolStats.chunkMallocs++;
+	}
+	pthread_mutex_unlock(&chunkPoolLock);
+
+	if (chunk == NULL) {
+		chunk = (struct Chunk *)calloc(1, sizeof(struct Chunk) + size);
+		if (chunk == NULL)
+			immutilError("Out of memory");
+		chunk->capacity = size;
+	}
+	chunk->next = NULL;
+	return chunk;
+}
+
+static void putChunk(struct Chunk *chunk)
+{
+	int c = chunkClass(chunk->capacity);
+
+	if (c >= 0) {
+		memset(chunk->data, 0, chunk->used);
+		chunk->used = 0;
+	}
+	pthread_mutex_lock(&chunkPoolLock);
+	if (c < 0 || chunkPoolBytes + chunk->capacity > CHUNK_POOL_MAX_BYTES) {
+		chunkPoolStats.chunkFrees++;
+		pthread_mutex_unlock(&chunkPoolLock);
+		free(chunk);
+		return;
+	}
+	chunk->next = chunkPool[c];
+	chunkPool[c] = chunk;
+	chunkPoolBytes += chunk->capacity;
+	pthread_mutex_unlock(&chunkPoolLock);
+}
+
+static struct Arena *arenaCreate(void)
+{
+	struct Chunk *chunk = getChunk(CHUNK_MIN);
+	struct Arena *arena = (struct Arena *)chunk->data;
+	chunk->used = alignSize(sizeof(struct Arena));
+	arena->chunks = chunk;
+	arena->nextSize = 2 * CHUNK_MIN;
+	arena->reserved = CHUNK_MIN;
+	return arena;
+}
+
+static void arenaDelete(struct Arena *arena)
+{
+	struct Chunk *chunk = arena->chunks;
+	while (chunk != NULL) {
+		struct Chunk *next = chunk->next;
+		putChunk(chunk);
+		chunk = next;
+	}
+}
+
+static void *arenaMalloc(struct Arena *arena, size_t size)
+{
+	struct Chunk *chunk = arena->chunks;
+	unsigned char *mem;
+
+	size = alignSize(size);
+	arena->allocations++;
+	arena->bytes += size;
+
+	if (chunk->capacity - chunk->used < size) {
+		if (size > arena->nextSize / 2) {
+			/* Large allocation, give it a chunk of its own behind
+			   the current one so the current one is not wasted */
+			chunk = getChunk(size <= arena->nextSize
+					     ? arena->nextSize
+					     : size);
+			chunk->next = arena->chunks->next;
+			arena->chunks->next = chunk;
+		} else {
+			chunk = getChunk(arena->nextSize);
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+			if (arena->nextSize < CHUNK_MAX)
+				arena->nextSize *= 2;
+		}
+		arena->reserved += chunk->capacity;
+	}
+
+	mem = chunk->data + chunk->used;
+	chunk->used += size;
+	return mem;
+}
+
+void ccbutil_getCcbMemStats(const struct CcbUtilCcbData *ccb,
+			    struct CcbUtilMemStats *stats)
+{
+	const struct Arena *arena = (const struct Arena *)ccb->memref;
+	ccbLock((struct CcbUtilCcbData *)ccb);
+	stats->allocations = arena->allocations;
+	stats->bytes = arena->bytes;
+	stats->reserved = arena->reserved;
+	ccbUnlock((struct CcbUtilCcbData *)ccb);
+}
+
+void ccbutil_getMemPoolStats(struct CcbUtilMemPoolStats *stats)
+{
+	pthread_mutex_lock(&chunkPoolLock);
+	*stats = chunkPoolStats;
+	stats->pooledBytes = chunkPoolBytes;
+	pthread_mutex_unlock(&chunkPoolLock);
+}
+
+/* ----------------------------------------------------------------------
+ * IMM call wrappers; This wrapper interface offloads the burden to handle
+ * return values and retries for each and every IMM-call. It makes the code
+ * cleaner.
+ */
+
+struct ImmutilWrapperProfile immutilWrapperProfile = {1, 25, 400};
+
+/*
+ * The wrapped operations
+ */
+
+static const struct OperationInfo {
+	const char *name;
+	enum ImmutilRetryCategory category;
+} operationInfo[IMMUTIL_OP_COUNT] = {
+    [IMMUTIL_OP_OI_INITIALIZE_2] =
+	{"saImmOiInitialize_2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_INITIALIZE_O3] =
+	{"saImmOiInitialize_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_SELECTION_OBJECT_GET] =
+	{"saImmOiSelectionObjectGet", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_CLASS_IMPLEMENTER_SET] =
+	{"saImmOiClassImplementerSet", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_CLASS_IMPLEMENTER_RELEASE] =
+	{"saImmOiClassImplementerRelease", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_SET] =
+	{"saImmOiObjectImplementerSet", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_SET_O3] =
+	{"saImmOiObjectImplementerSet_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_RELEASE] =
+	{"saImmOiObjectImplementerRelease", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_RELEASE_O3] =
+	{"saImmOiObjectImplementerRelease_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_IMPLEMENTER_SET] =
+	{"saImmOiImplementerSet", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_IMPLEMENTER_CLEAR] =
+	{"saImmOiImplementerClear", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_RT_OBJECT_CREATE_2] =
+	{"saImmOiRtObjectCreate_2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_RT_OBJECT_CREATE_O3] =
+	{"saImmOiRtObjectCreate_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_RT_OBJECT_DELETE] =
+	{"saImmOiRtObjectDelete", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_RT_OBJECT_DELETE_O3] =
+	{"saImmOiRtObjectDelete_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_RT_OBJECT_UPDATE_2] =
+	{"saImmOiRtObjectUpdate_2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_RT_OBJECT_UPDATE_O3] =
+	{"saImmOiRtObjectUpdate_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_ADMIN_OPERATION_RESULT] =
+	{"saImmOiAdminOperationResult", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_ADMIN_OPERATION_RESULT_O2] =
+	{"saImmOiAdminOperationResult_o2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_AUGMENT_CCB_INITIALIZE] =
+	{"saImmOiAugmentCcbInitialize", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_INITIALIZE] = {"saImmOmInitialize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_INITIALIZE_O2] =
+	{"saImmOmInitialize_o2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_SELECTION_OBJECT_GET] =
+	{"saImmOmSelectionObjectGet", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_FINALIZE] = {"saImmOmFinalize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ACCESSOR_INITIALIZE] =
+	{"saImmOmAccessorInitialize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ACCESSOR_GET_2] =
+	{"saImmOmAccessorGet_2", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_ACCESSOR_GET_O3] =
+	{"saImmOmAccessorGet_o3", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_ACCESSOR_GET_CONFIG_ATTRS] =
+	{"saImmOmAccessorGetConfigAttrs", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_ACCESSOR_FINALIZE] =
+	{"saImmOmAccessorFinalize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_SEARCH_INITIALIZE_2] =
+	{"saImmOmSearchInitialize_2", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_SEARCH_INITIALIZE_O3] =
+	{"saImmOmSearchInitialize_o3", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_SEARCH_FINALIZE] =
+	{"saImmOmSearchFinalize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_SEARCH_NEXT_2] = {"saImmOmSearchNext_2", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_SEARCH_NEXT_O3] =
+	{"saImmOmSearchNext_o3", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_CLEAR] =
+	{"saImmOmAdminOwnerClear", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_CLEAR_O3] =
+	{"saImmOmAdminOwnerClear_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_CLASS_CREATE_2] =
+	{"saImmOmClassCreate_2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_CLASS_DELETE] =
+	{"saImmOmClassDelete", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OI_FINALIZE] = {"saImmOiFinalize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_INITIALIZE] =
+	{"saImmOmAdminOwnerInitialize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_FINALIZE] =
+	{"saImmOmAdminOwnerFinalize", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_CCB_INITIALIZE] =
+	{"saImmOmCcbInitialize", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_FINALIZE] = {"saImmOmCcbFinalize", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_APPLY] = {"saImmOmCcbApply", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_ABORT] = {"saImmOmCcbAbort", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_VALIDATE] = {"saImmOmCcbValidate", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_SET] =
+	{"saImmOmAdminOwnerSet", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_SET_O3] =
+	{"saImmOmAdminOwnerSet_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_RELEASE] =
+	{"saImmOmAdminOwnerRelease", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OWNER_RELEASE_O3] =
+	{"saImmOmAdminOwnerRelease_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_O2] =
+	{"saImmOmAdminOperationInvoke_o2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_2] =
+	{"saImmOmAdminOperationInvoke_2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_O3] =
+	{"saImmOmAdminOperationInvoke_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_ASYNC_2] =
+	{"saImmOmAdminOperationInvokeAsync_2", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_ASYNC_O3] =
+	{"saImmOmAdminOperationInvokeAsync_o3", IMMUTIL_RETRY_DEFAULT},
+    [IMMUTIL_OP_OM_CCB_OBJECT_CREATE_2] =
+	{"saImmOmCcbObjectCreate_2", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_OBJECT_CREATE_O3] =
+	{"saImmOmCcbObjectCreate_o3", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_OBJECT_MODIFY_2] =
+	{"saImmOmCcbObjectModify_2", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_OBJECT_MODIFY_O3] =
+	{"saImmOmCcbObjectModify_o3", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_OBJECT_DELETE] =
+	{"saImmOmCcbObjectDelete", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_OBJECT_DELETE_O3] =
+	{"saImmOmCcbObjectDelete_o3", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CCB_OBJECT_READ] =
+	{"saImmOmCcbObjectRead", IMMUTIL_RETRY_CCB},
+    [IMMUTIL_OP_OM_CLASS_DESCRIPTION_GET_2] =
+	{"saImmOmClassDescriptionGet_2", IMMUTIL_RETRY_READ},
+    [IMMUTIL_OP_OM_CLASS_DESCRIPTION_MEMORY_FREE_2] =
+	{"saImmOmClassDescriptionMemoryFree_2", IMMUTIL_RETRY_DEFAULT}};
+
+const char *immutil_operationName(enum ImmutilOperation operation)
+{
+	if ((unsigned int)operation >= IMMUTIL_OP_COUNT)
+		return NULL;
+	return operationInfo[operation].name;
+}
+
+/*
+ * Wrapper telemetry. Each thread counts in a block of its own with plain
+ * relaxed atomic loads and stores, it is the only writer. The blocks are
+ * linked in a list that is only locked when a thread gets a block; a block
+ * is marked free when its thread exits and reused by the next new thread, so
+ * that no counts are lost. A snapshot sums all blocks. Recording is off until
+ * immutil_telemetryEnable(true), so the wrappers read no clock by default.
+ */
+
+struct ThreadTelemetry {
+	struct ThreadTelemetry *next;
+	bool inUse;
+	struct ImmutilCallStats stats[IMMUTIL_OP_COUNT];
+};
+
+static pthread_mutex_t telemetryLock = PTHREAD_MUTEX_INITIALIZER;
+static struct ThreadTelemetry *telemetryThreads;
+static pthread_key_t telemetryKey;
+static pthread_once_t telemetryOnce = PTHREAD_ONCE_INIT;
+static bool telemetryEnabled = false;
+
+static struct ImmutilTelemetryShm *telemetryShm;
+static size_t telemetryShmSize;
+static SaTimeT telemetryShmInterval;
+static SaTimeT telemetryShmUpdated;
+static pthread_mutex_t telemetryShmLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void telemetryThreadExit(void *arg)
+{
+	struct ThreadTelemetry *block = arg;
+	__atomic_store_n(&block->inUse, false, __ATOMIC_RELEASE);
+}
+
+static void telemetryInit(void)
+{
+	if (pthread_key_create(&telemetryKey, telemetryThreadExit) != 0)
+		immutilError("pthread_key_create FAILED");
+}
+
+static struct ThreadTelemetry *telemetryBlock(void)
+{
+	struct ThreadTelemetry *block;
+
+	pthread_once(&telemetryOnce, telemetryInit);
+	if ((block = pthread_getspecific(telemetryKey)) != NULL)
+		return block;
+
+	pthread_mutex_lock(&telemetryLock);
+	for (block = telemetryThreads; block != NULL; block = block->next)
+		if (!__atomic_load_n(&block->inUse, __ATOMIC_ACQUIRE))
+			break;
+	if (block == NULL) {
+		block = calloc(1, sizeof(struct ThreadTelemetry));
+		if (block == NULL)
+			immutilError("Out of memory");
+		block->next = telemetryThreads;
+		telemetryThreads = block;
+	}
+	block->inUse = true;
+	pthread_mutex_unlock(&telemetryLock);
+	if (pthread_setspecific(telemetryKey, block) != 0)
+		immutilError("pthread_setspecific FAILED");
+	return block;
+}
+
+/* Add to a counter that only this thread writes */
+static void telemetryAdd(SaUint64T *counter, SaUint64T n)
+{
+	__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n,
+			 __ATOMIC_RELAXED);
+}
+
+/* Index of the highest bit set + 1, 0 for 0 */
+static unsigned int bitWidth(SaUint64T n)
+{
+	return n == 0 ? 0 : 64 - __builtin_clzll(n);
+}
+
+static void telemetryShmPublish(void);
+
+static void telemetryRecord(const struct ImmutilRetry *retry, SaAisErrorT rc)
+{
+	struct ImmutilCallStats *stats =
+	    &telemetryBlock()->stats[retry->operation];
+	SaTimeT now = monotonicTime();
+	unsigned int tries, latency;
+
+	tries = retry->tries <= 1 ? 0 : bitWidth(retry->tries - 1);
+	if (tries >= IMMUTIL_TELEMETRY_ATTEMPT_BUCKETS)
+		tries = IMMUTIL_TELEMETRY_ATTEMPT_BUCKETS - 1;
+	latency = bitWidth((now - retry->start) / 1000);
+	if (latency >= IMMUTIL_TELEMETRY_LATENCY_BUCKETS)
+		latency = IMMUTIL_TELEMETRY_LATENCY_BUCKETS - 1;
+
+	telemetryAdd(&stats->calls, 1);
+	if (rc != SA_AIS_OK)
+		telemetryAdd(&stats->errors, 1);
+	telemetryAdd(&stats->retrySleep, retry->slept);
+	telemetryAdd(&stats->attempts[tries], 1);
+	telemetryAdd(&stats->latency[latency], 1);
+
+	if (__atomic_load_n(&telemetryShm, __ATOMIC_ACQUIRE) != NULL &&
+	    telemetryShmInterval > 0 &&
+	    now - __atomic_load_n(&telemetryShmUpdated, __ATOMIC_RELAXED) >=
+		telemetryShmInterval &&
+	    pthread_mutex_trylock(&telemetryShmLock) == 0) {
+		telemetryShmPublish();
+		pthread_mutex_unlock(&telemetryShmLock);
+	}
+}
+
+void immutil_telemetryEnable(bool enable)
+{
+	__atomic_store_n(&telemetryEnabled, enable, __ATOMIC_RELAXED);
+}
+
+void immutil_telemetrySnapshot(struct ImmutilCallStats *stats)
+{
+	const struct ThreadTelemetry *block;
+	unsigned int op, i;
+
+	memset(stats, 0, IMMUTIL_OP_COUNT * sizeof(struct ImmutilCallStats));
+	pthread_mutex_lock(&telemetryLock);
+	for (block = telemetryThreads; block != NULL; block = block->next) {
+		/* All fields are SaUint64T counters */
+		const SaUint64T *src = (const SaUint64T *)block->stats;
+		SaUint64T *dest = (SaUint64T *)stats;
+		for (op = 0; op < IMMUTIL_OP_COUNT; op++) {
+			for (i = 0; i < sizeof(struct ImmutilCallStats) /
+					    sizeof(SaUint64T);
+			     i++, src++, dest++)
+				*dest += __atomic_load_n(src, __ATOMIC_RELAXED);
+		}
+	}
+	pthread_mutex_unlock(&telemetryLock);
+}
+
+/* Write a snapshot to the shared memory, called with telemetryShmLock */
+static void telemetryShmPublish(void)
+{
+	struct ImmutilTelemetryShm *shm = telemetryShm;
+	struct ImmutilCallStats stats[IMMUTIL_OP_COUNT];
+
+	if (shm == NULL)
+		return;
+	immutil_telemetrySnapshot(stats);
+	/* Sequence lock, odd while the stats are written */
+	__atomic_store_n(&shm->sequence, shm->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(shm->stats, stats, sizeof(stats));
+	shm->updated = monotonicTime();
+	__atomic_store_n(&shm->sequence, shm->sequence + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&telemetryShmUpdated, shm->updated, __ATOMIC_RELAXED);
+}
+
+SaAisErrorT immutil_telemetryShmOpen(const char *name, SaTimeT interval)
+{
+	struct ImmutilTelemetryShm *shm;
+	unsigned int op;
+	int fd;
+
+	pthread_mutex_lock(&telemetryShmLock);
+	if (telemetryShm != NULL) {
+		pthread_mutex_unlock(&telemetryShmLock);
+		return SA_AIS_ERR_EXIST;
+	}
+	fd = shm_open(name, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		pthread_mutex_unlock(&telemetryShmLock);
+		return SA_AIS_ERR_LIBRARY;
+	}
+	telemetryShmSize = sizeof(struct ImmutilTelemetryShm);
+	if (ftruncate(fd, telemetryShmSize) != 0 ||
+	    (shm = mmap(NULL, telemetryShmSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0)) == MAP_FAILED) {
+		close(fd);
+		pthread_mutex_unlock(&telemetryShmLock);
+		return SA_AIS_ERR_LIBRARY;
+	}
+	close(fd);
+
+	memset(shm, 0, telemetryShmSize);
+	shm->nOperations = IMMUTIL_OP_COUNT;
+	for (op = 0; op < IMMUTIL_OP_COUNT; op++)
+		strncpy(shm->names[op], operationInfo[op].name,
+			IMMUTIL_OPERATION_NAME_SIZE - 1);
+	telemetryShmInterval = interval;
+	telemetryShm = shm;
+	telemetryShmPublish();
+	__atomic_store_n(&shm->magic, IMMUTIL_TELEMETRY_SHM_MAGIC,
+			 __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&telemetryShmLock);
+	return SA_AIS_OK;
+}
+
+SaAisErrorT immutil_telemetryShmPublish(void)
+{
+	SaAisErrorT rc = SA_AIS_ERR_NOT_EXIST;
+	pthread_mutex_lock(&telemetryShmLock);
+	if (telemetryShm != NULL) {
+		telemetryShmPublish();
+		rc = SA_AIS_OK;
+	}
+	pthread_mutex_unlock(&telemetryShmLock);
+	return rc;
+}
+
+void immutil_telemetryShmClose(void)
+{
+	struct ImmutilTelemetryShm *shm;
+	pthread_mutex_lock(&telemetryShmLock);
+	shm = telemetryShm;
+	__atomic_store_n(&telemetryShm, NULL, __ATOMIC_RELEASE);
+	if (shm != NULL)
+		munmap(shm, telemetryShmSize);
+	pthread_mutex_unlock(&telemetryShmLock);
+}
+
+/*
+ * Retry engine. The delay before a retry is drawn with decorrelated jitter,
+ * uniformly between the initial delay and three times the previous delay and
+ * capped at the max delay, so that clients that failed together spread out.
+ * The deadline is counted from the first SA_AIS_ERR_TRY_AGAIN; a call that
+ * succeeds at once does not read the clock. Zero profile fields are taken
+ * from immutilWrapperProfile, see struct ImmutilRetryProfile.
+ */
+
+#define MS_TO_NS(ms) ((SaTimeT)(ms)*1000000)
+
+static struct ImmutilRetryProfile retryProfiles[IMMUTIL_RETRY_CATEGORIES] = {
+    [IMMUTIL_RETRY_DEFAULT] = {10, 0, 0},
+    [IMMUTIL_RETRY_READ] = {1, 50, 0},
+    [IMMUTIL_RETRY_CCB] = {20, 0, 0}};
+
+static void profileStore(struct ImmutilRetryProfile *p,
+			 const struct ImmutilRetryProfile *profile)
+{
+	__atomic_store_n(&p->initialDelay, profile->initialDelay,
+			 __ATOMIC_RELAXED);
+	__atomic_store_n(&p->maxDelay, profile->maxDelay, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->timeout, profile->timeout, __ATOMIC_RELAXED);
+}
+
+static void profileLoad(const struct ImmutilRetryProfile *p,
+			struct ImmutilRetryProfile *profile)
+{
+	profile->initialDelay =
+	    __atomic_load_n(&p->initialDelay, __ATOMIC_RELAXED);
+	profile->maxDelay = __atomic_load_n(&p->maxDelay, __ATOMIC_RELAXED);
+	profile->timeout = __atomic_load_n(&p->timeout, __ATOMIC_RELAXED);
+}
+
+/* Take the fields of profile that are 0 from another profile */
+static void profileMerge(struct ImmutilRetryProfile *profile,
+			 const struct ImmutilRetryProfile *from)
+{
+	if (profile->initialDelay == 0)
+		profile->initialDelay = from->initialDelay;
+	if (profile->maxDelay == 0)
+		profile->maxDelay = from->maxDelay;
+	if (profile->timeout == 0)
+		profile->timeout = from->timeout;
+}
+
+void immutil_setRetryProfile(enum ImmutilRetryCategory category,
+			     const struct ImmutilRetryProfile *profile)
+{
+	profileStore(&retryProfiles[category], profile);
+}
+
+void immutil_getRetryProfile(enum ImmutilRetryCategory category,
+			     struct ImmutilRetryProfile *profile)
+{
+	profileLoad(&retryProfiles[category], profile);
+}
+
+/*
+ * Per operation and per thread overrides of the category profiles. They are
+ * only looked up when a retry loop gets its first SA_AIS_ERR_TRY_AGAIN, calls
+ * that succeed at once never read them. The thread profiles are an array per
+ * thread, and are not looked for until some thread has installed one.
+ */
+
+static struct ImmutilRetryProfile operationProfiles[IMMUTIL_OP_COUNT];
+static pthread_key_t threadProfileKey;
+static pthread_once_t threadProfileOnce = PTHREAD_ONCE_INIT;
+static bool threadProfilesUsed;
+
+static void threadProfileInit(void)
+{
+	if (pthread_key_create(&threadProfileKey, free) != 0)
+		immutilError("pthread_key_create FAILED");
+}
+
+void immutil_setOperationRetryProfile(enum ImmutilOperation operation,
+				      const struct ImmutilRetryProfile *profile)
+{
+	static const struct ImmutilRetryProfile none;
+	profileStore(&operationProfiles[operation],
+		     profile != NULL ? profile : &none);
+}
+
+void immutil_getOperationRetryProfile(enum ImmutilOperation operation,
+				      struct ImmutilRetryProfile *profile)
+{
+	profileLoad(&operationProfiles[operation], profile);
+}
+
+void immutil_setThreadRetryProfile(enum ImmutilOperation operation,
+				   const struct ImmutilRetryProfile *profile)
+{
+	struct ImmutilRetryProfile *profiles;
+
+	pthread_once(&threadProfileOnce, threadProfileInit);
+	profiles = pthread_getspecific(threadProfileKey);
+	if (profiles == NULL) {
+		if (profile == NULL)
+			return;
+		profiles = calloc(IMMUTIL_OP_COUNT,
+				  sizeof(struct ImmutilRetryProfile));
+		if (profiles == NULL)
+			immutilError("Out of memory");
+		if (pthread_setspecific(threadProfileKey, profiles) != 0)
+			immutilError("pthread_setspecific FAILED");
+		__atomic_store_n(&threadProfilesUsed, true, __ATOMIC_RELEASE);
+	}
+	if (profile != NULL)
+		profiles[operation] = *profile;
+	else
+		memset(&profiles[operation], 0,
+		       sizeof(struct ImmutilRetryProfile));
+}
+
+/* Get the profile of a retry loop, fields still 0 are taken from
+   immutilWrapperProfile by the caller */
+static void retryProfile(const struct ImmutilRetry *retry,
+			 struct ImmutilRetryProfile *profile)
+{
+	struct ImmutilRetryProfile p;
+
+	memset(profile, 0, sizeof(*profile));
+	if (retry->operation >= 0) {
+		if (__atomic_load_n(&threadProfilesUsed, __ATOMIC_ACQUIRE)) {
+			const struct ImmutilRetryProfile *profiles =
+			    pthread_getspecific(threadProfileKey);
+			if (profiles != NULL)
+				*profile = profiles[retry->operation];
+		}
+		profileLoad(&operationProfiles[retry->operation], &p);
+		profileMerge(profile, &p);
+	}
+	immutil_getRetryProfile(retry->category, &p);
+	profileMerge(profile, &p);
+}
+
+void immutil_getEffectiveRetryProfile(enum ImmutilOperation operation,
+				      struct ImmutilRetryProfile *profile)
+{
+	struct ImmutilRetry retry;
+
+	retry.category = operationInfo[operation].category;
+	retry.operation = operation;
+	retryProfile(&retry, profile);
+}
+
+void immutil_retryStart(struct ImmutilRetry *retry,
+			enum ImmutilRetryCategory category)
+{
+	retry->category = category;
+	retry->operation = -1;
+	retry->tries = 1;
+	retry->probe = false;
+	retry->start = 0;
+	retry->slept = 0;
+	retry->deadline = 0;
+	retry->maxTries = 0;
+}
+
+/* Set up delays and deadline, at the first retry or wait */
+static void retryInit(struct ImmutilRetry *retry, SaTimeT now)
+{
+	struct ImmutilRetryProfile p;
+	unsigned int interval = immutilWrapperProfile.retryInterval;
+	unsigned int nTries = immutilWrapperProfile.nTries;
+
+	retryProfile(retry, &p);
+	if (p.timeout == 0)
+		p.timeout = nTries > 1 ? (nTries - 1) * interval : 0;
+	if (p.timeout == 0 && nTries > 1) {
+		/* retryInterval 0; nTries tries without sleeping in between,
+		   as the wrappers have always done */
+		retry->maxTries = nTries;
+		p.initialDelay = p.maxDelay = 0;
+	}
+	if (p.initialDelay == 0)
+		p.initialDelay = interval;
+	if (p.maxDelay == 0)
+		p.maxDelay = interval;
+	if (p.maxDelay < p.initialDelay)
+		p.maxDelay = p.initialDelay;
+	retry->deadline = now + MS_TO_NS(p.timeout);
+	retry->base = MS_TO_NS(p.initialDelay);
+	retry->cap = MS_TO_NS(p.maxDelay);
+	retry->delay = retry->base;
+	retry->seed = (SaUint64T)now ^ (SaUint64T)(uintptr_t)retry;
+}
+
+/* xorshift64* */
+static SaUint64T retryRandom(struct ImmutilRetry *retry)
+{
+	SaUint64T x = retry->seed != 0 ? retry->seed : 0x9e3779b97f4a7c15ULL;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	retry->seed = x;
+	return x * 0x2545f4914f6cdd1dULL;
+}
+
+/* Get the delay before the next try, false if the deadline is passed */
+static bool retryDelay(struct ImmutilRetry *retry, SaTimeT now, SaTimeT *delay)
+{
+	SaTimeT range;
+
+	if (retry->deadline == 0)
+		retryInit(retry, now);
+	if (retry->maxTries != 0) {
+		if (retry->tries >= retry->maxTries)
+			return false;
+		*delay = 0;
+		retry->tries++;
+		return true;
+	}
+	if (now >= retry->deadline)
+		return false;
+
+	range = 3 * retry->delay - retry->base;
+	*delay = retry->base + (SaTimeT)(retryRandom(retry) % (range + 1));
+	if (*delay > retry->cap)
+		*delay = retry->cap;
+	retry->delay = *delay;
+	if (*delay > retry->deadline - now)
+		*delay = retry->deadline - now;
+	retry->tries++;
+	return true;
+}
+
+static void retrySleep(struct ImmutilRetry *retry, SaTimeT delay)
+{
+	struct timespec ts;
+	if (delay == 0)
+		return;
+	ts.tv_sec = delay / 1000000000;
+	ts.tv_nsec = delay % 1000000000;
+	nanosleep(&ts, NULL);
+	retry->slept += delay;
+}
+
+/*
+ * Circuit breaker. Tries that return SA_AIS_ERR_TRY_AGAIN or
+ * SA_AIS_ERR_TIMEOUT are counted process wide, and after threshold of them in
+ * a row the breaker opens. While it is open wrapper calls make no retries;
+ * they either return at once (fail fast) or wait on a condition variable
+ * (queue). Every probeInterval one call is let through as a probe. A probe
+ * that returns SA_AIS_OK closes the breaker, and the waiters are released
+ * spread out over releaseSpread. The status and the failure count are read
+ * without the lock on the hot path.
+ */
+
+static struct ImmutilBreakerConfig breakerConfig = {IMMUTIL_BREAKER_OFF, 20,
+						    1000, 200};
+static struct ImmutilBreakerState breaker;
+static pthread_mutex_t breakerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t breakerCond;
+static pthread_once_t breakerOnce = PTHREAD_ONCE_INIT;
+
+static void breakerInit(void)
+{
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&breakerCond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+void immutil_setBreakerConfig(const struct ImmutilBreakerConfig *config)
+{
+	pthread_once(&breakerOnce, breakerInit);
+	pthread_mutex_lock(&breakerLock);
+	breakerConfig = *config;
+	if (config->mode == IMMUTIL_BREAKER_OFF) {
+		__atomic_store_n(&breaker.status, IMMUTIL_BREAKER_CLOSED,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&breaker.consecutiveFailures, 0,
+				 __ATOMIC_RELAXED);
+		pthread_cond_broadcast(&breakerCond);
+	}
+	pthread_mutex_unlock(&breakerLock);
+}
+
+void immutil_getBreakerConfig(struct ImmutilBreakerConfig *config)
+{
+	pthread_mutex_lock(&breakerLock);
+	*config = breakerConfig;
+	pthread_mutex_unlock(&breakerLock);
+}
+
+void immutil_getBreakerState(struct ImmutilBreakerState *state)
+{
+	pthread_mutex_lock(&breakerLock);
+	*state = breaker;
+	pthread_mutex_unlock(&breakerLock);
+}
+
+static bool breakerOff(void)
+{
+	return __atomic_load_n(&breakerConfig.mode, __ATOMIC_RELAXED) ==
+	       IMMUTIL_BREAKER_OFF;
+}
+
+static bool breakerClosed(void)
+{
+	return __atomic_load_n(&breaker.status, __ATOMIC_ACQUIRE) ==
+	       IMMUTIL_BREAKER_CLOSED;
+}
+
+/* Count the result of a try */
+static void breakerResult(struct ImmutilRetry *retry, SaAisErrorT rc)
+{
+	bool probe = retry->probe;
+
+	retry->probe = false;
+	if (breakerOff())
+		return;
+	if (rc == SA_AIS_ERR_TRY_AGAIN || rc == SA_AIS_ERR_TIMEOUT) {
+		unsigned int n = __atomic_add_fetch(
+		    &breaker.consecutiveFailures, 1, __ATOMIC_RELAXED);
+		if (!probe && (n < breakerConfig.threshold || !breakerClosed()))
+			return;
+		pthread_mutex_lock(&breakerLock);
+		if (probe || breaker.status == IMMUTIL_BREAKER_CLOSED) {
+			if (breaker.status == IMMUTIL_BREAKER_CLOSED)
+				breaker.opened++;
+			breaker.openedAt = monotonicTime();
+			__atomic_store_n(&breaker.status, IMMUTIL_BREAKER_OPEN,
+					 __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&breakerLock);
+	} else {
+		if (__atomic_load_n(&breaker.consecutiveFailures,
+				    __ATOMIC_RELAXED) != 0)
+			__atomic_store_n(&breaker.consecutiveFailures, 0,
+					 __ATOMIC_RELAXED);
+		/* Only a probe closes it, and only if IMM served it; a try
+		   made before the breaker opened proves nothing */
+		if (breakerClosed() || !probe)
+			return;
+		pthread_mutex_lock(&breakerLock);
+		if (rc == SA_AIS_OK) {
+			__atomic_store_n(&breaker.status,
+					 IMMUTIL_BREAKER_CLOSED,
+					 __ATOMIC_RELEASE);
+			pthread_cond_broadcast(&breakerCond);
+		} else {
+			breaker.openedAt = monotonicTime();
+			__atomic_store_n(&breaker.status, IMMUTIL_BREAKER_OPEN,
+					 __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&breakerLock);
+	}
+}
+
+/*
+ * Pass the breaker before a try. Return false if the try shall not be made,
+ * the breaker is open and the call fails fast or reached its deadline.
+ */
+static bool breakerPass(struct ImmutilRetry *retry)
+{
+	SaTimeT now, wakeAt, spread;
+	struct timespec ts;
+	bool waited = false;
+
+	if (breakerOff() || breakerClosed())
+		return true;
+
+	pthread_once(&breakerOnce, breakerInit);
+	pthread_mutex_lock(&breakerLock);
+	while (breaker.status != IMMUTIL_BREAKER_CLOSED) {
+		SaTimeT probeAt =
+		    breaker.openedAt + MS_TO_NS(breakerConfig.probeInterval);
+		now = monotonicTime();
+		if (breaker.status == IMMUTIL_BREAKER_OPEN && now >= probeAt) {
+			__atomic_store_n(&breaker.status,
+					 IMMUTIL_BREAKER_HALF_OPEN,
+					 __ATOMIC_RELAXED);
+			breaker.probes++;
+			retry->probe = true;
+			pthread_mutex_unlock(&breakerLock);
+			return true;
+		}
+		if (breakerConfig.mode == IMMUTIL_BREAKER_FAIL_FAST) {
+			breaker.rejected++;
+			pthread_mutex_unlock(&breakerLock);
+			return false;
+		}
+		if (retry->deadline == 0)
+			retryInit(retry, now);
+		if (now >= retry->deadline) {
+			pthread_mutex_unlock(&breakerLock);
+			return false;
+		}
+
+		/* Wake up for the next probe, or later if a probe is made */
+		wakeAt = breaker.status == IMMUTIL_BREAKER_OPEN
+			     ? probeAt
+			     : now + MS_TO_NS(breakerConfig.probeInterval);
+		if (wakeAt > retry->deadline)
+			wakeAt = retry->deadline;
+		ts.tv_sec = wakeAt / 1000000000;
+		ts.tv_nsec = wakeAt % 1000000000;
+		if (!waited)
+			breaker.queued++;
+		waited = true;
+		breaker.waiting++;
+		pthread_cond_timedwait(&breakerCond, &breakerLock, &ts);
+		breaker.waiting--;
+	}
+	spread = MS_TO_NS(breakerConfig.releaseSpread);
+	pthread_mutex_unlock(&breakerLock);
+
+	if (waited && spread > 0) {
+		now = monotonicTime();
+		spread = retryRandom(retry) % spread;
+		if (spread > retry->deadline - now)
+			spread = now < retry->deadline ? retry->deadline - now
+						       : 0;
+		retrySleep(retry, spread);
+	}
+	return true;
+}
+
+/*
+ * Start the retry loop of a wrapper. Returns SA_AIS_ERR_TRY_AGAIN without a
+ * try if the breaker fails the call fast, or it waited for the breaker until
+ * the deadline, else SA_AIS_OK.
+ */
+static SaAisErrorT retryStart(struct ImmutilRetry *retry,
+			      enum ImmutilOperation operation)
+{
+	immutil_retryStart(retry, operationInfo[operation].category);
+	retry->operation = operation;
+	if (__atomic_load_n(&telemetryEnabled, __ATOMIC_RELAXED))
+		retry->start = monotonicTime();
+	if (breakerPass(retry))
+		return SA_AIS_OK;
+	if (retry->start != 0)
+		telemetryRecord(retry, SA_AIS_ERR_TRY_AGAIN);
+	return SA_AIS_ERR_TRY_AGAIN;
+}
+
+bool immutil_retry(struct ImmutilRetry *retry, SaAisErrorT rc)
+{
+	bool again = false;
+	SaTimeT delay;
+
+	breakerResult(retry, rc);
+	if (rc == SA_AIS_ERR_TRY_AGAIN) {
+		if (!breakerOff() && !breakerClosed()) {
+			/* Wait for the breaker instead of backing off */
+			if ((again = breakerPass(retry)))
+				retry->tries++;
+		} else if (retryDelay(retry, monotonicTime(), &delay)) {
+			retrySleep(retry, delay);
+			again = true;
+		}
+	}
+	if (!again && retry->start != 0)
+		telemetryRecord(retry, rc);
+	return again;
+}
+
+SaAisErrorT
+immutil_saImmOiInitialize_2(SaImmOiHandleT *immOiHandle,
+			    const SaImmOiCallbacksT_2 *immOiCallbacks,
+			    const SaVersionT *version)
+{
+	/* Version parameter is in/out i.e. must be mutable and should not be
+	   re-used from previous call in a retry loop. */
+	SaVersionT localVer = *version;
+
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_INITIALIZE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			localVer = *version;
+			rc = saImmOiInitialize_2(immOiHandle, immOiCallbacks,
+						 &localVer);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiInitialize FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOiInitialize_o3(SaImmOiHandleT *immOiHandle,
+			     const SaImmOiCallbacksT_o3 *immOiCallbacks,
+			     const SaVersionT *version)
+{
+	/* Version parameter is in/out i.e. must be mutable and should not be
+	   re-used from previous call in a retry loop. */
+	SaVersionT localVer = *version;
+
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_INITIALIZE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			localVer = *version;
+			rc = saImmOiInitialize_o3(immOiHandle, immOiCallbacks,
+						  &localVer);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiInitialize_o3 FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOiSelectionObjectGet(SaImmOiHandleT immOiHandle,
+				  SaSelectionObjectT *selectionObject)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_SELECTION_OBJECT_GET);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiSelectionObjectGet(immOiHandle,
+						       selectionObject);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiSelectionObjectGet FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiClassImplementerSet(SaImmOiHandleT immOiHandle,
+					       const char *className)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_CLASS_IMPLEMENTER_SET);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiClassImplementerSet(
+			    immOiHandle, (const SaImmClassNameT)className);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiClassImplementerSet FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiClassImplementerRelease(SaImmOiHandleT immOiHandle,
+						   const char *className)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_CLASS_IMPLEMENTER_RELEASE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiClassImplementerRelease(
+			    immOiHandle, (const SaImmClassNameT)className);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiClassImplementerRelease FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiObjectImplementerSet(SaImmOiHandleT immOiHandle,
+						const SaNameT *objectName,
+						SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_SET);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiObjectImplementerSet(immOiHandle,
+							 objectName, scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiObjectImplementerSet_o3(SaImmOiHandleT immOiHandle,
+						   const char *objectName,
+						   SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_SET_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiObjectImplementerSet_o3(
+			    immOiHandle, (SaConstStringT)objectName, scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiObjectImplementerRelease(SaImmOiHandleT immOiHandle,
+						    const SaNameT *objectName,
+						    SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_RELEASE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiObjectImplementerRelease(immOiHandle,
+							     objectName, scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiObjectImplementerRelease_o3(
+    SaImmOiHandleT immOiHandle, const char *objectName, SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_RELEASE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiObjectImplementerRelease_o3(
+			    immOiHandle, (SaConstStringT)objectName, scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOiImplementerSet(SaImmOiHandleT immOiHandle,
+			      const SaImmOiImplementerNameT implementerName)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_IMPLEMENTER_SET);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiImplementerSet(immOiHandle,
+						   implementerName);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiImplementerSet FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiImplementerClear(SaImmOiHandleT immOiHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_IMPLEMENTER_CLEAR);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiImplementerClear(immOiHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiImplementerClear FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiRtObjectCreate_2(
+    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
+    const SaNameT *parentName, const SaImmAttrValuesT_2 **attrValues)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_RT_OBJECT_CREATE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiRtObjectCreate_2(immOiHandle, className,
+						     parentName, attrValues);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiRtObjectCreate_2 FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiRtObjectCreate_o2(
+    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
+    const char *parentName, const SaImmAttrValuesT_2 **attrValues)
+{
+	SaNameT parent_name;
+	if (parentName)
+		osaf_extended_name_lend(parentName, &parent_name);
+	else
+		osaf_extended_name_clear(&parent_name);
+
+	SaAisErrorT rc = immutil_saImmOiRtObjectCreate_2(
+	    immOiHandle, className, &parent_name, attrValues);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiRtObjectCreate_o3(
+    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
+    const char *objectName, const SaImmAttrValuesT_2 **attrValues)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_RT_OBJECT_CREATE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiRtObjectCreate_o3(
+			     immOiHandle, className, (SaConstStringT)objectName,
+			    attrValues);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiRtObjectDelete(SaImmOiHandleT immOiHandle,
+					  const SaNameT *objectName)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_RT_OBJECT_DELETE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiRtObjectDelete(immOiHandle, objectName);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiRtObjectDelete FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiRtObjectDelete_o2(SaImmOiHandleT immOiHandle,
+					     const char *objectName)
+{
+	SaNameT obj_name;
+	if (objectName)
+		osaf_extended_name_lend(objectName, &obj_name);
+	else
+		osaf_extended_name_clear(&obj_name);
+
+	SaAisErrorT rc = immutil_saImmOiRtObjectDelete(immOiHandle, &obj_name);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiRtObjectDelete_o3(SaImmOiHandleT immOiHandle,
+					     const char *objectName)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_RT_OBJECT_DELETE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiRtObjectDelete_o3(
+			     immOiHandle, (SaConstStringT)objectName);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOiRtObjectUpdate_2(SaImmOiHandleT immOiHandle,
+				const SaNameT *objectName,
+				const SaImmAttrModificationT_2 **attrMods)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_RT_OBJECT_UPDATE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiRtObjectUpdate_2(immOiHandle, objectName,
+						     attrMods);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiRtObjectUpdate_2 FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOiRtObjectUpdate_o2(SaImmOiHandleT immOiHandle,
+				 const char *objectName,
+				 const SaImmAttrModificationT_2 **attrMods)
+{
+	SaNameT obj_name;
+	if (objectName)
+		osaf_extended_name_lend(objectName, &obj_name);
+	else
+		osaf_extended_name_clear(&obj_name);
+
+	SaAisErrorT rc =
+	    immutil_saImmOiRtObjectUpdate_2(immOiHandle, &obj_name, attrMods);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOiRtObjectUpdate_o3(SaImmOiHandleT immOiHandle,
+				 const char *objectName,
+				 const SaImmAttrModificationT_2 **attrMods)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_RT_OBJECT_UPDATE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiRtObjectUpdate_o3(
+			    immOiHandle, (SaConstStringT)objectName, attrMods);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiAdminOperationResult(SaImmOiHandleT immOiHandle,
+						SaInvocationT invocation,
+						SaAisErrorT result)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_ADMIN_OPERATION_RESULT);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiAdminOperationResult(immOiHandle,
+							 invocation, result);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiAdminOperationResult FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiAdminOperationResult_o2(
+    SaImmOiHandleT immOiHandle, SaInvocationT invocation, SaAisErrorT result,
+    const SaImmAdminOperationParamsT_2 **returnParams)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_ADMIN_OPERATION_RESULT_O2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiAdminOperationResult_o2(immOiHandle,
+							    invocation, result,
+							    returnParams);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiAdminOperationResult FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOiAugmentCcbInitialize(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId64,
+    SaImmCcbHandleT *ccbHandle, SaImmAdminOwnerHandleT *ownerHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_AUGMENT_CCB_INITIALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiAugmentCcbInitialize(immOiHandle, ccbId64,
+							 ccbHandle,
+							 ownerHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiAugmentCcbInitialize FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmInitialize(SaImmHandleT *immHandle,
+				      const SaImmCallbacksT *immCallbacks,
+				      const SaVersionT *version)
+{
+	/* Version parameter is in/out i.e. must be mutable and should not be
+	   re-used from previous call in a retry loop. */
+	SaVersionT localVer = *version;
+
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_INITIALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			localVer = *version;
+			rc = saImmOmInitialize(immHandle, immCallbacks,
+					       &localVer);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmInitialize FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmInitialize_o2(SaImmHandleT *immHandle,
+					 const SaImmCallbacksT_o2 *immCallbacks,
+					 SaVersionT *version)
+{
+	/* Version parameter is in/out i.e. must be mutable and should not be
+	   re-used from previous call in a retry loop. */
+	SaVersionT localVer = *version;
+
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_INITIALIZE_O2);
+	if (rc == SA_AIS_OK)
+		do {
+			localVer = *version;
+			rc = saImmOmInitialize_o2(immHandle, immCallbacks,
+						  &localVer);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmSelectionObjectGet(SaImmHandleT immHandle,
+				  SaSelectionObjectT *selectionObject)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_SELECTION_OBJECT_GET);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmSelectionObjectGet(immHandle,
+						       selectionObject);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmFinalize(SaImmHandleT immHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_FINALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmFinalize(immHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmFinalize FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmAccessorInitialize(SaImmHandleT immHandle,
+				  SaImmAccessorHandleT *accessorHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ACCESSOR_INITIALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAccessorInitialize(immHandle,
+						       accessorHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAccessorInitialize FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAccessorGet_2(SaImmAccessorHandleT accessorHandle,
+					 const SaNameT *objectName,
+					 const SaImmAttrNameT *attributeNames,
+					 SaImmAttrValuesT_2 ***attributes)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ACCESSOR_GET_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAccessorGet_2(accessorHandle, objectName,
+						  attributeNames, attributes);
+		} while (immutil_retry(&retry, rc));
+	if ((rc != SA_AIS_OK) && (rc != SA_AIS_ERR_NOT_EXIST) &&
+	    immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAccessorGet FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAccessorGet_o2(SaImmAccessorHandleT accessorHandle,
+					  const char *objectName,
+					  const SaImmAttrNameT *attributeNames,
+					  SaImmAttrValuesT_2 ***attributes)
+{
+	SaNameT obj_name;
+	if (objectName)
+		osaf_extended_name_lend(objectName, &obj_name);
+	else
+		osaf_extended_name_clear(&obj_name);
+
+	SaAisErrorT rc = immutil_saImmOmAccessorGet_2(
+	    accessorHandle, &obj_name, attributeNames, attributes);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAccessorGet_o3(SaImmAccessorHandleT accessorHandle,
+					  const char *objectName,
+					  const SaImmAttrNameT *attributeNames,
+					  SaImmAttrValuesT_2 ***attributes)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ACCESSOR_GET_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAccessorGet_o3(accessorHandle,
+						   (SaConstStringT)objectName,
+						   attributeNames, attributes);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && rc != SA_AIS_ERR_NOT_EXIST &&
+	    immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmAccessorGetConfigAttrs(SaImmAccessorHandleT accessorHandle,
+				      const SaNameT *objectName,
+				      SaImmAttrValuesT_2 ***attributes)
+{
+	SaImmAttrNameT accessorGetConfigAttrsToken[2] = {
+	    "SA_IMM_SEARCH_GET_CONFIG_ATTR", NULL};
+	/* This is a hack to cater for the very common simple case of the OM
+	   user needing to access ONE object, but only its config
+	   attributes. The saImmOmAccessorGet_2 call has no search-options. The
+	   trick here is to "tunnel" a search option through the attributes
+	   parameter. The user will get ALL config attributes for the object in
+	   this way. If they only want some of the config attributes, then they
+	   just do a regular accessor get and enumerate the attributes they
+	   want.
+
+	   The support for thus is really inside the implementation of
+	   saImmOmSearchInitialize, which saImmOmAccessorGet_2 uses in its
+	   implementation. If it detects only one attribute in the attributes
+	   list and the name of that attribute is
+	   'SA_IMM_SEARCH_GET_CONFIG_ATTR' then it will assume that the user
+	   does not actually want an attribute with *that* name, but wants all
+	   config attribues.  This feature is only available with the A.2.11
+	   version of the IMMA-API.
+	*/
+
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ACCESSOR_GET_CONFIG_ATTRS);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAccessorGet_2(accessorHandle, objectName,
+						  accessorGetConfigAttrsToken,
+						  attributes);
+		} while (immutil_retry(&retry, rc));
+	if ((rc != SA_AIS_OK) && (rc != SA_AIS_ERR_NOT_EXIST) &&
+	    immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAccessorGet FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAccessorFinalize(SaImmAccessorHandleT accessorHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ACCESSOR_FINALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAccessorFinalize(accessorHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAccessorFinalize FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmSearchInitialize_2(
+    SaImmHandleT immHandle, const SaNameT *rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT searchOptions,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_SEARCH_INITIALIZE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmSearchInitialize_2(immHandle, rootName,
+						       scope, searchOptions,
+						       searchParam,
+						       attributeNames,
+						       searchHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc == SA_AIS_ERR_NOT_EXIST)
+		return rc;
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmSearchInitialize FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmSearchInitialize_o2(
+    SaImmHandleT immHandle, const char *rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT searchOptions,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+{
+	SaNameT root_name;
+	if (rootName)
+		osaf_extended_name_lend(rootName, &root_name);
+	else
+		osaf_extended_name_clear(&root_name);
+
+	SaAisErrorT rc = immutil_saImmOmSearchInitialize_2(
+	    immHandle, &root_name, scope, searchOptions, searchParam,
+	    attributeNames, searchHandle);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmSearchInitialize_o3(
+    SaImmHandleT immHandle, const char *rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT searchOptions,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_SEARCH_INITIALIZE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmSearchInitialize_o3(
+			     immHandle, (SaConstStringT)rootName, scope,
+			    searchOptions, searchParam, attributeNames,
+			    searchHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc == SA_AIS_ERR_NOT_EXIST)
+		return rc;
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmSearchFinalize(SaImmSearchHandleT searchHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_SEARCH_FINALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmSearchFinalize(searchHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmSearchFinalize FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmSearchNext_2(SaImmSearchHandleT searchHandle,
+					SaNameT *objectName,
+					SaImmAttrValuesT_2 ***attributes)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_SEARCH_NEXT_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmSearchNext_2(searchHandle, objectName,
+						 attributes);
+		} while (immutil_retry(&retry, rc));
+	if (rc == SA_AIS_ERR_NOT_EXIST)
+		return rc;
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmSearchNext FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmSearchNext_o2(SaImmSearchHandleT searchHandle,
+					 char **objectName,
+					 SaImmAttrValuesT_2 ***attributes)
+{
+	SaNameT obj_name;
+	const char *obj;
+
+	SaAisErrorT rc =
+	    immutil_saImmOmSearchNext_2(searchHandle, &obj_name, attributes);
+	if (rc == SA_AIS_OK) {
+		obj = osaf_extended_name_borrow(&obj_name);
+		*objectName = (char *)malloc(strlen(obj) + 1);
+		strcpy(*objectName, obj);
+	} else
+		*objectName = NULL;
+
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmSearchNext_o3(SaImmSearchHandleT searchHandle,
+					 char **objectName,
+					 SaImmAttrValuesT_2 ***attributes)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_SEARCH_NEXT_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmSearchNext_o3(searchHandle,
+						  (SaStringT *)objectName,
+						  attributes);
+		} while (immutil_retry(&retry, rc));
+	if (rc == SA_AIS_ERR_NOT_EXIST)
+		return rc;
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOwnerClear(SaImmHandleT immHandle,
+					   const SaNameT **objectNames,
+					   SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_CLEAR);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerClear(immHandle, objectNames,
+						    scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAdminOwnerClear FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOwnerClear_o2(SaImmHandleT immHandle,
+					      const char **objectNames,
+					      SaImmScopeT scope)
+{
+	int i = 0;
+
+	while (objectNames[i]) {
+		i++;
+	}
+	SaNameT **obj_names = (SaNameT **)malloc((i + 1) * sizeof(SaNameT *));
+	i = 0;
+
+	while (objectNames[i]) {
+		obj_names[i] = (SaNameT *)malloc(sizeof(SaNameT));
+		osaf_extended_name_lend(objectNames[i], obj_names[i]);
+		i++;
+	}
+	obj_names[i] = NULL;
+
+	SaAisErrorT rc = immutil_saImmOmAdminOwnerClear(
+	    immHandle, (const SaNameT **)obj_names, scope);
+
+	i = 0;
+	while (obj_names[i]) {
+		free(obj_names[i]);
+		i++;
+	}
+	free(obj_names);
+
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOwnerClear_o3(SaImmHandleT immHandle,
+					      const char **objectNames,
+					      SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_CLEAR_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerClear_o3(
+			    immHandle, (SaConstStringT *)objectNames, scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmClassCreate_2(SaImmCcbHandleT immCcbHandle,
+			     const SaImmClassNameT className,
+			     const SaImmClassCategoryT classCategory,
+			     const SaImmAttrDefinitionT_2 **attrDefinitions)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CLASS_CREATE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmClassCreate_2(immCcbHandle, className,
+						  classCategory,
+						  attrDefinitions);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmClassCreate_2 FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmClassDelete(SaImmCcbHandleT immCcbHandle,
+				       const SaImmClassNameT className)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CLASS_DELETE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmClassDelete(immCcbHandle, className);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmClassDelete FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+////////////////////////////////////////////
+SaAisErrorT immutil_saImmOiFinalize(SaImmOiHandleT immOiHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OI_FINALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiFinalize(immOiHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOiFinalize FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOwnerInitialize(
+    SaImmHandleT immHandle, const SaImmAdminOwnerNameT admOwnerName,
+    SaBoolT relOwnOnFinalize, SaImmAdminOwnerHandleT *ownerHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_INITIALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerInitialize(immHandle,
+							 admOwnerName,
+							 relOwnOnFinalize,
+							 ownerHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAdminOwnerInitialize FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmAdminOwnerFinalize(SaImmAdminOwnerHandleT ownerHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_FINALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerFinalize(ownerHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAdminOwnerFinalize FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbInitialize(SaImmAdminOwnerHandleT ownerHandle,
+					 SaImmCcbFlagsT ccbFlags,
+					 SaImmCcbHandleT *immCcbHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_INITIALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbInitialize(ownerHandle, ccbFlags,
+						  immCcbHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbInitialize FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbFinalize(SaImmCcbHandleT immCcbHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_FINALIZE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbFinalize(immCcbHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbFinalize FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbApply(SaImmCcbHandleT immCcbHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_APPLY);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbApply(immCcbHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbApply FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbAbort(SaImmCcbHandleT immCcbHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_ABORT);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbAbort(immCcbHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbAbort FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbValidate(SaImmCcbHandleT immCcbHandle)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_VALIDATE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbValidate(immCcbHandle);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbValidate FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOwnerSet(SaImmAdminOwnerHandleT ownerHandle,
+					 const SaNameT **name,
+					 SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_SET);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerSet(ownerHandle, name, scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAdminOwnerSet FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOwnerSet_o2(SaImmAdminOwnerHandleT ownerHandle,
+					    const char **name,
+					    SaImmScopeT scope)
+{
+	int i = 0;
+
+	while (name[i]) {
+		i++;
+	}
+	SaNameT **obj_names = (SaNameT **)malloc((i + 1) * sizeof(SaNameT *));
+
+	i = 0;
+	while (name[i]) {
+		obj_names[i] = (SaNameT *)malloc(sizeof(SaNameT));
+		osaf_extended_name_lend(name[i], obj_names[i]);
+		i++;
+	}
+	obj_names[i] = NULL;
+	SaAisErrorT rc = immutil_saImmOmAdminOwnerSet(
+	    ownerHandle, (const SaNameT **)obj_names, scope);
+
+	i = 0;
+	while (obj_names[i]) {
+		free(obj_names[i]);
+		i++;
+	}
+	free(obj_names);
+
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmAdminOwnerSet_o3(SaImmAdminOwnerHandleT adminOwnerHandle,
+				const char **objectNames, SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_SET_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerSet_o3(
+			     adminOwnerHandle, (SaConstStringT *)objectNames,
+			    scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOwnerRelease(SaImmAdminOwnerHandleT ownerHandle,
+					     const SaNameT **name,
+					     SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_RELEASE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerRelease(ownerHandle, name, scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAdminOwnerRelease FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmAdminOwnerRelease_o2(SaImmAdminOwnerHandleT ownerHandle,
+				    const char **name, SaImmScopeT scope)
+{
+	int i = 0;
+
+	while (name[i]) {
+		i++;
+	}
+	SaNameT **obj_names = (SaNameT **)malloc((i + 1) * sizeof(SaNameT *));
+
+	i = 0;
+	while (name[i]) {
+		obj_names[i] = (SaNameT *)malloc(sizeof(SaNameT));
+		osaf_extended_name_lend(name[i], obj_names[i]);
+		i++;
+	}
+	obj_names[i] = NULL;
+
+	SaAisErrorT rc = immutil_saImmOmAdminOwnerRelease(
+	    ownerHandle, (const SaNameT **)obj_names, scope);
+	i = 0;
+	while (obj_names[i]) {
+		free(obj_names[i]);
+		i++;
+	}
+	free(obj_names);
+
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmAdminOwnerRelease_o3(SaImmAdminOwnerHandleT adminOwnerHandle,
+				    const char **objectNames, SaImmScopeT scope)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OWNER_RELEASE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOwnerRelease_o3(
+			     adminOwnerHandle, (SaConstStringT *)objectNames,
+			    scope);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOperationInvoke_o214(
+    SaImmAdminOwnerHandleT ownerHandle, const char *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout,
+    SaImmAdminOperationParamsT_2 ***returnParams)
+{
+	SaNameT obj_name;
+	if (objectName)
+		osaf_extended_name_lend(objectName, &obj_name);
+	else
+		osaf_extended_name_clear(&obj_name);
+
+	SaAisErrorT rc = immutil_saImmOmAdminOperationInvoke_o2(
+	    ownerHandle, &obj_name, continuationId, operationId, params,
+	    operationReturnValue, timeout, returnParams);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOperationInvoke_o2(
+    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout,
+    SaImmAdminOperationParamsT_2 ***returnParams)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_O2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOperationInvoke_o2(
+			     ownerHandle, objectName, continuationId,
+			    operationId, params, operationReturnValue, timeout,
+			    returnParams);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAdminOperationInvoke_o2 FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOperationInvoke_2(
+    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOperationInvoke_2(ownerHandle,
+							   objectName,
+							   continuationId,
+							   operationId, params,
+							   operationReturnValue,
+							   timeout);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmAdminOperationInvoke_2 FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOperationInvoke_o3(
+    SaImmAdminOwnerHandleT ownerHandle, const char *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout,
+    SaImmAdminOperationParamsT_2 ***returnParams)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOperationInvoke_o3(
+			     ownerHandle, (SaConstStringT)objectName,
+			    continuationId, operationId, params,
+			    operationReturnValue, timeout, returnParams);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOperationInvokeAsync_2(
+    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT userInvocation,
+    const SaNameT *objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_ASYNC_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOperationInvokeAsync_2(ownerHandle,
+								userInvocation,
+								objectName,
+								continuationId,
+								operationId,
+								params);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmAdminOperationInvokeAsync_o3(
+    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT userInvocation,
+    const char *objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_ASYNC_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmAdminOperationInvokeAsync_o3(
+			     ownerHandle, userInvocation,
+			    (SaConstStringT)objectName, continuationId,
+			    operationId, params);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbObjectCreate_2(
+    SaImmCcbHandleT immCcbHandle, const SaImmClassNameT className,
+    const SaNameT *parent, const SaImmAttrValuesT_2 **attrValues)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_OBJECT_CREATE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbObjectCreate_2(immCcbHandle, className,
+						      parent, attrValues);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbObjectCreate_2 FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbObjectCreate_o2(
+    SaImmCcbHandleT immCcbHandle, const SaImmClassNameT className,
+    const char *parent, const SaImmAttrValuesT_2 **attrValues)
+{
+	SaNameT parent_name;
+	if (parent)
+		osaf_extended_name_lend(parent, &parent_name);
+	else
+		osaf_extended_name_clear(&parent_name);
+
+	SaAisErrorT rc = immutil_saImmOmCcbObjectCreate_2(
+	    immCcbHandle, className, &parent_name, attrValues);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbObjectCreate_o3(
+    SaImmCcbHandleT ccbHandle, const char *className,
+    const char *const objectName, const SaImmAttrValuesT_2 **attrValues)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_OBJECT_CREATE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbObjectCreate_o3(
+			    ccbHandle, (const SaImmClassNameT)className,
+			    (const SaConstStringT)objectName, attrValues);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmCcbObjectModify_2(SaImmCcbHandleT immCcbHandle,
+				 const SaNameT *objectName,
+				 const SaImmAttrModificationT_2 **attrMods)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_OBJECT_MODIFY_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbObjectModify_2(immCcbHandle, objectName,
+						      attrMods);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbObjectModify_2 FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmCcbObjectModify_o2(SaImmCcbHandleT immCcbHandle,
+				  const char *objectName,
+				  const SaImmAttrModificationT_2 **attrMods)
+{
+	SaNameT obj_name;
+	if (objectName)
+		osaf_extended_name_lend(objectName, &obj_name);
+	else
+		osaf_extended_name_clear(&obj_name);
+
+	SaAisErrorT rc =
+	    immutil_saImmOmCcbObjectModify_2(immCcbHandle, &obj_name, attrMods);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmCcbObjectModify_o3(SaImmCcbHandleT ccbHandle,
+				  const char *objectName,
+				  const SaImmAttrModificationT_2 **attrMods)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_OBJECT_MODIFY_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbObjectModify_o3(
+			    ccbHandle, (SaConstStringT)objectName, attrMods);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbObjectDelete(SaImmCcbHandleT immCcbHandle,
+					   const SaNameT *objectName)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_OBJECT_DELETE);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbObjectDelete(immCcbHandle, objectName);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbObjectDelete FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbObjectDelete_o2(SaImmCcbHandleT immCcbHandle,
+					      const char *objectName)
+{
+	SaNameT obj_name;
+	if (objectName)
+		osaf_extended_name_lend(objectName, &obj_name);
+	else
+		osaf_extended_name_clear(&obj_name);
+
+	SaAisErrorT rc =
+	    immutil_saImmOmCcbObjectDelete(immCcbHandle, &obj_name);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbObjectDelete_o3(SaImmCcbHandleT ccbHandle,
+					      const char *objectName)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_OBJECT_DELETE_O3);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbObjectDelete_o3(
+			     ccbHandle, (SaConstStringT)objectName);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(" FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT immutil_saImmOmCcbObjectRead(SaImmCcbHandleT ccbHandle,
+					 SaConstStringT objectName,
+					 const SaImmAttrNameT *attributeNames,
+					 SaImmAttrValuesT_2 ***attributes)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CCB_OBJECT_READ);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmCcbObjectRead(ccbHandle, objectName,
+						  attributeNames, attributes);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && rc != SA_AIS_ERR_NOT_EXIST &&
+	    immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmCcbObjectRead FAILED, rc = %d", (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmClassDescriptionGet_2(SaImmHandleT immHandle,
+				     const SaImmClassNameT className,
+				     SaImmClassCategoryT *classCategory,
+				     SaImmAttrDefinitionT_2 ***attrDefinitions)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CLASS_DESCRIPTION_GET_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmClassDescriptionGet_2(immHandle, className,
+							  classCategory,
+							  attrDefinitions);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmClassDescriptionGet_2 FAILED, rc = %d",
+			     (int)rc);
+	return rc;
+}
+
+SaAisErrorT
+immutil_saImmOmClassDescriptionMemoryFree_2(SaImmHandleT immHandle,
+					    SaImmAttrDefinitionT_2 **attrDef)
+{
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
+
+	rc = retryStart(&retry, IMMUTIL_OP_OM_CLASS_DESCRIPTION_MEMORY_FREE_2);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOmClassDescriptionMemoryFree_2(immHandle,
+								 attrDef);
+		} while (immutil_retry(&retry, rc));
+	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
+		immutilError(
+		    "saImmOmClassDescriptionMemoryFree_2 FAILED, rc = %d",
+		    (int)rc);
+	return rc;
+}
+
+/* ----------------------------------------------------------------------
+ * Asynchronous IMM calls; Each request is a small state machine: it is
+ * queued on a timer wheel, called from immutil_asyncDispatch when due, and
+ * either queued again with the backoff of the retry engine on
+ * SA_AIS_ERR_TRY_AGAIN or completed with a callback. The arguments are
+ * copied to an arena owned by the request. Requests on the same handle are
+ * made in order, only the first one of each handle is on the wheel.
+ */
+
+#define WHEEL_SLOTS 256 /* One slot per millisecond tick */
+
+enum AsyncCall {
+	ASYNC_CCB_OBJECT_CREATE,
+	ASYNC_CCB_OBJECT_MODIFY,
+	ASYNC_CCB_OBJECT_DELETE,
+	ASYNC_CCB_APPLY,
+	ASYNC_ACCESSOR_GET,
+	ASYNC_RT_OBJECT_UPDATE,
+	ASYNC_ADMIN_OPERATION_INVOKE
+};
+
+struct AsyncRequest {
+	struct AsyncRequest *next;	     /* Wheel slot list */
+	struct AsyncRequest *nextSameHandle; /* Handle queue */
+	SaUint64T dueTick;
+	enum AsyncCall call;
+	struct ImmutilRetry retry;
+	struct Arena *arena;
+	ImmutilAsyncCallbackT callback;
+	void *arg;
+	SaUint64T handle;
+	const SaNameT *objectName;
+	SaImmClassNameT className;
+	const SaImmAttrValuesT_2 **attrValues;
+	const SaImmAttrModificationT_2 **attrMods;
+	const SaImmAttrNameT *attributeNames;
+	SaImmContinuationIdT continuationId;
+	SaImmAdminOperationIdT operationId;
+	const SaImmAdminOperationParamsT_2 **params;
+	SaTimeT timeout;
+};
+
+/* The requests on one handle, the first one is on the wheel */
+struct AsyncHandleQueue {
+	struct AsyncHandleQueue *next;
+	SaUint64T handle;
+	struct AsyncRequest *head;
+	struct AsyncRequest *tail;
+};
+
+struct ImmutilAsync {
+	pthread_mutex_t lock;
+	int timerFd;
+	SaUint64T armedTick; /* Tick the timer is set for, 0 if not set */
+	SaUint64T nextTick;  /* First tick not processed */
+	unsigned int pending;
+	struct AsyncHandleQueue *queues;
+	struct AsyncRequest *wheel[WHEEL_SLOTS];
+};
+
+static SaUint64T asyncTick(SaTimeT time)
+{
+	return (SaUint64T)time / 1000000;
+}
+
+/* Set the timer for the earliest due request, called with the lock held */
+static void asyncArm(struct ImmutilAsync *async)
+{
+	SaUint64T tick = 0;
+	struct itimerspec its;
+	unsigned int i;
+
+	for (i = 0; i < WHEEL_SLOTS; i++) {
+		struct AsyncRequest *req;
+		for (req = async->wheel[i]; req != NULL; req = req->next)
+			if (tick == 0 || req->dueTick < tick)
+				tick = req->dueTick;
+	}
+	if (tick == async->armedTick)
+		return;
+	memset(&its, 0, sizeof(its));
+	if (tick != 0) {
+		/* A zero it_value disarms, a past one fires at once */
+		its.it_value.tv_sec = tick / 1000;
+		its.it_value.tv_nsec = (tick % 1000) * 1000000 + 1;
+	}
+	if (timerfd_settime(async->timerFd, TFD_TIMER_ABSTIME, &its, NULL) !=
+	    0)
+		immutilError("timerfd_settime FAILED, errno = %d", errno);
+	async->armedTick = tick;
+}
+
+/* Queue a request, called with the lock held */
+static void asyncQueue(struct ImmutilAsync *async, struct AsyncRequest *req,
+		       SaUint64T dueTick)
+{
+	struct AsyncRequest **slot;
+
+	if (dueTick < async->nextTick)
+		dueTick = async->nextTick;
+	req->dueTick = dueTick;
+	slot = &async->wheel[dueTick % WHEEL_SLOTS];
+	req->next = *slot;
+	*slot = req;
+	if (async->armedTick == 0 || dueTick < async->armedTick)
+		asyncArm(async);
+}
+
+static void asyncFree(struct AsyncRequest *req)
+{
+	arenaDelete(req->arena);
+	free(req);
+}
+
+/*
+ * Remove a completed request from its handle queue and put the next one on
+ * the wheel, called with the lock held
+ */
+static void asyncDone(struct ImmutilAsync *async, struct AsyncRequest *req)
+{
+	struct AsyncHandleQueue *queue, **pp;
+
+	for (pp = &async->queues; (queue = *pp) != NULL; pp = &queue->next)
+		if (queue->handle == req->handle)
+			break;
+	assert(queue != NULL && queue->head == req);
+	async->pending--;
+	if ((queue->head = req->nextSameHandle) != NULL) {
+		asyncQueue(async, queue->head, 0);
+	} else {
+		*pp = queue->next;
+		free(queue);
+	}
 }
 
-static void deleteClist(struct Chunk *clist)
+ImmutilAsync_t *immutil_asyncCreate(void)
 {
-	while (clist != NULL) {
-		struct Chunk *chunk = clist;
-		clist = clist->next;
-		free(chunk);
-	}
+	struct ImmutilAsync *async = calloc(1, sizeof(struct ImmutilAsync));
+	if (async == NULL)
+		immutilError("Out of memory");
+	async->timerFd =
+	    timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (async->timerFd < 0)
+		immutilError("timerfd_create FAILED, errno = %d", errno);
+	pthread_mutex_init(&async->lock, NULL);
+	async->nextTick = asyncTick(monotonicTime());
+	return async;
 }
 
-static void *clistMalloc(struct Chunk *clist, size_t size)
+void immutil_asyncDelete(ImmutilAsync_t *async)
 {
-	struct Chunk *chunk;
-
-	size = (size + 3) & ~3;
+	struct AsyncHandleQueue *queue;
+	struct AsyncRequest *req;
 
-	if (size > CHUNK) {
-		chunk = newChunk(clist->next, size);
-		clist->next = chunk;
-		chunk->free = 0;
-		memset(chunk->data, 0, size);
-		return chunk->data;
-	}
-
-	for (chunk = clist; chunk != NULL; chunk = chunk->next) {
-		if (chunk->free >= size) {
-			unsigned char *mem =
-			    chunk->data + (chunk->capacity - chunk->free);
-			chunk->free -= size;
-			memset(mem, 0, size);
-			return mem;
+	if (async == NULL)
+		return;
+	while ((queue = async->queues) != NULL) {
+		async->queues = queue->next;
+		while ((req = queue->head) != NULL) {
+			queue->head = req->nextSameHandle;
+			asyncFree(req);
 		}
+		free(queue);
 	}
-
-	chunk = newChunk(clist->next, CHUNK);
-	clist->next = chunk;
-	chunk->free -= size;
-	memset(chunk->data, 0, size);
-	return chunk->data;
+	close(async->timerFd);
+	pthread_mutex_destroy(&async->lock);
+	free(async);
 }
 
-/* ----------------------------------------------------------------------
- * IMM call wrappers; This wrapper interface offloads the burden to handle
- * return values and retries for each and every IMM-call. It makes the code
- * cleaner.
- */
-
-struct ImmutilWrapperProfile immutilWrapperProfile = {1, 25, 400};
-
-SaAisErrorT
-immutil_saImmOiInitialize_2(SaImmOiHandleT *immOiHandle,
-			    const SaImmOiCallbacksT_2 *immOiCallbacks,
-			    const SaVersionT *version)
+SaAisErrorT immutil_asyncSelectionObjectGet(ImmutilAsync_t *async,
+					    SaSelectionObjectT *selectionObject)
 {
-	/* Version parameter is in/out i.e. must be mutable and should not be
-	   re-used from previous call in a retry loop. */
-	SaVersionT localVer = *version;
-
-	SaAisErrorT rc =
-	    saImmOiInitialize_2(immOiHandle, immOiCallbacks, &localVer);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		localVer = *version;
-		rc =
-		    saImmOiInitialize_2(immOiHandle, immOiCallbacks, &localVer);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiInitialize FAILED, rc = %d", (int)rc);
-	return rc;
+	*selectionObject = (SaSelectionObjectT)async->timerFd;
+	return SA_AIS_OK;
 }
 
-SaAisErrorT
-immutil_saImmOiInitialize_o3(SaImmOiHandleT *immOiHandle,
-			     const SaImmOiCallbacksT_o3 *immOiCallbacks,
-			     const SaVersionT *version)
+unsigned int immutil_asyncPending(ImmutilAsync_t *async)
 {
-	/* Version parameter is in/out i.e. must be mutable and should not be
-	   re-used from previous call in a retry loop. */
-	SaVersionT localVer = *version;
+	unsigned int pending;
+	pthread_mutex_lock(&async->lock);
+	pending = async->pending;
+	pthread_mutex_unlock(&async->lock);
+	return pending;
+}
 
-	SaAisErrorT rc =
-	    saImmOiInitialize_o3(immOiHandle, immOiCallbacks, &localVer);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		localVer = *version;
-		rc = saImmOiInitialize_o3(immOiHandle, immOiCallbacks,
-					  &localVer);
-		nTries++;
+/* Make one IMM call for a request */
+static SaAisErrorT asyncCall(struct AsyncRequest *req,
+			     struct ImmutilAsyncResult *result)
+{
+	switch (req->call) {
+	case ASYNC_CCB_OBJECT_CREATE:
+		return saImmOmCcbObjectCreate_2(req->handle, req->className,
+						req->objectName,
+						req->attrValues);
+	case ASYNC_CCB_OBJECT_MODIFY:
+		return saImmOmCcbObjectModify_2(req->handle, req->objectName,
+						req->attrMods);
+	case ASYNC_CCB_OBJECT_DELETE:
+		return saImmOmCcbObjectDelete(req->handle, req->objectName);
+	case ASYNC_CCB_APPLY:
+		return saImmOmCcbApply(req->handle);
+	case ASYNC_ACCESSOR_GET:
+		return saImmOmAccessorGet_2(req->handle, req->objectName,
+					    req->attributeNames,
+					    &result->attributes);
+	case ASYNC_RT_OBJECT_UPDATE:
+		return saImmOiRtObjectUpdate_2(req->handle, req->objectName,
+					       req->attrMods);
+	case ASYNC_ADMIN_OPERATION_INVOKE:
+		return saImmOmAdminOperationInvoke_2(
+		    req->handle, req->objectName, req->continuationId,
+		    req->operationId, req->params,
+		    &result->operationReturnValue, req->timeout);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiInitialize_o3 FAILED, rc = %d", (int)rc);
-	return rc;
+	return SA_AIS_ERR_LIBRARY;
 }
 
-SaAisErrorT
-immutil_saImmOiSelectionObjectGet(SaImmOiHandleT immOiHandle,
-				  SaSelectionObjectT *selectionObject)
+SaAisErrorT immutil_asyncDispatch(ImmutilAsync_t *async)
 {
-	SaAisErrorT rc =
-	    saImmOiSelectionObjectGet(immOiHandle, selectionObject);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiSelectionObjectGet(immOiHandle, selectionObject);
-		nTries++;
+	struct AsyncRequest *ready = NULL, *req, **pp;
+	SaUint64T nowTick = asyncTick(monotonicTime()), tick, lastTick;
+	SaUint64T expirations;
+
+	/* Clear the selection object */
+	while (read(async->timerFd, &expirations, sizeof(expirations)) > 0)
+		;
+
+	pthread_mutex_lock(&async->lock);
+	lastTick = nowTick;
+	if (nowTick >= async->nextTick + WHEEL_SLOTS)
+		lastTick = async->nextTick + WHEEL_SLOTS - 1;
+	for (tick = async->nextTick; tick <= lastTick; tick++) {
+		pp = &async->wheel[tick % WHEEL_SLOTS];
+		while ((req = *pp) != NULL) {
+			if (req->dueTick <= nowTick) {
+				*pp = req->next;
+				req->next = ready;
+				ready = req;
+			} else {
+				pp = &req->next;
+			}
+		}
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiSelectionObjectGet FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	if (nowTick > async->nextTick)
+		async->nextTick = nowTick;
+	async->armedTick = 0;
+	pthread_mutex_unlock(&async->lock);
+
+	while ((req = ready) != NULL) {
+		struct ImmutilAsyncResult result;
+		SaTimeT now, delay;
+
+		ready = req->next;
+		memset(&result, 0, sizeof(result));
+		result.rc = asyncCall(req, &result);
+		now = monotonicTime();
+		if (result.rc == SA_AIS_ERR_TRY_AGAIN &&
+		    retryDelay(&req->retry, now, &delay)) {
+			pthread_mutex_lock(&async->lock);
+			asyncQueue(async, req, asyncTick(now + delay));
+			pthread_mutex_unlock(&async->lock);
+			continue;
+		}
+		result.tries = req->retry.tries;
+		if (req->callback != NULL)
+			req->callback(&result, req->arg);
+		pthread_mutex_lock(&async->lock);
+		asyncDone(async, req);
+		pthread_mutex_unlock(&async->lock);
+		asyncFree(req);
+	}
+
+	pthread_mutex_lock(&async->lock);
+	asyncArm(async);
+	pthread_mutex_unlock(&async->lock);
+	return SA_AIS_OK;
 }
 
-SaAisErrorT immutil_saImmOiClassImplementerSet(SaImmOiHandleT immOiHandle,
-					       const char *className)
+static struct AsyncRequest *asyncRequest(enum AsyncCall call,
+					 enum ImmutilOperation operation,
+					 SaUint64T handle,
+					 ImmutilAsyncCallbackT callback,
+					 void *arg)
 {
-	SaAisErrorT rc = saImmOiClassImplementerSet(
-	    immOiHandle, (const SaImmClassNameT)className);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiClassImplementerSet(
-		    immOiHandle, (const SaImmClassNameT)className);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiClassImplementerSet FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	struct AsyncRequest *req = calloc(1, sizeof(struct AsyncRequest));
+	if (req == NULL)
+		immutilError("Out of memory");
+	req->call = call;
+	req->arena = arenaCreate();
+	req->handle = handle;
+	req->callback = callback;
+	req->arg = arg;
+	immutil_retryStart(&req->retry, operationInfo[operation].category);
+	req->retry.operation = operation;
+	return req;
 }
 
-SaAisErrorT immutil_saImmOiClassImplementerRelease(SaImmOiHandleT immOiHandle,
-						   const char *className)
+static SaAisErrorT asyncSubmit(struct ImmutilAsync *async,
+			       struct AsyncRequest *req)
 {
-	SaAisErrorT rc = saImmOiClassImplementerRelease(
-	    immOiHandle, (const SaImmClassNameT)className);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiClassImplementerRelease(
-		    immOiHandle, (const SaImmClassNameT)className);
-		nTries++;
+	struct AsyncHandleQueue *queue;
+
+	pthread_mutex_lock(&async->lock);
+	async->pending++;
+	for (queue = async->queues; queue != NULL; queue = queue->next)
+		if (queue->handle == req->handle)
+			break;
+	if (queue != NULL) {
+		queue->tail->nextSameHandle = req;
+		queue->tail = req;
+	} else {
+		queue = calloc(1, sizeof(struct AsyncHandleQueue));
+		if (queue == NULL)
+			immutilError("Out of memory");
+		queue->handle = req->handle;
+		queue->head = queue->tail = req;
+		queue->next = async->queues;
+		async->queues = queue;
+		asyncQueue(async, req, 0);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiClassImplementerRelease FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	pthread_mutex_unlock(&async->lock);
+	return SA_AIS_OK;
 }
 
-SaAisErrorT immutil_saImmOiObjectImplementerSet(SaImmOiHandleT immOiHandle,
-						const SaNameT *objectName,
-						SaImmScopeT scope)
+SaAisErrorT immutil_asyncCcbObjectCreate_2(
+    ImmutilAsync_t *async, SaImmCcbHandleT immCcbHandle,
+    const SaImmClassNameT className, const SaNameT *parent,
+    const SaImmAttrValuesT_2 **attrValues, ImmutilAsyncCallbackT callback,
+    void *arg)
 {
-	SaAisErrorT rc =
-	    saImmOiObjectImplementerSet(immOiHandle, objectName, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc =
-		    saImmOiObjectImplementerSet(immOiHandle, objectName, scope);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	struct AsyncRequest *req =
+	    asyncRequest(ASYNC_CCB_OBJECT_CREATE,
+			 IMMUTIL_OP_OM_CCB_OBJECT_CREATE_2, immCcbHandle,
+			 callback, arg);
+	req->className = dupSaImmClassNameT(req->arena, className);
+	req->objectName = dupSaNameT(req->arena, parent);
+	req->attrValues = dupSaImmAttrValuesT_array(req->arena, attrValues);
+	return asyncSubmit(async, req);
 }
 
-SaAisErrorT immutil_saImmOiObjectImplementerSet_o3(SaImmOiHandleT immOiHandle,
-						   const char *objectName,
-						   SaImmScopeT scope)
+SaAisErrorT immutil_asyncCcbObjectModify_2(
+    ImmutilAsync_t *async, SaImmCcbHandleT immCcbHandle,
+    const SaNameT *objectName, const SaImmAttrModificationT_2 **attrMods,
+    ImmutilAsyncCallbackT callback, void *arg)
 {
-	SaAisErrorT rc = saImmOiObjectImplementerSet_o3(
-	    immOiHandle, (SaConstStringT)objectName, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiObjectImplementerSet_o3(
-		    immOiHandle, (SaConstStringT)objectName, scope);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	struct AsyncRequest *req =
+	    asyncRequest(ASYNC_CCB_OBJECT_MODIFY,
+			 IMMUTIL_OP_OM_CCB_OBJECT_MODIFY_2, immCcbHandle,
+			 callback, arg);
+	req->objectName = dupSaNameT(req->arena, objectName);
+	req->attrMods = dupSaImmAttrModificationT_array(req->arena, attrMods);
+	return asyncSubmit(async, req);
 }
 
-SaAisErrorT immutil_saImmOiObjectImplementerRelease(SaImmOiHandleT immOiHandle,
-						    const SaNameT *objectName,
-						    SaImmScopeT scope)
+SaAisErrorT immutil_asyncCcbObjectDelete(ImmutilAsync_t *async,
+					 SaImmCcbHandleT immCcbHandle,
+					 const SaNameT *objectName,
+					 ImmutilAsyncCallbackT callback,
+					 void *arg)
 {
-	SaAisErrorT rc =
-	    saImmOiObjectImplementerRelease(immOiHandle, objectName, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiObjectImplementerRelease(immOiHandle, objectName,
-						     scope);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	struct AsyncRequest *req =
+	    asyncRequest(ASYNC_CCB_OBJECT_DELETE,
+			 IMMUTIL_OP_OM_CCB_OBJECT_DELETE, immCcbHandle,
+			 callback, arg);
+	req->objectName = dupSaNameT(req->arena, objectName);
+	return asyncSubmit(async, req);
 }
 
-SaAisErrorT immutil_saImmOiObjectImplementerRelease_o3(
-    SaImmOiHandleT immOiHandle, const char *objectName, SaImmScopeT scope)
+SaAisErrorT immutil_asyncCcbApply(ImmutilAsync_t *async,
+				  SaImmCcbHandleT immCcbHandle,
+				  ImmutilAsyncCallbackT callback, void *arg)
 {
-	SaAisErrorT rc = saImmOiObjectImplementerRelease_o3(
-	    immOiHandle, (SaConstStringT)objectName, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiObjectImplementerRelease_o3(
-		    immOiHandle, (SaConstStringT)objectName, scope);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	return asyncSubmit(async, asyncRequest(ASYNC_CCB_APPLY,
+					       IMMUTIL_OP_OM_CCB_APPLY,
+					       immCcbHandle, callback, arg));
 }
 
-SaAisErrorT
-immutil_saImmOiImplementerSet(SaImmOiHandleT immOiHandle,
-			      const SaImmOiImplementerNameT implementerName)
+SaAisErrorT immutil_asyncAccessorGet_2(ImmutilAsync_t *async,
+				       SaImmAccessorHandleT accessorHandle,
+				       const SaNameT *objectName,
+				       const SaImmAttrNameT *attributeNames,
+				       ImmutilAsyncCallbackT callback,
+				       void *arg)
 {
-	SaAisErrorT rc = saImmOiImplementerSet(immOiHandle, implementerName);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiImplementerSet(immOiHandle, implementerName);
-		nTries++;
+	struct AsyncRequest *req =
+	    asyncRequest(ASYNC_ACCESSOR_GET,
+			 IMMUTIL_OP_OM_ACCESSOR_GET_2, accessorHandle,
+			 callback, arg);
+	req->objectName = dupSaNameT(req->arena, objectName);
+	if (attributeNames != NULL) {
+		SaImmAttrNameT *names;
+		size_t i, n = 0;
+		while (attributeNames[n] != NULL)
+			n++;
+		names = arenaMalloc(req->arena, (n + 1) * sizeof(*names));
+		for (i = 0; i < n; i++)
+			names[i] = dupStr(req->arena, attributeNames[i]);
+		names[n] = NULL;
+		req->attributeNames = names;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiImplementerSet FAILED, rc = %d", (int)rc);
-	return rc;
+	return asyncSubmit(async, req);
 }
 
-SaAisErrorT immutil_saImmOiImplementerClear(SaImmOiHandleT immOiHandle)
+SaAisErrorT immutil_asyncRtObjectUpdate_2(
+    ImmutilAsync_t *async, SaImmOiHandleT immOiHandle,
+    const SaNameT *objectName, const SaImmAttrModificationT_2 **attrMods,
+    ImmutilAsyncCallbackT callback, void *arg)
 {
-	SaAisErrorT rc = saImmOiImplementerClear(immOiHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiImplementerClear(immOiHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiImplementerClear FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	struct AsyncRequest *req =
+	    asyncRequest(ASYNC_RT_OBJECT_UPDATE,
+			 IMMUTIL_OP_OI_RT_OBJECT_UPDATE_2, immOiHandle,
+			 callback, arg);
+	req->objectName = dupSaNameT(req->arena, objectName);
+	req->attrMods = dupSaImmAttrModificationT_array(req->arena, attrMods);
+	return asyncSubmit(async, req);
 }
 
-SaAisErrorT immutil_saImmOiRtObjectCreate_2(
-    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
-    const SaNameT *parentName, const SaImmAttrValuesT_2 **attrValues)
+SaAisErrorT immutil_asyncAdminOperationInvoke_2(
+    ImmutilAsync_t *async, SaImmAdminOwnerHandleT ownerHandle,
+    const SaNameT *objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params, SaTimeT timeout,
+    ImmutilAsyncCallbackT callback, void *arg)
 {
-	SaAisErrorT rc = saImmOiRtObjectCreate_2(immOiHandle, className,
-						 parentName, attrValues);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiRtObjectCreate_2(immOiHandle, className, parentName,
-					     attrValues);
-		nTries++;
+	struct AsyncRequest *req =
+	    asyncRequest(ASYNC_ADMIN_OPERATION_INVOKE,
+			 IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_2, ownerHandle,
+			 callback, arg);
+	SaImmAdminOperationParamsT_2 **copy;
+	size_t i, n = 0;
+
+	req->objectName = dupSaNameT(req->arena, objectName);
+	req->continuationId = continuationId;
+	req->operationId = operationId;
+	req->timeout = timeout;
+	while (params != NULL && params[n] != NULL)
+		n++;
+	copy = arenaMalloc(req->arena, (n + 1) * sizeof(*copy));
+	for (i = 0; i < n; i++) {
+		copy[i] = arenaMalloc(req->arena, sizeof(**copy));
+		copy[i]->paramName = dupStr(req->arena, params[i]->paramName);
+		copy[i]->paramType = params[i]->paramType;
+		copy[i]->paramBuffer =
+		    arenaMalloc(req->arena, valueTypeSize(params[i]->paramType));
+		copyValue(req->arena, params[i]->paramType,
+			  copy[i]->paramBuffer, params[i]->paramBuffer);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiRtObjectCreate_2 FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	copy[n] = NULL;
+	req->params = (const SaImmAdminOperationParamsT_2 **)copy;
+	return asyncSubmit(async, req);
 }
 
-SaAisErrorT immutil_saImmOiRtObjectCreate_o2(
-    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
-    const char *parentName, const SaImmAttrValuesT_2 **attrValues)
+/* ----------------------------------------------------------------------
+ * Batched search iterator; A thread reads the objects with
+ * saImmOmSearchNext_2 and copies them into batches, each in its own arena,
+ * while the caller works on earlier batches. The thread does not start a
+ * new batch while that would put more than prefetch objects ahead of the
+ * caller. A batch is freed when the caller asks for the next one.
+ */
+
+#define SEARCH_BATCH_DEFAULT 256
+
+struct SearchBatch {
+	struct SearchBatch *next;
+	struct Arena *arena;
+	struct ImmutilSearchRecord *records;
+	struct ImmutilSearchBatch batch;
+};
+
+struct ImmutilSearchIter {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+	SaImmSearchHandleT searchHandle;
+	size_t batchSize;
+	size_t prefetch;
+	struct SearchBatch *ready; /* Filled batches, oldest first */
+	struct SearchBatch *readyTail;
+	size_t nReady;		     /* Objects in the ready batches */
+	struct SearchBatch *current; /* The batch the caller has */
+	SaAisErrorT rc;		     /* SA_AIS_OK until the search ends */
+	bool stop;
+};
+
+/* Get all attributes for NULL, none for an empty list, else some */
+static SaImmSearchOptionsT
+searchOptions(const SaImmSearchParametersT_2 *searchParam,
+	      const SaImmAttrNameT *attributeNames)
 {
-	SaNameT parent_name;
-	if (parentName)
-		osaf_extended_name_lend(parentName, &parent_name);
-	else
-		osaf_extended_name_clear(&parent_name);
+	SaImmSearchOptionsT options;
 
-	SaAisErrorT rc = immutil_saImmOiRtObjectCreate_2(
-	    immOiHandle, className, &parent_name, attrValues);
-	return rc;
+	if (attributeNames == NULL)
+		options = SA_IMM_SEARCH_GET_ALL_ATTR;
+	else if (attributeNames[0] == NULL)
+		options = SA_IMM_SEARCH_GET_NO_ATTR;
+	else
+		options = SA_IMM_SEARCH_GET_SOME_ATTR;
+	if (searchParam != NULL)
+		options |= SA_IMM_SEARCH_ONE_ATTR;
+	return options;
 }
 
-SaAisErrorT immutil_saImmOiRtObjectCreate_o3(
-    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
-    const char *objectName, const SaImmAttrValuesT_2 **attrValues)
+static struct SearchBatch *searchBatchCreate(size_t size)
 {
-	SaAisErrorT rc = saImmOiRtObjectCreate_o3(
-	    immOiHandle, className, (SaConstStringT)objectName, attrValues);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiRtObjectCreate_o3(immOiHandle, className,
-					      (SaConstStringT)objectName,
-					      attrValues);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	struct Arena *arena = arenaCreate();
+	struct SearchBatch *b = arenaMalloc(arena, sizeof(struct SearchBatch));
+	b->arena = arena;
+	b->records =
+	    arenaMalloc(arena, size * sizeof(struct ImmutilSearchRecord));
+	b->batch.records = b->records;
+	return b;
 }
 
-SaAisErrorT immutil_saImmOiRtObjectDelete(SaImmOiHandleT immOiHandle,
-					  const SaNameT *objectName)
+static void *searchThread(void *arg)
 {
-	SaAisErrorT rc = saImmOiRtObjectDelete(immOiHandle, objectName);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiRtObjectDelete(immOiHandle, objectName);
-		nTries++;
+	struct ImmutilSearchIter *it = arg;
+	struct SearchBatch *b;
+	struct ImmutilSearchRecord *r;
+	SaNameT objectName;
+	SaImmAttrValuesT_2 **attributes;
+	SaAisErrorT rc = SA_AIS_OK;
+
+	while (rc == SA_AIS_OK) {
+		pthread_mutex_lock(&it->lock);
+		while (!it->stop && it->nReady + it->batchSize > it->prefetch)
+			pthread_cond_wait(&it->cond, &it->lock);
+		pthread_mutex_unlock(&it->lock);
+		if (__atomic_load_n(&it->stop, __ATOMIC_RELAXED))
+			break;
+
+		b = searchBatchCreate(it->batchSize);
+		while (b->batch.n < it->batchSize &&
+		       !__atomic_load_n(&it->stop, __ATOMIC_RELAXED)) {
+			rc = immutil_saImmOmSearchNext_2(
+			    it->searchHandle, &objectName, &attributes);
+			if (rc != SA_AIS_OK)
+				break;
+			r = &b->records[b->batch.n++];
+			r->objectName = dupSaNameT(b->arena, &objectName);
+			r->attributes = dupSaImmAttrValuesT_array(
+			    b->arena, (const SaImmAttrValuesT_2 **)attributes);
+		}
+
+		pthread_mutex_lock(&it->lock);
+		if (b->batch.n > 0) {
+			if (it->readyTail != NULL)
+				it->readyTail->next = b;
+			else
+				it->ready = b;
+			it->readyTail = b;
+			it->nReady += b->batch.n;
+		} else {
+			arenaDelete(b->arena);
+		}
+		if (rc != SA_AIS_OK)
+			it->rc = rc;
+		pthread_cond_broadcast(&it->cond);
+		pthread_mutex_unlock(&it->lock);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiRtObjectDelete FAILED, rc = %d", (int)rc);
-	return rc;
+	return NULL;
 }
 
-SaAisErrorT immutil_saImmOiRtObjectDelete_o2(SaImmOiHandleT immOiHandle,
-					     const char *objectName)
+SaAisErrorT immutil_searchIterCreate(SaImmHandleT immHandle,
+				     const SaNameT *rootName, SaImmScopeT scope,
+				     const SaImmSearchParametersT_2 *searchParam,
+				     const SaImmAttrNameT *attributeNames,
+				     size_t batchSize, size_t prefetch,
+				     ImmutilSearchIter_t **iter)
 {
-	SaNameT obj_name;
-	if (objectName)
-		osaf_extended_name_lend(objectName, &obj_name);
-	else
-		osaf_extended_name_clear(&obj_name);
+	struct ImmutilSearchIter *it;
+	SaImmSearchHandleT searchHandle;
+	SaAisErrorT rc;
 
-	SaAisErrorT rc = immutil_saImmOiRtObjectDelete(immOiHandle, &obj_name);
-	return rc;
+	rc = immutil_saImmOmSearchInitialize_2(
+	    immHandle, rootName, scope,
+	    searchOptions(searchParam, attributeNames), searchParam,
+	    attributeNames, &searchHandle);
+	if (rc != SA_AIS_OK)
+		return rc;
+
+	it = calloc(1, sizeof(struct ImmutilSearchIter));
+	if (it == NULL)
+		immutilError("Out of memory");
+	pthread_mutex_init(&it->lock, NULL);
+	pthread_cond_init(&it->cond, NULL);
+	it->searchHandle = searchHandle;
+	it->batchSize = batchSize != 0 ? batchSize : SEARCH_BATCH_DEFAULT;
+	it->prefetch = prefetch > it->batchSize ? prefetch : it->batchSize;
+	it->rc = SA_AIS_OK;
+	if (pthread_create(&it->thread, NULL, searchThread, it) != 0)
+		immutilError("pthread_create FAILED");
+	*iter = it;
+	return SA_AIS_OK;
 }
 
-SaAisErrorT immutil_saImmOiRtObjectDelete_o3(SaImmOiHandleT immOiHandle,
-					     const char *objectName)
+SaAisErrorT immutil_searchIterNext(ImmutilSearchIter_t *it,
+				   const struct ImmutilSearchBatch **batch)
 {
-	SaAisErrorT rc =
-	    saImmOiRtObjectDelete_o3(immOiHandle, (SaConstStringT)objectName);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiRtObjectDelete_o3(immOiHandle,
-					      (SaConstStringT)objectName);
-		nTries++;
+	struct SearchBatch *b;
+	SaAisErrorT rc;
+
+	if (it->current != NULL) {
+		arenaDelete(it->current->arena);
+		it->current = NULL;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
-}
 
-SaAisErrorT
-immutil_saImmOiRtObjectUpdate_2(SaImmOiHandleT immOiHandle,
-				const SaNameT *objectName,
-				const SaImmAttrModificationT_2 **attrMods)
-{
-	SaAisErrorT rc =
-	    saImmOiRtObjectUpdate_2(immOiHandle, objectName, attrMods);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiRtObjectUpdate_2(immOiHandle, objectName, attrMods);
-		nTries++;
+	pthread_mutex_lock(&it->lock);
+	while (it->ready == NULL && it->rc == SA_AIS_OK)
+		pthread_cond_wait(&it->cond, &it->lock);
+	if ((b = it->ready) != NULL) {
+		if ((it->ready = b->next) == NULL)
+			it->readyTail = NULL;
+		it->nReady -= b->batch.n;
+		pthread_cond_broadcast(&it->cond);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiRtObjectUpdate_2 FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	rc = it->rc;
+	pthread_mutex_unlock(&it->lock);
+
+	if (b == NULL) {
+		*batch = NULL;
+		return rc;
+	}
+	it->current = b;
+	*batch = &b->batch;
+	return SA_AIS_OK;
 }
 
-SaAisErrorT
-immutil_saImmOiRtObjectUpdate_o2(SaImmOiHandleT immOiHandle,
-				 const char *objectName,
-				 const SaImmAttrModificationT_2 **attrMods)
+void immutil_searchIterDelete(ImmutilSearchIter_t *it)
 {
-	SaNameT obj_name;
-	if (objectName)
-		osaf_extended_name_lend(objectName, &obj_name);
-	else
-		osaf_extended_name_clear(&obj_name);
+	struct SearchBatch *b;
 
-	SaAisErrorT rc =
-	    immutil_saImmOiRtObjectUpdate_2(immOiHandle, &obj_name, attrMods);
-	return rc;
+	if (it == NULL)
+		return;
+	pthread_mutex_lock(&it->lock);
+	__atomic_store_n(&it->stop, true, __ATOMIC_RELAXED);
+	pthread_cond_broadcast(&it->cond);
+	pthread_mutex_unlock(&it->lock);
+	pthread_join(it->thread, NULL);
+
+	immutil_saImmOmSearchFinalize(it->searchHandle);
+	if (it->current != NULL)
+		arenaDelete(it->current->arena);
+	while ((b = it->ready) != NULL) {
+		it->ready = b->next;
+		arenaDelete(b->arena);
+	}
+	pthread_cond_destroy(&it->cond);
+	pthread_mutex_destroy(&it->lock);
+	free(it);
 }
 
-SaAisErrorT
-immutil_saImmOiRtObjectUpdate_o3(SaImmOiHandleT immOiHandle,
-				 const char *objectName,
-				 const SaImmAttrModificationT_2 **attrMods)
+/* ----------------------------------------------------------------------
+ * Parallel subtree search; The children of the root are read with one
+ * SA_IMM_SUBLEVEL search, and each child subtree is a work item. Workers
+ * take the items with an atomic counter and search them on an OM handle of
+ * their own from the pool. The root itself is an SA_IMM_ONE item.
+ */
+
+struct SearchWork {
+	const SaNameT *root;
+	SaImmScopeT scope;
+};
+
+struct ParallelSearch {
+	SaImmSearchOptionsT options;
+	const SaImmSearchParametersT_2 *searchParam;
+	const SaImmAttrNameT *attributeNames;
+	ImmutilSearchCallbackT callback;
+	void *arg;
+	struct SearchWork *work;
+	size_t nWork;
+	size_t next; /* The next work item */
+	SaAisErrorT rc;
+	bool stop;
+};
+
+/* Stop the search, the first error is returned */
+static void parallelSearchStop(struct ParallelSearch *ps, SaAisErrorT rc)
 {
-	SaAisErrorT rc = saImmOiRtObjectUpdate_o3(
-	    immOiHandle, (SaConstStringT)objectName, attrMods);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiRtObjectUpdate_o3(
-		    immOiHandle, (SaConstStringT)objectName, attrMods);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	SaAisErrorT ok = SA_AIS_OK;
+	if (rc != SA_AIS_OK)
+		__atomic_compare_exchange_n(&ps->rc, &ok, rc, false,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	__atomic_store_n(&ps->stop, true, __ATOMIC_RELAXED);
 }
 
-SaAisErrorT immutil_saImmOiAdminOperationResult(SaImmOiHandleT immOiHandle,
-						SaInvocationT invocation,
-						SaAisErrorT result)
+/*
+ * Initialize a search on the pooled entry *hp, checked out here if NULL.
+ * Pooled handles go stale together, e.g. after a controller failover, so
+ * on SA_AIS_ERR_BAD_HANDLE the entry is returned, which purges the idle
+ * owned ones, and the search is retried once on new handles.
+ */
+static SaAisErrorT parallelSearchInitialize(
+    struct OmHandles **hp, const SaNameT *rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT options, const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
 {
-	SaAisErrorT rc =
-	    saImmOiAdminOperationResult(immOiHandle, invocation, result);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiAdminOperationResult(immOiHandle, invocation,
-						 result);
-		nTries++;
+	SaAisErrorT rc = SA_AIS_ERR_BAD_HANDLE;
+	int attempt;
+
+	for (attempt = 0; attempt < 2 && rc == SA_AIS_ERR_BAD_HANDLE;
+	     attempt++) {
+		struct ImmutilRetry retry;
+		if (*hp == NULL && (*hp = omHandlesGet(0)) == NULL)
+			return SA_AIS_ERR_UNAVAILABLE;
+		rc = retryStart(&retry, IMMUTIL_OP_OM_SEARCH_INITIALIZE_2);
+		if (rc == SA_AIS_OK)
+			do {
+				rc = saImmOmSearchInitialize_2(
+				    (*hp)->omHandle, rootName, scope, options,
+				    searchParam, attributeNames, searchHandle);
+			} while (immutil_retry(&retry, rc));
+		if (rc == SA_AIS_ERR_BAD_HANDLE) {
+			omHandlesPut(*hp, rc);
+			*hp = NULL;
+		}
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiAdminOperationResult FAILED, rc = %d",
+	if (rc != SA_AIS_OK && rc != SA_AIS_ERR_NOT_EXIST &&
+	    immutilWrapperProfile.errorsAreFatal)
+		immutilError("saImmOmSearchInitialize FAILED, rc = %d",
 			     (int)rc);
 	return rc;
 }
 
-SaAisErrorT immutil_saImmOiAdminOperationResult_o2(
-    SaImmOiHandleT immOiHandle, SaInvocationT invocation, SaAisErrorT result,
-    const SaImmAdminOperationParamsT_2 **returnParams)
+static SaAisErrorT parallelSearchWork(struct ParallelSearch *ps,
+				      struct OmHandles **hp,
+				      const struct SearchWork *w)
 {
-	SaAisErrorT rc = saImmOiAdminOperationResult_o2(immOiHandle, invocation,
-							result, returnParams);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiAdminOperationResult_o2(immOiHandle, invocation,
-						    result, returnParams);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiAdminOperationResult FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	SaImmSearchHandleT searchHandle;
+	SaNameT objectName;
+	SaImmAttrValuesT_2 **attributes;
+	SaAisErrorT rc;
+
+	rc = parallelSearchInitialize(hp, w->root, w->scope, ps->options,
+				      ps->searchParam, ps->attributeNames,
+				      &searchHandle);
+	if (rc != SA_AIS_OK) /* SA_AIS_ERR_NOT_EXIST if deleted since */
+		return rc == SA_AIS_ERR_NOT_EXIST ? SA_AIS_OK : rc;
+	while (!__atomic_load_n(&ps->stop, __ATOMIC_RELAXED) &&
+	       (rc = immutil_saImmOmSearchNext_2(searchHandle, &objectName,
+						 &attributes)) == SA_AIS_OK) {
+		if (!ps->callback(&objectName,
+				  (const SaImmAttrValuesT_2 **)attributes,
+				  ps->arg))
+			parallelSearchStop(ps, SA_AIS_OK);
+	}
+	(void)immutil_saImmOmSearchFinalize(searchHandle);
+	return rc == SA_AIS_ERR_NOT_EXIST ? SA_AIS_OK : rc;
 }
 
-SaAisErrorT immutil_saImmOiAugmentCcbInitialize(
-    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId64,
-    SaImmCcbHandleT *ccbHandle, SaImmAdminOwnerHandleT *ownerHandle)
+static void *parallelSearchWorker(void *arg)
 {
-	SaAisErrorT rc = saImmOiAugmentCcbInitialize(immOiHandle, ccbId64,
-						     ccbHandle, ownerHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiAugmentCcbInitialize(immOiHandle, ccbId64,
-						 ccbHandle, ownerHandle);
-		nTries++;
+	struct ParallelSearch *ps = arg;
+	struct OmHandles *h = NULL;
+	SaAisErrorT rc = SA_AIS_OK;
+	size_t i;
+
+	while (!__atomic_load_n(&ps->stop, __ATOMIC_RELAXED)) {
+		i = __atomic_fetch_add(&ps->next, 1, __ATOMIC_RELAXED);
+		if (i >= ps->nWork)
+			break;
+		if ((rc = parallelSearchWork(ps, &h, &ps->work[i])) !=
+		    SA_AIS_OK)
+			break;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiAugmentCcbInitialize FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	if (h != NULL)
+		omHandlesPut(h, rc);
+	if (rc != SA_AIS_OK)
+		parallelSearchStop(ps, rc);
+	return NULL;
 }
 
-SaAisErrorT immutil_saImmOmInitialize(SaImmHandleT *immHandle,
-				      const SaImmCallbacksT *immCallbacks,
-				      const SaVersionT *version)
+/* Make the root and the subtree of each child of it work items */
+static SaAisErrorT parallelSearchSplit(struct ParallelSearch *ps,
+				       struct Arena *arena,
+				       const SaNameT *rootName)
 {
-	/* Version parameter is in/out i.e. must be mutable and should not be
-	   re-used from previous call in a retry loop. */
-	SaVersionT localVer = *version;
+	const char *root = rootName != NULL ? saAisNameBorrow(rootName) : "";
+	struct OmHandles *h = NULL;
+	SaImmSearchHandleT searchHandle;
+	SaNameT objectName;
+	SaImmAttrValuesT_2 **attributes;
+	size_t size = 0;
+	SaAisErrorT rc;
 
-	SaAisErrorT rc = saImmOmInitialize(immHandle, immCallbacks, &localVer);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		localVer = *version;
-		rc = saImmOmInitialize(immHandle, immCallbacks, &localVer);
-		nTries++;
+	rc = parallelSearchInitialize(&h, rootName, SA_IMM_SUBLEVEL,
+				      SA_IMM_SEARCH_GET_NO_ATTR, NULL, NULL,
+				      &searchHandle);
+	if (rc == SA_AIS_OK) {
+		while ((rc = immutil_saImmOmSearchNext_2(
+			    searchHandle, &objectName, &attributes)) ==
+		       SA_AIS_OK) {
+			struct SearchWork *w;
+			if (ps->nWork == size) {
+				size = size == 0 ? 64 : 2 * size;
+				ps->work = realloc(
+				    ps->work, size * sizeof(struct SearchWork));
+				if (ps->work == NULL)
+					immutilError("Out of memory");
+			}
+			w = &ps->work[ps->nWork++];
+			w->root = dupSaNameT(arena, &objectName);
+			w->scope = strcmp(saAisNameBorrow(&objectName), root) == 0
+				       ? SA_IMM_ONE
+				       : SA_IMM_SUBTREE;
+		}
+		(void)immutil_saImmOmSearchFinalize(searchHandle);
+		if (rc == SA_AIS_ERR_NOT_EXIST)
+			rc = SA_AIS_OK;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmInitialize FAILED, rc = %d", (int)rc);
+	if (h != NULL)
+		omHandlesPut(h, rc);
 	return rc;
 }
 
-SaAisErrorT immutil_saImmOmInitialize_o2(SaImmHandleT *immHandle,
-					 const SaImmCallbacksT_o2 *immCallbacks,
-					 SaVersionT *version)
+SaAisErrorT immutil_parallelSearch(const SaNameT *rootName,
+				   const SaImmSearchParametersT_2 *searchParam,
+				   const SaImmAttrNameT *attributeNames,
+				   unsigned int nWorkers,
+				   ImmutilSearchCallbackT callback, void *arg)
 {
-	/* Version parameter is in/out i.e. must be mutable and should not be
-	   re-used from previous call in a retry loop. */
-	SaVersionT localVer = *version;
+	struct ParallelSearch ps;
+	struct Arena *arena = arenaCreate();
+	pthread_t *threads;
+	unsigned int i;
+	SaAisErrorT rc;
 
-	SaAisErrorT rc =
-	    saImmOmInitialize_o2(immHandle, immCallbacks, &localVer);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		localVer = *version;
-		rc = saImmOmInitialize_o2(immHandle, immCallbacks, &localVer);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
+	memset(&ps, 0, sizeof(ps));
+	ps.options = searchOptions(searchParam, attributeNames);
+	ps.searchParam = searchParam;
+	ps.attributeNames = attributeNames;
+	ps.callback = callback;
+	ps.arg = arg;
+	ps.rc = SA_AIS_OK;
+	if ((rc = parallelSearchSplit(&ps, arena, rootName)) != SA_AIS_OK)
+		goto done;
+
+	if (nWorkers == 0)
+		nWorkers = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (nWorkers > ps.nWork)
+		nWorkers = ps.nWork;
+	if (nWorkers == 0)
+		goto done;
+
+	/* The calling thread is one of the workers */
+	threads = malloc(nWorkers * sizeof(pthread_t));
+	if (threads == NULL)
+		immutilError("Out of memory");
+	for (i = 1; i < nWorkers; i++)
+		if (pthread_create(&threads[i], NULL, parallelSearchWorker,
+				   &ps) != 0)
+			immutilError("pthread_create FAILED");
+	parallelSearchWorker(&ps);
+	for (i = 1; i < nWorkers; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	rc = ps.rc;
+done:
+	free(ps.work);
+	arenaDelete(arena);
 	return rc;
 }
 
-SaAisErrorT
-immutil_saImmOmSelectionObjectGet(SaImmHandleT immHandle,
-				  SaSelectionObjectT *selectionObject)
+/* ----------------------------------------------------------------------
+ * IMM snapshot files; The writer keeps everything in growing buffers and
+ * writes the file in one go. Strings (DNs, class and attribute names and
+ * string values) are interned in one section and referred to by offset,
+ * offset 0 is "". Each class has one column per attribute name; a column
+ * holds the values of all rows back to back and the index of the first
+ * value of each row, so row r has first[r + 1] - first[r] values. The DN
+ * index is an open addressed hash table of object numbers + 1 on the FNV-1a
+ * hash of the DN. Sections are 8 byte aligned, the reader maps the file
+ * and returns pointers into the map.
+ */
+
+#define SNAPSHOT_MAGIC 0x534d4d49 /* "IMMS" */
+#define SNAPSHOT_VERSION 1
+
+struct SnapshotHeader {
+	SaUint32T magic;
+	SaUint32T version;
+	SaUint32T nObjects;
+	SaUint32T nClasses;
+	SaUint32T indexSize; /* Slots in the DN index, a power of 2 */
+	SaUint32T reserved;
+	SaUint64T objects; /* File offsets of the sections */
+	SaUint64T index;
+	SaUint64T classes;
+	SaUint64T strings;
+	SaUint64T stringsSize;
+	SaUint64T size;
+};
+
+struct SnapshotObject {
+	SaUint32T dn;
+	SaUint32T cls;
+	SaUint32T row;
+	SaUint32T parent;
+	SaUint32T firstChild;
+	SaUint32T nextSibling;
+};
+
+struct SnapshotClass {
+	SaUint32T name;
+	SaUint32T nRows;
+	SaUint32T nColumns;
+	SaUint32T reserved;
+	SaUint64T objects; /* SaUint32T object per row */
+	SaUint64T columns; /* struct SnapshotColumn array */
+};
+
+struct SnapshotColumn {
+	SaUint32T name;
+	SaUint32T type;
+	SaUint64T nValues;
+	SaUint64T first;  /* SaUint32T per row + 1 */
+	SaUint64T values; /* nValues values of snapValueSize(type) */
+};
+
+struct SnapBuf {
+	unsigned char *data;
+	size_t size;
+	size_t capacity;
+};
+
+struct SnapColumn {
+	SaUint32T name;
+	SaImmValueTypeT type;
+	struct SnapBuf first;
+	struct SnapBuf values;
+	SaUint32T nValues;
+	SaUint32T lastRow; /* Row + 1 of the last values added */
+};
+
+struct SnapClass {
+	SaUint32T name;
+	SaUint32T nRows;
+	struct SnapBuf objects;
+	struct SnapColumn *columns;
+	SaUint32T nColumns;
+};
+
+struct SnapString {
+	SaUint32T offset;
+	SaUint32T cls; /* Class number + 1 if a class name, else 0 */
+	SaUint64T hash;
+};
+
+struct ImmutilSnapshotWriter {
+	struct SnapBuf strings;
+	struct SnapString *table; /* Intern table */
+	size_t tableSize;
+	size_t nStrings;
+	struct SnapBuf objects; /* struct SnapshotObject */
+	SaUint32T nObjects;
+	struct SnapClass *classes;
+	SaUint32T nClasses;
+};
+
+struct ImmutilSnapshot {
+	const unsigned char *map;
+	size_t size;
+	const struct SnapshotHeader *hdr;
+	const struct SnapshotObject *objects;
+	const SaUint32T *index;
+	const struct SnapshotClass *classes;
+	const char *strings;
+};
+
+static size_t snapAlign(size_t size)
 {
-	SaAisErrorT rc = saImmOmSelectionObjectGet(immHandle, selectionObject);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmSelectionObjectGet(immHandle, selectionObject);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	return (size + 7) & ~(size_t)7;
 }
 
-SaAisErrorT immutil_saImmOmFinalize(SaImmHandleT immHandle)
+/* Size of a value in a column */
+static size_t snapValueSize(SaImmValueTypeT type)
 {
-	SaAisErrorT rc = saImmOmFinalize(immHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmFinalize(immHandle);
-		nTries++;
+	switch (type) {
+	case SA_IMM_ATTR_SAINT32T:
+	case SA_IMM_ATTR_SAUINT32T:
+	case SA_IMM_ATTR_SAFLOATT:
+	case SA_IMM_ATTR_SASTRINGT: /* String offset */
+	case SA_IMM_ATTR_SANAMET:
+		return 4;
+	case SA_IMM_ATTR_SAINT64T:
+	case SA_IMM_ATTR_SAUINT64T:
+	case SA_IMM_ATTR_SATIMET:
+	case SA_IMM_ATTR_SADOUBLET:
+	case SA_IMM_ATTR_SAANYT: /* Offset and size */
+		return 8;
+	default:
+		return 0;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmFinalize FAILED, rc = %d", (int)rc);
-	return rc;
 }
 
-SaAisErrorT
-immutil_saImmOmAccessorInitialize(SaImmHandleT immHandle,
-				  SaImmAccessorHandleT *accessorHandle)
+static size_t snapBufAppend(struct SnapBuf *b, const void *data, size_t size)
 {
-	SaAisErrorT rc = saImmOmAccessorInitialize(immHandle, accessorHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAccessorInitialize(immHandle, accessorHandle);
-		nTries++;
+	size_t offset = b->size;
+	if (b->size + size > b->capacity) {
+		size_t capacity = b->capacity == 0 ? 256 : 2 * b->capacity;
+		while (capacity < b->size + size)
+			capacity *= 2;
+		b->data = realloc(b->data, capacity);
+		if (b->data == NULL)
+			immutilError("Out of memory");
+		b->capacity = capacity;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAccessorInitialize FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	memcpy(b->data + offset, data, size);
+	b->size += size;
+	return offset;
 }
 
-SaAisErrorT immutil_saImmOmAccessorGet_2(SaImmAccessorHandleT accessorHandle,
-					 const SaNameT *objectName,
-					 const SaImmAttrNameT *attributeNames,
-					 SaImmAttrValuesT_2 ***attributes)
+static struct SnapString *snapIntern(struct ImmutilSnapshotWriter *w,
+				     const void *str, size_t len)
 {
-	SaAisErrorT rc = saImmOmAccessorGet_2(accessorHandle, objectName,
-					      attributeNames, attributes);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAccessorGet_2(accessorHandle, objectName,
-					  attributeNames, attributes);
-		nTries++;
+	SaUint64T hash = 0xcbf29ce484222325ULL;
+	struct SnapString *s;
+	size_t i, mask;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ ((const unsigned char *)str)[i]) *
+		       0x100000001b3ULL;
+	if (2 * (w->nStrings + 1) > w->tableSize) {
+		struct SnapString *old = w->table;
+		size_t oldSize = w->tableSize;
+		w->tableSize = oldSize == 0 ? 1024 : 2 * oldSize;
+		w->table = calloc(w->tableSize, sizeof(struct SnapString));
+		if (w->table == NULL)
+			immutilError("Out of memory");
+		mask = w->tableSize - 1;
+		for (i = 0; i < oldSize; i++) {
+			size_t j = old[i].hash & mask;
+			if (old[i].offset == 0)
+				continue;
+			while (w->table[j].offset != 0)
+				j = (j + 1) & mask;
+			w->table[j] = old[i];
+		}
+		free(old);
 	}
-	if ((rc != SA_AIS_OK) && (rc != SA_AIS_ERR_NOT_EXIST) &&
-	    immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAccessorGet FAILED, rc = %d", (int)rc);
-	return rc;
+	mask = w->tableSize - 1;
+	for (i = hash & mask; (s = &w->table[i])->offset != 0;
+	     i = (i + 1) & mask) {
+		if (s->hash == hash &&
+		    strncmp((char *)w->strings.data + s->offset, str, len) ==
+			0 &&
+		    w->strings.data[s->offset + len] == 0)
+			return s;
+	}
+	s->offset = snapBufAppend(&w->strings, str, len);
+	snapBufAppend(&w->strings, "", 1);
+	s->hash = hash;
+	w->nStrings++;
+	return s;
 }
 
-SaAisErrorT immutil_saImmOmAccessorGet_o2(SaImmAccessorHandleT accessorHandle,
-					  const char *objectName,
-					  const SaImmAttrNameT *attributeNames,
-					  SaImmAttrValuesT_2 ***attributes)
+static SaUint32T snapString(struct ImmutilSnapshotWriter *w, const char *str)
 {
-	SaNameT obj_name;
-	if (objectName)
-		osaf_extended_name_lend(objectName, &obj_name);
-	else
-		osaf_extended_name_clear(&obj_name);
-
-	SaAisErrorT rc = immutil_saImmOmAccessorGet_2(
-	    accessorHandle, &obj_name, attributeNames, attributes);
-	return rc;
+	return str == NULL || *str == 0 ? 0
+					: snapIntern(w, str, strlen(str))->offset;
 }
 
-SaAisErrorT immutil_saImmOmAccessorGet_o3(SaImmAccessorHandleT accessorHandle,
-					  const char *objectName,
-					  const SaImmAttrNameT *attributeNames,
-					  SaImmAttrValuesT_2 ***attributes)
+static struct SnapColumn *snapColumn(struct SnapClass *c, SaUint32T name,
+				     SaImmValueTypeT type, unsigned int hint)
 {
-	SaAisErrorT rc =
-	    saImmOmAccessorGet_o3(accessorHandle, (SaConstStringT)objectName,
-				  attributeNames, attributes);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAccessorGet_o3(accessorHandle,
-					   (SaConstStringT)objectName,
-					   attributeNames, attributes);
-		nTries++;
+	struct SnapColumn *col;
+	SaUint32T i;
+
+	/* Objects of a class usually have their attributes in one order */
+	if (hint < c->nColumns && c->columns[hint].name == name)
+		return &c->columns[hint];
+	for (i = 0; i < c->nColumns; i++)
+		if (c->columns[i].name == name)
+			return &c->columns[i];
+	if ((c->nColumns & (c->nColumns - 1)) == 0) {
+		c->columns = realloc(c->columns,
+				     (c->nColumns == 0 ? 1 : 2 * c->nColumns) *
+					 sizeof(struct SnapColumn));
+		if (c->columns == NULL)
+			immutilError("Out of memory");
 	}
-	if (rc != SA_AIS_OK && rc != SA_AIS_ERR_NOT_EXIST &&
-	    immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	col = &c->columns[c->nColumns++];
+	memset(col, 0, sizeof(*col));
+	col->name = name;
+	col->type = type;
+	return col;
 }
 
-SaAisErrorT
-immutil_saImmOmAccessorGetConfigAttrs(SaImmAccessorHandleT accessorHandle,
-				      const SaNameT *objectName,
-				      SaImmAttrValuesT_2 ***attributes)
+/* Add the first index of rows up to and including row */
+static void snapColumnRows(struct SnapColumn *col, SaUint32T row)
 {
-	SaImmAttrNameT accessorGetConfigAttrsToken[2] = {
-	    "SA_IMM_SEARCH_GET_CONFIG_ATTR", NULL};
-	/* This is a hack to cater for the very common simple case of the OM
-	   user needing to access ONE object, but only its config
-	   attributes. The saImmOmAccessorGet_2 call has no search-options. The
-	   trick here is to "tunnel" a search option through the attributes
-	   parameter. The user will get ALL config attributes for the object in
-	   this way. If they only want some of the config attributes, then they
-	   just do a regular accessor get and enumerate the attributes they
-	   want.
+	while (col->first.size / sizeof(SaUint32T) <= row)
+		snapBufAppend(&col->first, &col->nValues, sizeof(SaUint32T));
+}
 
-	   The support for thus is really inside the implementation of
-	   saImmOmSearchInitialize, which saImmOmAccessorGet_2 uses in its
-	   implementation. If it detects only one attribute in the attributes
-	   list and the name of that attribute is
-	   'SA_IMM_SEARCH_GET_CONFIG_ATTR' then it will assume that the user
-	   does not actually want an attribute with *that* name, but wants all
-	   config attribues.  This feature is only available with the A.2.11
-	   version of the IMMA-API.
-	*/
+static void snapAddValues(struct ImmutilSnapshotWriter *w,
+			  struct SnapColumn *col, SaUint32T row,
+			  const SaImmAttrValuesT_2 *attr)
+{
+	SaUint32T i, v32[2];
 
-	SaAisErrorT rc =
-	    saImmOmAccessorGet_2(accessorHandle, objectName,
-				 accessorGetConfigAttrsToken, attributes);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAccessorGet_2(accessorHandle, objectName, NULL,
-					  attributes);
-		nTries++;
+	if (col->lastRow == row + 1) /* Attribute given twice */
+		return;
+	col->lastRow = row + 1;
+	snapColumnRows(col, row);
+	for (i = 0; i < attr->attrValuesNumber; i++) {
+		const void *value = attr->attrValues[i];
+		switch (col->type) {
+		case SA_IMM_ATTR_SASTRINGT:
+			v32[0] = snapString(w, *(const SaStringT *)value);
+			value = v32;
+			break;
+		case SA_IMM_ATTR_SANAMET:
+			v32[0] = snapString(
+			    w, saAisNameBorrow((const SaNameT *)value));
+			value = v32;
+			break;
+		case SA_IMM_ATTR_SAANYT: {
+			const SaAnyT *any = value;
+			v32[0] = snapBufAppend(&w->strings, any->bufferAddr,
+					       any->bufferSize);
+			v32[1] = any->bufferSize;
+			/* The section ends with a NUL */
+			snapBufAppend(&w->strings, "", 1);
+			value = v32;
+			break;
+		}
+		default:
+			break;
+		}
+		snapBufAppend(&col->values, value, snapValueSize(col->type));
+		col->nValues++;
 	}
-	if ((rc != SA_AIS_OK) && (rc != SA_AIS_ERR_NOT_EXIST) &&
-	    immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAccessorGet FAILED, rc = %d", (int)rc);
-	return rc;
 }
 
-SaAisErrorT immutil_saImmOmAccessorFinalize(SaImmAccessorHandleT accessorHandle)
+ImmutilSnapshotWriter_t *immutil_snapshotWriterCreate(void)
+{
+	struct ImmutilSnapshotWriter *w =
+	    calloc(1, sizeof(struct ImmutilSnapshotWriter));
+	if (w == NULL)
+		immutilError("Out of memory");
+	snapBufAppend(&w->strings, "", 1);
+	return w;
+}
+
+void immutil_snapshotWriterDelete(ImmutilSnapshotWriter_t *w)
 {
-	SaAisErrorT rc = saImmOmAccessorFinalize(accessorHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAccessorFinalize(accessorHandle);
-		nTries++;
+	SaUint32T i, j;
+
+	if (w == NULL)
+		return;
+	for (i = 0; i < w->nClasses; i++) {
+		struct SnapClass *c = &w->classes[i];
+		for (j = 0; j < c->nColumns; j++) {
+			free(c->columns[j].first.data);
+			free(c->columns[j].values.data);
+		}
+		free(c->columns);
+		free(c->objects.data);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAccessorFinalize FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	free(w->classes);
+	free(w->objects.data);
+	free(w->table);
+	free(w->strings.data);
+	free(w);
 }
 
-SaAisErrorT immutil_saImmOmSearchInitialize_2(
-    SaImmHandleT immHandle, const SaNameT *rootName, SaImmScopeT scope,
-    SaImmSearchOptionsT searchOptions,
-    const SaImmSearchParametersT_2 *searchParam,
-    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+void immutil_snapshotWriterAdd(ImmutilSnapshotWriter_t *w,
+			       const SaNameT *objectName,
+			       const SaImmAttrValuesT_2 **attributes)
 {
-	SaAisErrorT rc = saImmOmSearchInitialize_2(
-	    immHandle, rootName, scope, searchOptions, searchParam,
-	    attributeNames, searchHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmSearchInitialize_2(immHandle, rootName, scope,
-					       searchOptions, searchParam,
-					       attributeNames, searchHandle);
-		nTries++;
+	struct SnapshotObject obj;
+	struct SnapString *name;
+	struct SnapClass *c;
+	const char *className = NULL;
+	SaUint32T i, cls;
+
+	for (i = 0; attributes != NULL && attributes[i] != NULL; i++)
+		if (strcmp(attributes[i]->attrName, SA_IMM_ATTR_CLASS_NAME) ==
+			0 &&
+		    attributes[i]->attrValuesNumber == 1)
+			className =
+			    *(const SaStringT *)attributes[i]->attrValues[0];
+	if (className == NULL)
+		className = "";
+	name = snapIntern(w, className, strlen(className));
+	if (name->cls == 0) {
+		if ((w->nClasses & (w->nClasses - 1)) == 0) {
+			w->classes = realloc(
+			    w->classes,
+			    (w->nClasses == 0 ? 1 : 2 * w->nClasses) *
+				sizeof(struct SnapClass));
+			if (w->classes == NULL)
+				immutilError("Out of memory");
+		}
+		c = &w->classes[w->nClasses++];
+		memset(c, 0, sizeof(*c));
+		c->name = name->offset;
+		name->cls = w->nClasses;
 	}
-	if (rc == SA_AIS_ERR_NOT_EXIST)
-		return rc;
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmSearchInitialize FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	/* name is invalid once the next string is interned */
+	cls = name->cls - 1;
+	c = &w->classes[cls];
+
+	obj.dn = snapString(w, saAisNameBorrow(objectName));
+	obj.cls = cls;
+	obj.row = c->nRows;
+	obj.parent = obj.firstChild = obj.nextSibling = IMMUTIL_SNAPSHOT_NONE;
+	snapBufAppend(&w->objects, &obj, sizeof(obj));
+	snapBufAppend(&c->objects, &w->nObjects, sizeof(SaUint32T));
+	w->nObjects++;
+
+	for (i = 0; attributes != NULL && attributes[i] != NULL; i++) {
+		const SaImmAttrValuesT_2 *attr = attributes[i];
+		struct SnapColumn *col;
+		if (strcmp(attr->attrName, SA_IMM_ATTR_CLASS_NAME) == 0 ||
+		    snapValueSize(attr->attrValueType) == 0)
+			continue;
+		col = snapColumn(c, snapString(w, attr->attrName),
+				 attr->attrValueType, i);
+		if (col->type == attr->attrValueType)
+			snapAddValues(w, col, obj.row, attr);
+	}
+	c->nRows++;
 }
 
-SaAisErrorT immutil_saImmOmSearchInitialize_o2(
-    SaImmHandleT immHandle, const char *rootName, SaImmScopeT scope,
-    SaImmSearchOptionsT searchOptions,
+SaAisErrorT immutil_snapshotWriterAddSearch(
+    ImmutilSnapshotWriter_t *w, SaImmHandleT immHandle,
+    const SaNameT *rootName, SaImmScopeT scope,
     const SaImmSearchParametersT_2 *searchParam,
-    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+    const SaImmAttrNameT *attributeNames)
 {
-	SaNameT root_name;
-	if (rootName)
-		osaf_extended_name_lend(rootName, &root_name);
-	else
-		osaf_extended_name_clear(&root_name);
+	const SaImmAttrNameT *names = attributeNames;
+	SaImmAttrNameT *copy = NULL;
+	ImmutilSearchIter_t *it;
+	const struct ImmutilSearchBatch *batch;
+	SaAisErrorT rc;
+	size_t i, n = 0;
 
-	SaAisErrorT rc = immutil_saImmOmSearchInitialize_2(
-	    immHandle, &root_name, scope, searchOptions, searchParam,
-	    attributeNames, searchHandle);
+	/* The class name is needed to put the object in its class */
+	if (attributeNames != NULL) {
+		for (n = 0; attributeNames[n] != NULL; n++)
+			if (strcmp(attributeNames[n],
+				   SA_IMM_ATTR_CLASS_NAME) == 0)
+				break;
+		if (attributeNames[n] == NULL) {
+			copy = malloc((n + 2) * sizeof(SaImmAttrNameT));
+			if (copy == NULL)
+				immutilError("Out of memory");
+			memcpy(copy, attributeNames, n * sizeof(SaImmAttrNameT));
+			copy[n] = (SaImmAttrNameT)SA_IMM_ATTR_CLASS_NAME;
+			copy[n + 1] = NULL;
+			names = copy;
+		}
+	}
+
+	rc = immutil_searchIterCreate(immHandle, rootName, scope, searchParam,
+				      names, 0, 0, &it);
+	if (rc == SA_AIS_OK) {
+		while ((rc = immutil_searchIterNext(it, &batch)) == SA_AIS_OK)
+			for (i = 0; i < batch->n; i++)
+				immutil_snapshotWriterAdd(
+				    w, batch->records[i].objectName,
+				    batch->records[i].attributes);
+		immutil_searchIterDelete(it);
+		if (rc == SA_AIS_ERR_NOT_EXIST)
+			rc = SA_AIS_OK;
+	}
+	free(copy);
 	return rc;
 }
 
-SaAisErrorT immutil_saImmOmSearchInitialize_o3(
-    SaImmHandleT immHandle, const char *rootName, SaImmScopeT scope,
-    SaImmSearchOptionsT searchOptions,
-    const SaImmSearchParametersT_2 *searchParam,
-    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+/* Find an object in a DN index */
+static SaUint32T snapIndexFind(const SaUint32T *index, SaUint32T indexSize,
+			       const struct SnapshotObject *objects,
+			       const char *strings, const char *dn)
 {
-	SaAisErrorT rc = saImmOmSearchInitialize_o3(
-	    immHandle, (SaConstStringT)rootName, scope, searchOptions,
-	    searchParam, attributeNames, searchHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmSearchInitialize_o3(
-		    immHandle, (SaConstStringT)rootName, scope, searchOptions,
-		    searchParam, attributeNames, searchHandle);
-		nTries++;
-	}
-	if (rc == SA_AIS_ERR_NOT_EXIST)
-		return rc;
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	SaUint32T mask = indexSize - 1;
+	SaUint32T i = hashStr(dn) & mask;
+	for (; index[i] != 0; i = (i + 1) & mask)
+		if (strcmp(strings + objects[index[i] - 1].dn, dn) == 0)
+			return index[i] - 1;
+	return IMMUTIL_SNAPSHOT_NONE;
 }
 
-SaAisErrorT immutil_saImmOmSearchFinalize(SaImmSearchHandleT searchHandle)
+static int snapWriteAll(int fd, const void *data, size_t size)
 {
-	SaAisErrorT rc = saImmOmSearchFinalize(searchHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmSearchFinalize(searchHandle);
-		nTries++;
+	const unsigned char *p = data;
+
+	while (size > 0) {
+		ssize_t n = write(fd, p, size);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		size -= n;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmSearchFinalize FAILED, rc = %d", (int)rc);
-	return rc;
+	return 0;
 }
 
-SaAisErrorT immutil_saImmOmSearchNext_2(SaImmSearchHandleT searchHandle,
-					SaNameT *objectName,
-					SaImmAttrValuesT_2 ***attributes)
+/* Write data and pad to 8 bytes */
+static int snapWrite(int fd, const void *data, size_t size)
 {
-	SaAisErrorT rc =
-	    saImmOmSearchNext_2(searchHandle, objectName, attributes);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmSearchNext_2(searchHandle, objectName, attributes);
-		nTries++;
-	}
-	if (rc == SA_AIS_ERR_NOT_EXIST)
-		return rc;
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmSearchNext FAILED, rc = %d", (int)rc);
-	return rc;
+	static const unsigned char pad[8];
+
+	if (snapWriteAll(fd, data, size) != 0)
+		return -1;
+	return snapWriteAll(fd, pad, snapAlign(size) - size);
 }
 
-SaAisErrorT immutil_saImmOmSearchNext_o2(SaImmSearchHandleT searchHandle,
-					 char **objectName,
-					 SaImmAttrValuesT_2 ***attributes)
+int immutil_snapshotWriterSave(ImmutilSnapshotWriter_t *w, const char *path)
 {
-	SaNameT obj_name;
-	const char *obj;
+	struct SnapshotObject *objects =
+	    (struct SnapshotObject *)w->objects.data;
+	const char *strings = (const char *)w->strings.data;
+	struct SnapshotHeader hdr;
+	struct SnapshotClass *classes = NULL;
+	struct SnapshotColumn *columns;
+	SaUint32T *index = NULL;
+	SaUint32T i, j, mask;
+	size_t off;
+	char *tmpPath = NULL;
+	int fd = -1, rc = -1, err;
+
+	if (w->strings.size > UINT32_MAX) {
+		errno = EFBIG;
+		return -1;
+	}
 
-	SaAisErrorT rc =
-	    immutil_saImmOmSearchNext_2(searchHandle, &obj_name, attributes);
-	if (rc == SA_AIS_OK) {
-		obj = osaf_extended_name_borrow(&obj_name);
-		*objectName = (char *)malloc(strlen(obj) + 1);
-		strcpy(*objectName, obj);
-	} else
-		*objectName = NULL;
+	/* DN index, then parent and children from it */
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.indexSize = 16;
+	while (hdr.indexSize < 2 * w->nObjects)
+		hdr.indexSize *= 2;
+	index = calloc(hdr.indexSize, sizeof(SaUint32T));
+	if (index == NULL)
+		immutilError("Out of memory");
+	mask = hdr.indexSize - 1;
+	for (i = 0; i < w->nObjects; i++) {
+		SaUint32T k = hashStr(strings + objects[i].dn) & mask;
+		while (index[k] != 0)
+			k = (k + 1) & mask;
+		index[k] = i + 1;
+	}
+	for (i = w->nObjects; i-- > 0;) {
+		const char *dn = strings + objects[i].dn;
+		const char *p = dn;
+		while (*p != 0 && (*p != ',' || (p > dn && p[-1] == '\\')))
+			p++;
+		objects[i].parent =
+		    *p == 0 ? IMMUTIL_SNAPSHOT_NONE
+			    : snapIndexFind(index, hdr.indexSize, objects,
+					    strings, p + 1);
+		objects[i].firstChild = IMMUTIL_SNAPSHOT_NONE;
+		objects[i].nextSibling = IMMUTIL_SNAPSHOT_NONE;
+	}
+	for (i = w->nObjects; i-- > 0;) {
+		SaUint32T parent = objects[i].parent;
+		if (parent != IMMUTIL_SNAPSHOT_NONE) {
+			objects[i].nextSibling = objects[parent].firstChild;
+			objects[parent].firstChild = i;
+		}
+	}
 
-	return rc;
-}
+	/* Layout */
+	hdr.magic = SNAPSHOT_MAGIC;
+	hdr.version = SNAPSHOT_VERSION;
+	hdr.nObjects = w->nObjects;
+	hdr.nClasses = w->nClasses;
+	off = snapAlign(sizeof(hdr));
+	hdr.objects = off;
+	off += snapAlign(w->objects.size);
+	hdr.index = off;
+	off += snapAlign(hdr.indexSize * sizeof(SaUint32T));
+	hdr.strings = off;
+	hdr.stringsSize = w->strings.size;
+	off += snapAlign(w->strings.size);
+	hdr.classes = off;
+	off += snapAlign(w->nClasses * sizeof(struct SnapshotClass));
+	classes = calloc(w->nClasses + 1, sizeof(struct SnapshotClass));
+	if (classes == NULL)
+		immutilError("Out of memory");
+	for (i = 0; i < w->nClasses; i++) {
+		struct SnapClass *c = &w->classes[i];
+		classes[i].name = c->name;
+		classes[i].nRows = c->nRows;
+		classes[i].nColumns = c->nColumns;
+		classes[i].objects = off;
+		off += snapAlign(c->objects.size);
+		classes[i].columns = off;
+		off += snapAlign(c->nColumns * sizeof(struct SnapshotColumn));
+		for (j = 0; j < c->nColumns; j++) {
+			snapColumnRows(&c->columns[j], c->nRows);
+			off += snapAlign(c->columns[j].first.size) +
+			       snapAlign(c->columns[j].values.size);
+		}
+	}
+	hdr.size = off;
 
-SaAisErrorT immutil_saImmOmSearchNext_o3(SaImmSearchHandleT searchHandle,
-					 char **objectName,
-					 SaImmAttrValuesT_2 ***attributes)
-{
-	SaAisErrorT rc = saImmOmSearchNext_o3(
-	    searchHandle, (SaStringT *)objectName, attributes);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmSearchNext_o3(searchHandle, (SaStringT *)objectName,
-					  attributes);
-		nTries++;
+	if (asprintf(&tmpPath, "%s.tmp", path) == -1) {
+		tmpPath = NULL;
+		goto done;
 	}
-	if (rc == SA_AIS_ERR_NOT_EXIST)
-		return rc;
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
+	fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1)
+		goto done;
+	if (snapWrite(fd, &hdr, sizeof(hdr)) != 0 ||
+	    snapWrite(fd, w->objects.data, w->objects.size) != 0 ||
+	    snapWrite(fd, index, hdr.indexSize * sizeof(SaUint32T)) != 0 ||
+	    snapWrite(fd, w->strings.data, w->strings.size) != 0 ||
+	    snapWrite(fd, classes,
+		      w->nClasses * sizeof(struct SnapshotClass)) != 0)
+		goto fail;
+	for (i = 0; i < w->nClasses; i++) {
+		struct SnapClass *c = &w->classes[i];
+		off = classes[i].columns +
+		      snapAlign(c->nColumns * sizeof(struct SnapshotColumn));
+		columns = calloc(c->nColumns + 1, sizeof(struct SnapshotColumn));
+		if (columns == NULL)
+			immutilError("Out of memory");
+		for (j = 0; j < c->nColumns; j++) {
+			columns[j].name = c->columns[j].name;
+			columns[j].type = c->columns[j].type;
+			columns[j].nValues = c->columns[j].nValues;
+			columns[j].first = off;
+			off += snapAlign(c->columns[j].first.size);
+			columns[j].values = off;
+			off += snapAlign(c->columns[j].values.size);
+		}
+		rc = snapWrite(fd, c->objects.data, c->objects.size) != 0 ||
+			     snapWrite(fd, columns,
+				       c->nColumns *
+					   sizeof(struct SnapshotColumn)) != 0
+			 ? -1
+			 : 0;
+		free(columns);
+		for (j = 0; rc == 0 && j < c->nColumns; j++)
+			if (snapWrite(fd, c->columns[j].first.data,
+				      c->columns[j].first.size) != 0 ||
+			    snapWrite(fd, c->columns[j].values.data,
+				      c->columns[j].values.size) != 0)
+				rc = -1;
+		if (rc != 0)
+			goto fail;
+	}
+	rc = -1;
+	if (fsync(fd) != 0 || close(fd) != 0) {
+		fd = -1;
+		goto fail;
+	}
+	fd = -1;
+	if (rename(tmpPath, path) != 0)
+		goto fail;
+	rc = 0;
+	goto done;
+
+fail:
+	err = errno;
+	if (fd != -1)
+		close(fd);
+	unlink(tmpPath);
+	errno = err;
+	rc = -1;
+done:
+	free(tmpPath);
+	free(classes);
+	free(index);
 	return rc;
 }
 
-SaAisErrorT immutil_saImmOmAdminOwnerClear(SaImmHandleT immHandle,
-					   const SaNameT **objectNames,
-					   SaImmScopeT scope)
+/* Check that a section of count elements of size is in the file */
+static bool snapSection(const struct ImmutilSnapshot *s, SaUint64T off,
+			SaUint64T count, size_t size)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerClear(immHandle, objectNames, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerClear(immHandle, objectNames, scope);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAdminOwnerClear FAILED, rc = %d", (int)rc);
-	return rc;
+	return off % 8 == 0 && off <= s->size &&
+	       count <= (s->size - off) / size;
 }
 
-SaAisErrorT immutil_saImmOmAdminOwnerClear_o2(SaImmHandleT immHandle,
-					      const char **objectNames,
-					      SaImmScopeT scope)
+ImmutilSnapshot_t *immutil_snapshotOpen(const char *path)
 {
-	int i = 0;
-
-	while (objectNames[i]) {
-		i++;
+	struct ImmutilSnapshot *s;
+	const struct SnapshotHeader *hdr;
+	struct stat st;
+	SaUint32T i, j;
+	int fd, err;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return NULL;
+	if (fstat(fd, &st) != 0) {
+		err = errno;
+		close(fd);
+		errno = err;
+		return NULL;
+	}
+	if ((size_t)st.st_size < sizeof(struct SnapshotHeader)) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+	s = calloc(1, sizeof(struct ImmutilSnapshot));
+	if (s == NULL)
+		immutilError("Out of memory");
+	s->size = st.st_size;
+	s->map = mmap(NULL, s->size, PROT_READ, MAP_SHARED, fd, 0);
+	err = errno;
+	close(fd);
+	if (s->map == MAP_FAILED) {
+		free(s);
+		errno = err;
+		return NULL;
 	}
-	SaNameT **obj_names = (SaNameT **)malloc((i + 1) * sizeof(SaNameT *));
-	i = 0;
 
-	while (objectNames[i]) {
-		obj_names[i] = (SaNameT *)malloc(sizeof(SaNameT));
-		osaf_extended_name_lend(objectNames[i], obj_names[i]);
-		i++;
+	hdr = s->hdr = (const struct SnapshotHeader *)s->map;
+	if (hdr->magic != SNAPSHOT_MAGIC || hdr->version != SNAPSHOT_VERSION ||
+	    hdr->size != s->size || hdr->indexSize == 0 ||
+	    (hdr->indexSize & (hdr->indexSize - 1)) != 0 ||
+	    hdr->indexSize <= hdr->nObjects ||
+	    !snapSection(s, hdr->objects, hdr->nObjects,
+			 sizeof(struct SnapshotObject)) ||
+	    !snapSection(s, hdr->index, hdr->indexSize, sizeof(SaUint32T)) ||
+	    !snapSection(s, hdr->classes, hdr->nClasses,
+			 sizeof(struct SnapshotClass)) ||
+	    hdr->stringsSize == 0 ||
+	    !snapSection(s, hdr->strings, hdr->stringsSize, 1) ||
+	    s->map[hdr->strings + hdr->stringsSize - 1] != 0)
+		goto invalid;
+	s->objects = (const struct SnapshotObject *)(s->map + hdr->objects);
+	s->index = (const SaUint32T *)(s->map + hdr->index);
+	s->classes = (const struct SnapshotClass *)(s->map + hdr->classes);
+	s->strings = (const char *)(s->map + hdr->strings);
+
+	/* The objects are checked when used */
+	for (i = 0; i < hdr->nClasses; i++) {
+		const struct SnapshotClass *c = &s->classes[i];
+		const struct SnapshotColumn *col;
+		if (c->name >= hdr->stringsSize ||
+		    !snapSection(s, c->objects, c->nRows, sizeof(SaUint32T)) ||
+		    !snapSection(s, c->columns, c->nColumns,
+				 sizeof(struct SnapshotColumn)))
+			goto invalid;
+		col = (const struct SnapshotColumn *)(s->map + c->columns);
+		for (j = 0; j < c->nColumns; j++, col++) {
+			size_t size = snapValueSize(col->type);
+			const SaUint32T *first;
+			if (col->name >= hdr->stringsSize || size == 0 ||
+			    !snapSection(s, col->first, (SaUint64T)c->nRows + 1,
+					 sizeof(SaUint32T)) ||
+			    !snapSection(s, col->values, col->nValues, size))
+				goto invalid;
+			first = (const SaUint32T *)(s->map + col->first);
+			if (first[c->nRows] != col->nValues)
+				goto invalid;
+		}
 	}
-	obj_names[i] = NULL;
+	return s;
 
-	SaAisErrorT rc = immutil_saImmOmAdminOwnerClear(
-	    immHandle, (const SaNameT **)obj_names, scope);
+invalid:
+	munmap((void *)s->map, s->size);
+	free(s);
+	errno = EINVAL;
+	return NULL;
+}
 
-	i = 0;
-	while (obj_names[i]) {
-		free(obj_names[i]);
-		i++;
-	}
-	free(obj_names);
+void immutil_snapshotClose(ImmutilSnapshot_t *s)
+{
+	if (s == NULL)
+		return;
+	munmap((void *)s->map, s->size);
+	free(s);
+}
 
-	return rc;
+SaUint32T immutil_snapshotObjects(const ImmutilSnapshot_t *s)
+{
+	return s->hdr->nObjects;
 }
 
-SaAisErrorT immutil_saImmOmAdminOwnerClear_o3(SaImmHandleT immHandle,
-					      const char **objectNames,
-					      SaImmScopeT scope)
+const char *immutil_snapshotString(const ImmutilSnapshot_t *s,
+				   SaUint32T offset)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerClear_o3(
-	    immHandle, (SaConstStringT *)objectNames, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerClear_o3(
-		    immHandle, (SaConstStringT *)objectNames, scope);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	return offset < s->hdr->stringsSize ? s->strings + offset : NULL;
 }
 
-SaAisErrorT
-immutil_saImmOmClassCreate_2(SaImmCcbHandleT immCcbHandle,
-			     const SaImmClassNameT className,
-			     const SaImmClassCategoryT classCategory,
-			     const SaImmAttrDefinitionT_2 **attrDefinitions)
+SaUint32T immutil_snapshotFind(const ImmutilSnapshot_t *s, const char *dn)
 {
-	SaAisErrorT rc = saImmOmClassCreate_2(immCcbHandle, className,
-					      classCategory, attrDefinitions);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmClassCreate_2(immCcbHandle, className,
-					  classCategory, attrDefinitions);
-		nTries++;
+	SaUint32T mask = s->hdr->indexSize - 1;
+	SaUint32T i = hashStr(dn) & mask;
+	const char *objectDn;
+	SaUint32T n;
+
+	/* A damaged file may have no free slot, so probe each slot once */
+	for (n = 0; n < s->hdr->indexSize && s->index[i] != 0;
+	     n++, i = (i + 1) & mask) {
+		if (s->index[i] > s->hdr->nObjects)
+			return IMMUTIL_SNAPSHOT_NONE;
+		objectDn = immutil_snapshotString(
+		    s, s->objects[s->index[i] - 1].dn);
+		if (objectDn != NULL && strcmp(objectDn, dn) == 0)
+			return s->index[i] - 1;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmClassCreate_2 FAILED, rc = %d", (int)rc);
-	return rc;
+	return IMMUTIL_SNAPSHOT_NONE;
 }
 
-SaAisErrorT immutil_saImmOmClassDelete(SaImmCcbHandleT immCcbHandle,
-				       const SaImmClassNameT className)
+/* The object, NULL if out of range or invalid */
+static const struct SnapshotObject *snapObject(const ImmutilSnapshot_t *s,
+					       SaUint32T object)
 {
-	SaAisErrorT rc = saImmOmClassDelete(immCcbHandle, className);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmClassDelete(immCcbHandle, className);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmClassDelete FAILED, rc = %d", (int)rc);
-	return rc;
+	const struct SnapshotObject *obj;
+	if (object >= s->hdr->nObjects)
+		return NULL;
+	obj = &s->objects[object];
+	if (obj->cls >= s->hdr->nClasses ||
+	    obj->row >= s->classes[obj->cls].nRows)
+		return NULL;
+	return obj;
 }
 
-////////////////////////////////////////////
-SaAisErrorT immutil_saImmOiFinalize(SaImmOiHandleT immOiHandle)
+const char *immutil_snapshotDn(const ImmutilSnapshot_t *s, SaUint32T object)
 {
-	SaAisErrorT rc = saImmOiFinalize(immOiHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOiFinalize(immOiHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOiFinalize FAILED, rc = %d", (int)rc);
-	return rc;
+	const struct SnapshotObject *obj = snapObject(s, object);
+	return obj != NULL ? immutil_snapshotString(s, obj->dn) : NULL;
 }
 
-SaAisErrorT immutil_saImmOmAdminOwnerInitialize(
-    SaImmHandleT immHandle, const SaImmAdminOwnerNameT admOwnerName,
-    SaBoolT relOwnOnFinalize, SaImmAdminOwnerHandleT *ownerHandle)
+const char *immutil_snapshotClassName(const ImmutilSnapshot_t *s,
+				      SaUint32T object)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerInitialize(
-	    immHandle, admOwnerName, relOwnOnFinalize, ownerHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerInitialize(immHandle, admOwnerName,
-						 relOwnOnFinalize, ownerHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAdminOwnerInitialize FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	const struct SnapshotObject *obj = snapObject(s, object);
+	return obj != NULL
+		   ? immutil_snapshotString(s, s->classes[obj->cls].name)
+		   : NULL;
 }
 
-SaAisErrorT
-immutil_saImmOmAdminOwnerFinalize(SaImmAdminOwnerHandleT ownerHandle)
+SaUint32T immutil_snapshotParent(const ImmutilSnapshot_t *s, SaUint32T object)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerFinalize(ownerHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerFinalize(ownerHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAdminOwnerFinalize FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	const struct SnapshotObject *obj = snapObject(s, object);
+	return obj != NULL && obj->parent < s->hdr->nObjects
+		   ? obj->parent
+		   : IMMUTIL_SNAPSHOT_NONE;
 }
 
-SaAisErrorT immutil_saImmOmCcbInitialize(SaImmAdminOwnerHandleT ownerHandle,
-					 SaImmCcbFlagsT ccbFlags,
-					 SaImmCcbHandleT *immCcbHandle)
+SaUint32T immutil_snapshotFirstChild(const ImmutilSnapshot_t *s,
+				     SaUint32T object)
 {
-	SaAisErrorT rc =
-	    saImmOmCcbInitialize(ownerHandle, ccbFlags, immCcbHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbInitialize(ownerHandle, ccbFlags, immCcbHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbInitialize FAILED, rc = %d", (int)rc);
-	return rc;
+	const struct SnapshotObject *obj = snapObject(s, object);
+	return obj != NULL && obj->firstChild < s->hdr->nObjects
+		   ? obj->firstChild
+		   : IMMUTIL_SNAPSHOT_NONE;
 }
 
-SaAisErrorT immutil_saImmOmCcbFinalize(SaImmCcbHandleT immCcbHandle)
+SaUint32T immutil_snapshotNextSibling(const ImmutilSnapshot_t *s,
+				      SaUint32T object)
 {
-	SaAisErrorT rc = saImmOmCcbFinalize(immCcbHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbFinalize(immCcbHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbFinalize FAILED, rc = %d", (int)rc);
-	return rc;
+	const struct SnapshotObject *obj = snapObject(s, object);
+	return obj != NULL && obj->nextSibling < s->hdr->nObjects
+		   ? obj->nextSibling
+		   : IMMUTIL_SNAPSHOT_NONE;
 }
 
-SaAisErrorT immutil_saImmOmCcbApply(SaImmCcbHandleT immCcbHandle)
+static const struct SnapshotColumn *
+snapColumnFind(const ImmutilSnapshot_t *s, const struct SnapshotClass *c,
+	       const char *attrName)
 {
-	SaAisErrorT rc = saImmOmCcbApply(immCcbHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbApply(immCcbHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbApply FAILED, rc = %d", (int)rc);
-	return rc;
+	const struct SnapshotColumn *col =
+	    (const struct SnapshotColumn *)(s->map + c->columns);
+	SaUint32T i;
+	for (i = 0; i < c->nColumns; i++)
+		if (strcmp(s->strings + col[i].name, attrName) == 0)
+			return &col[i];
+	return NULL;
 }
 
-SaAisErrorT immutil_saImmOmCcbAbort(SaImmCcbHandleT immCcbHandle)
+bool immutil_snapshotGetColumn(const ImmutilSnapshot_t *s,
+			       const char *className, const char *attrName,
+			       struct ImmutilSnapshotColumn *column)
 {
-	SaAisErrorT rc = saImmOmCcbAbort(immCcbHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbAbort(immCcbHandle);
-		nTries++;
+	const struct SnapshotColumn *col;
+	SaUint32T i;
+
+	for (i = 0; i < s->hdr->nClasses; i++) {
+		const struct SnapshotClass *c = &s->classes[i];
+		if (strcmp(s->strings + c->name, className) != 0)
+			continue;
+		if ((col = snapColumnFind(s, c, attrName)) == NULL)
+			return false;
+		column->type = (SaImmValueTypeT)col->type;
+		column->nRows = c->nRows;
+		column->objects = (const SaUint32T *)(s->map + c->objects);
+		column->first = (const SaUint32T *)(s->map + col->first);
+		column->values = s->map + col->values;
+		return true;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbAbort FAILED, rc = %d", (int)rc);
-	return rc;
+	return false;
 }
 
-SaAisErrorT immutil_saImmOmCcbValidate(SaImmCcbHandleT immCcbHandle)
+bool immutil_snapshotGetAttr(const ImmutilSnapshot_t *s, SaUint32T object,
+			     const char *attrName,
+			     struct ImmutilSnapshotAttr *attr)
 {
-	SaAisErrorT rc = saImmOmCcbValidate(immCcbHandle);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbValidate(immCcbHandle);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbValidate FAILED, rc = %d", (int)rc);
-	return rc;
+	const struct SnapshotObject *obj = snapObject(s, object);
+	const struct SnapshotColumn *col;
+	const SaUint32T *first;
+
+	if (obj == NULL ||
+	    (col = snapColumnFind(s, &s->classes[obj->cls], attrName)) ==
+		NULL)
+		return false;
+	first = (const SaUint32T *)(s->map + col->first);
+	if (first[obj->row] > first[obj->row + 1] ||
+	    first[obj->row + 1] > col->nValues)
+		return false;
+	attr->type = (SaImmValueTypeT)col->type;
+	attr->nValues = first[obj->row + 1] - first[obj->row];
+	attr->values = s->map + col->values +
+		       (size_t)first[obj->row] * snapValueSize(col->type);
+	return true;
 }
 
-SaAisErrorT immutil_saImmOmAdminOwnerSet(SaImmAdminOwnerHandleT ownerHandle,
-					 const SaNameT **name,
-					 SaImmScopeT scope)
+/* ----------------------------------------------------------------------
+ * Object cache; The config attributes read by immutil_objectCacheGet are
+ * kept per DN and attribute, each attribute in one malloc'ed block. An
+ * applier watches the classes of the cached objects and drops the modified
+ * attributes and deleted objects when a CCB is applied. A read that overlaps
+ * an invalidation is not cached, this is detected with a generation number.
+ * Objects are evicted with the CLOCK algorithm when the cache holds more
+ * than maxBytes.
+ */
+
+#define OBJECT_CACHE_TABLE_MIN 64
+
+struct CacheAttr {
+	struct CacheAttr *next;
+	SaTimeT time; /* When the values were read */
+	size_t size;
+	SaImmAttrValuesT_2 attr;
+};
+
+struct CacheObject {
+	struct CacheObject *next; /* Hash chain */
+	struct CacheObject *ringPrev;
+	struct CacheObject *ringNext;
+	SaUint64T hash;
+	size_t size;
+	struct CacheAttr *attrs;
+	bool complete;	 /* All config attributes are cached */
+	bool referenced; /* Hit since the clock hand passed */
+	char dn[];
+};
+
+/* A class the applier is set for */
+struct CacheClass {
+	struct CacheClass *next;
+	bool watched;
+	char name[];
+};
+
+/* A modified attribute, or a deleted object if attrName is NULL */
+struct CachePending {
+	struct CachePending *next;
+	SaImmOiCcbIdT ccbId;
+	char *attrName;
+	char dn[];
+};
+
+struct ImmutilObjectCache {
+	struct ImmutilObjectCache *next; /* In objectCaches */
+	pthread_rwlock_t lock;
+	struct CacheObject **table;
+	size_t tableSize;
+	size_t maxBytes;
+	SaTimeT maxAge;
+	struct CacheObject *hand; /* The clock hand */
+	SaUint64T generation;	  /* Bumped by every invalidation */
+	struct ImmutilObjectCacheStats stats;
+	pthread_mutex_t classLock;
+	struct CacheClass *classes;
+	SaImmOiHandleT oiHandle;
+	char *applierName;
+	struct CachePending *pending; /* Only used by the dispatch thread */
+};
+
+static pthread_mutex_t objectCachesLock = PTHREAD_MUTEX_INITIALIZER;
+static struct ImmutilObjectCache *objectCaches;
+
+static pthread_key_t objectCacheKey;
+static pthread_once_t objectCacheOnce = PTHREAD_ONCE_INIT;
+
+static void objectCacheResultFree(void *arena)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerSet(ownerHandle, name, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerSet(ownerHandle, name, scope);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAdminOwnerSet FAILED, rc = %d", (int)rc);
-	return rc;
+	arenaDelete((struct Arena *)arena);
 }
 
-SaAisErrorT immutil_saImmOmAdminOwnerSet_o2(SaImmAdminOwnerHandleT ownerHandle,
-					    const char **name,
-					    SaImmScopeT scope)
+static void objectCacheKeyInit(void)
 {
-	int i = 0;
+	if (pthread_key_create(&objectCacheKey, objectCacheResultFree) != 0)
+		immutilError("pthread_key_create FAILED");
+}
 
-	while (name[i]) {
-		i++;
-	}
-	SaNameT **obj_names = (SaNameT **)malloc((i + 1) * sizeof(SaNameT *));
+/* Free the result of the previous get in this thread, return a new arena */
+static struct Arena *objectCacheArena(void)
+{
+	struct Arena *arena;
+
+	pthread_once(&objectCacheOnce, objectCacheKeyInit);
+	if ((arena = pthread_getspecific(objectCacheKey)) != NULL)
+		arenaDelete(arena);
+	arena = arenaCreate();
+	if (pthread_setspecific(objectCacheKey, arena) != 0)
+		immutilError("pthread_setspecific FAILED");
+	return arena;
+}
 
-	i = 0;
-	while (name[i]) {
-		obj_names[i] = (SaNameT *)malloc(sizeof(SaNameT));
-		osaf_extended_name_lend(name[i], obj_names[i]);
-		i++;
-	}
-	obj_names[i] = NULL;
-	SaAisErrorT rc = immutil_saImmOmAdminOwnerSet(
-	    ownerHandle, (const SaNameT **)obj_names, scope);
+static size_t cacheAlign(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
 
-	i = 0;
-	while (obj_names[i]) {
-		free(obj_names[i]);
-		i++;
+/* Bytes needed for the data a value points to */
+static size_t cacheValueExtra(SaImmValueTypeT type, const void *value)
+{
+	if (type == SA_IMM_ATTR_SASTRINGT) {
+		const char *str = *((char *const *)value);
+		return str != NULL ? strlen(str) + 1 : 0;
+	} else if (type == SA_IMM_ATTR_SANAMET) {
+		return strlen(saAisNameBorrow((const SaNameT *)value)) + 1;
+	} else if (type == SA_IMM_ATTR_SAANYT) {
+		return ((const SaAnyT *)value)->bufferSize;
 	}
-	free(obj_names);
+	return 0;
+}
 
-	return rc;
+/* Copy a value to dest and its data to data, return the end of the data */
+static char *cacheValueCopy(SaImmValueTypeT type, void *dest,
+			    const void *value, char *data)
+{
+	size_t size = cacheValueExtra(type, value);
+
+	if (type == SA_IMM_ATTR_SASTRINGT) {
+		const char *str = *((char *const *)value);
+		*((char **)dest) = str != NULL ? memcpy(data, str, size) : NULL;
+	} else if (type == SA_IMM_ATTR_SANAMET) {
+		memcpy(data, saAisNameBorrow((const SaNameT *)value), size);
+		saAisNameLend(data, (SaNameT *)dest);
+	} else if (type == SA_IMM_ATTR_SAANYT) {
+		const SaAnyT *any = (const SaAnyT *)value;
+		SaAnyT *copy = (SaAnyT *)dest;
+		copy->bufferSize = any->bufferSize;
+		copy->bufferAddr = NULL;
+		if (size != 0)
+			copy->bufferAddr = memcpy(data, any->bufferAddr, size);
+	} else {
+		memcpy(dest, value, valueTypeSize(type));
+	}
+	return data + size;
 }
 
-SaAisErrorT
-immutil_saImmOmAdminOwnerSet_o3(SaImmAdminOwnerHandleT adminOwnerHandle,
-				const char **objectNames, SaImmScopeT scope)
+/* Copy an attribute into one block: values pointers, values, data */
+static struct CacheAttr *cacheAttrCreate(const SaImmAttrValuesT_2 *attr,
+					 SaTimeT time)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerSet_o3(
-	    adminOwnerHandle, (SaConstStringT *)objectNames, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerSet_o3(
-		    adminOwnerHandle, (SaConstStringT *)objectNames, scope);
-		nTries++;
+	SaImmValueTypeT type = attr->attrValueType;
+	size_t i, n = attr->attrValuesNumber, valueSize = valueTypeSize(type);
+	size_t pointers = cacheAlign(n * sizeof(SaImmAttrValueT));
+	size_t size = cacheAlign(sizeof(struct CacheAttr)) + pointers +
+		      cacheAlign(n * valueSize) + strlen(attr->attrName) + 1;
+	struct CacheAttr *a;
+	char *values, *data;
+
+	for (i = 0; i < n; i++)
+		size += cacheValueExtra(type, attr->attrValues[i]);
+	if ((a = malloc(size)) == NULL)
+		immutilError("Out of memory");
+	a->next = NULL;
+	a->time = time;
+	a->size = size;
+	a->attr.attrValueType = type;
+	a->attr.attrValuesNumber = n;
+	a->attr.attrValues =
+	    (SaImmAttrValueT *)((char *)a + cacheAlign(sizeof(struct CacheAttr)));
+	values = (char *)a->attr.attrValues + pointers;
+	data = values + cacheAlign(n * valueSize);
+	a->attr.attrName = strcpy(data, attr->attrName);
+	data += strlen(data) + 1;
+	for (i = 0; i < n; i++) {
+		a->attr.attrValues[i] = values + i * valueSize;
+		data = cacheValueCopy(type, a->attr.attrValues[i],
+				      attr->attrValues[i], data);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	return a;
 }
 
-SaAisErrorT immutil_saImmOmAdminOwnerRelease(SaImmAdminOwnerHandleT ownerHandle,
-					     const SaNameT **name,
-					     SaImmScopeT scope)
+static void cacheAttrsFree(struct CacheAttr *a)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerRelease(ownerHandle, name, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerRelease(ownerHandle, name, scope);
-		nTries++;
+	while (a != NULL) {
+		struct CacheAttr *next = a->next;
+		free(a);
+		a = next;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAdminOwnerRelease FAILED, rc = %d",
-			     (int)rc);
-	return rc;
 }
 
-SaAisErrorT
-immutil_saImmOmAdminOwnerRelease_o2(SaImmAdminOwnerHandleT ownerHandle,
-				    const char **name, SaImmScopeT scope)
+static struct CacheAttr *cacheAttrFind(const struct CacheObject *o,
+				       const char *attrName)
 {
-	int i = 0;
+	struct CacheAttr *a;
+	for (a = o->attrs; a != NULL; a = a->next)
+		if (strcmp(a->attr.attrName, attrName) == 0)
+			break;
+	return a;
+}
 
-	while (name[i]) {
-		i++;
-	}
-	SaNameT **obj_names = (SaNameT **)malloc((i + 1) * sizeof(SaNameT *));
+static bool cacheAttrFresh(const struct ImmutilObjectCache *cache,
+			   const struct CacheAttr *a, SaTimeT now)
+{
+	return cache->maxAge == 0 || now - a->time < cache->maxAge;
+}
 
-	i = 0;
-	while (name[i]) {
-		obj_names[i] = (SaNameT *)malloc(sizeof(SaNameT));
-		osaf_extended_name_lend(name[i], obj_names[i]);
-		i++;
+static struct CacheObject *cacheObjectFind(struct ImmutilObjectCache *cache,
+					   const char *dn, SaUint64T hash)
+{
+	struct CacheObject *o;
+	if (cache->tableSize == 0)
+		return NULL;
+	for (o = cache->table[hash & (cache->tableSize - 1)]; o != NULL;
+	     o = o->next)
+		if (o->hash == hash && strcmp(o->dn, dn) == 0)
+			break;
+	return o;
+}
+
+/* Create an object, it is put behind the clock hand */
+static struct CacheObject *cacheObjectCreate(struct ImmutilObjectCache *cache,
+					     const char *dn, SaUint64T hash)
+{
+	size_t i, size = strlen(dn) + 1;
+	struct CacheObject *o;
+
+	if (cache->stats.objects >= cache->tableSize) {
+		size_t tableSize = cache->tableSize == 0
+				       ? OBJECT_CACHE_TABLE_MIN
+				       : 2 * cache->tableSize;
+		struct CacheObject **table = calloc(tableSize, sizeof(*table));
+		if (table == NULL)
+			immutilError("Out of memory");
+		for (i = 0; i < cache->tableSize; i++) {
+			while ((o = cache->table[i]) != NULL) {
+				cache->table[i] = o->next;
+				o->next = table[o->hash & (tableSize - 1)];
+				table[o->hash & (tableSize - 1)] = o;
+			}
+		}
+		free(cache->table);
+		cache->table = table;
+		cache->tableSize = tableSize;
 	}
-	obj_names[i] = NULL;
+	if ((o = calloc(1, sizeof(struct CacheObject) + size)) == NULL)
+		immutilError("Out of memory");
+	memcpy(o->dn, dn, size);
+	o->hash = hash;
+	o->size = sizeof(struct CacheObject) + size;
+	i = hash & (cache->tableSize - 1);
+	o->next = cache->table[i];
+	cache->table[i] = o;
+	if (cache->hand == NULL) {
+		o->ringPrev = o->ringNext = o;
+		cache->hand = o;
+	} else {
+		o->ringNext = cache->hand;
+		o->ringPrev = cache->hand->ringPrev;
+		o->ringPrev->ringNext = o;
+		cache->hand->ringPrev = o;
+	}
+	cache->stats.objects++;
+	cache->stats.bytes += o->size;
+	return o;
+}
 
-	SaAisErrorT rc = immutil_saImmOmAdminOwnerRelease(
-	    ownerHandle, (const SaNameT **)obj_names, scope);
-	i = 0;
-	while (obj_names[i]) {
-		free(obj_names[i]);
-		i++;
+static void cacheObjectDelete(struct ImmutilObjectCache *cache,
+			      struct CacheObject *o)
+{
+	struct CacheObject **pp = &cache->table[o->hash & (cache->tableSize - 1)];
+
+	while (*pp != o)
+		pp = &(*pp)->next;
+	*pp = o->next;
+	if (o->ringNext == o) {
+		cache->hand = NULL;
+	} else {
+		if (cache->hand == o)
+			cache->hand = o->ringNext;
+		o->ringPrev->ringNext = o->ringNext;
+		o->ringNext->ringPrev = o->ringPrev;
 	}
-	free(obj_names);
+	cache->stats.objects--;
+	cache->stats.bytes -= o->size;
+	cacheAttrsFree(o->attrs);
+	free(o);
+}
 
-	return rc;
+/* Unlink and free an attribute, return false if it is not cached */
+static bool cacheAttrDelete(struct ImmutilObjectCache *cache,
+			    struct CacheObject *o, const char *attrName)
+{
+	struct CacheAttr *a, **pp;
+
+	for (pp = &o->attrs; (a = *pp) != NULL; pp = &a->next) {
+		if (strcmp(a->attr.attrName, attrName) == 0) {
+			*pp = a->next;
+			o->size -= a->size;
+			cache->stats.bytes -= a->size;
+			free(a);
+			return true;
+		}
+	}
+	return false;
 }
 
-SaAisErrorT
-immutil_saImmOmAdminOwnerRelease_o3(SaImmAdminOwnerHandleT adminOwnerHandle,
-				    const char **objectNames, SaImmScopeT scope)
+/* Give objects that were not hit since the hand passed them a second
+   chance, evict the others until the cache is within maxBytes */
+static void cacheEvict(struct ImmutilObjectCache *cache)
 {
-	SaAisErrorT rc = saImmOmAdminOwnerRelease_o3(
-	    adminOwnerHandle, (SaConstStringT *)objectNames, scope);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOwnerRelease_o3(
-		    adminOwnerHandle, (SaConstStringT *)objectNames, scope);
-		nTries++;
+	while (cache->maxBytes != 0 && cache->stats.bytes > cache->maxBytes &&
+	       cache->hand != NULL) {
+		struct CacheObject *o = cache->hand;
+		if (__atomic_exchange_n(&o->referenced, false,
+					__ATOMIC_RELAXED)) {
+			cache->hand = o->ringNext;
+		} else {
+			cacheObjectDelete(cache, o);
+			cache->stats.evictions++;
+		}
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
 }
 
-SaAisErrorT immutil_saImmOmAdminOperationInvoke_o214(
-    SaImmAdminOwnerHandleT ownerHandle, const char *objectName,
-    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
-    const SaImmAdminOperationParamsT_2 **params,
-    SaAisErrorT *operationReturnValue, SaTimeT timeout,
-    SaImmAdminOperationParamsT_2 ***returnParams)
+/* Set the applier for a class */
+static SaAisErrorT cacheClassWatch(SaImmOiHandleT oiHandle,
+				   const char *className)
 {
-	SaNameT obj_name;
-	if (objectName)
-		osaf_extended_name_lend(objectName, &obj_name);
-	else
-		osaf_extended_name_clear(&obj_name);
+	struct ImmutilRetry retry;
+	SaAisErrorT rc;
 
-	SaAisErrorT rc = immutil_saImmOmAdminOperationInvoke_o2(
-	    ownerHandle, &obj_name, continuationId, operationId, params,
-	    operationReturnValue, timeout, returnParams);
+	rc = retryStart(&retry, IMMUTIL_OP_OI_CLASS_IMPLEMENTER_SET);
+	if (rc == SA_AIS_OK)
+		do {
+			rc = saImmOiClassImplementerSet(
+			     oiHandle, (SaImmClassNameT)className);
+		} while (immutil_retry(&retry, rc));
 	return rc;
 }
 
-SaAisErrorT immutil_saImmOmAdminOperationInvoke_o2(
-    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
-    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
-    const SaImmAdminOperationParamsT_2 **params,
-    SaAisErrorT *operationReturnValue, SaTimeT timeout,
-    SaImmAdminOperationParamsT_2 ***returnParams)
+/*
+ * Return true if the applier was set for the class before this call. The
+ * applier is set for a new class here, but an object read before that may
+ * already be stale, so it is not cached. Runtime classes can not have an
+ * applier and are never cached.
+ */
+static bool cacheClassWatched(struct ImmutilObjectCache *cache,
+			      const char *className)
 {
-	SaAisErrorT rc = saImmOmAdminOperationInvoke_o2(
-	    ownerHandle, objectName, continuationId, operationId, params,
-	    operationReturnValue, timeout, returnParams);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOperationInvoke_o2(
-		    ownerHandle, objectName, continuationId, operationId,
-		    params, operationReturnValue, timeout, returnParams);
-		nTries++;
+	struct CacheClass *c;
+	bool watched = false;
+
+	pthread_mutex_lock(&cache->classLock);
+	for (c = cache->classes; c != NULL; c = c->next)
+		if (strcmp(c->name, className) == 0)
+			break;
+	if (c != NULL) {
+		watched = c->watched;
+	} else {
+		c = malloc(sizeof(struct CacheClass) + strlen(className) + 1);
+		if (c == NULL)
+			immutilError("Out of memory");
+		strcpy(c->name, className);
+		c->watched = cache->oiHandle != 0 &&
+			     cacheClassWatch(cache->oiHandle, className) ==
+				 SA_AIS_OK;
+		c->next = cache->classes;
+		cache->classes = c;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAdminOperationInvoke_o2 FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	pthread_mutex_unlock(&cache->classLock);
+	return watched;
 }
 
-SaAisErrorT immutil_saImmOmAdminOperationInvoke_2(
-    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
-    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
-    const SaImmAdminOperationParamsT_2 **params,
-    SaAisErrorT *operationReturnValue, SaTimeT timeout)
+/* Drop all objects, reads in progress are not cached */
+static void cacheFlush(struct ImmutilObjectCache *cache,
+		       const SaNameT *objectName)
 {
-	SaAisErrorT rc = saImmOmAdminOperationInvoke_2(
-	    ownerHandle, objectName, continuationId, operationId, params,
-	    operationReturnValue, timeout);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOperationInvoke_2(
-		    ownerHandle, objectName, continuationId, operationId,
-		    params, operationReturnValue, timeout);
-		nTries++;
+	struct CacheObject *o;
+
+	pthread_rwlock_wrlock(&cache->lock);
+	cache->generation++;
+	if (objectName != NULL) {
+		const char *dn = saAisNameBorrow(objectName);
+		if ((o = cacheObjectFind(cache, dn, hashStr(dn))) != NULL)
+			cacheObjectDelete(cache, o);
+	} else {
+		while (cache->hand != NULL)
+			cacheObjectDelete(cache, cache->hand);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmAdminOperationInvoke_2 FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	pthread_rwlock_unlock(&cache->lock);
 }
 
-SaAisErrorT immutil_saImmOmAdminOperationInvoke_o3(
-    SaImmAdminOwnerHandleT ownerHandle, const char *objectName,
-    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
-    const SaImmAdminOperationParamsT_2 **params,
-    SaAisErrorT *operationReturnValue, SaTimeT timeout,
-    SaImmAdminOperationParamsT_2 ***returnParams)
+/* Keep the config attributes of a read and put them in the cache */
+static void cacheInsert(struct ImmutilObjectCache *cache,
+			const SaNameT *objectName, SaUint64T hash,
+			SaUint64T generation, struct CacheAttr *attrs,
+			bool complete)
 {
-	SaAisErrorT rc = saImmOmAdminOperationInvoke_o3(
-	    ownerHandle, (SaConstStringT)objectName, continuationId,
-	    operationId, params, operationReturnValue, timeout, returnParams);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOperationInvoke_o3(
-		    ownerHandle, (SaConstStringT)objectName, continuationId,
-		    operationId, params, operationReturnValue, timeout,
-		    returnParams);
-		nTries++;
+	const char *dn = saAisNameBorrow(objectName);
+	struct CacheAttr *keep = NULL, *a;
+	struct CacheObject *o;
+	char *className = NULL;
+
+	for (a = attrs; a != NULL; a = a->next) {
+		if (strcmp(a->attr.attrName, SA_IMM_ATTR_CLASS_NAME) == 0 &&
+		    a->attr.attrValuesNumber == 1) {
+			className =
+			    strdup(*((char **)a->attr.attrValues[0]));
+			if (className == NULL)
+				immutilError("Out of memory");
+		}
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	if (className == NULL &&
+	    (className = classNameGet(0, objectName)) == NULL) {
+		cacheAttrsFree(attrs);
+		return;
+	}
+	if (!cacheClassWatched(cache, className)) {
+		free(className);
+		cacheAttrsFree(attrs);
+		return;
+	}
+	while ((a = attrs) != NULL) {
+		SaImmAttrFlagsT flags = 0;
+		attrs = a->next;
+		if (strcmp(a->attr.attrName, SA_IMM_ATTR_CLASS_NAME) == 0 ||
+		    (immutil_get_attrDefinition(className, a->attr.attrName,
+						NULL, &flags) == SA_AIS_OK &&
+		     (flags & SA_IMM_ATTR_CONFIG) != 0)) {
+			a->next = keep;
+			keep = a;
+		} else {
+			complete = false;
+			free(a);
+		}
+	}
+	free(className);
+
+	pthread_rwlock_wrlock(&cache->lock);
+	if (cache->generation == generation) {
+		if ((o = cacheObjectFind(cache, dn, hash)) == NULL)
+			o = cacheObjectCreate(cache, dn, hash);
+		while ((a = keep) != NULL) {
+			keep = a->next;
+			(void)cacheAttrDelete(cache, o, a->attr.attrName);
+			a->next = o->attrs;
+			o->attrs = a;
+			o->size += a->size;
+			cache->stats.bytes += a->size;
+		}
+		o->complete = o->complete || complete;
+		cacheEvict(cache);
+	}
+	pthread_rwlock_unlock(&cache->lock);
+	cacheAttrsFree(keep);
 }
 
-SaAisErrorT immutil_saImmOmAdminOperationInvokeAsync_2(
-    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT userInvocation,
-    const SaNameT *objectName, SaImmContinuationIdT continuationId,
-    SaImmAdminOperationIdT operationId,
-    const SaImmAdminOperationParamsT_2 **params)
+static void cacheHit(struct ImmutilObjectCache *cache, struct CacheObject *o,
+		     SaTimeT age)
 {
-	SaAisErrorT rc = saImmOmAdminOperationInvokeAsync_2(
-	    ownerHandle, userInvocation, objectName, continuationId,
-	    operationId, params);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOperationInvokeAsync_2(
-		    ownerHandle, userInvocation, objectName, continuationId,
-		    operationId, params);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	SaTimeT max = __atomic_load_n(&cache->stats.hitAgeMax, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&o->referenced, true, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&cache->stats.hits, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&cache->stats.hitAgeSum, age, __ATOMIC_RELAXED);
+	while (age > max &&
+	       !__atomic_compare_exchange_n(&cache->stats.hitAgeMax, &max, age,
+					    true, __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		;
 }
 
-SaAisErrorT immutil_saImmOmAdminOperationInvokeAsync_o3(
-    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT userInvocation,
-    const char *objectName, SaImmContinuationIdT continuationId,
-    SaImmAdminOperationIdT operationId,
-    const SaImmAdminOperationParamsT_2 **params)
+SaAisErrorT immutil_objectCacheGet(ImmutilObjectCache_t *cache,
+				   const SaNameT *objectName,
+				   const SaImmAttrNameT *attributeNames,
+				   SaImmAttrValuesT_2 ***attributes)
 {
-	SaAisErrorT rc = saImmOmAdminOperationInvokeAsync_o3(
-	    ownerHandle, userInvocation, (SaConstStringT)objectName,
-	    continuationId, operationId, params);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmAdminOperationInvokeAsync_o3(
-		    ownerHandle, userInvocation, (SaConstStringT)objectName,
-		    continuationId, operationId, params);
-		nTries++;
+	SaImmAttrNameT configAttrs[] = {"SA_IMM_SEARCH_GET_CONFIG_ATTR", NULL};
+	const char *dn = saAisNameBorrow(objectName);
+	SaUint64T hash = hashStr(dn), generation;
+	struct Arena *arena = objectCacheArena();
+	SaTimeT now = monotonicTime(), oldest = now;
+	const SaImmAttrValuesT_2 **result = NULL;
+	SaImmAttrNameT *missing = configAttrs;
+	struct CacheAttr *attrs = NULL;
+	SaAisErrorT rc = SA_AIS_ERR_BAD_HANDLE;
+	size_t i, j, n = 0, nMissing = 0;
+	struct CacheObject *o;
+	struct CacheAttr *a;
+	bool hit;
+	int attempt;
+
+	if (attributeNames != NULL) {
+		while (attributeNames[n] != NULL)
+			n++;
+		missing = arenaMalloc(arena, (n + 2) * sizeof(*missing));
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
-}
 
-SaAisErrorT immutil_saImmOmCcbObjectCreate_2(
-    SaImmCcbHandleT immCcbHandle, const SaImmClassNameT className,
-    const SaNameT *parent, const SaImmAttrValuesT_2 **attrValues)
-{
-	SaAisErrorT rc = saImmOmCcbObjectCreate_2(immCcbHandle, className,
-						  parent, attrValues);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbObjectCreate_2(immCcbHandle, className, parent,
-					      attrValues);
-		nTries++;
+	/* The cached values, or the attributes to read */
+	pthread_rwlock_rdlock(&cache->lock);
+	generation = cache->generation;
+	o = cacheObjectFind(cache, dn, hash);
+	hit = o != NULL;
+	if (attributeNames == NULL) {
+		hit = hit && o->complete;
+		for (a = hit ? o->attrs : NULL; a != NULL; a = a->next)
+			n++;
+		result = arenaMalloc(arena, (n + 1) * sizeof(*result));
+		for (a = hit ? o->attrs : NULL, i = 0; hit && a != NULL;
+		     a = a->next, i++) {
+			hit = cacheAttrFresh(cache, a, now);
+			result[i] = dupSaImmAttrValuesT(arena, &a->attr);
+			if (a->time < oldest)
+				oldest = a->time;
+		}
+	} else {
+		result = arenaMalloc(arena, (n + 1) * sizeof(*result));
+		for (i = 0; i < n; i++) {
+			a = o != NULL ? cacheAttrFind(o, attributeNames[i])
+				      : NULL;
+			if (a != NULL && cacheAttrFresh(cache, a, now)) {
+				result[i] = dupSaImmAttrValuesT(arena, &a->attr);
+				if (a->time < oldest)
+					oldest = a->time;
+			} else {
+				missing[nMissing++] = attributeNames[i];
+				hit = false;
+			}
+		}
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbObjectCreate_2 FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	if (hit)
+		cacheHit(cache, o, now - oldest);
+	else
+		__atomic_fetch_add(&cache->stats.misses, 1, __ATOMIC_RELAXED);
+	pthread_rwlock_unlock(&cache->lock);
+	if (hit) {
+		*attributes = (SaImmAttrValuesT_2 **)result;
+		return SA_AIS_OK;
+	}
+
+	/* The class name is read to find the config attributes */
+	if (attributeNames != NULL) {
+		for (i = 0; i < nMissing; i++)
+			if (strcmp(missing[i], SA_IMM_ATTR_CLASS_NAME) == 0)
+				break;
+		if (i == nMissing)
+			missing[nMissing++] = (SaImmAttrNameT)SA_IMM_ATTR_CLASS_NAME;
+		missing[nMissing] = NULL;
+	}
+
+	/* One retry with new handles on SA_AIS_ERR_BAD_HANDLE */
+	for (attempt = 0; attempt < 2 && rc == SA_AIS_ERR_BAD_HANDLE;
+	     attempt++) {
+		struct OmHandles *h = omHandlesGet(0);
+		struct ImmutilRetry retry;
+		SaImmAttrValuesT_2 **read;
+		if (h == NULL) {
+			rc = SA_AIS_ERR_UNAVAILABLE;
+			break;
+		}
+		rc = retryStart(&retry, IMMUTIL_OP_OM_ACCESSOR_GET_2);
+		if (rc == SA_AIS_OK)
+			do {
+				rc = saImmOmAccessorGet_2(h->accessorHandle,
+							  objectName, missing,
+							  &read);
+			} while (immutil_retry(&retry, rc));
+		if (rc == SA_AIS_OK) {
+			now = monotonicTime();
+			for (j = 0; read != NULL && read[j] != NULL; j++) {
+				a = cacheAttrCreate(read[j], now);
+				a->next = attrs;
+				attrs = a;
+			}
+			if (attributeNames == NULL) {
+				result = dupSaImmAttrValuesT_array(
+				    arena, (const SaImmAttrValuesT_2 **)read);
+			} else {
+				for (i = 0; i < n; i++) {
+					for (j = 0; result[i] == NULL &&
+						    read != NULL &&
+						    read[j] != NULL;
+					     j++)
+						if (strcmp(read[j]->attrName,
+							   attributeNames[i]) ==
+						    0)
+							result[i] =
+							    dupSaImmAttrValuesT(
+								arena, read[j]);
+				}
+			}
+		}
+		omHandlesPut(h, rc);
+	}
+	if (rc != SA_AIS_OK) {
+		if (rc != SA_AIS_ERR_NOT_EXIST &&
+		    immutilWrapperProfile.errorsAreFatal)
+			immutilError("saImmOmAccessorGet_2 FAILED, rc = %d",
+				     (int)rc);
+		return rc;
+	}
+	if (attributeNames != NULL) {
+		/* Leave out names that were not returned */
+		for (i = j = 0; i < n; i++)
+			if (result[i] != NULL)
+				result[j++] = result[i];
+		result[j] = NULL;
+	}
+	cacheInsert(cache, objectName, hash, generation, attrs,
+		    attributeNames == NULL);
+	*attributes = (SaImmAttrValuesT_2 **)result;
+	return SA_AIS_OK;
 }
 
-SaAisErrorT immutil_saImmOmCcbObjectCreate_o2(
-    SaImmCcbHandleT immCcbHandle, const SaImmClassNameT className,
-    const char *parent, const SaImmAttrValuesT_2 **attrValues)
+/*
+ * Applier callbacks. The operations of a CCB are kept until the CCB is
+ * applied or aborted, the cache is not changed before the apply.
+ */
+
+static struct ImmutilObjectCache *objectCacheFind(SaImmOiHandleT oiHandle)
 {
-	SaNameT parent_name;
-	if (parent)
-		osaf_extended_name_lend(parent, &parent_name);
-	else
-		osaf_extended_name_clear(&parent_name);
+	struct ImmutilObjectCache *cache;
 
-	SaAisErrorT rc = immutil_saImmOmCcbObjectCreate_2(
-	    immCcbHandle, className, &parent_name, attrValues);
-	return rc;
+	pthread_mutex_lock(&objectCachesLock);
+	for (cache = objectCaches; cache != NULL; cache = cache->next)
+		if (__atomic_load_n(&cache->oiHandle, __ATOMIC_RELAXED) ==
+		    oiHandle)
+			break;
+	pthread_mutex_unlock(&objectCachesLock);
+	return cache;
 }
 
-SaAisErrorT immutil_saImmOmCcbObjectCreate_o3(
-    SaImmCcbHandleT ccbHandle, const char *className,
-    const char *const objectName, const SaImmAttrValuesT_2 **attrValues)
+static void objectCachePending(SaImmOiHandleT oiHandle, SaImmOiCcbIdT ccbId,
+			       const SaNameT *objectName, const char *attrName)
 {
-	SaAisErrorT rc = saImmOmCcbObjectCreate_o3(
-	    ccbHandle, (const SaImmClassNameT)className,
-	    (const SaConstStringT)objectName, attrValues);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbObjectCreate_o3(
-		    ccbHandle, (const SaImmClassNameT)className,
-		    (const SaConstStringT)objectName, attrValues);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	struct ImmutilObjectCache *cache = objectCacheFind(oiHandle);
+	const char *dn = saAisNameBorrow(objectName);
+	struct CachePending *p;
+
+	if (cache == NULL)
+		return;
+	p = malloc(sizeof(struct CachePending) + strlen(dn) + 1);
+	if (p == NULL)
+		immutilError("Out of memory");
+	strcpy(p->dn, dn);
+	p->ccbId = ccbId;
+	p->attrName = NULL;
+	if (attrName != NULL && (p->attrName = strdup(attrName)) == NULL)
+		immutilError("Out of memory");
+	p->next = cache->pending;
+	cache->pending = p;
 }
 
-SaAisErrorT
-immutil_saImmOmCcbObjectModify_2(SaImmCcbHandleT immCcbHandle,
-				 const SaNameT *objectName,
-				 const SaImmAttrModificationT_2 **attrMods)
+static SaAisErrorT objectCacheCcbCreate(SaImmOiHandleT oiHandle,
+					SaImmOiCcbIdT ccbId,
+					const SaImmClassNameT className,
+					const SaNameT *parentName,
+					const SaImmAttrValuesT_2 **attr)
 {
-	SaAisErrorT rc =
-	    saImmOmCcbObjectModify_2(immCcbHandle, objectName, attrMods);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbObjectModify_2(immCcbHandle, objectName,
-					      attrMods);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbObjectModify_2 FAILED, rc = %d",
-			     (int)rc);
-	return rc;
+	return SA_AIS_OK;
 }
 
-SaAisErrorT
-immutil_saImmOmCcbObjectModify_o2(SaImmCcbHandleT immCcbHandle,
-				  const char *objectName,
-				  const SaImmAttrModificationT_2 **attrMods)
+static SaAisErrorT objectCacheCcbDelete(SaImmOiHandleT oiHandle,
+					SaImmOiCcbIdT ccbId,
+					const SaNameT *objectName)
 {
-	SaNameT obj_name;
-	if (objectName)
-		osaf_extended_name_lend(objectName, &obj_name);
-	else
-		osaf_extended_name_clear(&obj_name);
+	objectCachePending(oiHandle, ccbId, objectName, NULL);
+	return SA_AIS_OK;
+}
 
-	SaAisErrorT rc =
-	    immutil_saImmOmCcbObjectModify_2(immCcbHandle, &obj_name, attrMods);
-	return rc;
+static SaAisErrorT
+objectCacheCcbModify(SaImmOiHandleT oiHandle, SaImmOiCcbIdT ccbId,
+		     const SaNameT *objectName,
+		     const SaImmAttrModificationT_2 **attrMods)
+{
+	size_t i;
+	for (i = 0; attrMods != NULL && attrMods[i] != NULL; i++)
+		objectCachePending(oiHandle, ccbId, objectName,
+				   attrMods[i]->modAttr.attrName);
+	return SA_AIS_OK;
 }
 
-SaAisErrorT
-immutil_saImmOmCcbObjectModify_o3(SaImmCcbHandleT ccbHandle,
-				  const char *objectName,
-				  const SaImmAttrModificationT_2 **attrMods)
+static SaAisErrorT objectCacheCcbCompleted(SaImmOiHandleT oiHandle,
+					   SaImmOiCcbIdT ccbId)
 {
-	SaAisErrorT rc = saImmOmCcbObjectModify_o3(
-	    ccbHandle, (SaConstStringT)objectName, attrMods);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbObjectModify_o3(
-		    ccbHandle, (SaConstStringT)objectName, attrMods);
-		nTries++;
-	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	return SA_AIS_OK;
 }
 
-SaAisErrorT immutil_saImmOmCcbObjectDelete(SaImmCcbHandleT immCcbHandle,
-					   const SaNameT *objectName)
+/* Remove the operations of a CCB, and apply them to the cache if apply */
+static void objectCacheCcbEnd(SaImmOiHandleT oiHandle, SaImmOiCcbIdT ccbId,
+			      bool apply)
 {
-	SaAisErrorT rc = saImmOmCcbObjectDelete(immCcbHandle, objectName);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbObjectDelete(immCcbHandle, objectName);
-		nTries++;
+	struct ImmutilObjectCache *cache = objectCacheFind(oiHandle);
+	struct CachePending *p, **pp, *done = NULL;
+	struct CacheObject *o;
+
+	if (cache == NULL)
+		return;
+	for (pp = &cache->pending; (p = *pp) != NULL;) {
+		if (p->ccbId == ccbId) {
+			*pp = p->next;
+			p->next = done;
+			done = p;
+		} else {
+			pp = &p->next;
+		}
+	}
+	if (done == NULL)
+		return;
+	if (apply) {
+		pthread_rwlock_wrlock(&cache->lock);
+		cache->generation++;
+		for (p = done; p != NULL; p = p->next) {
+			o = cacheObjectFind(cache, p->dn, hashStr(p->dn));
+			if (o == NULL)
+				continue;
+			if (p->attrName == NULL) {
+				cacheObjectDelete(cache, o);
+				cache->stats.invalidations++;
+			} else if (cacheAttrDelete(cache, o, p->attrName)) {
+				o->complete = false;
+				cache->stats.invalidations++;
+			}
+		}
+		pthread_rwlock_unlock(&cache->lock);
+	}
+	while ((p = done) != NULL) {
+		done = p->next;
+		if (apply && p->attrName == NULL) {
+			/* The DN may be created again with another class */
+			SaNameT name;
+			saAisNameLend(p->dn, &name);
+			immutil_classNameCacheFlush(&name);
+		}
+		free(p->attrName);
+		free(p);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbObjectDelete FAILED, rc = %d", (int)rc);
-	return rc;
 }
 
-SaAisErrorT immutil_saImmOmCcbObjectDelete_o2(SaImmCcbHandleT immCcbHandle,
-					      const char *objectName)
+static void objectCacheCcbApply(SaImmOiHandleT oiHandle, SaImmOiCcbIdT ccbId)
 {
-	SaNameT obj_name;
-	if (objectName)
-		osaf_extended_name_lend(objectName, &obj_name);
-	else
-		osaf_extended_name_clear(&obj_name);
+	objectCacheCcbEnd(oiHandle, ccbId, true);
+}
 
-	SaAisErrorT rc =
-	    immutil_saImmOmCcbObjectDelete(immCcbHandle, &obj_name);
-	return rc;
+static void objectCacheCcbAbort(SaImmOiHandleT oiHandle, SaImmOiCcbIdT ccbId)
+{
+	objectCacheCcbEnd(oiHandle, ccbId, false);
 }
 
-SaAisErrorT immutil_saImmOmCcbObjectDelete_o3(SaImmCcbHandleT ccbHandle,
-					      const char *objectName)
+static const SaImmOiCallbacksT_2 objectCacheCallbacks = {
+    .saImmOiCcbAbortCallback = objectCacheCcbAbort,
+    .saImmOiCcbApplyCallback = objectCacheCcbApply,
+    .saImmOiCcbCompletedCallback = objectCacheCcbCompleted,
+    .saImmOiCcbObjectCreateCallback = objectCacheCcbCreate,
+    .saImmOiCcbObjectDeleteCallback = objectCacheCcbDelete,
+    .saImmOiCcbObjectModifyCallback = objectCacheCcbModify,
+};
+
+/* Finalize the applier, nothing is cached until it is set up again */
+static void objectCacheApplierFinalize(struct ImmutilObjectCache *cache)
 {
-	SaAisErrorT rc =
-	    saImmOmCcbObjectDelete_o3(ccbHandle, (SaConstStringT)objectName);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbObjectDelete_o3(ccbHandle,
-					       (SaConstStringT)objectName);
-		nTries++;
+	struct CacheClass *c;
+	struct CachePending *p;
+	SaImmOiHandleT oiHandle;
+
+	pthread_mutex_lock(&cache->classLock);
+	oiHandle = cache->oiHandle;
+	__atomic_store_n(&cache->oiHandle, 0, __ATOMIC_RELAXED);
+	for (c = cache->classes; c != NULL; c = c->next)
+		c->watched = false;
+	pthread_mutex_unlock(&cache->classLock);
+	while ((p = cache->pending) != NULL) {
+		cache->pending = p->next;
+		free(p->attrName);
+		free(p);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(" FAILED, rc = %d", (int)rc);
-	return rc;
+	cacheFlush(cache, NULL);
+	if (oiHandle != 0)
+		(void)saImmOiFinalize(oiHandle);
 }
 
-SaAisErrorT immutil_saImmOmCcbObjectRead(SaImmCcbHandleT ccbHandle,
-					 SaConstStringT objectName,
-					 const SaImmAttrNameT *attributeNames,
-					 SaImmAttrValuesT_2 ***attributes)
+SaAisErrorT immutil_objectCacheApplierInit(ImmutilObjectCache_t *cache)
 {
-	SaAisErrorT rc = saImmOmCcbObjectRead(ccbHandle, objectName,
-					      attributeNames, attributes);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmCcbObjectRead(ccbHandle, objectName, attributeNames,
-					  attributes);
-		nTries++;
+	SaImmOiHandleT oiHandle;
+	struct CacheClass *c;
+	SaAisErrorT rc;
+
+	if (cache->oiHandle != 0)
+		objectCacheApplierFinalize(cache);
+	if ((rc = immutil_saImmOiInitialize_2(&oiHandle, &objectCacheCallbacks,
+					      &immVersion)) != SA_AIS_OK)
+		return rc;
+	if ((rc = immutil_saImmOiImplementerSet(oiHandle,
+						cache->applierName)) !=
+	    SA_AIS_OK) {
+		(void)saImmOiFinalize(oiHandle);
+		return rc;
 	}
-	if (rc != SA_AIS_OK && rc != SA_AIS_ERR_NOT_EXIST &&
-	    immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmCcbObjectRead FAILED, rc = %d", (int)rc);
-	return rc;
+	pthread_mutex_lock(&cache->classLock);
+	for (c = cache->classes; c != NULL; c = c->next)
+		c->watched = cacheClassWatch(oiHandle, c->name) == SA_AIS_OK;
+	__atomic_store_n(&cache->oiHandle, oiHandle, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&cache->classLock);
+	/* Changes made before the classes were watched are not seen */
+	cacheFlush(cache, NULL);
+	return SA_AIS_OK;
 }
 
-SaAisErrorT
-immutil_saImmOmClassDescriptionGet_2(SaImmHandleT immHandle,
-				     const SaImmClassNameT className,
-				     SaImmClassCategoryT *classCategory,
-				     SaImmAttrDefinitionT_2 ***attrDefinitions)
+SaAisErrorT immutil_objectCacheCreate(const char *applierName,
+				      size_t maxBytes, SaTimeT maxAge,
+				      ImmutilObjectCache_t **cache)
 {
-	SaAisErrorT rc = saImmOmClassDescriptionGet_2(
-	    immHandle, className, classCategory, attrDefinitions);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmClassDescriptionGet_2(
-		    immHandle, className, classCategory, attrDefinitions);
-		nTries++;
+	struct ImmutilObjectCache *c = calloc(1, sizeof(*c));
+	SaAisErrorT rc;
+
+	if (c == NULL ||
+	    asprintf(&c->applierName, applierName[0] == '@' ? "%s" : "@%s",
+		     applierName) < 0)
+		immutilError("Out of memory");
+	pthread_rwlock_init(&c->lock, NULL);
+	pthread_mutex_init(&c->classLock, NULL);
+	c->maxBytes = maxBytes;
+	c->maxAge = maxAge;
+	pthread_mutex_lock(&objectCachesLock);
+	c->next = objectCaches;
+	objectCaches = c;
+	pthread_mutex_unlock(&objectCachesLock);
+	if ((rc = immutil_objectCacheApplierInit(c)) != SA_AIS_OK) {
+		immutil_objectCacheDelete(c);
+		c = NULL;
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError("saImmOmClassDescriptionGet_2 FAILED, rc = %d",
-			     (int)rc);
+	*cache = c;
 	return rc;
 }
 
-SaAisErrorT
-immutil_saImmOmClassDescriptionMemoryFree_2(SaImmHandleT immHandle,
-					    SaImmAttrDefinitionT_2 **attrDef)
+void immutil_objectCacheDelete(ImmutilObjectCache_t *cache)
 {
-	SaAisErrorT rc =
-	    saImmOmClassDescriptionMemoryFree_2(immHandle, attrDef);
-	unsigned int nTries = 1;
-	while (rc == SA_AIS_ERR_TRY_AGAIN &&
-	       nTries < immutilWrapperProfile.nTries) {
-		usleep(immutilWrapperProfile.retryInterval * 1000);
-		rc = saImmOmClassDescriptionMemoryFree_2(immHandle, attrDef);
-		nTries++;
+	struct ImmutilObjectCache **pp;
+	struct CacheClass *c;
+
+	pthread_mutex_lock(&objectCachesLock);
+	for (pp = &objectCaches; *pp != cache; pp = &(*pp)->next)
+		;
+	*pp = cache->next;
+	pthread_mutex_unlock(&objectCachesLock);
+	objectCacheApplierFinalize(cache);
+	while ((c = cache->classes) != NULL) {
+		cache->classes = c->next;
+		free(c);
 	}
-	if (rc != SA_AIS_OK && immutilWrapperProfile.errorsAreFatal)
-		immutilError(
-		    "saImmOmClassDescriptionMemoryFree_2 FAILED, rc = %d",
-		    (int)rc);
+	free(cache->table);
+	free(cache->applierName);
+	pthread_rwlock_destroy(&cache->lock);
+	pthread_mutex_destroy(&cache->classLock);
+	free(cache);
+}
+
+SaAisErrorT immutil_objectCacheSelectionObjectGet(ImmutilObjectCache_t *cache,
+						  SaSelectionObjectT *sel)
+{
+	if (cache->oiHandle == 0)
+		return SA_AIS_ERR_BAD_HANDLE;
+	return immutil_saImmOiSelectionObjectGet(cache->oiHandle, sel);
+}
+
+SaAisErrorT immutil_objectCacheDispatch(ImmutilObjectCache_t *cache)
+{
+	SaAisErrorT rc = SA_AIS_ERR_BAD_HANDLE;
+
+	if (cache->oiHandle != 0)
+		rc = saImmOiDispatch(cache->oiHandle, SA_DISPATCH_ALL);
+	if (rc == SA_AIS_ERR_BAD_HANDLE)
+		objectCacheApplierFinalize(cache);
 	return rc;
 }
+
+void immutil_objectCacheFlush(ImmutilObjectCache_t *cache,
+			      const SaNameT *objectName)
+{
+	cacheFlush(cache, objectName);
+}
+
+void immutil_objectCacheGetStats(ImmutilObjectCache_t *cache,
+				 struct ImmutilObjectCacheStats *stats)
+{
+	pthread_rwlock_wrlock(&cache->lock);
+	*stats = cache->stats;
+	pthread_rwlock_unlock(&cache->lock);
+}
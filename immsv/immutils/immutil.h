@@ -55,6 +55,11 @@
  *
  * This is a collection of functions for storing the configuration operations
  * for an CCB.
+ *
+ * The functions are thread-safe; CCBs are kept in a sharded table with one
+ * lock per shard, and operations may be added to the same CCB from several
+ * threads. The operation lists may be traversed while other threads add
+ * operations, but a CCB must not be deleted while another thread is using it.
  */
 /*@{*/
 
@@ -100,7 +105,7 @@ typedef struct CcbUtilOperationData {
  * A CCB object, holds the stored operations for a CCB.
  */
 typedef struct CcbUtilCcbData {
-  struct CcbUtilCcbData *next;
+  struct CcbUtilCcbData *next;  // unused, CCBs are kept in a hash table
   SaImmOiCcbIdT ccbId;
   void *userData;
   void *memref;
@@ -137,7 +142,11 @@ EXTERN_C bool ccbutil_EmptyCcbExists();
 EXTERN_C void ccbutil_deleteCcbData(struct CcbUtilCcbData *ccb);
 
 /**
- * Add a Create operation to a CCB data object.
+ * Add a Create operation to a CCB data object. The objectName of the
+ * operation is empty. The operation is indexed for #ccbutil_getCcbOpDataByDN
+ * on the DN made from parentName and the RDN attribute, i.e. the
+ * attribute with a single value of the form "<attribute name>=...". If there
+ * is none, the operation is found once the caller has set its objectName.
  */
 EXTERN_C CcbUtilOperationData_t *ccbutil_ccbAddCreateOperation(
     struct CcbUtilCcbData *ccb, const SaImmClassNameT className,
@@ -173,15 +182,231 @@ EXTERN_C CcbUtilOperationData_t *ccbutil_getNextCcbOp(
     SaImmOiCcbIdT id, CcbUtilOperationData_t *opData);
 
 /**
- * Find a CCB operation using DN
+ * Enable or disable modify coalescing. When enabled,
+ * #ccbutil_ccbAddModifyOperation merges the modification into the previous
+ * operation on the same object if that is a modify, so apply handlers see
+ * one modify operation per object instead of one per call. The merged
+ * operation holds the net effect per attribute: a REPLACE supersedes earlier
+ * modifications, later ADD and DELETE values are applied to the REPLACE
+ * values, and otherwise the attribute gets at most one DELETE followed by one
+ * ADD. A merge gives the operation a new attrMods array, an array read
+ * before the merge stays valid until the CCB is deleted. Default is disabled.
+ * @param enable true to enable modify coalescing
+ */
+EXTERN_C void ccbutil_setModifyCoalescing(bool enable);
+
+/**
+ * Find a CCB operation using DN. The operations are indexed on DN so this is a
+ * constant time lookup, except that creates added by
+ * #ccbutil_ccbAddCreateOperation without an RDN attribute are scanned, and
+ * indexed on their objectName if the caller has set it.
  * @param id
  * @param dn
  *
- * @return CcbUtilOperationData_t*
+ * @return The first operation on the DN in the CCB or NULL if none
  */
 EXTERN_C CcbUtilOperationData_t *ccbutil_getCcbOpDataByDN(SaImmOiCcbIdT id,
                                                           const SaNameT *dn);
 
+/**
+ * Get the next operation on the same DN in the same CCB.
+ * @param opData An operation returned from #ccbutil_getCcbOpDataByDN or from
+ *               a previous call to this function
+ *
+ * @return The next operation on the DN or NULL if none
+ */
+EXTERN_C CcbUtilOperationData_t *ccbutil_getNextCcbOpByDN(
+    CcbUtilOperationData_t *opData);
+
+/**
+ * A read-only view of a packed operation, see #ccbutil_packOperation.
+ */
+typedef struct CcbUtilPackedView CcbUtilPackedView_t;
+
+/**
+ * Enable or disable capture mode. In capture mode the operations added to a
+ * CCB are stored packed (see #ccbutil_packOperation) in one contiguous buffer
+ * per operation instead of as a deep copy, and the param member of the
+ * operation refers into that buffer. The packed buffer can be retrieved with
+ * #ccbutil_getPackedOperation without encoding it again. Default is disabled.
+ * @param enable true to enable capture mode
+ */
+EXTERN_C void ccbutil_setCaptureMode(bool enable);
+
+/**
+ * Pack an operation, including all its values, into one contiguous and
+ * relocatable buffer. References inside the buffer are offsets, so the buffer
+ * can be copied, written to disk, put in shared memory or sent on a socket as
+ * is. Numbers are in host byte order.
+ * @param opData The operation
+ * @param buf [out] Buffer for the packed operation, should be 8-byte aligned
+ * @param size Size of the buffer
+ * @return The size of the packed operation, 0 on failure. If the returned size
+ *         is larger than size the buffer content is undefined.
+ */
+EXTERN_C size_t ccbutil_packOperation(const CcbUtilOperationData_t *opData,
+                                      void *buf, size_t size);
+
+/**
+ * Get the packed buffer of an operation stored in capture mode.
+ * @param opData The operation
+ * @param size [out] Size of the packed buffer
+ * @return The packed buffer, owned by the CCB, or NULL if the operation was
+ *         not stored in capture mode
+ */
+EXTERN_C const void *ccbutil_getPackedOperation(
+    const CcbUtilOperationData_t *opData, size_t *size);
+
+/**
+ * Create a view of a packed operation. The buffer is validated but not
+ * copied and must outlive the view.
+ * @param buf The packed operation, must be 8-byte aligned
+ * @param size Size of the buffer
+ * @return The view or NULL if the buffer does not hold a packed operation
+ */
+EXTERN_C CcbUtilPackedView_t *ccbutil_packedViewCreate(const void *buf,
+                                                       size_t size);
+
+/**
+ * Delete a view. All memory returned from the view is freed.
+ */
+EXTERN_C void ccbutil_packedViewDelete(CcbUtilPackedView_t *view);
+
+/**
+ * Get the size of the packed operation, packed operations can be stored back
+ * to back in a buffer.
+ */
+EXTERN_C size_t ccbutil_packedViewSize(const CcbUtilPackedView_t *view);
+
+/**
+ * Get the operation of a view. The operation is built on the first call, it
+ * refers into the packed buffer for names, strings and values whenever the
+ * representation allows it. The operation is not part of any CCB.
+ */
+EXTERN_C const CcbUtilOperationData_t *ccbutil_packedViewGetOperation(
+    CcbUtilPackedView_t *view);
+
+/**
+ * Get the attribute values of a packed create operation.
+ * @return The attribute values or NULL if not a create operation
+ */
+EXTERN_C const SaImmAttrValuesT_2 **ccbutil_packedViewGetAttrValues(
+    CcbUtilPackedView_t *view);
+
+/**
+ * Get the attribute modifications of a packed modify operation.
+ * @return The modifications or NULL if not a modify operation
+ */
+EXTERN_C const SaImmAttrModificationT_2 **ccbutil_packedViewGetAttrMods(
+    CcbUtilPackedView_t *view);
+
+/**
+ * A journal of applied CCBs, see #ccbutil_journalOpen.
+ */
+typedef struct CcbUtilJournal CcbUtilJournal_t;
+
+/**
+ * Defines the type of the function called for each operation on replay. The
+ * operation is only valid during the call.
+ */
+typedef void (*CcbUtilJournalReplayFnT)(const CcbUtilOperationData_t *opData,
+                                        void *arg);
+
+/**
+ * Open a journal, the file is created if it does not exist. The journal is an
+ * append-only, memory mapped file where each applied CCB is stored as one
+ * checksummed record of packed operations (see #ccbutil_packOperation). An
+ * incomplete or corrupt record at the end, e.g. after a crash during append,
+ * is ignored and overwritten by the next append.
+ * @param path Path of the journal file
+ * @param sync true to flush each record to disk before
+ *        #ccbutil_journalAppend returns
+ * @return The journal or NULL on failure with errno set
+ */
+EXTERN_C CcbUtilJournal_t *ccbutil_journalOpen(const char *path, bool sync);
+
+/**
+ * Close a journal.
+ */
+EXTERN_C void ccbutil_journalClose(CcbUtilJournal_t *journal);
+
+/**
+ * Append all operations of a CCB to the journal, typically from the CCB apply
+ * callback. The journal is compacted when it has grown to twice its size
+ * after the last compaction, and is at least a few MB.
+ * @param journal
+ * @param ccb
+ * @return 0 on success, -1 on failure with errno set
+ */
+EXTERN_C int ccbutil_journalAppend(CcbUtilJournal_t *journal,
+                                   const CcbUtilCcbData_t *ccb);
+
+/**
+ * Compact the journal. The operations are folded into the net operations per
+ * object; modifications are merged into the create or earlier modify of the
+ * object and a delete drops earlier operations on the object. Modifications
+ * of attributes not given in the create are kept in a modify after the
+ * create, since the object may have class defaults for them. The compacted
+ * journal is written to a new file which then replaces the old one, so a
+ * failed compaction leaves the journal intact. Creates without object name
+ * (see #ccbutil_ccbAddCreateOperation) are kept as they are.
+ * @return 0 on success, -1 on failure with errno set
+ */
+EXTERN_C int ccbutil_journalCompact(CcbUtilJournal_t *journal);
+
+/**
+ * Replay the journal by calling replayFn for each operation in the order they
+ * were appended. The journal is locked during replay, replayFn must not call
+ * the journal functions.
+ * @param journal
+ * @param replayFn
+ * @param arg Passed to replayFn
+ * @return The number of operations replayed
+ */
+EXTERN_C SaUint64T ccbutil_journalReplay(CcbUtilJournal_t *journal,
+                                         CcbUtilJournalReplayFnT replayFn,
+                                         void *arg);
+
+/**
+ * Memory statistics for a CCB object.
+ */
+typedef struct CcbUtilMemStats {
+  SaUint64T allocations;
+  /**< Number of allocations made for the CCB and its operations.  */
+  SaUint64T bytes;
+  /**< Number of bytes allocated for the CCB and its operations.  */
+  SaUint64T reserved;
+  /**< Number of bytes reserved from the system or the recycle pool.  */
+} CcbUtilMemStats_t;
+
+/**
+ * Process-wide statistics for the chunk recycle pool used by CCB objects.
+ */
+typedef struct CcbUtilMemPoolStats {
+  SaUint64T chunkMallocs;
+  /**< Number of chunks allocated with malloc.  */
+  SaUint64T chunkReuses;
+  /**< Number of chunks reused from the recycle pool.  */
+  SaUint64T chunkFrees;
+  /**< Number of chunks returned to the system.  */
+  SaUint64T pooledBytes;
+  /**< Number of bytes currently held in the recycle pool.  */
+} CcbUtilMemPoolStats_t;
+
+/**
+ * Get memory statistics for a CCB object.
+ * @param ccb The CCB object
+ * @param stats [out] The statistics
+ */
+EXTERN_C void ccbutil_getCcbMemStats(const struct CcbUtilCcbData *ccb,
+                                     struct CcbUtilMemStats *stats);
+
+/**
+ * Get statistics for the chunk recycle pool shared by all CCB objects.
+ * @param stats [out] The statistics
+ */
+EXTERN_C void ccbutil_getMemPoolStats(struct CcbUtilMemPoolStats *stats);
+
 /*@}*/
 /**
  * @defgroup ImmHelpUtils General help utilities for IMM users
@@ -203,12 +428,22 @@ EXTERN_C char *immutil_strdup(struct CcbUtilCcbData *ccb, char const *source);
 
 /**
  * Get the ClassName for an object. Common usage is to get the class
- * of the parent on a CreateOperation.
+ * of the parent on a CreateOperation. Class names are cached per DN and
+ * the accessor on immHandle is kept for the next call, see
+ * immutil_classNameCacheFlush().
  */
 EXTERN_C char const *immutil_getClassName(struct CcbUtilCcbData *ccb,
                                           SaImmHandleT immHandle,
                                           const SaNameT *objectName);
 
+/**
+ * Remove an object from the DN to class name cache used by
+ * immutil_getClassName() and immutil_get_className(). Call it when an
+ * object may have been deleted and created again with another class.
+ * @param objectName The object, or NULL for all objects
+ */
+EXTERN_C void immutil_classNameCacheFlush(const SaNameT *objectName);
+
 /**
  * Searches a distinguished name for a numeric value identified by the passed
  * key.  If the key is not found or the value is not numeric LONG_MIN is
@@ -227,7 +462,8 @@ EXTERN_C long immutil_getNumericValue(char const *key, SaNameT const *name);
  * may be terminated by a ',' character or end-of-name.
  * @param key The key. Must be appended with a '=', like "proto=".
  * @param name The distinguished name to scan.
- * @return The string value (statically allocated) or NULL in case of error.
+ * @return The string value (in a per-thread buffer valid until the next call
+ *         from the same thread) or NULL in case of error.
  */
 EXTERN_C char const *immutil_getStringValue(char const *key,
                                             SaNameT const *name);
@@ -236,10 +472,73 @@ EXTERN_C char const *immutil_getStringValue(char const *key,
  * Get the n'th item in a disinguished name as a string.
  * @param dn The disinguished name
  * @param index The index of the item, 0 is the first.
- * @return The item as a (statically allocated) string or NULL if not found.
+ * @return The item as a string (in a per-thread buffer valid until the next
+ *         call from the same thread) or NULL if not found.
  */
 EXTERN_C char const *immutil_getDnItem(SaNameT const *dn, unsigned int index);
 
+/**
+ * A part of a distinguished name. The value is not NUL terminated.
+ */
+struct ImmutilDnSlice {
+  const char *value;
+  size_t length;
+};
+
+/**
+ * An iterator over the RDNs of a distinguished name, see #immutil_dnNext.
+ */
+struct ImmutilDnIter {
+  const char *pos;
+  const char *end;
+};
+
+/**
+ * Initiate an iterator over the RDNs of a distinguished name. The name is
+ * neither copied nor modified and must outlive the iterator. Names longer
+ * than 255 bytes are supported.
+ * @param iter The iterator
+ * @param dn The distinguished name
+ */
+EXTERN_C void immutil_dnIterInit(struct ImmutilDnIter *iter, SaNameT const *dn);
+
+/**
+ * Get the next RDN. RDNs are separated by ',' characters, a ',' preceded by
+ * an odd number of '\' characters is escaped and part of the RDN.
+ * @param iter The iterator
+ * @param rdn [out] The RDN, including the key
+ * @return true if an RDN was found, false at the end of the name
+ */
+EXTERN_C bool immutil_dnNext(struct ImmutilDnIter *iter,
+                             struct ImmutilDnSlice *rdn);
+
+/**
+ * Get the n'th item in a distinguished name, as #immutil_getDnItem but
+ * without copying.
+ * @return true if found
+ */
+EXTERN_C bool immutil_dnGetItem(SaNameT const *dn, unsigned int index,
+                                struct ImmutilDnSlice *item);
+
+/**
+ * Get the value of the first RDN with the passed key, as
+ * #immutil_getStringValue but without copying. The value may be empty.
+ * @param dn The distinguished name
+ * @param key The key. Must be appended with a '=', like "proto=".
+ * @param value [out] The value
+ * @return true if found
+ */
+EXTERN_C bool immutil_dnGetValue(SaNameT const *dn, char const *key,
+                                 struct ImmutilDnSlice *value);
+
+/**
+ * Split an RDN in key and value at the first '='.
+ * @return true if the RDN contains a '='
+ */
+EXTERN_C bool immutil_rdnSplit(struct ImmutilDnSlice const *rdn,
+                               struct ImmutilDnSlice *key,
+                               struct ImmutilDnSlice *value);
+
 /**
  * Scans the attributes for an an attribute identified by the passed name. If
  * the attribute is found the value with the passed index is returned.
@@ -317,6 +616,74 @@ EXTERN_C SaAisErrorT immutil_getAttr(const char *attrName,
                                      const SaImmAttrValuesT_2 **attr,
                                      SaUint32T index, void *param);
 
+/**
+ * An index of an attribute vector on attribute name, see
+ * #immutil_attrIndexCreate.
+ */
+typedef struct ImmutilAttrIndex ImmutilAttrIndex_t;
+
+/**
+ * Create an index of an attribute vector. The immutil_attrIndexGet functions
+ * find an attribute in constant time, while the functions above scan the
+ * vector on each call. Build an index when many attributes of a vector are
+ * read. The vector is not copied and must outlive the index. If an attribute
+ * occurs more than once the first one is found, as with the functions above.
+ * @param attr The attribute vector, may be NULL
+ * @return The index
+ */
+EXTERN_C ImmutilAttrIndex_t *immutil_attrIndexCreate(
+    const SaImmAttrValuesT_2 **attr);
+
+/**
+ * Delete an attribute index.
+ */
+EXTERN_C void immutil_attrIndexDelete(ImmutilAttrIndex_t *index);
+
+/**
+ * Find an attribute in an index.
+ * @return The attribute or NULL if not found
+ */
+EXTERN_C const SaImmAttrValuesT_2 *immutil_attrIndexFind(
+    const ImmutilAttrIndex_t *index, char const *name);
+
+/**
+ * As #immutil_getNameAttr but using an index.
+ */
+EXTERN_C const SaNameT *immutil_attrIndexGetName(
+    const ImmutilAttrIndex_t *index, char const *name, unsigned int i);
+
+/**
+ * As #immutil_getStringAttr but using an index.
+ */
+EXTERN_C char const *immutil_attrIndexGetString(
+    const ImmutilAttrIndex_t *index, char const *name, unsigned int i);
+
+/**
+ * As #immutil_getTimeAttr but using an index.
+ */
+EXTERN_C const SaTimeT *immutil_attrIndexGetTime(
+    const ImmutilAttrIndex_t *index, char const *name, unsigned int i);
+
+/**
+ * As #immutil_getUint32Attr but using an index.
+ */
+EXTERN_C const SaUint32T *immutil_attrIndexGetUint32(
+    const ImmutilAttrIndex_t *index, char const *name, unsigned int i);
+
+/**
+ * As #immutil_getAttrValuesNumber but using an index.
+ */
+EXTERN_C SaAisErrorT immutil_attrIndexGetValuesNumber(
+    const ImmutilAttrIndex_t *index, const char *attrName,
+    SaUint32T *attrValuesNumber);
+
+/**
+ * As #immutil_getAttr but using an index.
+ */
+EXTERN_C SaAisErrorT immutil_attrIndexGetAttr(const ImmutilAttrIndex_t *index,
+                                              const char *attrName,
+                                              SaUint32T i, void *param);
+
 /**
  * Works as "strchr()" but with a length limit. It is provided here since
  * "strnchr()" is not standard, and is useful when scanning SaNameT.
@@ -341,6 +708,58 @@ EXTERN_C char const *immutil_strnchr(char const *str, int c, size_t length);
  */
 EXTERN_C int immutil_matchName(SaNameT const *name, regex_t const *preg);
 
+/**
+ * A compiled DN pattern, see #immutil_dnPatternCompile.
+ */
+typedef struct ImmutilDnPattern ImmutilDnPattern_t;
+
+/**
+ * Compile a DN pattern. A DN pattern is matched RDN by RDN and is much faster
+ * than a regular expression with #immutil_matchName. The pattern is a DN
+ * where:
+ *  - an RDN without '*' matches that RDN exactly,
+ *  - one '*' in an RDN matches any characters within the RDN, so "safSu=*"
+ *    matches any safSu RDN, "safSu=SU*" is a prefix, "*=x" a suffix, and
+ *    "*" any RDN on that level,
+ *  - a leading "**" RDN matches zero or more RDNs, making the pattern match
+ *    a subtree.
+ * Example (error checks omitted);
+ * \code
+ *    ImmutilDnPattern_t *p = immutil_dnPatternCompile("**,safSg=*,safApp=X");
+ *    if (immutil_dnPatternMatch(p, name)) {
+ *       ...
+ *    }
+ *    immutil_dnPatternDelete(p);
+ * \endcode
+ * @param pattern The pattern
+ * @return The compiled pattern or NULL if the pattern is invalid
+ */
+EXTERN_C ImmutilDnPattern_t *immutil_dnPatternCompile(const char *pattern);
+
+/**
+ * Delete a compiled DN pattern.
+ */
+EXTERN_C void immutil_dnPatternDelete(ImmutilDnPattern_t *pattern);
+
+/**
+ * Match a name against a compiled DN pattern.
+ * @return true if the name matches
+ */
+EXTERN_C bool immutil_dnPatternMatch(const ImmutilDnPattern_t *pattern,
+                                     SaNameT const *name);
+
+/**
+ * Match an array of names against a compiled DN pattern.
+ * @param pattern The compiled pattern
+ * @param names The names
+ * @param n Number of names
+ * @param matches [out] Set to the result per name, may be NULL
+ * @return The number of matching names
+ */
+EXTERN_C size_t immutil_dnPatternMatchBulk(const ImmutilDnPattern_t *pattern,
+                                           SaNameT const *names, size_t n,
+                                           bool *matches);
+
 /**
  * Update one runtime attribute of the specified object.
  *
@@ -360,16 +779,93 @@ EXTERN_C SaAisErrorT immutil_update_one_rattr(SaImmOiHandleT immOiHandle,
                                               void *value);
 
 /**
- * Get class name from object name.
+ * An accumulator of runtime attribute updates, see #immutil_rtUpdaterCreate.
+ */
+typedef struct ImmutilRtUpdater ImmutilRtUpdater_t;
+
+/**
+ * Statistics of a runtime attribute update accumulator.
+ */
+struct ImmutilRtUpdaterStats {
+  SaUint64T updates; /**< Attribute updates added */
+  SaUint64T merged;  /**< Updates merged into a pending update */
+  SaUint64T calls;   /**< saImmOiRtObjectUpdate_2 calls made */
+  SaUint64T errors;  /**< Calls that failed */
+  SaUint64T saved;   /**< Calls saved compared to immutil_update_one_rattr */
+};
+
+/**
+ * Create an accumulator of runtime attribute updates. Updates are collected
+ * per object, an update of an attribute that is already pending replaces the
+ * pending value, and each object is updated with one
+ * saImmOiRtObjectUpdate_2 call on flush.
+ *
+ * The pending updates are flushed when maxPending attributes are pending, when
+ * the oldest pending update is older than maxAge, or on request. The age is
+ * checked when updates are added and by #immutil_rtUpdaterPoll.
+ *
+ * @param immOiHandle
+ * @param maxPending Max number of pending attributes, 0 for no limit
+ * @param maxAge Max age in nanoseconds of the oldest pending update, 0 for no
+ *        limit
+ * @return The accumulator
+ */
+EXTERN_C ImmutilRtUpdater_t *immutil_rtUpdaterCreate(SaImmOiHandleT immOiHandle,
+                                                     size_t maxPending,
+                                                     SaTimeT maxAge);
+
+/**
+ * Delete an accumulator. Pending updates are discarded.
+ */
+EXTERN_C void immutil_rtUpdaterDelete(ImmutilRtUpdater_t *updater);
+
+/**
+ * Add an update of one runtime attribute, the arguments are as for
+ * #immutil_update_one_rattr. The value is copied.
+ *
+ * @return SA_AIS_OK, or the result of the flush if one was triggered
+ */
+EXTERN_C SaAisErrorT immutil_rtUpdaterAdd(ImmutilRtUpdater_t *updater,
+                                          const char *dn,
+                                          SaImmAttrNameT attributeName,
+                                          SaImmValueTypeT attrValueType,
+                                          void *value);
+
+/**
+ * Flush the pending updates if the oldest is older than maxAge. Call
+ * periodically if updates are not added continuously.
+ *
+ * @return SA_AIS_OK, or the result of the flush if one was done
+ */
+EXTERN_C SaAisErrorT immutil_rtUpdaterPoll(ImmutilRtUpdater_t *updater);
+
+/**
+ * Flush the pending updates. Updates of objects that fail are dropped.
+ *
+ * @return SA_AIS_OK or the first error
+ */
+EXTERN_C SaAisErrorT immutil_rtUpdaterFlush(ImmutilRtUpdater_t *updater);
+
+/**
+ * Get the statistics of an accumulator.
+ */
+EXTERN_C void immutil_rtUpdaterGetStats(ImmutilRtUpdater_t *updater,
+                                        struct ImmutilRtUpdaterStats *stats);
+
+/**
+ * Get class name from object name. The caller must free the memory returned.
+ * The OM handle and accessor are taken from a process wide pool that is set
+ * up again after SA_AIS_ERR_BAD_HANDLE, and class names are cached, see
+ * immutil_getClassName().
  * @param objectName
  *
- * @return SaImmClassNameT
+ * @return SaImmClassNameT, NULL if the object does not exist
  */
 EXTERN_C SaImmClassNameT immutil_get_className(const SaNameT *objectName);
 
 /**
- * Get value type of named attribute for an object. The caller must free the
- * memory returned.
+ * Get value type of named attribute for an object. The class description is
+ * read from the schema cache, see immutil_get_attrDefinition().
  *
  * @param objectName
  * @param attrName
@@ -381,6 +877,33 @@ EXTERN_C SaAisErrorT immutil_get_attrValueType(const SaImmClassNameT className,
                                                SaImmAttrNameT attrName,
                                                SaImmValueTypeT *attrValueType);
 
+/**
+ * Get value type and flags of named attribute in a class. Class descriptions
+ * are fetched from IMM on the first lookup and kept in a process wide cache.
+ * The cache is not updated when a class is changed in IMM, call
+ * immutil_schemaCacheFlush() for that, for instance from an applier.
+ * Thread safe.
+ *
+ * @param className
+ * @param attrName
+ * @param attrValueType May be NULL
+ * @param attrFlags May be NULL
+ *
+ * @return SA_AIS_OK, SA_AIS_ERR_INVALID_PARAM if the attribute is not in
+ *   the class or the error from reading the class description
+ */
+EXTERN_C SaAisErrorT immutil_get_attrDefinition(const SaImmClassNameT className,
+                                                SaImmAttrNameT attrName,
+                                                SaImmValueTypeT *attrValueType,
+                                                SaImmAttrFlagsT *attrFlags);
+
+/**
+ * Remove a class from the schema cache, it is read again from IMM at the
+ * next lookup.
+ * @param className The class, or NULL for all classes
+ */
+EXTERN_C void immutil_schemaCacheFlush(const SaImmClassNameT className);
+
 /**
  * Create attribute value from type and string. The caller must free the memory
  * returned.
@@ -392,6 +915,42 @@ EXTERN_C SaAisErrorT immutil_get_attrValueType(const SaImmClassNameT className,
 EXTERN_C void *immutil_new_attrValue(SaImmValueTypeT attrValueType,
                                      const char *str);
 
+/**
+ * Parse an array of strings to values of one type, the bulk version of
+ * immutil_new_attrValue(). The value pointers, the values and any string,
+ * long name and SaAnyT data are stored in the passed buffer. The result
+ * can be used as attrValues in a SaImmAttrValuesT_2. Integers are parsed as
+ * strtol() with base 0, SA_IMM_ATTR_SAANYT values as hex digits.
+ * @param attrValueType The type of all values
+ * @param strs The strings to parse
+ * @param n Number of strings
+ * @param buf The buffer, may be NULL if size is 0
+ * @param size Size of the buffer
+ * @param errors If not NULL, errors[i] is set to 0, EINVAL or ERANGE for
+ *   strs[i] and the value pointer of a failed value is set to NULL
+ * @return The needed size. Nothing is written if it is larger than
+ *   size. 0 if attrValueType is invalid, or if a value fails and
+ *   errors is NULL.
+ */
+EXTERN_C size_t immutil_parse_attrValues(SaImmValueTypeT attrValueType,
+                                         const char *const *strs, size_t n,
+                                         void *buf, size_t size, int *errors);
+
+/**
+ * Parse an array of strings to values of one type in one allocation, see
+ * immutil_parse_attrValues(). The caller must free the returned array with
+ * one free().
+ * @param attrValueType The type of all values
+ * @param strs The strings to parse
+ * @param n Number of strings
+ * @param errors If not NULL, set per value as for immutil_parse_attrValues()
+ * @return The value pointers, NULL if attrValueType is invalid or if a value
+ *   fails and errors is NULL
+ */
+EXTERN_C SaImmAttrValueT *immutil_new_attrValues(SaImmValueTypeT attrValueType,
+                                                 const char *const *strs,
+                                                 size_t n, int *errors);
+
 /*@}*/
 
 /**
@@ -409,11 +968,351 @@ struct ImmutilWrapperProfile {
   int errorsAreFatal;
   /**< If set the calling program is aborted on an error return from SAF.  */
   unsigned int nTries;
-  /**< Number of tries before we give up.  */
+  /**< Number of tries before we give up. Retries stop after
+       (nTries - 1) * retryInterval milli-seconds, unless the retry profile
+       sets a timeout. If that is 0, nTries tries are made without delay.  */
   unsigned int retryInterval;
-  /**< Interval in milli-seconds between tries.  */
+  /**< Max interval in milli-seconds between tries, unless the retry profile
+       sets one.  */
 };
 
+/**
+ * Retry profile categories. Each wrapper retries SA_AIS_ERR_TRY_AGAIN with
+ * the profile of its category.
+ */
+enum ImmutilRetryCategory {
+  IMMUTIL_RETRY_DEFAULT, /**< Handles, implementers, admin owners etc.  */
+  IMMUTIL_RETRY_READ,    /**< Accessor gets, searches, class descriptions  */
+  IMMUTIL_RETRY_CCB,     /**< CCB initialize, operations, apply etc.  */
+  IMMUTIL_RETRY_CATEGORIES
+};
+
+/**
+ * Retry profile. The delay before each retry is random, between
+ * initialDelay and three times the previous delay, and at most maxDelay
+ * (exponential backoff with decorrelated jitter). A field set to 0 is taken
+ * from immutilWrapperProfile, so that the legacy settings still apply.
+ * Defaults: DEFAULT {10, 0, 0}, READ {1, 50, 0}, CCB {20, 0, 0}.
+ */
+struct ImmutilRetryProfile {
+  unsigned int initialDelay;
+  /**< Delay in milli-seconds before the first retry, 0 for retryInterval  */
+  unsigned int maxDelay;
+  /**< Max delay in milli-seconds, 0 for retryInterval  */
+  unsigned int timeout;
+  /**< No retries later than this many milli-seconds after the first
+       SA_AIS_ERR_TRY_AGAIN, 0 for (nTries - 1) * retryInterval  */
+};
+
+/**
+ * State of a retry loop, the fields are private.
+ */
+struct ImmutilRetry {
+  enum ImmutilRetryCategory category;
+  int operation;      /**< enum ImmutilOperation, -1 if none  */
+  unsigned int tries; /**< Number of tries so far  */
+  bool probe;         /**< The try is a circuit breaker probe  */
+  SaTimeT start;
+  SaTimeT slept;      /**< Nanoseconds slept so far  */
+  SaTimeT deadline;
+  unsigned int maxTries; /**< Try limit if retryInterval is 0, else 0  */
+  SaTimeT base;
+  SaTimeT cap;
+  SaTimeT delay;
+  SaUint64T seed;
+};
+
+/**
+ * Install the retry profile for a category. Thread safe, it applies to
+ * retry loops started after the call.
+ */
+EXTERN_C void immutil_setRetryProfile(
+    enum ImmutilRetryCategory category,
+    const struct ImmutilRetryProfile *profile);
+
+/**
+ * Get the retry profile for a category.
+ */
+EXTERN_C void immutil_getRetryProfile(enum ImmutilRetryCategory category,
+                                      struct ImmutilRetryProfile *profile);
+
+/**
+ * Circuit breaker modes, see struct ImmutilBreakerConfig.
+ */
+enum ImmutilBreakerMode {
+  IMMUTIL_BREAKER_OFF,       /**< No breaker, the default  */
+  IMMUTIL_BREAKER_FAIL_FAST, /**< Calls fail at once while open  */
+  IMMUTIL_BREAKER_QUEUE      /**< Calls wait while open  */
+};
+
+/**
+ * Circuit breaker for sustained IMM unavailability, e.g. during sync or a
+ * controller failover. After threshold tries in a row, in any thread, have
+ * returned SA_AIS_ERR_TRY_AGAIN or SA_AIS_ERR_TIMEOUT the breaker opens.
+ * While it is open the wrappers do not call IMM; with FAIL_FAST they return
+ * SA_AIS_ERR_TRY_AGAIN at once, with QUEUE they wait, at most until their
+ * retry deadline, and then return SA_AIS_ERR_TRY_AGAIN. Every probeInterval
+ * one call is let through as a probe. When a probe returns SA_AIS_OK the
+ * breaker closes, and waiting calls are released at random times within
+ * releaseSpread so that they do not all hit IMM at once; a probe with any
+ * other result opens it again. The async calls are not affected.
+ */
+struct ImmutilBreakerConfig {
+  enum ImmutilBreakerMode mode;
+  unsigned int threshold;     /**< Failed tries in a row that open it  */
+  unsigned int probeInterval; /**< Milli-seconds between probes  */
+  unsigned int releaseSpread; /**< Milli-seconds to release waiters over  */
+};
+
+/**
+ * Circuit breaker status.
+ */
+enum ImmutilBreakerStatus {
+  IMMUTIL_BREAKER_CLOSED,   /**< Calls are made as usual  */
+  IMMUTIL_BREAKER_OPEN,     /**< Calls fail fast or wait  */
+  IMMUTIL_BREAKER_HALF_OPEN /**< A probe is being made  */
+};
+
+/**
+ * Circuit breaker state, see immutil_getBreakerState().
+ */
+struct ImmutilBreakerState {
+  enum ImmutilBreakerStatus status;
+  unsigned int consecutiveFailures; /**< Failed tries in a row  */
+  unsigned int waiting;             /**< Calls waiting now  */
+  SaTimeT openedAt; /**< CLOCK_MONOTONIC time it last opened or probed  */
+  SaUint64T opened;   /**< Times it has opened  */
+  SaUint64T probes;   /**< Probes made  */
+  SaUint64T rejected; /**< Calls that failed fast  */
+  SaUint64T queued;   /**< Calls that waited  */
+};
+
+/**
+ * Configure the circuit breaker. The default is
+ * {IMMUTIL_BREAKER_OFF, 20, 1000, 200}.
+ */
+EXTERN_C void immutil_setBreakerConfig(
+    const struct ImmutilBreakerConfig *config);
+
+/**
+ * Get the circuit breaker configuration.
+ */
+EXTERN_C void immutil_getBreakerConfig(struct ImmutilBreakerConfig *config);
+
+/**
+ * Get the circuit breaker state.
+ */
+EXTERN_C void immutil_getBreakerState(struct ImmutilBreakerState *state);
+
+/**
+ * Start a retry loop. It is used by the wrappers and can be used for IMM
+ * calls that have no wrapper:
+ *
+ *   struct ImmutilRetry retry;
+ *   immutil_retryStart(&retry, IMMUTIL_RETRY_READ);
+ *   do {
+ *     rc = saImmOmSearchNext_2(...);
+ *   } while (immutil_retry(&retry, rc));
+ */
+EXTERN_C void immutil_retryStart(struct ImmutilRetry *retry,
+                                 enum ImmutilRetryCategory category);
+
+/**
+ * Sleep before a retry if rc is SA_AIS_ERR_TRY_AGAIN and the deadline is
+ * not passed.
+ * @return true if the call shall be made again
+ */
+EXTERN_C bool immutil_retry(struct ImmutilRetry *retry, SaAisErrorT rc);
+
+/**
+ * The wrapped IMM functions, for telemetry and per operation settings.
+ * IMMUTIL_OP_OM_CCB_APPLY is immutil_saImmOmCcbApply() and so on. The _o2
+ * variants that call another wrapper have no operation of their own.
+ */
+enum ImmutilOperation {
+  IMMUTIL_OP_OI_INITIALIZE_2,
+  IMMUTIL_OP_OI_INITIALIZE_O3,
+  IMMUTIL_OP_OI_SELECTION_OBJECT_GET,
+  IMMUTIL_OP_OI_CLASS_IMPLEMENTER_SET,
+  IMMUTIL_OP_OI_CLASS_IMPLEMENTER_RELEASE,
+  IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_SET,
+  IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_SET_O3,
+  IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_RELEASE,
+  IMMUTIL_OP_OI_OBJECT_IMPLEMENTER_RELEASE_O3,
+  IMMUTIL_OP_OI_IMPLEMENTER_SET,
+  IMMUTIL_OP_OI_IMPLEMENTER_CLEAR,
+  IMMUTIL_OP_OI_RT_OBJECT_CREATE_2,
+  IMMUTIL_OP_OI_RT_OBJECT_CREATE_O3,
+  IMMUTIL_OP_OI_RT_OBJECT_DELETE,
+  IMMUTIL_OP_OI_RT_OBJECT_DELETE_O3,
+  IMMUTIL_OP_OI_RT_OBJECT_UPDATE_2,
+  IMMUTIL_OP_OI_RT_OBJECT_UPDATE_O3,
+  IMMUTIL_OP_OI_ADMIN_OPERATION_RESULT,
+  IMMUTIL_OP_OI_ADMIN_OPERATION_RESULT_O2,
+  IMMUTIL_OP_OI_AUGMENT_CCB_INITIALIZE,
+  IMMUTIL_OP_OM_INITIALIZE,
+  IMMUTIL_OP_OM_INITIALIZE_O2,
+  IMMUTIL_OP_OM_SELECTION_OBJECT_GET,
+  IMMUTIL_OP_OM_FINALIZE,
+  IMMUTIL_OP_OM_ACCESSOR_INITIALIZE,
+  IMMUTIL_OP_OM_ACCESSOR_GET_2,
+  IMMUTIL_OP_OM_ACCESSOR_GET_O3,
+  IMMUTIL_OP_OM_ACCESSOR_GET_CONFIG_ATTRS,
+  IMMUTIL_OP_OM_ACCESSOR_FINALIZE,
+  IMMUTIL_OP_OM_SEARCH_INITIALIZE_2,
+  IMMUTIL_OP_OM_SEARCH_INITIALIZE_O3,
+  IMMUTIL_OP_OM_SEARCH_FINALIZE,
+  IMMUTIL_OP_OM_SEARCH_NEXT_2,
+  IMMUTIL_OP_OM_SEARCH_NEXT_O3,
+  IMMUTIL_OP_OM_ADMIN_OWNER_CLEAR,
+  IMMUTIL_OP_OM_ADMIN_OWNER_CLEAR_O3,
+  IMMUTIL_OP_OM_CLASS_CREATE_2,
+  IMMUTIL_OP_OM_CLASS_DELETE,
+  IMMUTIL_OP_OI_FINALIZE,
+  IMMUTIL_OP_OM_ADMIN_OWNER_INITIALIZE,
+  IMMUTIL_OP_OM_ADMIN_OWNER_FINALIZE,
+  IMMUTIL_OP_OM_CCB_INITIALIZE,
+  IMMUTIL_OP_OM_CCB_FINALIZE,
+  IMMUTIL_OP_OM_CCB_APPLY,
+  IMMUTIL_OP_OM_CCB_ABORT,
+  IMMUTIL_OP_OM_CCB_VALIDATE,
+  IMMUTIL_OP_OM_ADMIN_OWNER_SET,
+  IMMUTIL_OP_OM_ADMIN_OWNER_SET_O3,
+  IMMUTIL_OP_OM_ADMIN_OWNER_RELEASE,
+  IMMUTIL_OP_OM_ADMIN_OWNER_RELEASE_O3,
+  IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_O2,
+  IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_2,
+  IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_O3,
+  IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_ASYNC_2,
+  IMMUTIL_OP_OM_ADMIN_OPERATION_INVOKE_ASYNC_O3,
+  IMMUTIL_OP_OM_CCB_OBJECT_CREATE_2,
+  IMMUTIL_OP_OM_CCB_OBJECT_CREATE_O3,
+  IMMUTIL_OP_OM_CCB_OBJECT_MODIFY_2,
+  IMMUTIL_OP_OM_CCB_OBJECT_MODIFY_O3,
+  IMMUTIL_OP_OM_CCB_OBJECT_DELETE,
+  IMMUTIL_OP_OM_CCB_OBJECT_DELETE_O3,
+  IMMUTIL_OP_OM_CCB_OBJECT_READ,
+  IMMUTIL_OP_OM_CLASS_DESCRIPTION_GET_2,
+  IMMUTIL_OP_OM_CLASS_DESCRIPTION_MEMORY_FREE_2,
+  IMMUTIL_OP_COUNT
+};
+
+/**
+ * Get the name of the IMM function of an operation, e.g.
+ * "saImmOmCcbApply".
+ * @return The name, NULL if operation is out of range
+ */
+EXTERN_C const char *immutil_operationName(enum ImmutilOperation operation);
+
+/**
+ * Install a retry profile for one operation, overriding the profile of its
+ * category. A field set to 0 is taken from the category profile, so a
+ * zeroed profile (or NULL) removes the override. Thread safe, it applies to
+ * retry loops started after the call, including the async calls.
+ */
+EXTERN_C void immutil_setOperationRetryProfile(
+    enum ImmutilOperation operation,
+    const struct ImmutilRetryProfile *profile);
+
+/**
+ * Get the retry profile installed for an operation, zeroed if none.
+ */
+EXTERN_C void immutil_getOperationRetryProfile(
+    enum ImmutilOperation operation, struct ImmutilRetryProfile *profile);
+
+/**
+ * Install a retry profile for one operation in the calling thread only,
+ * e.g. short timeouts for the reads of a health check thread. It overrides
+ * the operation and category profiles the same way, NULL removes it. The
+ * async calls use the profiles of the thread that calls
+ * immutil_asyncDispatch().
+ */
+EXTERN_C void immutil_setThreadRetryProfile(
+    enum ImmutilOperation operation,
+    const struct ImmutilRetryProfile *profile);
+
+/**
+ * Get the retry profile the wrapper of an operation uses in the calling
+ * thread; the thread, operation and category profiles merged. Fields still
+ * 0 are taken from immutilWrapperProfile.
+ */
+EXTERN_C void immutil_getEffectiveRetryProfile(
+    enum ImmutilOperation operation, struct ImmutilRetryProfile *profile);
+
+#define IMMUTIL_TELEMETRY_ATTEMPT_BUCKETS 8
+#define IMMUTIL_TELEMETRY_LATENCY_BUCKETS 24
+
+/**
+ * Telemetry of one wrapped operation, see immutil_telemetrySnapshot().
+ */
+struct ImmutilCallStats {
+  SaUint64T calls;      /**< Calls of the wrapper */
+  SaUint64T errors;     /**< Calls that did not return SA_AIS_OK */
+  SaUint64T retrySleep; /**< Nanoseconds slept between tries */
+  SaUint64T attempts[IMMUTIL_TELEMETRY_ATTEMPT_BUCKETS];
+  /**< Calls by number of tries: 1, 2, 3-4, 5-8, ..., 65 or more */
+  SaUint64T latency[IMMUTIL_TELEMETRY_LATENCY_BUCKETS];
+  /**< Calls by time from start to return: below 1 us, 1-2 us, 2-4 us,
+       ..., 2^22 us (4.2 s) or more */
+};
+
+/**
+ * Turn the recording of wrapper telemetry on or off, it is off by default.
+ * Recording costs two clock reads per call and is done in counters of the
+ * calling thread, without locks. Calls are only counted while it is on.
+ */
+EXTERN_C void immutil_telemetryEnable(bool enable);
+
+/**
+ * Get the telemetry of all threads, summed per operation.
+ * @param stats Array of IMMUTIL_OP_COUNT elements, indexed by
+ *   enum ImmutilOperation
+ */
+EXTERN_C void immutil_telemetrySnapshot(struct ImmutilCallStats *stats);
+
+#define IMMUTIL_TELEMETRY_SHM_MAGIC 0x494d4d54
+#define IMMUTIL_OPERATION_NAME_SIZE 48
+
+/**
+ * Layout of the telemetry shared memory segment. A reader copies the stats
+ * and retries if sequence was odd or changed during the copy.
+ */
+struct ImmutilTelemetryShm {
+  SaUint32T magic;       /**< IMMUTIL_TELEMETRY_SHM_MAGIC when set up */
+  SaUint32T nOperations; /**< IMMUTIL_OP_COUNT */
+  SaUint64T sequence;    /**< Odd while the stats are written */
+  SaTimeT updated;       /**< CLOCK_MONOTONIC time of the last update */
+  char names[IMMUTIL_OP_COUNT][IMMUTIL_OPERATION_NAME_SIZE];
+  struct ImmutilCallStats stats[IMMUTIL_OP_COUNT];
+};
+
+/**
+ * Publish the telemetry in a POSIX shared memory segment, so that an
+ * external tool can read it from the running process. The segment is
+ * updated by immutil_telemetryShmPublish() and, if interval is not 0, by a
+ * wrapper call that returns when the last update is older than interval.
+ * Recording must be turned on with immutil_telemetryEnable(). Link with -lrt
+ * on older C libraries.
+ * @param name Name for shm_open(), e.g. "/immutil.<pid>"
+ * @param interval Min nanoseconds between automatic updates, 0 for none
+ * @return SA_AIS_OK, SA_AIS_ERR_EXIST if already open or
+ *   SA_AIS_ERR_LIBRARY if the segment could not be set up
+ */
+EXTERN_C SaAisErrorT immutil_telemetryShmOpen(const char *name,
+                                              SaTimeT interval);
+
+/**
+ * Update the telemetry shared memory segment.
+ * @return SA_AIS_OK or SA_AIS_ERR_NOT_EXIST if it is not open
+ */
+EXTERN_C SaAisErrorT immutil_telemetryShmPublish(void);
+
+/**
+ * Stop updating the telemetry shared memory segment and unmap it. The
+ * segment is not unlinked, readers may still use it.
+ */
+EXTERN_C void immutil_telemetryShmClose(void);
+
 /**
  * Default: errorsAreFatal=1, nTries=5, retryInterval=400.
  */
@@ -787,6 +1686,506 @@ EXTERN_C SaAisErrorT immutil_saImmOmClassDescriptionGet_2(
 EXTERN_C SaAisErrorT immutil_saImmOmClassDescriptionMemoryFree_2(
     SaImmHandleT immHandle, SaImmAttrDefinitionT_2 **attrDef);
 
+/**
+ * An executor of asynchronous IMM calls, see #immutil_asyncCreate.
+ */
+typedef struct ImmutilAsync ImmutilAsync_t;
+
+/**
+ * Result of an asynchronous call, passed to the completion callback.
+ */
+struct ImmutilAsyncResult {
+  SaAisErrorT rc;     /**< Result of the last try */
+  unsigned int tries; /**< Number of tries */
+  SaImmAttrValuesT_2 **attributes;
+  /**< Accessor get: the attributes, valid until the next call on the
+       accessor handle */
+  SaAisErrorT operationReturnValue;
+  /**< Admin operation invoke: the result of the operation */
+};
+
+/**
+ * Completion callback of an asynchronous call, called from
+ * immutil_asyncDispatch().
+ */
+typedef void (*ImmutilAsyncCallbackT)(const struct ImmutilAsyncResult *result,
+                                      void *arg);
+
+/**
+ * Create an executor of asynchronous IMM calls. The immutil_async*
+ * functions queue a call and return at once, the arguments are copied. The
+ * calls are made from immutil_asyncDispatch(). A call that gets
+ * SA_AIS_ERR_TRY_AGAIN is queued again on a timer wheel with the delay and
+ * deadline of the retry engine, without blocking. When a call is done its
+ * callback is called with the result. The errorsAreFatal setting does not
+ * apply, errors are passed to the callback.
+ *
+ * Poll the selection object together with the IMM selection objects and
+ * call immutil_asyncDispatch() when it is readable:
+ *
+ *   immutil_asyncSelectionObjectGet(async, &asyncFd);
+ *   ...
+ *   if (fds[ASYNC_FD].revents & POLLIN)
+ *     immutil_asyncDispatch(async);
+ *   if (fds[IMM_FD].revents & POLLIN)
+ *     saImmOiDispatch(immOiHandle, SA_DISPATCH_ALL);
+ *
+ * Calls on the same handle are made in the order they were queued, calls on
+ * different handles independently. Calls can be queued from any thread.
+ */
+EXTERN_C ImmutilAsync_t *immutil_asyncCreate(void);
+
+/**
+ * Delete an executor. Queued calls are dropped without callbacks. Not to be
+ * called concurrently with other calls on the executor.
+ */
+EXTERN_C void immutil_asyncDelete(ImmutilAsync_t *async);
+
+/**
+ * Get the selection object of an executor, it is readable when queued calls
+ * are due.
+ */
+EXTERN_C SaAisErrorT immutil_asyncSelectionObjectGet(
+    ImmutilAsync_t *async, SaSelectionObjectT *selectionObject);
+
+/**
+ * Make the calls that are due and call the callbacks of the calls that are
+ * done. Never blocks on SA_AIS_ERR_TRY_AGAIN.
+ */
+EXTERN_C SaAisErrorT immutil_asyncDispatch(ImmutilAsync_t *async);
+
+/**
+ * Get the number of queued calls.
+ */
+EXTERN_C unsigned int immutil_asyncPending(ImmutilAsync_t *async);
+
+/**
+ * Asynchronous saImmOmCcbObjectCreate_2
+ */
+EXTERN_C SaAisErrorT immutil_asyncCcbObjectCreate_2(
+    ImmutilAsync_t *async, SaImmCcbHandleT immCcbHandle,
+    const SaImmClassNameT className, const SaNameT *parent,
+    const SaImmAttrValuesT_2 **attrValues, ImmutilAsyncCallbackT callback,
+    void *arg);
+
+/**
+ * Asynchronous saImmOmCcbObjectModify_2
+ */
+EXTERN_C SaAisErrorT immutil_asyncCcbObjectModify_2(
+    ImmutilAsync_t *async, SaImmCcbHandleT immCcbHandle,
+    const SaNameT *objectName, const SaImmAttrModificationT_2 **attrMods,
+    ImmutilAsyncCallbackT callback, void *arg);
+
+/**
+ * Asynchronous saImmOmCcbObjectDelete
+ */
+EXTERN_C SaAisErrorT immutil_asyncCcbObjectDelete(
+    ImmutilAsync_t *async, SaImmCcbHandleT immCcbHandle,
+    const SaNameT *objectName, ImmutilAsyncCallbackT callback, void *arg);
+
+/**
+ * Asynchronous saImmOmCcbApply. It is made after the operations queued
+ * before it on the same CCB.
+ */
+EXTERN_C SaAisErrorT immutil_asyncCcbApply(ImmutilAsync_t *async,
+                                           SaImmCcbHandleT immCcbHandle,
+                                           ImmutilAsyncCallbackT callback,
+                                           void *arg);
+
+/**
+ * Asynchronous saImmOmAccessorGet_2
+ */
+EXTERN_C SaAisErrorT immutil_asyncAccessorGet_2(
+    ImmutilAsync_t *async, SaImmAccessorHandleT accessorHandle,
+    const SaNameT *objectName, const SaImmAttrNameT *attributeNames,
+    ImmutilAsyncCallbackT callback, void *arg);
+
+/**
+ * Asynchronous saImmOiRtObjectUpdate_2
+ */
+EXTERN_C SaAisErrorT immutil_asyncRtObjectUpdate_2(
+    ImmutilAsync_t *async, SaImmOiHandleT immOiHandle,
+    const SaNameT *objectName, const SaImmAttrModificationT_2 **attrMods,
+    ImmutilAsyncCallbackT callback, void *arg);
+
+/**
+ * Asynchronous saImmOmAdminOperationInvoke_2
+ */
+EXTERN_C SaAisErrorT immutil_asyncAdminOperationInvoke_2(
+    ImmutilAsync_t *async, SaImmAdminOwnerHandleT ownerHandle,
+    const SaNameT *objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params, SaTimeT timeout,
+    ImmutilAsyncCallbackT callback, void *arg);
+
+/**
+ * A batched search iterator, see #immutil_searchIterCreate.
+ */
+typedef struct ImmutilSearchIter ImmutilSearchIter_t;
+
+/**
+ * An object found by a search iterator.
+ */
+struct ImmutilSearchRecord {
+  const SaNameT *objectName;
+  const SaImmAttrValuesT_2 **attributes; /**< NULL terminated  */
+};
+
+/**
+ * A batch of objects found by a search iterator. All memory of a batch is
+ * in one arena that is freed in one step by the next
+ * #immutil_searchIterNext, or by #immutil_searchIterDelete.
+ */
+struct ImmutilSearchBatch {
+  size_t n; /**< Number of records, at least 1  */
+  const struct ImmutilSearchRecord *records;
+};
+
+/**
+ * Start a search that is read in batches. A thread calls
+ * immutil_saImmOmSearchNext_2 in the background and keeps up to prefetch
+ * objects ready while the caller works on the current batch, so that the
+ * round-trips to IMM overlap with the processing. An iterator shall be
+ * used by one thread at a time.
+ *
+ * @param immHandle An OM handle that is valid until the iterator is deleted
+ * @param rootName As for saImmOmSearchInitialize_2
+ * @param scope As for saImmOmSearchInitialize_2
+ * @param searchParam NULL for all objects, else objects with the attribute
+ *   value (SA_IMM_SEARCH_ONE_ATTR)
+ * @param attributeNames The attributes to get (SA_IMM_SEARCH_GET_SOME_ATTR),
+ *   NULL for all, an empty list for none
+ * @param batchSize Max objects per batch, 0 for 256
+ * @param prefetch Max objects read ahead of the caller, at least batchSize
+ * @param iter The iterator
+ * @return The result of immutil_saImmOmSearchInitialize_2
+ */
+EXTERN_C SaAisErrorT immutil_searchIterCreate(
+    SaImmHandleT immHandle, const SaNameT *rootName, SaImmScopeT scope,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, size_t batchSize, size_t prefetch,
+    ImmutilSearchIter_t **iter);
+
+/**
+ * Get the next batch. The previous batch is freed.
+ * @return SA_AIS_OK with a batch, SA_AIS_ERR_NOT_EXIST when there are no
+ *   more objects, or the error of immutil_saImmOmSearchNext_2. The batch is
+ *   set to NULL unless SA_AIS_OK is returned.
+ */
+EXTERN_C SaAisErrorT immutil_searchIterNext(
+    ImmutilSearchIter_t *iter, const struct ImmutilSearchBatch **batch);
+
+/**
+ * Stop the background thread, finalize the search and free all batches.
+ */
+EXTERN_C void immutil_searchIterDelete(ImmutilSearchIter_t *iter);
+
+
+/**
+ * Called for each object found by #immutil_parallelSearch, from several
+ * threads at once. The object name and attributes are valid during the
+ * call only.
+ * @return false to stop the search
+ */
+typedef bool (*ImmutilSearchCallbackT)(const SaNameT *objectName,
+                                       const SaImmAttrValuesT_2 **attributes,
+                                       void *arg);
+
+/**
+ * Search a subtree with several threads. The children of the root are read
+ * with an SA_IMM_SUBLEVEL search, then each child subtree is searched with
+ * SA_IMM_SUBTREE by one of nWorkers threads, each on an OM handle of its
+ * own from the pool of immutil_get_className(). The work is shared per
+ * child, so a tree where one child holds most objects gains little. The
+ * order of the objects is not defined.
+ *
+ * @param rootName The root, NULL for the whole tree
+ * @param searchParam As for #immutil_searchIterCreate
+ * @param attributeNames As for #immutil_searchIterCreate
+ * @param nWorkers Number of threads including the calling one, 0 for the
+ *   number of online CPUs
+ * @param callback Called for each object, it must be thread safe
+ * @param arg Passed to the callback
+ * @return SA_AIS_OK if the search completed or was stopped by the
+ *   callback, else the first error
+ */
+EXTERN_C SaAisErrorT immutil_parallelSearch(
+    const SaNameT *rootName, const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, unsigned int nWorkers,
+    ImmutilSearchCallbackT callback, void *arg);
+
+
+/**
+ * A writer of IMM snapshot files, see #immutil_snapshotWriterCreate.
+ */
+typedef struct ImmutilSnapshotWriter ImmutilSnapshotWriter_t;
+
+/**
+ * An open IMM snapshot file, see #immutil_snapshotOpen.
+ */
+typedef struct ImmutilSnapshot ImmutilSnapshot_t;
+
+/**
+ * No object, returned by the snapshot navigation functions.
+ */
+#define IMMUTIL_SNAPSHOT_NONE 0xffffffffU
+
+/**
+ * The values of one attribute of one object in a snapshot. The values are
+ * packed, 4 bytes for SA_IMM_ATTR_SAINT32T, _SAUINT32T and _SAFLOATT and 8
+ * bytes for _SAINT64T, _SAUINT64T, _SATIMET and _SADOUBLET. A
+ * SA_IMM_ATTR_SASTRINGT or _SANAMET value is a SaUint32T string offset, and
+ * a SA_IMM_ATTR_SAANYT value is a SaUint32T offset followed by a SaUint32T
+ * size, see #immutil_snapshotString.
+ */
+struct ImmutilSnapshotAttr {
+  SaImmValueTypeT type;
+  SaUint32T nValues;
+  const void *values;
+};
+
+/**
+ * An attribute of all objects of a class in a snapshot. Row r is object
+ * objects[r] and has the values first[r] up to first[r + 1], packed as in
+ * struct ImmutilSnapshotAttr.
+ */
+struct ImmutilSnapshotColumn {
+  SaImmValueTypeT type;
+  SaUint32T nRows;
+  const SaUint32T *objects; /**< nRows object numbers  */
+  const SaUint32T *first;   /**< nRows + 1 value indexes  */
+  const void *values;
+};
+
+/**
+ * Create a writer of an IMM snapshot file. A snapshot is a compact, read
+ * only copy of a set of objects that can be queried offline: interned
+ * strings, one array of typed values per class and attribute, and an index
+ * on DN with the parent and children of each object. Objects are kept in
+ * memory until the file is saved.
+ */
+EXTERN_C ImmutilSnapshotWriter_t *immutil_snapshotWriterCreate(void);
+
+/**
+ * Delete a writer.
+ */
+EXTERN_C void immutil_snapshotWriterDelete(ImmutilSnapshotWriter_t *writer);
+
+/**
+ * Add an object. The class is taken from the SaImmAttrClassName attribute,
+ * objects without it are put in the class "". An attribute with another
+ * type than earlier objects of the class gave it is left out.
+ */
+EXTERN_C void immutil_snapshotWriterAdd(
+    ImmutilSnapshotWriter_t *writer, const SaNameT *objectName,
+    const SaImmAttrValuesT_2 **attributes);
+
+/**
+ * Add the objects found by a search, read with #immutil_searchIterCreate.
+ * SaImmAttrClassName is added to attributeNames if it is missing.
+ * @return SA_AIS_OK or the error of the search
+ */
+EXTERN_C SaAisErrorT immutil_snapshotWriterAddSearch(
+    ImmutilSnapshotWriter_t *writer, SaImmHandleT immHandle,
+    const SaNameT *rootName, SaImmScopeT scope,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames);
+
+/**
+ * Write the snapshot to a file. It is written to a temporary file which
+ * then replaces path, so a failed save leaves an earlier snapshot intact.
+ * @return 0 on success, -1 on failure with errno set
+ */
+EXTERN_C int immutil_snapshotWriterSave(ImmutilSnapshotWriter_t *writer,
+                                        const char *path);
+
+/**
+ * Open a snapshot file. The file is memory mapped read only, and the
+ * strings and values returned by the query functions point into the map
+ * until the snapshot is closed. The tables are checked on open, so opening
+ * takes time in proportion to the number of classes and not objects.
+ * @return The snapshot or NULL on failure with errno set, EINVAL if the
+ *   file is not a valid snapshot
+ */
+EXTERN_C ImmutilSnapshot_t *immutil_snapshotOpen(const char *path);
+
+/**
+ * Close a snapshot.
+ */
+EXTERN_C void immutil_snapshotClose(ImmutilSnapshot_t *snapshot);
+
+/**
+ * Get the number of objects, they are numbered from 0.
+ */
+EXTERN_C SaUint32T immutil_snapshotObjects(const ImmutilSnapshot_t *snapshot);
+
+/**
+ * Get a string, or the data of a SA_IMM_ATTR_SAANYT value, from its offset.
+ * @return The string or NULL if the offset is out of range
+ */
+EXTERN_C const char *immutil_snapshotString(const ImmutilSnapshot_t *snapshot,
+                                            SaUint32T offset);
+
+/**
+ * Find an object by DN.
+ * @return The object or IMMUTIL_SNAPSHOT_NONE
+ */
+EXTERN_C SaUint32T immutil_snapshotFind(const ImmutilSnapshot_t *snapshot,
+                                        const char *dn);
+
+/**
+ * Get the DN of an object, NULL if there is no such object.
+ */
+EXTERN_C const char *immutil_snapshotDn(const ImmutilSnapshot_t *snapshot,
+                                        SaUint32T object);
+
+/**
+ * Get the class name of an object, NULL if there is no such object.
+ */
+EXTERN_C const char *immutil_snapshotClassName(
+    const ImmutilSnapshot_t *snapshot, SaUint32T object);
+
+/**
+ * Get the parent of an object, IMMUTIL_SNAPSHOT_NONE if the parent is not
+ * in the snapshot.
+ */
+EXTERN_C SaUint32T immutil_snapshotParent(const ImmutilSnapshot_t *snapshot,
+                                          SaUint32T object);
+
+/**
+ * Get the first child of an object in the snapshot, IMMUTIL_SNAPSHOT_NONE
+ * if none. The children are in the order they were added.
+ */
+EXTERN_C SaUint32T immutil_snapshotFirstChild(
+    const ImmutilSnapshot_t *snapshot, SaUint32T object);
+
+/**
+ * Get the next child of the parent of an object, IMMUTIL_SNAPSHOT_NONE if
+ * none.
+ */
+EXTERN_C SaUint32T immutil_snapshotNextSibling(
+    const ImmutilSnapshot_t *snapshot, SaUint32T object);
+
+/**
+ * Get an attribute of all objects of a class.
+ * @return false if the class or attribute is not in the snapshot
+ */
+EXTERN_C bool immutil_snapshotGetColumn(const ImmutilSnapshot_t *snapshot,
+                                        const char *className,
+                                        const char *attrName,
+                                        struct ImmutilSnapshotColumn *column);
+
+/**
+ * Get an attribute of an object.
+ * @return false if the object or attribute is not in the snapshot
+ */
+EXTERN_C bool immutil_snapshotGetAttr(const ImmutilSnapshot_t *snapshot,
+                                      SaUint32T object, const char *attrName,
+                                      struct ImmutilSnapshotAttr *attr);
+
+
+/**
+ * A read-through cache of config attributes, see #immutil_objectCacheCreate.
+ */
+typedef struct ImmutilObjectCache ImmutilObjectCache_t;
+
+/**
+ * Object cache statistics. The hit ratio is hits / (hits + misses), and
+ * hitAgeSum / hits is the mean time since the values returned by a hit were
+ * read from IMM.
+ */
+struct ImmutilObjectCacheStats {
+  SaUint64T hits;          /**< Gets answered from the cache  */
+  SaUint64T misses;        /**< Gets that read from IMM  */
+  SaUint64T invalidations; /**< Cached attributes and objects dropped by
+                                applied CCBs  */
+  SaUint64T evictions;     /**< Objects evicted to stay within maxBytes  */
+  SaUint64T hitAgeSum;     /**< Sum of the age of the oldest value of each
+                                hit, in nanoseconds  */
+  SaTimeT hitAgeMax;       /**< The oldest value returned by a hit  */
+  SaUint64T objects;       /**< Objects in the cache  */
+  SaUint64T bytes;         /**< Memory held by the cached objects  */
+};
+
+/**
+ * Create a read-through cache in front of saImmOmAccessorGet_2, keyed on DN
+ * and attribute name. Only config attributes are cached, runtime attributes
+ * are read from IMM on every get. An IMM applier is set for the classes of
+ * the cached objects, and drops the modified attributes and the deleted
+ * objects when a CCB is applied. Call #immutil_objectCacheDispatch when the
+ * selection object is readable, a cache that is not dispatched is not
+ * invalidated. Between the commit of a CCB and the dispatch of its apply
+ * callback a get may still return the old values, maxAge puts a bound on
+ * that.
+ *
+ * @param applierName The applier name, an '@' is put in front if missing
+ * @param maxBytes Evict objects when the cache holds more than this, 0 for
+ *   no limit. Objects that were not hit since the last eviction pass are
+ *   evicted first (CLOCK).
+ * @param maxAge Read values again when older than this, in nanoseconds, 0
+ *   for no limit
+ * @param cache The new cache, NULL on failure
+ * @return SA_AIS_OK or the error setting up the applier
+ */
+EXTERN_C SaAisErrorT immutil_objectCacheCreate(const char *applierName,
+                                               size_t maxBytes,
+                                               SaTimeT maxAge,
+                                               ImmutilObjectCache_t **cache);
+
+/**
+ * Delete a cache and finalize its applier.
+ */
+EXTERN_C void immutil_objectCacheDelete(ImmutilObjectCache_t *cache);
+
+/**
+ * Get attributes of an object, as #immutil_saImmOmAccessorGet_2 but from
+ * the cache when all asked attributes are cached. Missing attributes are
+ * read with a pooled OM handle and cached. The result is valid until the
+ * next get in the same thread and must not be freed.
+ *
+ * @param cache The cache
+ * @param objectName The object
+ * @param attributeNames The attributes, NULL for all config attributes
+ * @param attributes The result
+ * @return As for saImmOmAccessorGet_2
+ */
+EXTERN_C SaAisErrorT immutil_objectCacheGet(
+    ImmutilObjectCache_t *cache, const SaNameT *objectName,
+    const SaImmAttrNameT *attributeNames, SaImmAttrValuesT_2 ***attributes);
+
+/**
+ * Get the selection object of the applier. It changes when the applier is
+ * set up again.
+ */
+EXTERN_C SaAisErrorT immutil_objectCacheSelectionObjectGet(
+    ImmutilObjectCache_t *cache, SaSelectionObjectT *selectionObject);
+
+/**
+ * Dispatch the applier callbacks, it must not be called from more than one
+ * thread at a time. On SA_AIS_ERR_BAD_HANDLE, e.g. after a controller
+ * failover, the cache is flushed and nothing is cached until
+ * #immutil_objectCacheApplierInit has set up the applier again.
+ */
+EXTERN_C SaAisErrorT immutil_objectCacheDispatch(ImmutilObjectCache_t *cache);
+
+/**
+ * Set up the applier again, and flush the cache.
+ */
+EXTERN_C SaAisErrorT immutil_objectCacheApplierInit(
+    ImmutilObjectCache_t *cache);
+
+/**
+ * Drop an object from the cache, or all objects if objectName is NULL.
+ */
+EXTERN_C void immutil_objectCacheFlush(ImmutilObjectCache_t *cache,
+                                       const SaNameT *objectName);
+
+/**
+ * Get the statistics of a cache.
+ */
+EXTERN_C void immutil_objectCacheGetStats(
+    ImmutilObjectCache_t *cache, struct ImmutilObjectCacheStats *stats);
+
 /*@}*/
 
 #endif
@@ -0,0 +1,92 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+#ifndef IMMUTIL_TESTS_BENCH_H
+#define IMMUTIL_TESTS_BENCH_H
+/**
+ * @file bench.h
+ * @brief A minimal benchmark runner for immutil.
+ *
+ *    A BENCH() function runs the measured operation b->n times. The runner
+ *    calls it with a growing n until it runs for the bench time, one second
+ *    or IMMUTIL_BENCHTIME seconds, and prints one JSON object per line:
+ *
+ *      {"name":"ccbAddModify","iterations":1000000,"ns_per_op":212.4,
+ *       "allocs_per_op":0.00}
+ *
+ *    Allocations are the calls of malloc, calloc and realloc made while the
+ *    timer runs. Each benchmark runs in a child process with a fresh immutil
+ *    and stub IMM, the stub is reset before each call of the function.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imm_stub.h"
+
+struct Bench {
+  unsigned long n;
+  /**< Number of times to run the measured operation.  */
+  bool timerOn;
+  SaTimeT start;
+  SaTimeT elapsed;
+  unsigned long allocsStart;
+  unsigned long allocs;
+  char metrics[512];
+};
+
+typedef void (*BenchFnT)(struct Bench *b);
+
+/**
+ * Register a benchmark, called by the BENCH() constructors.
+ */
+extern void benchRegister(const char *name, BenchFnT fn);
+
+/**
+ * Start, stop and reset the timer and the allocation count. The timer is
+ * started when the function is called, stop it around set-up that should
+ * not be measured.
+ */
+extern void benchStartTimer(struct Bench *b);
+extern void benchStopTimer(struct Bench *b);
+extern void benchResetTimer(struct Bench *b);
+
+/**
+ * Add a metric to the result of the last run, e.g. a latency percentile.
+ */
+extern void benchMetric(struct Bench *b, const char *name, double value);
+
+/**
+ * Fail the benchmark.
+ */
+extern void benchFail(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2), noreturn));
+
+/**
+ * Return the monotonic time in nanoseconds.
+ */
+extern SaTimeT benchNow(void);
+
+#define BENCH(name)                                                            \
+	static void name(struct Bench *b);                                     \
+	__attribute__((constructor)) static void name##Register(void)          \
+	{                                                                      \
+		benchRegister(#name, name);                                    \
+	}                                                                      \
+	static void name(struct Bench *b)
+
+#endif /* IMMUTIL_TESTS_BENCH_H */
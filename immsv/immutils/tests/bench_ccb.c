@@ -0,0 +1,105 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * CCB lookup, insert and delete cost with 10, 1k and 100k live CCBs.
+ */
+
+#include "bench.h"
+#include "immutil.h"
+
+/* CCB ids as the IMM hands them out are increasing but not dense */
+static SaImmOiCcbIdT ccbId(unsigned long i)
+{
+	return 1000 + 3 * (SaImmOiCcbIdT)i;
+}
+
+static void ccbsCreate(unsigned long live)
+{
+	unsigned long i;
+
+	for (i = 0; i < live; i++)
+		(void)ccbutil_getCcbData(ccbId(i));
+}
+
+static void ccbsDelete(unsigned long live)
+{
+	unsigned long i;
+
+	for (i = 0; i < live; i++)
+		ccbutil_deleteCcbData(ccbutil_findCcbData(ccbId(i)));
+}
+
+/* Find each live CCB in turn, and miss every eighth lookup */
+static void ccbFind(struct Bench *b, unsigned long live)
+{
+	unsigned long i;
+
+	benchStopTimer(b);
+	ccbsCreate(live);
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++) {
+		SaImmOiCcbIdT id = ccbId(i % live) + (i % 8 == 7);
+		struct CcbUtilCcbData *ccb = ccbutil_findCcbData(id);
+		if ((ccb == NULL) != (i % 8 == 7))
+			benchFail("ccbutil_findCcbData");
+	}
+	benchStopTimer(b);
+	ccbsDelete(live);
+}
+
+/* Create and delete a CCB next to the live ones */
+static void ccbInsertDelete(struct Bench *b, unsigned long live)
+{
+	unsigned long i;
+
+	benchStopTimer(b);
+	ccbsCreate(live);
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++)
+		ccbutil_deleteCcbData(ccbutil_getCcbData(ccbId(live + i)));
+	benchStopTimer(b);
+	ccbsDelete(live);
+}
+
+BENCH(ccbFind10)
+{
+	ccbFind(b, 10);
+}
+
+BENCH(ccbFind1k)
+{
+	ccbFind(b, 1000);
+}
+
+BENCH(ccbFind100k)
+{
+	ccbFind(b, 100000);
+}
+
+BENCH(ccbInsertDelete10)
+{
+	ccbInsertDelete(b, 10);
+}
+
+BENCH(ccbInsertDelete1k)
+{
+	ccbInsertDelete(b, 1000);
+}
+
+BENCH(ccbInsertDelete100k)
+{
+	ccbInsertDelete(b, 100000);
+}
@@ -0,0 +1,293 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * Benchmarks of the CCB store, the copiers, the attribute and DN lookups and
+ * the value parsing.
+ */
+
+#include "bench.h"
+#include "immutil.h"
+
+/* CCBs are deleted and created again after this many operations */
+#define OPS_PER_CCB 256
+
+static const char *dnStr = "safComp=comp1,safSu=su1,safSg=sg1,safApp=app1";
+
+static SaUint32T uint32s[] = {1, 2, 3};
+static const char *strs[] = {"one", "two"};
+static SaTimeT time1 = 1000000000;
+static SaImmAttrValueT uint32Values[] = {&uint32s[0], &uint32s[1],
+					 &uint32s[2]};
+static SaImmAttrValueT strValues[] = {&strs[0], &strs[1]};
+static SaImmAttrValueT timeValues[] = {&time1};
+
+static SaImmAttrValuesT_2 attrA = {(SaImmAttrNameT) "attrA",
+				   SA_IMM_ATTR_SAUINT32T, 3, uint32Values};
+static SaImmAttrValuesT_2 attrB = {(SaImmAttrNameT) "attrB",
+				   SA_IMM_ATTR_SASTRINGT, 2, strValues};
+static SaImmAttrValuesT_2 attrC = {(SaImmAttrNameT) "attrC",
+				   SA_IMM_ATTR_SATIMET, 1, timeValues};
+static SaImmAttrValuesT_2 attrD = {(SaImmAttrNameT) "attrD",
+				   SA_IMM_ATTR_SAUINT32T, 1, uint32Values};
+static SaImmAttrValuesT_2 attrE = {(SaImmAttrNameT) "attrE",
+				   SA_IMM_ATTR_SASTRINGT, 1, strValues};
+static SaImmAttrValuesT_2 attrF = {(SaImmAttrNameT) "attrF",
+				   SA_IMM_ATTR_SAUINT32T, 2, uint32Values};
+static SaImmAttrValuesT_2 attrG = {(SaImmAttrNameT) "attrG",
+				   SA_IMM_ATTR_SASTRINGT, 1, &strValues[1]};
+static SaImmAttrValuesT_2 attrH = {(SaImmAttrNameT) "attrH",
+				   SA_IMM_ATTR_SATIMET, 1, timeValues};
+static const SaImmAttrValuesT_2 *attrs[] = {
+    &attrA, &attrB, &attrC, &attrD, &attrE, &attrF, &attrG, &attrH, NULL};
+
+BENCH(arenaStrdup)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	unsigned long i;
+
+	for (i = 0; i < b->n; i++) {
+		if (i % OPS_PER_CCB == OPS_PER_CCB - 1) {
+			ccbutil_deleteCcbData(ccb);
+			ccb = ccbutil_getCcbData(1);
+		}
+		if (immutil_strdup(ccb, dnStr) == NULL)
+			benchFail("immutil_strdup");
+	}
+	ccbutil_deleteCcbData(ccb);
+}
+
+BENCH(ccbAddCreate)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	SaNameT parent, name;
+	unsigned long i;
+
+	saAisNameLend("safSu=su1,safSg=sg1,safApp=app1", &parent);
+	saAisNameLend(dnStr, &name);
+	for (i = 0; i < b->n; i++) {
+		if (i % OPS_PER_CCB == OPS_PER_CCB - 1) {
+			ccbutil_deleteCcbData(ccb);
+			ccb = ccbutil_getCcbData(1);
+		}
+		ccbutil_ccbAddCreateOperation_2(ccb, &name,
+						(SaImmClassNameT) "SaAmfComp",
+						&parent, attrs);
+	}
+	ccbutil_deleteCcbData(ccb);
+}
+
+BENCH(ccbAddModify)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	SaImmAttrModificationT_2 modA = {SA_IMM_ATTR_VALUES_REPLACE, attrA};
+	SaImmAttrModificationT_2 modB = {SA_IMM_ATTR_VALUES_ADD, attrB};
+	const SaImmAttrModificationT_2 *mods[] = {&modA, &modB, NULL};
+	SaNameT name;
+	unsigned long i;
+
+	saAisNameLend(dnStr, &name);
+	for (i = 0; i < b->n; i++) {
+		if (i % OPS_PER_CCB == OPS_PER_CCB - 1) {
+			ccbutil_deleteCcbData(ccb);
+			ccb = ccbutil_getCcbData(1);
+		}
+		ccbutil_ccbAddModifyOperation(ccb, &name, mods);
+	}
+	ccbutil_deleteCcbData(ccb);
+}
+
+/* Create a CCB with 8 delete operations, look it up, walk it and delete it */
+BENCH(ccbLifecycle)
+{
+	static char dns[8][64];
+	SaNameT names[8];
+	unsigned long i;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		snprintf(dns[j], sizeof(dns[j]),
+			 "safSu=su%d,safSg=sg1,safApp=app1", j);
+		saAisNameLend(dns[j], &names[j]);
+	}
+	for (i = 0; i < b->n; i++) {
+		SaImmOiCcbIdT id = i + 1;
+		struct CcbUtilCcbData *ccb = ccbutil_getCcbData(id);
+		CcbUtilOperationData_t *op = NULL;
+		int ops = 0;
+		for (j = 0; j < 8; j++)
+			ccbutil_ccbAddDeleteOperation(ccb, &names[j]);
+		if (ccbutil_findCcbData(id) != ccb)
+			benchFail("ccbutil_findCcbData");
+		while ((op = ccbutil_getNextCcbOp(id, op)) != NULL)
+			ops++;
+		if (ops != 8)
+			benchFail("ccbutil_getNextCcbOp");
+		ccbutil_deleteCcbData(ccb);
+	}
+}
+
+BENCH(getAttr)
+{
+	SaTimeT value;
+	unsigned long i;
+
+	for (i = 0; i < b->n; i++)
+		if (immutil_getAttr("attrH", attrs, 0, &value) != SA_AIS_OK)
+			benchFail("immutil_getAttr");
+}
+
+BENCH(getStringAttr)
+{
+	unsigned long i;
+
+	for (i = 0; i < b->n; i++)
+		if (immutil_getStringAttr(attrs, "attrG", 0) == NULL)
+			benchFail("immutil_getStringAttr");
+}
+
+BENCH(getStringValue)
+{
+	SaNameT name;
+	unsigned long i;
+
+	saAisNameLend(dnStr, &name);
+	for (i = 0; i < b->n; i++)
+		if (immutil_getStringValue("safSg=", &name) == NULL)
+			benchFail("immutil_getStringValue");
+}
+
+BENCH(getDnItem)
+{
+	SaNameT name;
+	unsigned long i;
+
+	saAisNameLend(dnStr, &name);
+	for (i = 0; i < b->n; i++)
+		if (immutil_getDnItem(&name, 2) == NULL)
+			benchFail("immutil_getDnItem");
+}
+
+/*
+ * A DN workload for the question whether parsed DNs are worth caching: 3000
+ * hot DNs of about 90 bytes, looked up in turn. dnHashCompare is what any
+ * cache hit costs at least, hashing the DN and comparing it with the cached
+ * copy, before locking and copying out the result.
+ */
+
+#define HOT_DNS 3000
+
+static char hotDns[HOT_DNS][96];
+static SaNameT hotNames[HOT_DNS];
+
+static void hotDnsCreate(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < HOT_DNS; i++) {
+		snprintf(hotDns[i], sizeof(hotDns[i]),
+			 "safCsi=csi-%04u,safSi=si-%02u,safSu=su-%02u,"
+			 "safSg=sg-%02u,safApp=application,safAmfCluster=cl1",
+			 i, i % 97, i % 31, i % 13);
+		saAisNameLend(hotDns[i], &hotNames[i]);
+	}
+}
+
+BENCH(dnWorkloadGetValue)
+{
+	static const char *keys[] = {"safSu=", "safSg=", "safApp="};
+	struct ImmutilDnSlice value;
+	unsigned long i;
+
+	benchStopTimer(b);
+	hotDnsCreate();
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++)
+		if (!immutil_dnGetValue(&hotNames[i % HOT_DNS], keys[i % 3],
+					&value))
+			benchFail("immutil_dnGetValue");
+}
+
+BENCH(dnWorkloadGetItem)
+{
+	struct ImmutilDnSlice item;
+	unsigned long i;
+
+	benchStopTimer(b);
+	hotDnsCreate();
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++)
+		if (!immutil_dnGetItem(&hotNames[i % HOT_DNS], i % 6, &item))
+			benchFail("immutil_dnGetItem");
+}
+
+/* FNV-1a, as used for DN hash tables in immutil.c */
+static SaUint64T dnHash(const char *dn, size_t len)
+{
+	SaUint64T hash = 0xcbf29ce484222325ULL;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (unsigned char)dn[i]) * 0x100000001b3ULL;
+	return hash;
+}
+
+BENCH(dnHashCompare)
+{
+	static char copies[HOT_DNS][96];
+	static SaUint64T hashes[HOT_DNS];
+	unsigned long i;
+
+	benchStopTimer(b);
+	hotDnsCreate();
+	for (i = 0; i < HOT_DNS; i++) {
+		strcpy(copies[i], hotDns[i]);
+		hashes[i] = dnHash(copies[i], strlen(copies[i]));
+	}
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++) {
+		const char *dn = saAisNameBorrow(&hotNames[i % HOT_DNS]);
+		size_t len = strlen(dn);
+		if (dnHash(dn, len) != hashes[i % HOT_DNS] ||
+		    memcmp(copies[i % HOT_DNS], dn, len + 1) != 0)
+			benchFail("hash or compare");
+	}
+}
+
+BENCH(newAttrValueUint32)
+{
+	unsigned long i;
+
+	for (i = 0; i < b->n; i++) {
+		void *value = immutil_new_attrValue(SA_IMM_ATTR_SAUINT32T,
+						    "4294967295");
+		if (value == NULL)
+			benchFail("immutil_new_attrValue");
+		free(value);
+	}
+}
+
+BENCH(newAttrValueName)
+{
+	unsigned long i;
+
+	for (i = 0; i < b->n; i++) {
+		void *value =
+		    immutil_new_attrValue(SA_IMM_ATTR_SANAMET, dnStr);
+		if (value == NULL)
+			benchFail("immutil_new_attrValue");
+		free(value);
+	}
+}
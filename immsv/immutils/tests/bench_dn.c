@@ -0,0 +1,145 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * DN pattern matching against the equivalent regular expressions with
+ * immutil_matchName (regexec).
+ */
+
+#include <regex.h>
+
+#include "bench.h"
+#include "immutil.h"
+
+#define NAMES 1024
+
+static char dns[NAMES][96];
+static SaNameT names[NAMES];
+
+/* Components, SUs and SGs of 8 applications, about 1/8 match "app3" */
+static void namesCreate(void)
+{
+	unsigned long i;
+
+	for (i = 0; i < NAMES; i++) {
+		unsigned long app = i % 8, sg = (i / 8) % 4, su = (i / 32) % 8;
+		switch (i % 3) {
+		case 0:
+			snprintf(dns[i], sizeof(dns[i]),
+				 "safComp=comp%lu,safSu=SU%lu,safSg=sg%lu,"
+				 "safApp=app%lu",
+				 i, su, sg, app);
+			break;
+		case 1:
+			snprintf(dns[i], sizeof(dns[i]),
+				 "safSu=SU%lu,safSg=sg%lu,safApp=app%lu", su, sg,
+				 app);
+			break;
+		default:
+			snprintf(dns[i], sizeof(dns[i]),
+				 "safSg=sg%lu,safApp=app%lu", sg, app);
+		}
+		saAisNameLend(dns[i], &names[i]);
+	}
+}
+
+static void dnPatternBench(struct Bench *b, const char *pattern,
+			   const char *re)
+{
+	ImmutilDnPattern_t *p;
+	regex_t preg;
+	unsigned long i, matches = 0;
+
+	benchStopTimer(b);
+	namesCreate();
+	p = immutil_dnPatternCompile(pattern);
+	if (p == NULL || regcomp(&preg, re, REG_EXTENDED | REG_NOSUB) != 0)
+		benchFail("compile %s", pattern);
+	for (i = 0; i < NAMES; i++)
+		if (immutil_dnPatternMatch(p, &names[i]) !=
+		    (immutil_matchName(&names[i], &preg) == 0))
+			benchFail("%s and %s differ on %s", pattern, re,
+				  dns[i]);
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++)
+		matches += immutil_dnPatternMatch(p, &names[i % NAMES]);
+	benchStopTimer(b);
+	if (b->n >= NAMES && matches == 0)
+		benchFail("no match");
+	immutil_dnPatternDelete(p);
+	regfree(&preg);
+}
+
+static void regexecBench(struct Bench *b, const char *re)
+{
+	regex_t preg;
+	unsigned long i, matches = 0;
+
+	benchStopTimer(b);
+	namesCreate();
+	if (regcomp(&preg, re, REG_EXTENDED | REG_NOSUB) != 0)
+		benchFail("regcomp %s", re);
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++)
+		matches += immutil_matchName(&names[i % NAMES], &preg) == 0;
+	benchStopTimer(b);
+	if (b->n >= NAMES && matches == 0)
+		benchFail("no match");
+	regfree(&preg);
+}
+
+/* All objects below the SGs of an application */
+#define SUBTREE "**,safSg=*,safApp=app3"
+#define SUBTREE_RE "^(.*,)?safSg=[^,]*,safApp=app3$"
+
+/* SUs by prefix in one SG */
+#define PREFIX "safSu=SU*,safSg=sg1,safApp=app1"
+#define PREFIX_RE "^safSu=SU[^,]*,safSg=sg1,safApp=app1$"
+
+BENCH(dnPatternSubtree)
+{
+	dnPatternBench(b, SUBTREE, SUBTREE_RE);
+}
+
+BENCH(regexecSubtree)
+{
+	regexecBench(b, SUBTREE_RE);
+}
+
+BENCH(dnPatternPrefix)
+{
+	dnPatternBench(b, PREFIX, PREFIX_RE);
+}
+
+BENCH(regexecPrefix)
+{
+	regexecBench(b, PREFIX_RE);
+}
+
+BENCH(dnPatternMatchBulk)
+{
+	ImmutilDnPattern_t *p;
+	unsigned long i;
+
+	benchStopTimer(b);
+	namesCreate();
+	p = immutil_dnPatternCompile(SUBTREE);
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i += NAMES)
+		if (immutil_dnPatternMatchBulk(p, names, NAMES, NULL) == 0)
+			benchFail("no match");
+	benchStopTimer(b);
+	immutil_dnPatternDelete(p);
+}
@@ -0,0 +1,206 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The benchmark runner, see bench.h. The allocation functions of the C
+ * library are wrapped to count the allocations.
+ */
+
+#define _GNU_SOURCE
+#include "bench.h"
+#include <stdarg.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_N 1000000000UL
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void __libc_free(void *p);
+
+static unsigned long allocations;
+
+void *malloc(size_t size)
+{
+	__atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+	__atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+	__atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(p, size);
+}
+
+void free(void *p)
+{
+	__libc_free(p);
+}
+
+struct BenchCase {
+	const char *name;
+	BenchFnT fn;
+};
+
+static struct BenchCase *benches;
+static size_t nBenches;
+
+void benchRegister(const char *name, BenchFnT fn)
+{
+	benches = realloc(benches, (nBenches + 1) * sizeof(*benches));
+	if (benches == NULL)
+		abort();
+	benches[nBenches].name = name;
+	benches[nBenches].fn = fn;
+	nBenches++;
+}
+
+SaTimeT benchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (SaTimeT)ts.tv_sec * SA_TIME_ONE_SECOND + ts.tv_nsec;
+}
+
+void benchStartTimer(struct Bench *b)
+{
+	if (b->timerOn)
+		return;
+	b->timerOn = true;
+	b->start = benchNow();
+	b->allocsStart = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+}
+
+void benchStopTimer(struct Bench *b)
+{
+	if (!b->timerOn)
+		return;
+	b->timerOn = false;
+	b->elapsed += benchNow() - b->start;
+	b->allocs +=
+	    __atomic_load_n(&allocations, __ATOMIC_RELAXED) - b->allocsStart;
+}
+
+void benchResetTimer(struct Bench *b)
+{
+	b->elapsed = 0;
+	b->allocs = 0;
+	if (b->timerOn) {
+		b->start = benchNow();
+		b->allocsStart =
+		    __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+	}
+}
+
+void benchMetric(struct Bench *b, const char *name, double value)
+{
+	size_t length = strlen(b->metrics);
+	snprintf(b->metrics + length, sizeof(b->metrics) - length,
+		 ",\"%s\":%.2f", name, value);
+}
+
+void benchFail(const char *fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "bench failed: ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	fflush(stderr);
+	_exit(1);
+}
+
+static void benchRun(struct Bench *b, BenchFnT fn, unsigned long n)
+{
+	immStubReset();
+	memset(b, 0, sizeof(*b));
+	b->n = n;
+	benchStartTimer(b);
+	fn(b);
+	benchStopTimer(b);
+}
+
+/* Run a benchmark with a growing n until it runs for the bench time */
+static void benchCase(const struct BenchCase *c, SaTimeT benchTime)
+{
+	struct Bench b;
+	unsigned long n = 1;
+
+	benchRun(&b, c->fn, n);
+	while (b.elapsed < benchTime && n < BENCH_MAX_N) {
+		unsigned long prev = n;
+		double perOp = (double)b.elapsed / n;
+		if (perOp <= 0)
+			perOp = 1;
+		n = (unsigned long)(1.2 * benchTime / perOp);
+		if (n > 100 * prev)
+			n = 100 * prev;
+		if (n <= prev)
+			n = prev + 1;
+		if (n > BENCH_MAX_N)
+			n = BENCH_MAX_N;
+		benchRun(&b, c->fn, n);
+	}
+	printf("{\"name\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.2f,"
+	       "\"allocs_per_op\":%.2f%s}\n",
+	       c->name, b.n, (double)b.elapsed / b.n, (double)b.allocs / b.n,
+	       b.metrics);
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("IMMUTIL_BENCHTIME");
+	SaTimeT benchTime = SA_TIME_ONE_SECOND;
+	unsigned int failed = 0;
+	size_t i;
+	int j;
+
+	if (env != NULL)
+		benchTime = (SaTimeT)(atof(env) * SA_TIME_ONE_SECOND);
+	for (i = 0; i < nBenches; i++) {
+		bool run = argc < 2;
+		int status;
+		pid_t pid;
+
+		for (j = 1; j < argc; j++)
+			run = run || strstr(benches[i].name, argv[j]) != NULL;
+		if (!run)
+			continue;
+		if ((pid = fork()) == 0) {
+			benchCase(&benches[i], benchTime);
+			_exit(0);
+		}
+		if (pid < 0 || waitpid(pid, &status, 0) != pid) {
+			perror("fork");
+			return 2;
+		}
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "%s failed\n", benches[i].name);
+			failed++;
+		}
+	}
+	return failed != 0 ? 1 : 0;
+}
@@ -0,0 +1,89 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The cost of the retry profile lookup and of the wrapper around an IMM call
+ * that succeeds at once.
+ */
+
+#include "bench.h"
+#include "immutil.h"
+
+static const struct ImmutilRetryProfile health = {1, 5, 100};
+
+/* Operation and category profiles, no thread has a profile */
+BENCH(retryProfileLookup)
+{
+	struct ImmutilRetryProfile p;
+	unsigned long i;
+
+	immutil_setOperationRetryProfile(IMMUTIL_OP_OM_ACCESSOR_GET_2, &health);
+	for (i = 0; i < b->n; i++) {
+		immutil_getEffectiveRetryProfile(IMMUTIL_OP_OM_ACCESSOR_GET_2,
+						 &p);
+		if (p.timeout != health.timeout)
+			benchFail("wrong profile");
+	}
+}
+
+/* With a thread profile installed, for another operation */
+BENCH(retryProfileLookupThread)
+{
+	struct ImmutilRetryProfile p;
+	unsigned long i;
+
+	immutil_setThreadRetryProfile(IMMUTIL_OP_OM_SEARCH_NEXT_2, &health);
+	for (i = 0; i < b->n; i++) {
+		immutil_getEffectiveRetryProfile(IMMUTIL_OP_OM_ACCESSOR_GET_2,
+						 &p);
+		if (p.initialDelay != 1)
+			benchFail("wrong profile");
+	}
+	immutil_setThreadRetryProfile(IMMUTIL_OP_OM_SEARCH_NEXT_2, NULL);
+}
+
+/*
+ * A wrapper call that succeeds at once, with profiles installed; the
+ * overhead_ns metric is the time over the plain stub call.
+ */
+BENCH(wrapperOverhead)
+{
+	SaImmHandleT om;
+	SaSelectionObjectT selection;
+	SaVersionT version = {'A', 2, 11};
+	SaTimeT start, plain;
+	unsigned long i;
+
+	benchStopTimer(b);
+	immutil_setOperationRetryProfile(IMMUTIL_OP_OM_SELECTION_OBJECT_GET,
+					 &health);
+	immutil_setThreadRetryProfile(IMMUTIL_OP_OM_SEARCH_NEXT_2, &health);
+	if (immutil_saImmOmInitialize(&om, NULL, &version) != SA_AIS_OK)
+		benchFail("immutil_saImmOmInitialize");
+	start = benchNow();
+	for (i = 0; i < b->n; i++)
+		if (saImmOmSelectionObjectGet(om, &selection) != SA_AIS_OK)
+			benchFail("saImmOmSelectionObjectGet");
+	plain = benchNow() - start;
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++)
+		if (immutil_saImmOmSelectionObjectGet(om, &selection) !=
+		    SA_AIS_OK)
+			benchFail("immutil_saImmOmSelectionObjectGet");
+	benchStopTimer(b);
+	benchMetric(b, "overhead_ns",
+		    ((double)b->elapsed - (double)plain) / (double)b->n);
+	immutil_setThreadRetryProfile(IMMUTIL_OP_OM_SEARCH_NEXT_2, NULL);
+}
@@ -0,0 +1,110 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * Parallel subtree search of a synthetic tree of 1M objects, and of a small
+ * tree where each IMM call has a round trip latency. One iteration is one
+ * search of the whole tree. Without latency the search is CPU bound in the
+ * stub IMM, so the 1M object case measures the stand-in's cost per object
+ * and gains from workers only with as many free cores; the latency bound
+ * case shows what the workers save against a real IMM.
+ */
+
+#include "bench.h"
+#include "immutil.h"
+
+#define ROOT "safApp=bench"
+
+/* A root with objects below each of its children, return the total */
+static unsigned long treeCreate(unsigned int children, unsigned int objects)
+{
+	char dn[128];
+	unsigned int i, j;
+
+	immStubClassCreate("BenchObject", SA_IMM_CLASS_CONFIG, "benchId", NULL);
+	if (immStubObjectCreate("BenchObject", ROOT, NULL) != SA_AIS_OK)
+		benchFail("create %s", ROOT);
+	for (i = 0; i < children; i++) {
+		snprintf(dn, sizeof(dn), "safSg=%u," ROOT, i);
+		if (immStubObjectCreate("BenchObject", dn, NULL) != SA_AIS_OK)
+			benchFail("create %s", dn);
+		for (j = 0; j < objects; j++) {
+			snprintf(dn, sizeof(dn), "safSu=%u,safSg=%u," ROOT, j,
+				 i);
+			if (immStubObjectCreate("BenchObject", dn, NULL) !=
+			    SA_AIS_OK)
+				benchFail("create %s", dn);
+		}
+	}
+	return 1 + children + (unsigned long)children * objects;
+}
+
+static bool countObject(const SaNameT *objectName,
+			const SaImmAttrValuesT_2 **attributes, void *arg)
+{
+	(void)objectName;
+	(void)attributes;
+	__atomic_add_fetch((unsigned long *)arg, 1, __ATOMIC_RELAXED);
+	return true;
+}
+
+static void search(struct Bench *b, unsigned int children,
+		   unsigned int objects, unsigned int nWorkers, SaTimeT latency)
+{
+	SaImmAttrNameT noAttrs[] = {NULL};
+	unsigned long expected, found;
+	SaNameT root;
+	unsigned long i;
+
+	benchStopTimer(b);
+	expected = treeCreate(children, objects);
+	saAisNameLend(ROOT, &root);
+	immStubSetLatency(latency);
+	benchStartTimer(b);
+	for (i = 0; i < b->n; i++) {
+		found = 0;
+		if (immutil_parallelSearch(&root, NULL, noAttrs, nWorkers,
+					   countObject, &found) != SA_AIS_OK)
+			benchFail("immutil_parallelSearch");
+		if (found != expected)
+			benchFail("found %lu of %lu", found, expected);
+	}
+	benchStopTimer(b);
+	immStubSetLatency(0);
+	benchMetric(b, "objects", (double)expected);
+	benchMetric(b, "ns_per_object",
+		    (double)b->elapsed / b->n / (double)expected);
+}
+
+BENCH(parallelSearch1MSerial)
+{
+	search(b, 64, 15624, 1, 0);
+}
+
+BENCH(parallelSearch1M4Workers)
+{
+	search(b, 64, 15624, 4, 0);
+}
+
+/* 50 us per IMM call, the workers overlap the round trips */
+BENCH(parallelSearchLatencySerial)
+{
+	search(b, 64, 16, 1, 50000);
+}
+
+BENCH(parallelSearchLatency8Workers)
+{
+	search(b, 64, 16, 8, 50000);
+}
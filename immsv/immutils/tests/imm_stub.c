@@ -0,0 +1,2414 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * An in-process IMM for the immutil tests, see imm_stub.h. Objects are kept
+ * in a tree with a DN hash table under one read-write lock. Deleted objects
+ * and classes are kept until immStubReset(), so a search may still refer to
+ * them. All handles are in one table, a handle is its index + 1.
+ */
+
+#define _GNU_SOURCE
+#include "imm_stub.h"
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osaf_extended_name.h"
+
+#define EXTENDED_NAME_MAGIC 0xcd2b
+#define CONFIG_ATTR_NAME "SA_IMM_SEARCH_GET_CONFIG_ATTR"
+
+static void stubError(const char *what)
+{
+	fprintf(stderr, "imm_stub: %s\n", what);
+	abort();
+}
+
+static void *stubMalloc(size_t size)
+{
+	void *p = malloc(size);
+	if (p == NULL)
+		stubError("Out of memory");
+	return p;
+}
+
+static void *stubCalloc(size_t n, size_t size)
+{
+	void *p = calloc(n, size);
+	if (p == NULL)
+		stubError("Out of memory");
+	return p;
+}
+
+static char *stubStrdup(const char *s)
+{
+	char *p = strdup(s);
+	if (p == NULL)
+		stubError("Out of memory");
+	return p;
+}
+
+static SaTimeT stubNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (SaTimeT)ts.tv_sec * SA_TIME_ONE_SECOND + ts.tv_nsec;
+}
+
+/* ----------------------------------------------------------------------
+ * SaNameT; names longer than 255 are lent as a pointer to the string.
+ */
+
+void osaf_extended_name_lend(SaConstStringT value, SaNameT *name)
+{
+	size_t length = strlen(value);
+
+	if (length < SA_MAX_UNEXTENDED_NAME_LENGTH) {
+		name->length = (SaUint16T)length;
+		memcpy(name->value, value, length + 1);
+	} else {
+		name->length = EXTENDED_NAME_MAGIC;
+		memcpy(name->value, &value, sizeof(value));
+	}
+}
+
+SaConstStringT osaf_extended_name_borrow(const SaNameT *name)
+{
+	SaConstStringT value;
+
+	if (name->length != EXTENDED_NAME_MAGIC)
+		return (SaConstStringT)name->value;
+	memcpy(&value, name->value, sizeof(value));
+	return value;
+}
+
+void osaf_extended_name_clear(SaNameT *name)
+{
+	name->length = 0;
+	name->value[0] = '\0';
+}
+
+void osaf_extended_name_free(SaNameT *name)
+{
+	if (name->length == EXTENDED_NAME_MAGIC)
+		free((char *)osaf_extended_name_borrow(name));
+	osaf_extended_name_clear(name);
+}
+
+SaConstStringT saAisNameBorrow(const SaNameT *name)
+{
+	return osaf_extended_name_borrow(name);
+}
+
+void saAisNameLend(SaConstStringT value, SaNameT *name)
+{
+	osaf_extended_name_lend(value, name);
+}
+
+/* An owned copy of a name, long names get a copy of the string */
+static void nameCopy(SaNameT *dest, const SaNameT *src)
+{
+	if (src->length == EXTENDED_NAME_MAGIC)
+		osaf_extended_name_lend(
+		    stubStrdup(osaf_extended_name_borrow(src)), dest);
+	else
+		*dest = *src;
+}
+
+/* ----------------------------------------------------------------------
+ * Attribute values
+ */
+
+static size_t valueSize(SaImmValueTypeT type)
+{
+	switch (type) {
+	case SA_IMM_ATTR_SAINT32T:
+	case SA_IMM_ATTR_SAUINT32T:
+	case SA_IMM_ATTR_SAFLOATT:
+		return 4;
+	case SA_IMM_ATTR_SAINT64T:
+	case SA_IMM_ATTR_SAUINT64T:
+	case SA_IMM_ATTR_SATIMET:
+	case SA_IMM_ATTR_SADOUBLET:
+		return 8;
+	case SA_IMM_ATTR_SANAMET:
+		return sizeof(SaNameT);
+	case SA_IMM_ATTR_SASTRINGT:
+		return sizeof(SaStringT);
+	case SA_IMM_ATTR_SAANYT:
+		return sizeof(SaAnyT);
+	}
+	return 0;
+}
+
+static void valueCopy(SaImmValueTypeT type, void *dest, const void *src)
+{
+	switch (type) {
+	case SA_IMM_ATTR_SANAMET:
+		nameCopy(dest, src);
+		break;
+	case SA_IMM_ATTR_SASTRINGT: {
+		const char *s = *(const SaStringT *)src;
+		*(SaStringT *)dest = s != NULL ? stubStrdup(s) : NULL;
+		break;
+	}
+	case SA_IMM_ATTR_SAANYT: {
+		const SaAnyT *a = src;
+		SaAnyT *d = dest;
+		d->bufferSize = a->bufferSize;
+		d->bufferAddr = NULL;
+		if (a->bufferSize != 0) {
+			d->bufferAddr = stubMalloc(a->bufferSize);
+			memcpy(d->bufferAddr, a->bufferAddr, a->bufferSize);
+		}
+		break;
+	}
+	default:
+		memcpy(dest, src, valueSize(type));
+		break;
+	}
+}
+
+static void valueFree(SaImmValueTypeT type, void *value)
+{
+	switch (type) {
+	case SA_IMM_ATTR_SANAMET:
+		osaf_extended_name_free(value);
+		break;
+	case SA_IMM_ATTR_SASTRINGT:
+		free(*(SaStringT *)value);
+		break;
+	case SA_IMM_ATTR_SAANYT:
+		free(((SaAnyT *)value)->bufferAddr);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool valueEqual(SaImmValueTypeT type, const void *a, const void *b)
+{
+	switch (type) {
+	case SA_IMM_ATTR_SANAMET:
+		return strcmp(osaf_extended_name_borrow(a),
+			      osaf_extended_name_borrow(b)) == 0;
+	case SA_IMM_ATTR_SASTRINGT: {
+		const char *x = *(const SaStringT *)a, *y = *(const SaStringT *)b;
+		return x == y || (x != NULL && y != NULL && strcmp(x, y) == 0);
+	}
+	case SA_IMM_ATTR_SAANYT: {
+		const SaAnyT *x = a, *y = b;
+		return x->bufferSize == y->bufferSize &&
+		       (x->bufferSize == 0 ||
+			memcmp(x->bufferAddr, y->bufferAddr, x->bufferSize) ==
+			    0);
+	}
+	default:
+		return memcmp(a, b, valueSize(type)) == 0;
+	}
+}
+
+/* A copy of n values in one allocation with the attribute */
+static SaImmAttrValuesT_2 *attrCreate(const char *name, SaImmValueTypeT type,
+				      SaUint32T n, SaImmAttrValueT *values)
+{
+	size_t size = valueSize(type);
+	SaImmAttrValuesT_2 *attr =
+	    stubMalloc(sizeof(*attr) + n * (sizeof(SaImmAttrValueT) + size));
+	unsigned char *storage = (unsigned char *)(attr + 1) +
+				 n * sizeof(SaImmAttrValueT);
+	SaUint32T i;
+
+	attr->attrName = stubStrdup(name);
+	attr->attrValueType = type;
+	attr->attrValuesNumber = n;
+	attr->attrValues = n != 0 ? (SaImmAttrValueT *)(attr + 1) : NULL;
+	for (i = 0; i < n; i++) {
+		attr->attrValues[i] = storage + i * size;
+		valueCopy(type, attr->attrValues[i], values[i]);
+	}
+	return attr;
+}
+
+static SaImmAttrValuesT_2 *attrDup(const SaImmAttrValuesT_2 *attr)
+{
+	return attrCreate(attr->attrName, attr->attrValueType,
+			  attr->attrValuesNumber, attr->attrValues);
+}
+
+static void attrFree(SaImmAttrValuesT_2 *attr)
+{
+	SaUint32T i;
+
+	if (attr == NULL)
+		return;
+	for (i = 0; i < attr->attrValuesNumber; i++)
+		valueFree(attr->attrValueType, attr->attrValues[i]);
+	free(attr->attrName);
+	free(attr);
+}
+
+static void attrsFree(SaImmAttrValuesT_2 **attrs)
+{
+	size_t i;
+
+	for (i = 0; attrs != NULL && attrs[i] != NULL; i++)
+		attrFree(attrs[i]);
+	free(attrs);
+}
+
+static SaImmAttrValuesT_2 **attrsDup(const SaImmAttrValuesT_2 **attrs)
+{
+	SaImmAttrValuesT_2 **copy;
+	size_t i, n = 0;
+
+	while (attrs != NULL && attrs[n] != NULL)
+		n++;
+	copy = stubMalloc((n + 1) * sizeof(*copy));
+	for (i = 0; i < n; i++)
+		copy[i] = attrDup(attrs[i]);
+	copy[n] = NULL;
+	return copy;
+}
+
+struct StubMod {
+	SaImmAttrModificationT_2 mod; /* First, the arrays point to it */
+	SaImmAttrValuesT_2 *attr;     /* Owns the name and the values */
+};
+
+static SaImmAttrModificationT_2 **
+modsDup(const SaImmAttrModificationT_2 **mods)
+{
+	SaImmAttrModificationT_2 **copy;
+	size_t i, n = 0;
+
+	while (mods != NULL && mods[n] != NULL)
+		n++;
+	copy = stubMalloc((n + 1) * sizeof(*copy));
+	for (i = 0; i < n; i++) {
+		struct StubMod *m = stubMalloc(sizeof(*m));
+		m->attr = attrDup(&mods[i]->modAttr);
+		m->mod.modType = mods[i]->modType;
+		m->mod.modAttr = *m->attr;
+		copy[i] = &m->mod;
+	}
+	copy[n] = NULL;
+	return copy;
+}
+
+static void modsFree(SaImmAttrModificationT_2 **mods)
+{
+	size_t i;
+
+	for (i = 0; mods != NULL && mods[i] != NULL; i++) {
+		struct StubMod *m = (struct StubMod *)mods[i];
+		attrFree(m->attr);
+		free(m);
+	}
+	free(mods);
+}
+
+/* Apply a modification to an attribute, the old one is freed */
+static SaImmAttrValuesT_2 *attrModify(SaImmAttrValuesT_2 *attr,
+				      const SaImmAttrModificationT_2 *mod)
+{
+	const SaImmAttrValuesT_2 *m = &mod->modAttr;
+	SaImmAttrValueT *values;
+	SaImmAttrValuesT_2 *result;
+	SaUint32T i, j, n = 0;
+
+	if (mod->modType == SA_IMM_ATTR_VALUES_REPLACE) {
+		result = attrCreate(attr->attrName, attr->attrValueType,
+				    m->attrValuesNumber, m->attrValues);
+		attrFree(attr);
+		return result;
+	}
+	values = stubMalloc((attr->attrValuesNumber + m->attrValuesNumber + 1) *
+			    sizeof(*values));
+	for (i = 0; i < attr->attrValuesNumber; i++) {
+		bool deleted = false;
+		for (j = 0; mod->modType == SA_IMM_ATTR_VALUES_DELETE &&
+			    j < m->attrValuesNumber;
+		     j++)
+			deleted = deleted ||
+				  valueEqual(attr->attrValueType,
+					     attr->attrValues[i],
+					     m->attrValues[j]);
+		if (!deleted)
+			values[n++] = attr->attrValues[i];
+	}
+	for (j = 0; mod->modType == SA_IMM_ATTR_VALUES_ADD &&
+		    j < m->attrValuesNumber;
+	     j++)
+		values[n++] = m->attrValues[j];
+	result = attrCreate(attr->attrName, attr->attrValueType, n, values);
+	free(values);
+	attrFree(attr);
+	return result;
+}
+
+/* ----------------------------------------------------------------------
+ * Classes and objects
+ */
+
+struct StubClass {
+	struct StubClass *next;
+	char *name;
+	SaImmClassCategoryT category;
+	SaImmAttrDefinitionT_2 **defs; /* The class name attribute first */
+	size_t nDefs;
+	size_t rdn; /* Index of the RDN definition */
+	bool deleted;
+};
+
+struct StubObject {
+	struct StubObject *hashNext; /* Also the list of deleted objects */
+	struct StubObject *parent;
+	struct StubObject *firstChild;
+	struct StubObject *nextSibling;
+	struct StubClass *cls;
+	SaImmAttrValuesT_2 **attrs; /* One per definition but the first */
+	char dn[];
+};
+
+static pthread_rwlock_t storeLock = PTHREAD_RWLOCK_INITIALIZER;
+static struct StubClass *classes;
+static struct StubObject **objectTable;
+static size_t objectTableSize;
+static unsigned long nObjects;
+static struct StubObject *deletedObjects;
+
+static SaUint64T hashDn(const char *dn)
+{
+	SaUint64T hash = 14695981039346656037ULL;
+	while (*dn != '\0') {
+		hash ^= (unsigned char)*dn++;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static struct StubClass *classFind(const char *name)
+{
+	struct StubClass *c;
+	for (c = classes; c != NULL; c = c->next)
+		if (!c->deleted && strcmp(c->name, name) == 0)
+			return c;
+	return NULL;
+}
+
+/* Return the index of an attribute definition or -1 */
+static long classAttr(const struct StubClass *c, const char *attrName)
+{
+	size_t i;
+	for (i = 0; i < c->nDefs; i++)
+		if (strcmp(c->defs[i]->attrName, attrName) == 0)
+			return (long)i;
+	return -1;
+}
+
+static SaImmAttrDefinitionT_2 *defDup(const SaImmAttrDefinitionT_2 *def)
+{
+	SaImmAttrDefinitionT_2 *copy = stubMalloc(sizeof(*copy));
+
+	copy->attrName = stubStrdup(def->attrName);
+	copy->attrValueType = def->attrValueType;
+	copy->attrFlags = def->attrFlags;
+	copy->attrDefaultValue = NULL;
+	if (def->attrDefaultValue != NULL) {
+		copy->attrDefaultValue =
+		    stubMalloc(valueSize(def->attrValueType));
+		valueCopy(def->attrValueType, copy->attrDefaultValue,
+			  def->attrDefaultValue);
+	}
+	return copy;
+}
+
+static void defFree(SaImmAttrDefinitionT_2 *def)
+{
+	if (def->attrDefaultValue != NULL) {
+		valueFree(def->attrValueType, def->attrDefaultValue);
+		free(def->attrDefaultValue);
+	}
+	free(def->attrName);
+	free(def);
+}
+
+static SaAisErrorT classCreate(const char *className,
+			       SaImmClassCategoryT category,
+			       const SaImmAttrDefinitionT_2 **defs)
+{
+	SaImmAttrDefinitionT_2 classNameDef = {
+	    (SaImmAttrNameT)SA_IMM_ATTR_CLASS_NAME, SA_IMM_ATTR_SASTRINGT,
+	    category == SA_IMM_CLASS_CONFIG
+		? SA_IMM_ATTR_CONFIG
+		: SA_IMM_ATTR_RUNTIME | SA_IMM_ATTR_CACHED,
+	    NULL};
+	struct StubClass *c;
+	size_t i, n = 0;
+	long rdn = -1;
+
+	while (defs != NULL && defs[n] != NULL) {
+		if (defs[n]->attrFlags & SA_IMM_ATTR_RDN)
+			rdn = (long)n + 1;
+		n++;
+	}
+	if (rdn < 0)
+		return SA_AIS_ERR_INVALID_PARAM;
+	pthread_rwlock_wrlock(&storeLock);
+	if (classFind(className) != NULL) {
+		pthread_rwlock_unlock(&storeLock);
+		return SA_AIS_ERR_EXIST;
+	}
+	c = stubCalloc(1, sizeof(*c));
+	c->name = stubStrdup(className);
+	c->category = category;
+	c->nDefs = n + 1;
+	c->defs = stubMalloc((n + 2) * sizeof(*c->defs));
+	c->defs[0] = defDup(&classNameDef);
+	for (i = 0; i < n; i++)
+		c->defs[i + 1] = defDup(defs[i]);
+	c->defs[n + 1] = NULL;
+	c->rdn = (size_t)rdn;
+	c->next = classes;
+	classes = c;
+	pthread_rwlock_unlock(&storeLock);
+	return SA_AIS_OK;
+}
+
+void immStubClassCreate(const char *className, SaImmClassCategoryT category,
+			const char *rdnName,
+			const SaImmAttrDefinitionT_2 **attrDefinitions)
+{
+	SaImmAttrDefinitionT_2 rdnDef = {
+	    (SaImmAttrNameT)rdnName, SA_IMM_ATTR_SASTRINGT,
+	    SA_IMM_ATTR_RDN | (category == SA_IMM_CLASS_CONFIG
+				   ? SA_IMM_ATTR_CONFIG
+				   : SA_IMM_ATTR_RUNTIME | SA_IMM_ATTR_CACHED),
+	    NULL};
+	const SaImmAttrDefinitionT_2 **defs;
+	size_t i, n = 0;
+
+	while (attrDefinitions != NULL && attrDefinitions[n] != NULL)
+		n++;
+	defs = stubMalloc((n + 2) * sizeof(*defs));
+	defs[0] = &rdnDef;
+	for (i = 0; i < n; i++)
+		defs[i + 1] = attrDefinitions[i];
+	defs[n + 1] = NULL;
+	if (classCreate(className, category, defs) != SA_AIS_OK)
+		stubError("immStubClassCreate FAILED");
+	free(defs);
+}
+
+static struct StubObject *objectFind(const char *dn)
+{
+	struct StubObject *o;
+
+	if (objectTableSize == 0)
+		return NULL;
+	for (o = objectTable[hashDn(dn) & (objectTableSize - 1)]; o != NULL;
+	     o = o->hashNext)
+		if (strcmp(o->dn, dn) == 0)
+			return o;
+	return NULL;
+}
+
+static void objectTableGrow(void)
+{
+	size_t size = objectTableSize == 0 ? 1024 : 2 * objectTableSize, i;
+	struct StubObject **table = stubCalloc(size, sizeof(*table));
+
+	for (i = 0; i < objectTableSize; i++) {
+		struct StubObject *o, *next;
+		for (o = objectTable[i]; o != NULL; o = next) {
+			struct StubObject **slot =
+			    &table[hashDn(o->dn) & (size - 1)];
+			next = o->hashNext;
+			o->hashNext = *slot;
+			*slot = o;
+		}
+	}
+	free(objectTable);
+	objectTable = table;
+	objectTableSize = size;
+}
+
+/* Return the parent DN of dn, "" for a top level object */
+static const char *parentDn(const char *dn)
+{
+	const char *p;
+	for (p = dn; *p != '\0'; p++) {
+		if (*p == '\\' && p[1] != '\0')
+			p++;
+		else if (*p == ',')
+			return p + 1;
+	}
+	return p;
+}
+
+/* Return a copy of the value of the first RDN of dn */
+static char *rdnValue(const char *dn)
+{
+	const char *eq = strchr(dn, '=');
+	size_t length = (size_t)(parentDn(dn) - dn);
+
+	if (*parentDn(dn) != '\0')
+		length--;
+	if (eq == NULL || eq > dn + length)
+		return stubStrdup(dn);
+	return strndup(eq + 1, length - (size_t)(eq + 1 - dn));
+}
+
+/* Find the value of the RDN attribute in attrValues and make the DN */
+static char *objectDn(const struct StubClass *c, const char *parent,
+		      const SaImmAttrValuesT_2 **attrValues)
+{
+	const char *rdnName = c->defs[c->rdn]->attrName;
+	const char *rdn = NULL;
+	char *dn;
+	size_t i;
+
+	for (i = 0; attrValues != NULL && attrValues[i] != NULL; i++) {
+		const SaImmAttrValuesT_2 *a = attrValues[i];
+		if (strcmp(a->attrName, rdnName) != 0 ||
+		    a->attrValuesNumber != 1)
+			continue;
+		if (a->attrValueType == SA_IMM_ATTR_SASTRINGT)
+			rdn = *(SaStringT *)a->attrValues[0];
+		else if (a->attrValueType == SA_IMM_ATTR_SANAMET)
+			rdn = osaf_extended_name_borrow(a->attrValues[0]);
+	}
+	if (rdn == NULL)
+		return NULL;
+	if (parent == NULL || parent[0] == '\0')
+		return stubStrdup(rdn);
+	if (asprintf(&dn, "%s,%s", rdn, parent) < 0)
+		stubError("Out of memory");
+	return dn;
+}
+
+/* Create an object, called with the store lock held */
+static SaAisErrorT objectCreate(struct StubClass *c, const char *dn,
+				const SaImmAttrValuesT_2 **attrValues,
+				bool setRdn)
+{
+	const char *parent = parentDn(dn);
+	struct StubObject *o, *p = NULL, **slot;
+	size_t i;
+
+	if (objectFind(dn) != NULL)
+		return SA_AIS_ERR_EXIST;
+	if (parent[0] != '\0' && (p = objectFind(parent)) == NULL)
+		return SA_AIS_ERR_NOT_EXIST;
+	for (i = 0; attrValues != NULL && attrValues[i] != NULL; i++)
+		if (classAttr(c, attrValues[i]->attrName) <= 0)
+			return SA_AIS_ERR_INVALID_PARAM;
+
+	o = stubCalloc(1, sizeof(*o) + strlen(dn) + 1);
+	strcpy(o->dn, dn);
+	o->cls = c;
+	o->attrs = stubMalloc(c->nDefs * sizeof(*o->attrs));
+	for (i = 1; i < c->nDefs; i++) {
+		const SaImmAttrDefinitionT_2 *def = c->defs[i];
+		SaImmAttrValueT value = def->attrDefaultValue;
+		o->attrs[i - 1] = attrCreate(def->attrName, def->attrValueType,
+					     value != NULL, &value);
+	}
+	o->attrs[c->nDefs - 1] = NULL;
+	for (i = 0; attrValues != NULL && attrValues[i] != NULL; i++) {
+		long k = classAttr(c, attrValues[i]->attrName);
+		attrFree(o->attrs[k - 1]);
+		o->attrs[k - 1] = attrCreate(c->defs[k]->attrName,
+					     c->defs[k]->attrValueType,
+					     attrValues[i]->attrValuesNumber,
+					     attrValues[i]->attrValues);
+	}
+	if (setRdn && o->attrs[c->rdn - 1]->attrValuesNumber == 0) {
+		char *rdn = rdnValue(dn);
+		SaImmAttrValueT value = &rdn;
+		attrFree(o->attrs[c->rdn - 1]);
+		o->attrs[c->rdn - 1] = attrCreate(c->defs[c->rdn]->attrName,
+						  SA_IMM_ATTR_SASTRINGT, 1,
+						  &value);
+		free(rdn);
+	}
+
+	if (nObjects >= objectTableSize)
+		objectTableGrow();
+	slot = &objectTable[hashDn(dn) & (objectTableSize - 1)];
+	o->hashNext = *slot;
+	*slot = o;
+	if ((o->parent = p) != NULL) {
+		o->nextSibling = p->firstChild;
+		p->firstChild = o;
+	}
+	nObjects++;
+	return SA_AIS_OK;
+}
+
+/* Delete an object and its subtree, called with the store lock held */
+static void objectDelete(struct StubObject *o)
+{
+	struct StubObject **pp;
+
+	while (o->firstChild != NULL)
+		objectDelete(o->firstChild);
+	if (o->parent != NULL) {
+		for (pp = &o->parent->firstChild; *pp != o;
+		     pp = &(*pp)->nextSibling)
+			;
+		*pp = o->nextSibling;
+	}
+	for (pp = &objectTable[hashDn(o->dn) & (objectTableSize - 1)];
+	     *pp != o; pp = &(*pp)->hashNext)
+		;
+	*pp = o->hashNext;
+	o->hashNext = deletedObjects;
+	deletedObjects = o;
+	nObjects--;
+}
+
+static SaAisErrorT objectModify(struct StubObject *o,
+				const SaImmAttrModificationT_2 **attrMods)
+{
+	size_t i;
+
+	for (i = 0; attrMods != NULL && attrMods[i] != NULL; i++)
+		if (classAttr(o->cls, attrMods[i]->modAttr.attrName) <= 0)
+			return SA_AIS_ERR_INVALID_PARAM;
+	for (i = 0; attrMods != NULL && attrMods[i] != NULL; i++) {
+		long k = classAttr(o->cls, attrMods[i]->modAttr.attrName);
+		o->attrs[k - 1] = attrModify(o->attrs[k - 1], attrMods[i]);
+	}
+	return SA_AIS_OK;
+}
+
+SaAisErrorT immStubObjectCreate(const char *className, const char *dn,
+				const SaImmAttrValuesT_2 **attrValues)
+{
+	struct StubClass *c;
+	SaAisErrorT rc = SA_AIS_ERR_NOT_EXIST;
+
+	pthread_rwlock_wrlock(&storeLock);
+	if ((c = classFind(className)) != NULL)
+		rc = objectCreate(c, dn, attrValues, true);
+	pthread_rwlock_unlock(&storeLock);
+	return rc;
+}
+
+unsigned long immStubObjects(void)
+{
+	unsigned long n;
+	pthread_rwlock_rdlock(&storeLock);
+	n = nObjects;
+	pthread_rwlock_unlock(&storeLock);
+	return n;
+}
+
+/*
+ * Return copies of attributes of an object; all for NULL names, the config
+ * attributes for SA_IMM_SEARCH_GET_CONFIG_ATTR, else the named ones. The
+ * class name attribute is first. Called with the store lock held.
+ */
+static SaAisErrorT objectAttrs(const struct StubObject *o,
+			       const SaImmAttrNameT *names, bool config,
+			       SaImmAttrValuesT_2 ***result)
+{
+	const struct StubClass *c = o->cls;
+	SaImmAttrValuesT_2 **attrs;
+	SaImmAttrValueT className = (SaImmAttrValueT)&c->name;
+	size_t i, n = 0;
+
+	for (i = 0; !config && names != NULL && names[i] != NULL; i++) {
+		if (strcmp(names[i], CONFIG_ATTR_NAME) == 0)
+			config = true;
+		else if (classAttr(c, names[i]) < 0)
+			return SA_AIS_ERR_NOT_EXIST;
+	}
+	attrs = stubMalloc((c->nDefs + 1) * sizeof(*attrs));
+	for (i = 0; i < c->nDefs; i++) {
+		const SaImmAttrDefinitionT_2 *def = c->defs[i];
+		bool want = names == NULL;
+		size_t j;
+		if (config)
+			want = (def->attrFlags & SA_IMM_ATTR_CONFIG) != 0;
+		for (j = 0; !config && names != NULL && names[j] != NULL; j++)
+			want = want || strcmp(names[j], def->attrName) == 0;
+		if (!want)
+			continue;
+		attrs[n++] = i == 0 ? attrCreate(def->attrName,
+						 SA_IMM_ATTR_SASTRINGT, 1,
+						 &className)
+				    : attrDup(o->attrs[i - 1]);
+	}
+	attrs[n] = NULL;
+	*result = attrs;
+	return SA_AIS_OK;
+}
+
+/* ----------------------------------------------------------------------
+ * Error injection and call counting
+ */
+
+struct StubCall {
+	const char *name;
+	unsigned long calls;
+	struct StubCall *next;
+	bool registered;
+};
+
+struct Fault {
+	struct Fault *next;
+	char *function; /* NULL for any */
+	SaAisErrorT rc;
+	unsigned int count;
+};
+
+static pthread_mutex_t faultLock = PTHREAD_MUTEX_INITIALIZER;
+static struct StubCall *stubCalls;
+static unsigned long totalCalls;
+static struct Fault *faults;
+static bool faultsActive;
+static SaTimeT outageEnd;
+static SaAisErrorT outageRc;
+static SaTimeT latency;
+
+void immStubFail(const char *function, SaAisErrorT rc, unsigned int count)
+{
+	struct Fault *f = stubCalloc(1, sizeof(*f)), **pp;
+
+	f->function = function != NULL ? stubStrdup(function) : NULL;
+	f->rc = rc;
+	f->count = count;
+	pthread_mutex_lock(&faultLock);
+	for (pp = &faults; *pp != NULL; pp = &(*pp)->next)
+		;
+	*pp = f;
+	__atomic_store_n(&faultsActive, true, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&faultLock);
+}
+
+void immStubOutage(SaAisErrorT rc, SaTimeT duration)
+{
+	pthread_mutex_lock(&faultLock);
+	outageRc = rc;
+	__atomic_store_n(&outageEnd, stubNow() + duration, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&faultLock);
+}
+
+void immStubOutageEnd(void)
+{
+	__atomic_store_n(&outageEnd, 0, __ATOMIC_RELEASE);
+}
+
+void immStubSetLatency(SaTimeT value)
+{
+	__atomic_store_n(&latency, value, __ATOMIC_RELAXED);
+}
+
+unsigned long immStubCalls(const char *function)
+{
+	struct StubCall *c;
+	unsigned long n = 0;
+
+	if (function == NULL)
+		return __atomic_load_n(&totalCalls, __ATOMIC_RELAXED);
+	pthread_mutex_lock(&faultLock);
+	for (c = stubCalls; c != NULL; c = c->next)
+		if (strcmp(c->name, function) == 0)
+			n = __atomic_load_n(&c->calls, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&faultLock);
+	return n;
+}
+
+/* Count a call and return the injected error, or SA_AIS_OK */
+static SaAisErrorT stubEnter(struct StubCall *call, bool finalize)
+{
+	SaTimeT end, delay;
+	SaAisErrorT rc = SA_AIS_OK;
+
+	if (!__atomic_load_n(&call->registered, __ATOMIC_ACQUIRE)) {
+		pthread_mutex_lock(&faultLock);
+		if (!call->registered) {
+			call->next = stubCalls;
+			stubCalls = call;
+			__atomic_store_n(&call->registered, true,
+					 __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&faultLock);
+	}
+	__atomic_fetch_add(&call->calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&totalCalls, 1, __ATOMIC_RELAXED);
+
+	if ((delay = __atomic_load_n(&latency, __ATOMIC_RELAXED)) != 0) {
+		struct timespec ts = {delay / SA_TIME_ONE_SECOND,
+				      delay % SA_TIME_ONE_SECOND};
+		while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+			;
+	}
+	if (finalize)
+		return SA_AIS_OK;
+	if ((end = __atomic_load_n(&outageEnd, __ATOMIC_ACQUIRE)) != 0 &&
+	    stubNow() < end)
+		return outageRc;
+	if (__atomic_load_n(&faultsActive, __ATOMIC_ACQUIRE)) {
+		struct Fault *f, **pp;
+		pthread_mutex_lock(&faultLock);
+		for (pp = &faults; (f = *pp) != NULL; pp = &f->next)
+			if (f->function == NULL ||
+			    strcmp(f->function, call->name) == 0)
+				break;
+		if (f != NULL) {
+			rc = f->rc;
+			if (--f->count == 0) {
+				*pp = f->next;
+				free(f->function);
+				free(f);
+			}
+		}
+		if (faults == NULL)
+			__atomic_store_n(&faultsActive, false,
+					 __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&faultLock);
+	}
+	return rc;
+}
+
+#define STUB_ENTER(name, finalize)                                             \
+	do {                                                                   \
+		static struct StubCall call_ = {name, 0, NULL, false};         \
+		SaAisErrorT rc_ = stubEnter(&call_, finalize);                 \
+		if (rc_ != SA_AIS_OK)                                          \
+			return rc_;                                            \
+	} while (0)
+
+/* ----------------------------------------------------------------------
+ * Handles
+ */
+
+enum HandleKind {
+	HANDLE_OM = 1,
+	HANDLE_ACCESSOR,
+	HANDLE_OWNER,
+	HANDLE_CCB,
+	HANDLE_SEARCH,
+	HANDLE_OI
+};
+
+enum OpType { OP_CREATE, OP_DELETE, OP_MODIFY, OP_COMPLETED, OP_APPLY };
+
+/* A CCB operation, also an OI callback to make */
+struct StubOp {
+	struct StubOp *next;
+	enum OpType type;
+	SaImmOiCcbIdT ccbId;
+	char *className;
+	char *dn;
+	SaImmAttrValuesT_2 **attrValues;
+	SaImmAttrModificationT_2 **attrMods;
+};
+
+struct StubHandle {
+	enum HandleKind kind;
+	unsigned int epoch;
+	SaUint64T om;		     /* The OM handle it belongs to */
+	int fd;			     /* Selection object or -1 */
+	SaImmAttrValuesT_2 **result; /* Freed on the next call */
+	/* CCB */
+	SaImmOiCcbIdT ccbId;
+	struct StubOp *ops;
+	/* Search */
+	struct StubObject **objects;
+	size_t nObjects;
+	size_t next;
+	SaImmAttrNameT *attrNames; /* NULL for all */
+	bool config;
+	bool noAttrs;
+	/* OI */
+	SaImmOiCallbacksT_2 callbacks;
+	SaImmOiCallbacksT_o3 callbacksO3;
+	bool o3;
+	char *implementerName;
+	char **classNames;
+	size_t nClassNames;
+	struct StubOp *events; /* Callbacks to make */
+};
+
+/* Read locked to look up a handle, so that calls on other handles overlap */
+static pthread_rwlock_t handleLock = PTHREAD_RWLOCK_INITIALIZER;
+static struct StubHandle **handles;
+static size_t nHandles;
+static size_t handlesCapacity;
+static unsigned int epoch;
+static SaImmOiCcbIdT lastCcbId;
+
+static SaUint64T handleCreate(enum HandleKind kind, SaUint64T om)
+{
+	struct StubHandle *h = stubCalloc(1, sizeof(*h));
+	SaUint64T handle;
+
+	h->kind = kind;
+	h->om = om;
+	h->fd = -1;
+	pthread_rwlock_wrlock(&handleLock);
+	h->epoch = epoch;
+	if (nHandles == handlesCapacity) {
+		handlesCapacity =
+		    handlesCapacity == 0 ? 256 : 2 * handlesCapacity;
+		handles =
+		    realloc(handles, handlesCapacity * sizeof(*handles));
+		if (handles == NULL)
+			stubError("Out of memory");
+	}
+	handles[nHandles++] = h;
+	handle = nHandles;
+	pthread_rwlock_unlock(&handleLock);
+	return handle;
+}
+
+static struct StubHandle *handleGet(SaUint64T handle, enum HandleKind kind)
+{
+	struct StubHandle *h = NULL;
+
+	pthread_rwlock_rdlock(&handleLock);
+	if (handle != 0 && handle <= nHandles) {
+		h = handles[handle - 1];
+		if (h != NULL && (h->kind != kind || h->epoch != epoch))
+			h = NULL;
+	}
+	pthread_rwlock_unlock(&handleLock);
+	return h;
+}
+
+static void opsFree(struct StubOp *op)
+{
+	while (op != NULL) {
+		struct StubOp *next = op->next;
+		free(op->className);
+		free(op->dn);
+		attrsFree(op->attrValues);
+		modsFree(op->attrMods);
+		free(op);
+		op = next;
+	}
+}
+
+static void handleFree(struct StubHandle *h)
+{
+	size_t i;
+
+	if (h->fd >= 0)
+		close(h->fd);
+	attrsFree(h->result);
+	opsFree(h->ops);
+	opsFree(h->events);
+	free(h->objects);
+	for (i = 0; h->attrNames != NULL && h->attrNames[i] != NULL; i++)
+		free(h->attrNames[i]);
+	free(h->attrNames);
+	free(h->implementerName);
+	for (i = 0; i < h->nClassNames; i++)
+		free(h->classNames[i]);
+	free(h->classNames);
+	free(h);
+}
+
+/* Finalize a handle, and for an OM handle all handles on it */
+static SaAisErrorT handleFinalize(SaUint64T handle, enum HandleKind kind)
+{
+	struct StubHandle *h;
+	size_t i;
+
+	pthread_rwlock_wrlock(&handleLock);
+	if (handle == 0 || handle > nHandles ||
+	    (h = handles[handle - 1]) == NULL || h->kind != kind ||
+	    h->epoch != epoch) {
+		pthread_rwlock_unlock(&handleLock);
+		return SA_AIS_ERR_BAD_HANDLE;
+	}
+	handles[handle - 1] = NULL;
+	handleFree(h);
+	for (i = 0; kind == HANDLE_OM && i < nHandles; i++) {
+		if (handles[i] != NULL && handles[i]->om == handle) {
+			handleFree(handles[i]);
+			handles[i] = NULL;
+		}
+	}
+	pthread_rwlock_unlock(&handleLock);
+	return SA_AIS_OK;
+}
+
+static void resultSet(struct StubHandle *h, SaImmAttrValuesT_2 **result)
+{
+	attrsFree(h->result);
+	h->result = result;
+}
+
+void immStubInvalidateHandles(void)
+{
+	pthread_rwlock_wrlock(&handleLock);
+	epoch++;
+	pthread_rwlock_unlock(&handleLock);
+}
+
+void immStubReset(void)
+{
+	struct StubClass *c;
+	struct StubObject *o;
+	struct StubCall *call;
+	struct Fault *f;
+	size_t i;
+
+	pthread_rwlock_wrlock(&handleLock);
+	for (i = 0; i < nHandles; i++)
+		if (handles[i] != NULL)
+			handleFree(handles[i]);
+	free(handles);
+	handles = NULL;
+	nHandles = handlesCapacity = 0;
+	epoch++;
+	pthread_rwlock_unlock(&handleLock);
+
+	pthread_rwlock_wrlock(&storeLock);
+	for (i = 0; i < objectTableSize; i++) {
+		while ((o = objectTable[i]) != NULL) {
+			objectTable[i] = o->hashNext;
+			o->hashNext = deletedObjects;
+			deletedObjects = o;
+		}
+	}
+	while ((o = deletedObjects) != NULL) {
+		deletedObjects = o->hashNext;
+		attrsFree(o->attrs);
+		free(o);
+	}
+	free(objectTable);
+	objectTable = NULL;
+	objectTableSize = 0;
+	nObjects = 0;
+	while ((c = classes) != NULL) {
+		classes = c->next;
+		for (i = 0; i < c->nDefs; i++)
+			defFree(c->defs[i]);
+		free(c->defs);
+		free(c->name);
+		free(c);
+	}
+	pthread_rwlock_unlock(&storeLock);
+
+	pthread_mutex_lock(&faultLock);
+	while ((f = faults) != NULL) {
+		faults = f->next;
+		free(f->function);
+		free(f);
+	}
+	__atomic_store_n(&faultsActive, false, __ATOMIC_RELAXED);
+	__atomic_store_n(&outageEnd, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&totalCalls, 0, __ATOMIC_RELAXED);
+	for (call = stubCalls; call != NULL; call = call->next)
+		__atomic_store_n(&call->calls, 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&faultLock);
+	__atomic_store_n(&latency, 0, __ATOMIC_RELAXED);
+}
+
+static int eventFd(struct StubHandle *h)
+{
+	if (h->fd < 0 &&
+	    (h->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+		stubError("eventfd FAILED");
+	return h->fd;
+}
+
+/* ----------------------------------------------------------------------
+ * saImmOm
+ */
+
+SaAisErrorT saImmOmInitialize(SaImmHandleT *immHandle,
+			      const SaImmCallbacksT *immCallbacks,
+			      SaVersionT *version)
+{
+	STUB_ENTER("saImmOmInitialize", false);
+	*immHandle = handleCreate(HANDLE_OM, 0);
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmInitialize_o2(SaImmHandleT *immHandle,
+				 const SaImmCallbacksT_o2 *immCallbacks,
+				 SaVersionT *version)
+{
+	STUB_ENTER("saImmOmInitialize_o2", false);
+	*immHandle = handleCreate(HANDLE_OM, 0);
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmSelectionObjectGet(SaImmHandleT immHandle,
+				      SaSelectionObjectT *selectionObject)
+{
+	struct StubHandle *h;
+	STUB_ENTER("saImmOmSelectionObjectGet", false);
+	if ((h = handleGet(immHandle, HANDLE_OM)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	*selectionObject = (SaSelectionObjectT)eventFd(h);
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmDispatch(SaImmHandleT immHandle,
+			    SaDispatchFlagsT dispatchFlags)
+{
+	STUB_ENTER("saImmOmDispatch", false);
+	if (handleGet(immHandle, HANDLE_OM) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmFinalize(SaImmHandleT immHandle)
+{
+	STUB_ENTER("saImmOmFinalize", true);
+	return handleFinalize(immHandle, HANDLE_OM);
+}
+
+SaAisErrorT saImmOmClassCreate_2(SaImmHandleT immHandle,
+				 const SaImmClassNameT className,
+				 SaImmClassCategoryT classCategory,
+				 const SaImmAttrDefinitionT_2 **attrDefinitions)
+{
+	STUB_ENTER("saImmOmClassCreate_2", false);
+	if (handleGet(immHandle, HANDLE_OM) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	return classCreate(className, classCategory, attrDefinitions);
+}
+
+SaAisErrorT saImmOmClassDescriptionGet_2(
+    SaImmHandleT immHandle, const SaImmClassNameT className,
+    SaImmClassCategoryT *classCategory,
+    SaImmAttrDefinitionT_2 ***attrDefinitions)
+{
+	struct StubClass *c;
+	SaImmAttrDefinitionT_2 **defs;
+	size_t i;
+
+	STUB_ENTER("saImmOmClassDescriptionGet_2", false);
+	if (handleGet(immHandle, HANDLE_OM) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_rdlock(&storeLock);
+	if ((c = classFind(className)) == NULL) {
+		pthread_rwlock_unlock(&storeLock);
+		return SA_AIS_ERR_NOT_EXIST;
+	}
+	defs = stubMalloc((c->nDefs + 1) * sizeof(*defs));
+	for (i = 0; i < c->nDefs; i++)
+		defs[i] = defDup(c->defs[i]);
+	defs[c->nDefs] = NULL;
+	*classCategory = c->category;
+	pthread_rwlock_unlock(&storeLock);
+	*attrDefinitions = defs;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmClassDescriptionMemoryFree_2(
+    SaImmHandleT immHandle, SaImmAttrDefinitionT_2 **attrDefinitions)
+{
+	size_t i;
+
+	STUB_ENTER("saImmOmClassDescriptionMemoryFree_2", true);
+	for (i = 0; attrDefinitions != NULL && attrDefinitions[i] != NULL; i++)
+		defFree(attrDefinitions[i]);
+	free(attrDefinitions);
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmClassDelete(SaImmHandleT immHandle,
+			       const SaImmClassNameT className)
+{
+	struct StubClass *c;
+	SaAisErrorT rc = SA_AIS_OK;
+	size_t i;
+
+	STUB_ENTER("saImmOmClassDelete", false);
+	if (handleGet(immHandle, HANDLE_OM) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_wrlock(&storeLock);
+	if ((c = classFind(className)) == NULL)
+		rc = SA_AIS_ERR_NOT_EXIST;
+	for (i = 0; rc == SA_AIS_OK && i < objectTableSize; i++) {
+		struct StubObject *o;
+		for (o = objectTable[i]; o != NULL; o = o->hashNext)
+			if (o->cls == c)
+				rc = SA_AIS_ERR_BUSY;
+	}
+	if (rc == SA_AIS_OK)
+		c->deleted = true;
+	pthread_rwlock_unlock(&storeLock);
+	return rc;
+}
+
+/* Return true if an object matches a SA_IMM_SEARCH_ONE_ATTR parameter */
+static bool searchMatch(const struct StubObject *o,
+			const SaImmSearchOneAttrT_2 *param)
+{
+	const SaImmAttrValuesT_2 *a;
+	long k = classAttr(o->cls, param->attrName);
+	SaUint32T i;
+
+	if (k < 0)
+		return false;
+	if (k == 0)
+		return param->attrValue == NULL ||
+		       strcmp(*(SaStringT *)param->attrValue, o->cls->name) ==
+			   0;
+	a = o->attrs[k - 1];
+	if (param->attrValue == NULL)
+		return true;
+	for (i = 0; i < a->attrValuesNumber; i++)
+		if (valueEqual(a->attrValueType, a->attrValues[i],
+			       param->attrValue))
+			return true;
+	return false;
+}
+
+static void searchAdd(struct StubHandle *h, size_t *size,
+		      struct StubObject *o,
+		      const SaImmSearchParametersT_2 *searchParam)
+{
+	if (searchParam != NULL && !searchMatch(o, &searchParam->searchOneAttr))
+		return;
+	if (h->nObjects == *size) {
+		*size = *size == 0 ? 64 : 2 * *size;
+		h->objects = realloc(h->objects, *size * sizeof(*h->objects));
+		if (h->objects == NULL)
+			stubError("Out of memory");
+	}
+	h->objects[h->nObjects++] = o;
+}
+
+static void searchSubtree(struct StubHandle *h, size_t *size,
+			  struct StubObject *o,
+			  const SaImmSearchParametersT_2 *searchParam)
+{
+	for (; o != NULL; o = o->nextSibling) {
+		searchAdd(h, size, o, searchParam);
+		searchSubtree(h, size, o->firstChild, searchParam);
+	}
+}
+
+static SaAisErrorT searchInitialize(SaImmHandleT immHandle, const char *root,
+				    SaImmScopeT scope,
+				    SaImmSearchOptionsT searchOptions,
+				    const SaImmSearchParametersT_2 *searchParam,
+				    const SaImmAttrNameT *attributeNames,
+				    SaImmSearchHandleT *searchHandle)
+{
+	SaImmSearchHandleT handle;
+	struct StubHandle *h;
+	struct StubObject *o = NULL;
+	size_t i, n = 0, size = 0;
+
+	if (handleGet(immHandle, HANDLE_OM) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	if (!(searchOptions & SA_IMM_SEARCH_ONE_ATTR))
+		searchParam = NULL;
+	handle = handleCreate(HANDLE_SEARCH, immHandle);
+	h = handleGet(handle, HANDLE_SEARCH);
+	h->noAttrs = (searchOptions & SA_IMM_SEARCH_GET_NO_ATTR) != 0;
+	h->config = (searchOptions & SA_IMM_SEARCH_GET_CONFIG_ATTR) != 0;
+	if ((searchOptions & SA_IMM_SEARCH_GET_SOME_ATTR) &&
+	    attributeNames != NULL) {
+		while (attributeNames[n] != NULL)
+			n++;
+		h->attrNames = stubMalloc((n + 1) * sizeof(*h->attrNames));
+		for (i = 0; i < n; i++)
+			h->attrNames[i] = stubStrdup(attributeNames[i]);
+		h->attrNames[n] = NULL;
+	}
+
+	pthread_rwlock_rdlock(&storeLock);
+	if (root != NULL && root[0] != '\0') {
+		if ((o = objectFind(root)) == NULL) {
+			pthread_rwlock_unlock(&storeLock);
+			(void)handleFinalize(handle, HANDLE_SEARCH);
+			return SA_AIS_ERR_NOT_EXIST;
+		}
+		searchAdd(h, &size, o, searchParam);
+		if (scope == SA_IMM_SUBLEVEL) {
+			for (o = o->firstChild; o != NULL; o = o->nextSibling)
+				searchAdd(h, &size, o, searchParam);
+		} else if (scope == SA_IMM_SUBTREE) {
+			searchSubtree(h, &size, o->firstChild, searchParam);
+		}
+	} else {
+		for (i = 0; i < objectTableSize; i++)
+			for (o = objectTable[i]; o != NULL; o = o->hashNext)
+				if (o->parent == NULL &&
+				    (scope == SA_IMM_SUBTREE ||
+				     scope == SA_IMM_SUBLEVEL)) {
+					searchAdd(h, &size, o, searchParam);
+					if (scope == SA_IMM_SUBTREE)
+						searchSubtree(h, &size,
+							      o->firstChild,
+							      searchParam);
+				}
+	}
+	pthread_rwlock_unlock(&storeLock);
+	*searchHandle = handle;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmSearchInitialize_2(
+    SaImmHandleT immHandle, const SaNameT *rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT searchOptions,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+{
+	STUB_ENTER("saImmOmSearchInitialize_2", false);
+	return searchInitialize(
+	    immHandle, rootName != NULL ? saAisNameBorrow(rootName) : NULL,
+	    scope, searchOptions, searchParam, attributeNames, searchHandle);
+}
+
+SaAisErrorT saImmOmSearchInitialize_o3(
+    SaImmHandleT immHandle, SaConstStringT rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT searchOptions,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle)
+{
+	STUB_ENTER("saImmOmSearchInitialize_o3", false);
+	return searchInitialize(immHandle, rootName, scope, searchOptions,
+				searchParam, attributeNames, searchHandle);
+}
+
+static SaAisErrorT searchNext(SaImmSearchHandleT searchHandle,
+			      const char **objectName,
+			      SaImmAttrValuesT_2 ***attributes)
+{
+	struct StubHandle *h = handleGet(searchHandle, HANDLE_SEARCH);
+	struct StubObject *o;
+	SaImmAttrValuesT_2 **attrs;
+	SaImmAttrNameT none[] = {NULL};
+
+	if (h == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	if (h->next == h->nObjects)
+		return SA_AIS_ERR_NOT_EXIST;
+	o = h->objects[h->next++];
+	pthread_rwlock_rdlock(&storeLock);
+	if (objectAttrs(o, h->noAttrs ? none : h->attrNames, h->config,
+			&attrs) != SA_AIS_OK)
+		attrs = stubCalloc(1, sizeof(*attrs));
+	pthread_rwlock_unlock(&storeLock);
+	resultSet(h, attrs);
+	*objectName = o->dn;
+	*attributes = attrs;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmSearchNext_2(SaImmSearchHandleT searchHandle,
+				SaNameT *objectName,
+				SaImmAttrValuesT_2 ***attributes)
+{
+	const char *dn;
+	SaAisErrorT rc;
+
+	STUB_ENTER("saImmOmSearchNext_2", false);
+	if ((rc = searchNext(searchHandle, &dn, attributes)) == SA_AIS_OK)
+		saAisNameLend(dn, objectName);
+	return rc;
+}
+
+SaAisErrorT saImmOmSearchNext_o3(SaImmSearchHandleT searchHandle,
+				 SaStringT *objectName,
+				 SaImmAttrValuesT_2 ***attributes)
+{
+	const char *dn;
+	SaAisErrorT rc;
+
+	STUB_ENTER("saImmOmSearchNext_o3", false);
+	if ((rc = searchNext(searchHandle, &dn, attributes)) == SA_AIS_OK)
+		*objectName = (SaStringT)dn;
+	return rc;
+}
+
+SaAisErrorT saImmOmSearchFinalize(SaImmSearchHandleT searchHandle)
+{
+	STUB_ENTER("saImmOmSearchFinalize", true);
+	return handleFinalize(searchHandle, HANDLE_SEARCH);
+}
+
+SaAisErrorT saImmOmAccessorInitialize(SaImmHandleT immHandle,
+				      SaImmAccessorHandleT *accessorHandle)
+{
+	STUB_ENTER("saImmOmAccessorInitialize", false);
+	if (handleGet(immHandle, HANDLE_OM) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	*accessorHandle = handleCreate(HANDLE_ACCESSOR, immHandle);
+	return SA_AIS_OK;
+}
+
+static SaAisErrorT accessorGet(struct StubHandle *h, const char *dn,
+			       const SaImmAttrNameT *attributeNames,
+			       SaImmAttrValuesT_2 ***attributes)
+{
+	struct StubObject *o;
+	SaImmAttrValuesT_2 **attrs;
+	SaAisErrorT rc;
+
+	if (h == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_rdlock(&storeLock);
+	if ((o = objectFind(dn)) == NULL)
+		rc = SA_AIS_ERR_NOT_EXIST;
+	else
+		rc = objectAttrs(o, attributeNames, false, &attrs);
+	pthread_rwlock_unlock(&storeLock);
+	if (rc == SA_AIS_OK) {
+		resultSet(h, attrs);
+		*attributes = attrs;
+	}
+	return rc;
+}
+
+SaAisErrorT saImmOmAccessorGet_2(SaImmAccessorHandleT accessorHandle,
+				 const SaNameT *objectName,
+				 const SaImmAttrNameT *attributeNames,
+				 SaImmAttrValuesT_2 ***attributes)
+{
+	STUB_ENTER("saImmOmAccessorGet_2", false);
+	return accessorGet(handleGet(accessorHandle, HANDLE_ACCESSOR),
+			   saAisNameBorrow(objectName), attributeNames,
+			   attributes);
+}
+
+SaAisErrorT saImmOmAccessorGet_o3(SaImmAccessorHandleT accessorHandle,
+				  SaConstStringT objectName,
+				  const SaImmAttrNameT *attributeNames,
+				  SaImmAttrValuesT_2 ***attributes)
+{
+	STUB_ENTER("saImmOmAccessorGet_o3", false);
+	return accessorGet(handleGet(accessorHandle, HANDLE_ACCESSOR),
+			   objectName, attributeNames, attributes);
+}
+
+SaAisErrorT saImmOmAccessorFinalize(SaImmAccessorHandleT accessorHandle)
+{
+	STUB_ENTER("saImmOmAccessorFinalize", true);
+	return handleFinalize(accessorHandle, HANDLE_ACCESSOR);
+}
+
+SaAisErrorT saImmOmAdminOwnerInitialize(
+    SaImmHandleT immHandle, const SaImmAdminOwnerNameT adminOwnerName,
+    SaBoolT releaseOwnershipOnFinalize, SaImmAdminOwnerHandleT *ownerHandle)
+{
+	STUB_ENTER("saImmOmAdminOwnerInitialize", false);
+	if (handleGet(immHandle, HANDLE_OM) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	*ownerHandle = handleCreate(HANDLE_OWNER, immHandle);
+	return SA_AIS_OK;
+}
+
+#define OWNER_CALL(name, finalize)                                             \
+	STUB_ENTER(name, finalize);                                            \
+	if (handleGet(ownerHandle, HANDLE_OWNER) == NULL)                      \
+		return SA_AIS_ERR_BAD_HANDLE;                                  \
+	return SA_AIS_OK
+
+SaAisErrorT saImmOmAdminOwnerSet(SaImmAdminOwnerHandleT ownerHandle,
+				 const SaNameT **objectNames,
+				 SaImmScopeT scope)
+{
+	OWNER_CALL("saImmOmAdminOwnerSet", false);
+}
+
+SaAisErrorT saImmOmAdminOwnerSet_o3(SaImmAdminOwnerHandleT ownerHandle,
+				    SaConstStringT *objectNames,
+				    SaImmScopeT scope)
+{
+	OWNER_CALL("saImmOmAdminOwnerSet_o3", false);
+}
+
+SaAisErrorT saImmOmAdminOwnerRelease(SaImmAdminOwnerHandleT ownerHandle,
+				     const SaNameT **objectNames,
+				     SaImmScopeT scope)
+{
+	OWNER_CALL("saImmOmAdminOwnerRelease", false);
+}
+
+SaAisErrorT saImmOmAdminOwnerRelease_o3(SaImmAdminOwnerHandleT ownerHandle,
+					SaConstStringT *objectNames,
+					SaImmScopeT scope)
+{
+	OWNER_CALL("saImmOmAdminOwnerRelease_o3", false);
+}
+
+SaAisErrorT saImmOmAdminOwnerFinalize(SaImmAdminOwnerHandleT ownerHandle)
+{
+	STUB_ENTER("saImmOmAdminOwnerFinalize", true);
+	return handleFinalize(ownerHandle, HANDLE_OWNER);
+}
+
+SaAisErrorT saImmOmAdminOwnerClear(SaImmHandleT immHandle,
+				   const SaNameT **objectNames,
+				   SaImmScopeT scope)
+{
+	STUB_ENTER("saImmOmAdminOwnerClear", false);
+	return handleGet(immHandle, HANDLE_OM) != NULL ? SA_AIS_OK
+						       : SA_AIS_ERR_BAD_HANDLE;
+}
+
+SaAisErrorT saImmOmAdminOwnerClear_o3(SaImmHandleT immHandle,
+				      SaConstStringT *objectNames,
+				      SaImmScopeT scope)
+{
+	STUB_ENTER("saImmOmAdminOwnerClear_o3", false);
+	return handleGet(immHandle, HANDLE_OM) != NULL ? SA_AIS_OK
+						       : SA_AIS_ERR_BAD_HANDLE;
+}
+
+/* ----------------------------------------------------------------------
+ * CCBs; operations are checked when added, against the objects and the
+ * earlier operations of the CCB, and made on apply.
+ */
+
+SaAisErrorT saImmOmCcbInitialize(SaImmAdminOwnerHandleT ownerHandle,
+				 SaImmCcbFlagsT ccbFlags,
+				 SaImmCcbHandleT *ccbHandle)
+{
+	struct StubHandle *owner;
+
+	STUB_ENTER("saImmOmCcbInitialize", false);
+	if ((owner = handleGet(ownerHandle, HANDLE_OWNER)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	*ccbHandle = handleCreate(HANDLE_CCB, owner->om);
+	return SA_AIS_OK;
+}
+
+/* Return the class of an object after the operations of a CCB, or NULL */
+static struct StubClass *ccbObjectClass(struct StubHandle *h, const char *dn)
+{
+	struct StubClass *c = NULL;
+	struct StubObject *o;
+	struct StubOp *op;
+
+	if ((o = objectFind(dn)) != NULL)
+		c = o->cls;
+	for (op = h->ops; op != NULL; op = op->next) {
+		if (strcmp(op->dn, dn) == 0 ||
+		    (op->type == OP_DELETE && c != NULL &&
+		     strlen(dn) > strlen(op->dn) &&
+		     strcmp(dn + strlen(dn) - strlen(op->dn), op->dn) == 0 &&
+		     dn[strlen(dn) - strlen(op->dn) - 1] == ',')) {
+			if (op->type == OP_CREATE)
+				c = classFind(op->className);
+			else if (op->type == OP_DELETE)
+				c = NULL;
+		}
+	}
+	return c;
+}
+
+static void ccbAdd(struct StubHandle *h, enum OpType type,
+		   const char *className, const char *dn,
+		   const SaImmAttrValuesT_2 **attrValues,
+		   const SaImmAttrModificationT_2 **attrMods)
+{
+	struct StubOp *op = stubCalloc(1, sizeof(*op)), **pp;
+
+	op->type = type;
+	op->className = className != NULL ? stubStrdup(className) : NULL;
+	op->dn = stubStrdup(dn);
+	op->attrValues = attrValues != NULL ? attrsDup(attrValues) : NULL;
+	op->attrMods = attrMods != NULL ? modsDup(attrMods) : NULL;
+	for (pp = &h->ops; *pp != NULL; pp = &(*pp)->next)
+		;
+	*pp = op;
+}
+
+static SaAisErrorT ccbObjectCreate(SaImmCcbHandleT ccbHandle,
+				   const SaImmClassNameT className,
+				   const char *parent, const char *objectName,
+				   const SaImmAttrValuesT_2 **attrValues)
+{
+	struct StubHandle *h = handleGet(ccbHandle, HANDLE_CCB);
+	struct StubClass *c;
+	SaAisErrorT rc = SA_AIS_OK;
+	char *dn = NULL;
+	size_t i;
+
+	if (h == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_rdlock(&storeLock);
+	if ((c = classFind(className)) == NULL ||
+	    c->category != SA_IMM_CLASS_CONFIG) {
+		rc = SA_AIS_ERR_NOT_EXIST;
+	} else if (objectName != NULL) {
+		dn = stubStrdup(objectName);
+		parent = parentDn(dn);
+	} else if ((dn = objectDn(c, parent, attrValues)) == NULL) {
+		rc = SA_AIS_ERR_INVALID_PARAM;
+	}
+	for (i = 0; rc == SA_AIS_OK && attrValues != NULL &&
+		    attrValues[i] != NULL;
+	     i++)
+		if (classAttr(c, attrValues[i]->attrName) <= 0)
+			rc = SA_AIS_ERR_INVALID_PARAM;
+	if (rc == SA_AIS_OK && ccbObjectClass(h, dn) != NULL)
+		rc = SA_AIS_ERR_EXIST;
+	if (rc == SA_AIS_OK && parent != NULL && parent[0] != '\0' &&
+	    ccbObjectClass(h, parent) == NULL)
+		rc = SA_AIS_ERR_NOT_EXIST;
+	if (rc == SA_AIS_OK)
+		ccbAdd(h, OP_CREATE, className, dn, attrValues, NULL);
+	pthread_rwlock_unlock(&storeLock);
+	free(dn);
+	return rc;
+}
+
+SaAisErrorT saImmOmCcbObjectCreate_2(SaImmCcbHandleT ccbHandle,
+				     const SaImmClassNameT className,
+				     const SaNameT *parentName,
+				     const SaImmAttrValuesT_2 **attrValues)
+{
+	STUB_ENTER("saImmOmCcbObjectCreate_2", false);
+	return ccbObjectCreate(
+	    ccbHandle, className,
+	    parentName != NULL ? saAisNameBorrow(parentName) : NULL, NULL,
+	    attrValues);
+}
+
+SaAisErrorT saImmOmCcbObjectCreate_o3(SaImmCcbHandleT ccbHandle,
+				      const SaImmClassNameT className,
+				      SaConstStringT objectName,
+				      const SaImmAttrValuesT_2 **attrValues)
+{
+	STUB_ENTER("saImmOmCcbObjectCreate_o3", false);
+	return ccbObjectCreate(ccbHandle, className, NULL, objectName,
+			       attrValues);
+}
+
+static SaAisErrorT ccbObjectDelete(SaImmCcbHandleT ccbHandle, const char *dn)
+{
+	struct StubHandle *h = handleGet(ccbHandle, HANDLE_CCB);
+	SaAisErrorT rc = SA_AIS_OK;
+
+	if (h == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_rdlock(&storeLock);
+	if (ccbObjectClass(h, dn) == NULL)
+		rc = SA_AIS_ERR_NOT_EXIST;
+	else
+		ccbAdd(h, OP_DELETE, NULL, dn, NULL, NULL);
+	pthread_rwlock_unlock(&storeLock);
+	return rc;
+}
+
+SaAisErrorT saImmOmCcbObjectDelete(SaImmCcbHandleT ccbHandle,
+				   const SaNameT *objectName)
+{
+	STUB_ENTER("saImmOmCcbObjectDelete", false);
+	return ccbObjectDelete(ccbHandle, saAisNameBorrow(objectName));
+}
+
+SaAisErrorT saImmOmCcbObjectDelete_o3(SaImmCcbHandleT ccbHandle,
+				      SaConstStringT objectName)
+{
+	STUB_ENTER("saImmOmCcbObjectDelete_o3", false);
+	return ccbObjectDelete(ccbHandle, objectName);
+}
+
+static SaAisErrorT ccbObjectModify(SaImmCcbHandleT ccbHandle, const char *dn,
+				   const SaImmAttrModificationT_2 **attrMods)
+{
+	struct StubHandle *h = handleGet(ccbHandle, HANDLE_CCB);
+	struct StubClass *c;
+	SaAisErrorT rc = SA_AIS_OK;
+	size_t i;
+
+	if (h == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_rdlock(&storeLock);
+	if ((c = ccbObjectClass(h, dn)) == NULL)
+		rc = SA_AIS_ERR_NOT_EXIST;
+	for (i = 0; rc == SA_AIS_OK && attrMods != NULL && attrMods[i] != NULL;
+	     i++)
+		if (classAttr(c, attrMods[i]->modAttr.attrName) <= 0)
+			rc = SA_AIS_ERR_INVALID_PARAM;
+	if (rc == SA_AIS_OK)
+		ccbAdd(h, OP_MODIFY, NULL, dn, NULL, attrMods);
+	pthread_rwlock_unlock(&storeLock);
+	return rc;
+}
+
+SaAisErrorT saImmOmCcbObjectModify_2(SaImmCcbHandleT ccbHandle,
+				     const SaNameT *objectName,
+				     const SaImmAttrModificationT_2 **attrMods)
+{
+	STUB_ENTER("saImmOmCcbObjectModify_2", false);
+	return ccbObjectModify(ccbHandle, saAisNameBorrow(objectName),
+			       attrMods);
+}
+
+SaAisErrorT saImmOmCcbObjectModify_o3(SaImmCcbHandleT ccbHandle,
+				      SaConstStringT objectName,
+				      const SaImmAttrModificationT_2 **attrMods)
+{
+	STUB_ENTER("saImmOmCcbObjectModify_o3", false);
+	return ccbObjectModify(ccbHandle, objectName, attrMods);
+}
+
+SaAisErrorT saImmOmCcbObjectRead(SaImmCcbHandleT ccbHandle,
+				 SaConstStringT objectName,
+				 const SaImmAttrNameT *attributeNames,
+				 SaImmAttrValuesT_2 ***attributes)
+{
+	STUB_ENTER("saImmOmCcbObjectRead", false);
+	return accessorGet(handleGet(ccbHandle, HANDLE_CCB), objectName,
+			   attributeNames, attributes);
+}
+
+/* Return true if an OI handles objects of a class */
+static bool oiImplements(const struct StubHandle *oi, const char *className)
+{
+	size_t i;
+	for (i = 0; className != NULL && i < oi->nClassNames; i++)
+		if (strcmp(oi->classNames[i], className) == 0)
+			return true;
+	return false;
+}
+
+static void oiQueue(struct StubHandle *oi, const struct StubOp *op,
+		    SaImmOiCcbIdT ccbId, enum OpType type)
+{
+	struct StubOp *event = stubCalloc(1, sizeof(*event)), **pp;
+	SaUint64T one = 1;
+
+	event->type = type;
+	event->ccbId = ccbId;
+	if (op != NULL) {
+		event->className =
+		    op->className != NULL ? stubStrdup(op->className) : NULL;
+		event->dn = stubStrdup(op->dn);
+		event->attrValues =
+		    op->attrValues != NULL
+			? attrsDup((const SaImmAttrValuesT_2 **)op->attrValues)
+			: NULL;
+		event->attrMods = op->attrMods != NULL
+				      ? modsDup((const SaImmAttrModificationT_2 *
+						     *)op->attrMods)
+				      : NULL;
+	}
+	for (pp = &oi->events; *pp != NULL; pp = &(*pp)->next)
+		;
+	*pp = event;
+	if (write(eventFd(oi), &one, sizeof(one)) != sizeof(one))
+		stubError("write FAILED");
+}
+
+/*
+ * Queue the callbacks of a CCB for the OIs and appliers of the classes,
+ * called with the handle lock held. The class of each operation is in
+ * op->className, set on apply.
+ */
+static void oiNotify(const struct StubOp *ops, SaImmOiCcbIdT ccbId)
+{
+	const struct StubOp *op;
+	size_t i;
+
+	for (i = 0; i < nHandles; i++) {
+		struct StubHandle *oi = handles[i];
+		bool involved = false;
+		if (oi == NULL || oi->kind != HANDLE_OI || oi->epoch != epoch)
+			continue;
+		for (op = ops; op != NULL; op = op->next) {
+			if (!oiImplements(oi, op->className))
+				continue;
+			oiQueue(oi, op, ccbId, op->type);
+			involved = true;
+		}
+		if (involved) {
+			oiQueue(oi, NULL, ccbId, OP_COMPLETED);
+			oiQueue(oi, NULL, ccbId, OP_APPLY);
+		}
+	}
+}
+
+SaAisErrorT saImmOmCcbApply(SaImmCcbHandleT ccbHandle)
+{
+	struct StubHandle *h;
+	struct StubOp *op;
+	SaAisErrorT rc = SA_AIS_OK;
+
+	STUB_ENTER("saImmOmCcbApply", false);
+	if ((h = handleGet(ccbHandle, HANDLE_CCB)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_wrlock(&storeLock);
+	for (op = h->ops; rc == SA_AIS_OK && op != NULL; op = op->next) {
+		struct StubObject *o = objectFind(op->dn);
+		switch (op->type) {
+		case OP_CREATE:
+			rc = objectCreate(
+			    classFind(op->className), op->dn,
+			    (const SaImmAttrValuesT_2 **)op->attrValues, true);
+			break;
+		case OP_DELETE:
+			if (o == NULL) {
+				rc = SA_AIS_ERR_NOT_EXIST;
+				break;
+			}
+			op->className = stubStrdup(o->cls->name);
+			objectDelete(o);
+			break;
+		case OP_MODIFY:
+			if (o == NULL) {
+				rc = SA_AIS_ERR_NOT_EXIST;
+				break;
+			}
+			op->className = stubStrdup(o->cls->name);
+			rc = objectModify(
+			    o, (const SaImmAttrModificationT_2 **)op->attrMods);
+			break;
+		default:
+			break;
+		}
+	}
+	pthread_rwlock_unlock(&storeLock);
+	if (rc != SA_AIS_OK)
+		stubError("saImmOmCcbApply: checked operation failed");
+
+	pthread_rwlock_wrlock(&handleLock);
+	h->ccbId = ++lastCcbId;
+	oiNotify(h->ops, h->ccbId);
+	pthread_rwlock_unlock(&handleLock);
+	opsFree(h->ops);
+	h->ops = NULL;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmCcbValidate(SaImmCcbHandleT ccbHandle)
+{
+	STUB_ENTER("saImmOmCcbValidate", false);
+	return handleGet(ccbHandle, HANDLE_CCB) != NULL ? SA_AIS_OK
+							: SA_AIS_ERR_BAD_HANDLE;
+}
+
+SaAisErrorT saImmOmCcbAbort(SaImmCcbHandleT ccbHandle)
+{
+	struct StubHandle *h;
+
+	STUB_ENTER("saImmOmCcbAbort", false);
+	if ((h = handleGet(ccbHandle, HANDLE_CCB)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	opsFree(h->ops);
+	h->ops = NULL;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmCcbFinalize(SaImmCcbHandleT ccbHandle)
+{
+	STUB_ENTER("saImmOmCcbFinalize", true);
+	return handleFinalize(ccbHandle, HANDLE_CCB);
+}
+
+/* ----------------------------------------------------------------------
+ * Administrative operations; the stub has no OI round trip, operations
+ * succeed at once.
+ */
+
+static SaAisErrorT adminOperation(SaImmAdminOwnerHandleT ownerHandle,
+				  const char *dn,
+				  SaAisErrorT *operationReturnValue)
+{
+	bool exists;
+
+	if (handleGet(ownerHandle, HANDLE_OWNER) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_rdlock(&storeLock);
+	exists = objectFind(dn) != NULL;
+	pthread_rwlock_unlock(&storeLock);
+	if (!exists)
+		return SA_AIS_ERR_NOT_EXIST;
+	if (operationReturnValue != NULL)
+		*operationReturnValue = SA_AIS_OK;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOmAdminOperationInvoke_2(
+    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout)
+{
+	STUB_ENTER("saImmOmAdminOperationInvoke_2", false);
+	return adminOperation(ownerHandle, saAisNameBorrow(objectName),
+			      operationReturnValue);
+}
+
+SaAisErrorT saImmOmAdminOperationInvoke_o2(
+    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout,
+    SaImmAdminOperationParamsT_2 ***returnParams)
+{
+	STUB_ENTER("saImmOmAdminOperationInvoke_o2", false);
+	if (returnParams != NULL)
+		*returnParams = NULL;
+	return adminOperation(ownerHandle, saAisNameBorrow(objectName),
+			      operationReturnValue);
+}
+
+SaAisErrorT saImmOmAdminOperationInvoke_o3(
+    SaImmAdminOwnerHandleT ownerHandle, SaConstStringT objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout,
+    SaImmAdminOperationParamsT_2 ***returnParams)
+{
+	STUB_ENTER("saImmOmAdminOperationInvoke_o3", false);
+	if (returnParams != NULL)
+		*returnParams = NULL;
+	return adminOperation(ownerHandle, objectName, operationReturnValue);
+}
+
+SaAisErrorT saImmOmAdminOperationInvokeAsync_2(
+    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT invocation,
+    const SaNameT *objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params)
+{
+	STUB_ENTER("saImmOmAdminOperationInvokeAsync_2", false);
+	return adminOperation(ownerHandle, saAisNameBorrow(objectName), NULL);
+}
+
+SaAisErrorT saImmOmAdminOperationInvokeAsync_o3(
+    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT invocation,
+    SaConstStringT objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params)
+{
+	STUB_ENTER("saImmOmAdminOperationInvokeAsync_o3", false);
+	return adminOperation(ownerHandle, objectName, NULL);
+}
+
+/* ----------------------------------------------------------------------
+ * saImmOi
+ */
+
+SaAisErrorT saImmOiInitialize_2(SaImmOiHandleT *immOiHandle,
+				const SaImmOiCallbacksT_2 *callbacks,
+				SaVersionT *version)
+{
+	SaImmOiHandleT handle;
+
+	STUB_ENTER("saImmOiInitialize_2", false);
+	handle = handleCreate(HANDLE_OI, 0);
+	if (callbacks != NULL)
+		handleGet(handle, HANDLE_OI)->callbacks = *callbacks;
+	*immOiHandle = handle;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOiInitialize_o3(SaImmOiHandleT *immOiHandle,
+				 const SaImmOiCallbacksT_o3 *callbacks,
+				 SaVersionT *version)
+{
+	SaImmOiHandleT handle;
+	struct StubHandle *h;
+
+	STUB_ENTER("saImmOiInitialize_o3", false);
+	handle = handleCreate(HANDLE_OI, 0);
+	h = handleGet(handle, HANDLE_OI);
+	h->o3 = true;
+	if (callbacks != NULL)
+		h->callbacksO3 = *callbacks;
+	*immOiHandle = handle;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOiSelectionObjectGet(SaImmOiHandleT immOiHandle,
+				      SaSelectionObjectT *selectionObject)
+{
+	struct StubHandle *h;
+	int fd;
+
+	STUB_ENTER("saImmOiSelectionObjectGet", false);
+	pthread_rwlock_wrlock(&handleLock);
+	h = immOiHandle != 0 && immOiHandle <= nHandles
+		? handles[immOiHandle - 1]
+		: NULL;
+	if (h == NULL || h->kind != HANDLE_OI || h->epoch != epoch) {
+		pthread_rwlock_unlock(&handleLock);
+		return SA_AIS_ERR_BAD_HANDLE;
+	}
+	fd = eventFd(h);
+	pthread_rwlock_unlock(&handleLock);
+	*selectionObject = (SaSelectionObjectT)fd;
+	return SA_AIS_OK;
+}
+
+static void oiCallback(SaImmOiHandleT handle, struct StubHandle *oi,
+		       struct StubOp *event)
+{
+	SaNameT name, parent;
+	const char *parentName;
+
+	saAisNameLend(event->dn != NULL ? event->dn : "", &name);
+	switch (event->type) {
+	case OP_CREATE:
+		parentName = parentDn(event->dn);
+		saAisNameLend(parentName, &parent);
+		if (oi->o3 && oi->callbacksO3.saImmOiCcbObjectCreateCallback)
+			(void)oi->callbacksO3.saImmOiCcbObjectCreateCallback(
+			    handle, event->ccbId, event->className, event->dn,
+			    (const SaImmAttrValuesT_2 **)event->attrValues);
+		else if (!oi->o3 &&
+			 oi->callbacks.saImmOiCcbObjectCreateCallback)
+			(void)oi->callbacks.saImmOiCcbObjectCreateCallback(
+			    handle, event->ccbId, event->className,
+			    parentName[0] != '\0' ? &parent : NULL,
+			    (const SaImmAttrValuesT_2 **)event->attrValues);
+		break;
+	case OP_DELETE:
+		if (oi->o3 && oi->callbacksO3.saImmOiCcbObjectDeleteCallback)
+			(void)oi->callbacksO3.saImmOiCcbObjectDeleteCallback(
+			    handle, event->ccbId, event->dn);
+		else if (!oi->o3 &&
+			 oi->callbacks.saImmOiCcbObjectDeleteCallback)
+			(void)oi->callbacks.saImmOiCcbObjectDeleteCallback(
+			    handle, event->ccbId, &name);
+		break;
+	case OP_MODIFY:
+		if (oi->o3 && oi->callbacksO3.saImmOiCcbObjectModifyCallback)
+			(void)oi->callbacksO3.saImmOiCcbObjectModifyCallback(
+			    handle, event->ccbId, event->dn,
+			    (const SaImmAttrModificationT_2 **)event->attrMods);
+		else if (!oi->o3 &&
+			 oi->callbacks.saImmOiCcbObjectModifyCallback)
+			(void)oi->callbacks.saImmOiCcbObjectModifyCallback(
+			    handle, event->ccbId, &name,
+			    (const SaImmAttrModificationT_2 **)event->attrMods);
+		break;
+	case OP_COMPLETED:
+		if (oi->o3 && oi->callbacksO3.saImmOiCcbCompletedCallback)
+			(void)oi->callbacksO3.saImmOiCcbCompletedCallback(
+			    handle, event->ccbId);
+		else if (!oi->o3 && oi->callbacks.saImmOiCcbCompletedCallback)
+			(void)oi->callbacks.saImmOiCcbCompletedCallback(
+			    handle, event->ccbId);
+		break;
+	case OP_APPLY:
+		if (oi->o3 && oi->callbacksO3.saImmOiCcbApplyCallback)
+			oi->callbacksO3.saImmOiCcbApplyCallback(handle,
+								event->ccbId);
+		else if (!oi->o3 && oi->callbacks.saImmOiCcbApplyCallback)
+			oi->callbacks.saImmOiCcbApplyCallback(handle,
+							      event->ccbId);
+		break;
+	}
+}
+
+SaAisErrorT saImmOiDispatch(SaImmOiHandleT immOiHandle,
+			    SaDispatchFlagsT dispatchFlags)
+{
+	struct StubHandle *oi;
+	struct StubOp *event;
+	SaUint64T count;
+
+	STUB_ENTER("saImmOiDispatch", false);
+	for (;;) {
+		pthread_rwlock_wrlock(&handleLock);
+		oi = immOiHandle != 0 && immOiHandle <= nHandles
+			 ? handles[immOiHandle - 1]
+			 : NULL;
+		if (oi == NULL || oi->kind != HANDLE_OI || oi->epoch != epoch) {
+			pthread_rwlock_unlock(&handleLock);
+			return SA_AIS_ERR_BAD_HANDLE;
+		}
+		if ((event = oi->events) != NULL)
+			oi->events = event->next;
+		else if (oi->fd >= 0)
+			while (read(oi->fd, &count, sizeof(count)) > 0)
+				;
+		pthread_rwlock_unlock(&handleLock);
+		if (event == NULL)
+			return SA_AIS_OK;
+		event->next = NULL;
+		oiCallback(immOiHandle, oi, event);
+		opsFree(event);
+		if (dispatchFlags == SA_DISPATCH_ONE)
+			return SA_AIS_OK;
+	}
+}
+
+SaAisErrorT saImmOiFinalize(SaImmOiHandleT immOiHandle)
+{
+	STUB_ENTER("saImmOiFinalize", true);
+	return handleFinalize(immOiHandle, HANDLE_OI);
+}
+
+SaAisErrorT saImmOiImplementerSet(SaImmOiHandleT immOiHandle,
+				  const SaImmOiImplementerNameT implementerName)
+{
+	struct StubHandle *h;
+
+	STUB_ENTER("saImmOiImplementerSet", false);
+	if ((h = handleGet(immOiHandle, HANDLE_OI)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	if (h->implementerName != NULL)
+		return SA_AIS_ERR_EXIST;
+	h->implementerName = stubStrdup(implementerName);
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOiImplementerClear(SaImmOiHandleT immOiHandle)
+{
+	struct StubHandle *h;
+
+	STUB_ENTER("saImmOiImplementerClear", false);
+	if ((h = handleGet(immOiHandle, HANDLE_OI)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	free(h->implementerName);
+	h->implementerName = NULL;
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOiClassImplementerSet(SaImmOiHandleT immOiHandle,
+				       const SaImmClassNameT className)
+{
+	struct StubHandle *h;
+	bool exists;
+
+	STUB_ENTER("saImmOiClassImplementerSet", false);
+	if ((h = handleGet(immOiHandle, HANDLE_OI)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	if (h->implementerName == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_rdlock(&storeLock);
+	exists = classFind(className) != NULL;
+	pthread_rwlock_unlock(&storeLock);
+	if (!exists)
+		return SA_AIS_ERR_NOT_EXIST;
+	if (oiImplements(h, className))
+		return SA_AIS_OK;
+	pthread_rwlock_wrlock(&handleLock);
+	h->classNames = realloc(h->classNames,
+				(h->nClassNames + 1) * sizeof(*h->classNames));
+	if (h->classNames == NULL)
+		stubError("Out of memory");
+	h->classNames[h->nClassNames++] = stubStrdup(className);
+	pthread_rwlock_unlock(&handleLock);
+	return SA_AIS_OK;
+}
+
+SaAisErrorT saImmOiClassImplementerRelease(SaImmOiHandleT immOiHandle,
+					   const SaImmClassNameT className)
+{
+	struct StubHandle *h;
+	size_t i;
+
+	STUB_ENTER("saImmOiClassImplementerRelease", false);
+	if ((h = handleGet(immOiHandle, HANDLE_OI)) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_wrlock(&handleLock);
+	for (i = 0; i < h->nClassNames; i++) {
+		if (strcmp(h->classNames[i], className) == 0) {
+			free(h->classNames[i]);
+			h->classNames[i] = h->classNames[--h->nClassNames];
+			break;
+		}
+	}
+	pthread_rwlock_unlock(&handleLock);
+	return SA_AIS_OK;
+}
+
+#define OI_CALL(name)                                                          \
+	STUB_ENTER(name, false);                                               \
+	if (handleGet(immOiHandle, HANDLE_OI) == NULL)                         \
+		return SA_AIS_ERR_BAD_HANDLE;                                  \
+	return SA_AIS_OK
+
+SaAisErrorT saImmOiObjectImplementerSet(SaImmOiHandleT immOiHandle,
+					const SaNameT *objectName,
+					SaImmScopeT scope)
+{
+	OI_CALL("saImmOiObjectImplementerSet");
+}
+
+SaAisErrorT saImmOiObjectImplementerSet_o3(SaImmOiHandleT immOiHandle,
+					   SaConstStringT objectName,
+					   SaImmScopeT scope)
+{
+	OI_CALL("saImmOiObjectImplementerSet_o3");
+}
+
+SaAisErrorT saImmOiObjectImplementerRelease(SaImmOiHandleT immOiHandle,
+					    const SaNameT *objectName,
+					    SaImmScopeT scope)
+{
+	OI_CALL("saImmOiObjectImplementerRelease");
+}
+
+SaAisErrorT saImmOiObjectImplementerRelease_o3(SaImmOiHandleT immOiHandle,
+					       SaConstStringT objectName,
+					       SaImmScopeT scope)
+{
+	OI_CALL("saImmOiObjectImplementerRelease_o3");
+}
+
+SaAisErrorT saImmOiAdminOperationResult(SaImmOiHandleT immOiHandle,
+					SaInvocationT invocation,
+					SaAisErrorT result)
+{
+	OI_CALL("saImmOiAdminOperationResult");
+}
+
+SaAisErrorT
+saImmOiAdminOperationResult_o2(SaImmOiHandleT immOiHandle,
+			       SaInvocationT invocation, SaAisErrorT result,
+			       const SaImmAdminOperationParamsT_2 **returnParams)
+{
+	OI_CALL("saImmOiAdminOperationResult_o2");
+}
+
+SaAisErrorT saImmOiAugmentCcbInitialize(SaImmOiHandleT immOiHandle,
+					SaImmOiCcbIdT ccbId,
+					SaImmCcbHandleT *ccbHandle,
+					SaImmAdminOwnerHandleT *ownerHandle)
+{
+	SaImmHandleT om;
+
+	STUB_ENTER("saImmOiAugmentCcbInitialize", false);
+	if (handleGet(immOiHandle, HANDLE_OI) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	om = handleCreate(HANDLE_OM, 0);
+	*ownerHandle = handleCreate(HANDLE_OWNER, om);
+	*ccbHandle = handleCreate(HANDLE_CCB, om);
+	return SA_AIS_OK;
+}
+
+/* Runtime objects are changed at once */
+
+static SaAisErrorT rtObjectCreate(SaImmOiHandleT immOiHandle,
+				  const SaImmClassNameT className,
+				  const char *parent, const char *objectName,
+				  const SaImmAttrValuesT_2 **attrValues)
+{
+	struct StubClass *c;
+	SaAisErrorT rc = SA_AIS_ERR_NOT_EXIST;
+	char *dn = NULL;
+
+	if (handleGet(immOiHandle, HANDLE_OI) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_wrlock(&storeLock);
+	if ((c = classFind(className)) != NULL &&
+	    c->category == SA_IMM_CLASS_RUNTIME) {
+		dn = objectName != NULL ? stubStrdup(objectName)
+					: objectDn(c, parent, attrValues);
+		rc = dn != NULL ? objectCreate(c, dn, attrValues, true)
+				: SA_AIS_ERR_INVALID_PARAM;
+	}
+	pthread_rwlock_unlock(&storeLock);
+	free(dn);
+	return rc;
+}
+
+SaAisErrorT saImmOiRtObjectCreate_2(SaImmOiHandleT immOiHandle,
+				    const SaImmClassNameT className,
+				    const SaNameT *parentName,
+				    const SaImmAttrValuesT_2 **attrValues)
+{
+	STUB_ENTER("saImmOiRtObjectCreate_2", false);
+	return rtObjectCreate(
+	    immOiHandle, className,
+	    parentName != NULL ? saAisNameBorrow(parentName) : NULL, NULL,
+	    attrValues);
+}
+
+SaAisErrorT saImmOiRtObjectCreate_o3(SaImmOiHandleT immOiHandle,
+				     const SaImmClassNameT className,
+				     SaConstStringT objectName,
+				     const SaImmAttrValuesT_2 **attrValues)
+{
+	STUB_ENTER("saImmOiRtObjectCreate_o3", false);
+	return rtObjectCreate(immOiHandle, className, NULL, objectName,
+			      attrValues);
+}
+
+static SaAisErrorT rtObjectDelete(SaImmOiHandleT immOiHandle, const char *dn)
+{
+	struct StubObject *o;
+	SaAisErrorT rc = SA_AIS_ERR_NOT_EXIST;
+
+	if (handleGet(immOiHandle, HANDLE_OI) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_wrlock(&storeLock);
+	if ((o = objectFind(dn)) != NULL) {
+		objectDelete(o);
+		rc = SA_AIS_OK;
+	}
+	pthread_rwlock_unlock(&storeLock);
+	return rc;
+}
+
+SaAisErrorT saImmOiRtObjectDelete(SaImmOiHandleT immOiHandle,
+				  const SaNameT *objectName)
+{
+	STUB_ENTER("saImmOiRtObjectDelete", false);
+	return rtObjectDelete(immOiHandle, saAisNameBorrow(objectName));
+}
+
+SaAisErrorT saImmOiRtObjectDelete_o3(SaImmOiHandleT immOiHandle,
+				     SaConstStringT objectName)
+{
+	STUB_ENTER("saImmOiRtObjectDelete_o3", false);
+	return rtObjectDelete(immOiHandle, objectName);
+}
+
+static SaAisErrorT rtObjectUpdate(SaImmOiHandleT immOiHandle, const char *dn,
+				  const SaImmAttrModificationT_2 **attrMods)
+{
+	struct StubObject *o;
+	SaAisErrorT rc = SA_AIS_ERR_NOT_EXIST;
+
+	if (handleGet(immOiHandle, HANDLE_OI) == NULL)
+		return SA_AIS_ERR_BAD_HANDLE;
+	pthread_rwlock_wrlock(&storeLock);
+	if ((o = objectFind(dn)) != NULL)
+		rc = objectModify(o, attrMods);
+	pthread_rwlock_unlock(&storeLock);
+	return rc;
+}
+
+SaAisErrorT saImmOiRtObjectUpdate_2(SaImmOiHandleT immOiHandle,
+				    const SaNameT *objectName,
+				    const SaImmAttrModificationT_2 **attrMods)
+{
+	STUB_ENTER("saImmOiRtObjectUpdate_2", false);
+	return rtObjectUpdate(immOiHandle, saAisNameBorrow(objectName),
+			      attrMods);
+}
+
+SaAisErrorT saImmOiRtObjectUpdate_o3(SaImmOiHandleT immOiHandle,
+				     SaConstStringT objectName,
+				     const SaImmAttrModificationT_2 **attrMods)
+{
+	STUB_ENTER("saImmOiRtObjectUpdate_o3", false);
+	return rtObjectUpdate(immOiHandle, objectName, attrMods);
+}
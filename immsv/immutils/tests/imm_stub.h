@@ -0,0 +1,104 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+#ifndef IMMUTIL_TESTS_IMM_STUB_H
+#define IMMUTIL_TESTS_IMM_STUB_H
+/**
+ * @file imm_stub.h
+ * @brief An in-process IMM for the immutil tests and benchmarks.
+ *
+ *    The stub implements the saImmOm and saImmOi calls used by immutil on an
+ *    in-memory object tree, so immutil can be tested without an OpenSAF
+ *    cluster. Classes are created with saImmOmClassCreate_2, the RDN of an
+ *    object is the attribute with the SA_IMM_ATTR_RDN flag. CCB operations
+ *    are checked and made on apply. The OI callbacks of a CCB are queued for
+ *    the implementers and appliers of the classes on apply and delivered by
+ *    saImmOiDispatch, there is no validation round trip.
+ *
+ *    The functions below control the stub; they inject errors and latency,
+ *    count the calls and add objects without a CCB.
+ */
+
+#include <saImmOm.h>
+#include <saImmOi.h>
+#include <stdbool.h>
+
+/**
+ * Drop all objects, classes, handles, injected errors and call counts.
+ */
+extern void immStubReset(void);
+
+/**
+ * Make the next count calls of function return rc without doing anything.
+ * An rc of SA_AIS_OK makes the calls as usual. Calls to queue up in order,
+ * e.g. two SA_AIS_ERR_TRY_AGAIN, one SA_AIS_OK and one SA_AIS_ERR_TIMEOUT.
+ * @param function The name of the SAF call, NULL for any call.
+ */
+extern void immStubFail(const char *function, SaAisErrorT rc,
+                        unsigned int count);
+
+/**
+ * Make every call return rc until duration has passed, as during an IMM
+ * sync or a controller failover. Finalize calls are not affected.
+ */
+extern void immStubOutage(SaAisErrorT rc, SaTimeT duration);
+
+/**
+ * End an outage started with immStubOutage().
+ */
+extern void immStubOutageEnd(void);
+
+/**
+ * Add a delay to each call, to stand in for the round trip to the IMM
+ * server. The calling thread sleeps, so concurrent calls overlap.
+ */
+extern void immStubSetLatency(SaTimeT latency);
+
+/**
+ * Return the number of calls of function since the last reset, including
+ * calls that failed, or of all calls for NULL.
+ */
+extern unsigned long immStubCalls(const char *function);
+
+/**
+ * Make all handles invalid, as after an IMM restart. Calls on them return
+ * SA_AIS_ERR_BAD_HANDLE, new handles work.
+ */
+extern void immStubInvalidateHandles(void);
+
+/**
+ * Create a class with a SaStringT RDN attribute named rdnName and the
+ * given extra attribute definitions, NULL terminated or NULL. Objects get
+ * the default values of attributes not given when they are created.
+ */
+extern void immStubClassCreate(const char *className,
+                               SaImmClassCategoryT category,
+                               const char *rdnName,
+                               const SaImmAttrDefinitionT_2 **attrDefinitions);
+
+/**
+ * Create an object without a CCB and without OI callbacks. The parent must
+ * exist, attrValues need not contain the RDN.
+ * @return SA_AIS_OK, SA_AIS_ERR_EXIST or SA_AIS_ERR_NOT_EXIST.
+ */
+extern SaAisErrorT immStubObjectCreate(const char *className, const char *dn,
+                                       const SaImmAttrValuesT_2 **attrValues);
+
+/**
+ * Return the number of objects.
+ */
+extern unsigned long immStubObjects(void);
+
+#endif /* IMMUTIL_TESTS_IMM_STUB_H */
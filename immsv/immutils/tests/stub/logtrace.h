@@ -0,0 +1,30 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/* Tracing is compiled out in the immutil tests */
+
+#ifndef IMMUTIL_TESTS_STUB_LOGTRACE_H
+#define IMMUTIL_TESTS_STUB_LOGTRACE_H
+
+#define TRACE(format, ...) ((void)0)
+#define TRACE_ENTER() ((void)0)
+#define TRACE_LEAVE() ((void)0)
+#define TRACE_ENTER2(format, ...) ((void)0)
+#define TRACE_LEAVE2(format, ...) ((void)0)
+#define LOG_ER(format, ...) ((void)0)
+#define LOG_WA(format, ...) ((void)0)
+#define LOG_NO(format, ...) ((void)0)
+
+#endif /* IMMUTIL_TESTS_STUB_LOGTRACE_H */
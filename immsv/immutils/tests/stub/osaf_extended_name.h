@@ -0,0 +1,39 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2015 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The extended SaNameT functions used by immutil, implemented by the stub
+ * IMM in tests/imm_stub.c.
+ */
+
+#ifndef IMMUTIL_TESTS_STUB_OSAF_EXTENDED_NAME_H
+#define IMMUTIL_TESTS_STUB_OSAF_EXTENDED_NAME_H
+
+#include "saAis.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void osaf_extended_name_lend(SaConstStringT value, SaNameT *name);
+extern SaConstStringT osaf_extended_name_borrow(const SaNameT *name);
+extern void osaf_extended_name_clear(SaNameT *name);
+extern void osaf_extended_name_free(SaNameT *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMMUTIL_TESTS_STUB_OSAF_EXTENDED_NAME_H */
@@ -0,0 +1,161 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The subset of saImmOi.h used by immutil, for building the immutil tests
+ * against the stub IMM in tests/imm_stub.c. The types and prototypes match
+ * the SAF IMM A.02.11 headers with the OpenSAF extensions.
+ */
+
+#ifndef IMMUTIL_TESTS_STUB_SAIMMOI_H
+#define IMMUTIL_TESTS_STUB_SAIMMOI_H
+
+#include "saImmOm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef SaUint64T SaImmOiHandleT;
+typedef SaUint64T SaImmOiCcbIdT;
+typedef SaStringT SaImmOiImplementerNameT;
+
+typedef void (*SaImmOiAdminOperationCallbackT_2)(
+    SaImmOiHandleT immOiHandle, SaInvocationT invocation,
+    const SaNameT *objectName, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params);
+typedef void (*SaImmOiCcbAbortCallbackT)(SaImmOiHandleT immOiHandle,
+                                         SaImmOiCcbIdT ccbId);
+typedef void (*SaImmOiCcbApplyCallbackT)(SaImmOiHandleT immOiHandle,
+                                         SaImmOiCcbIdT ccbId);
+typedef SaAisErrorT (*SaImmOiCcbCompletedCallbackT)(SaImmOiHandleT immOiHandle,
+                                                    SaImmOiCcbIdT ccbId);
+typedef SaAisErrorT (*SaImmOiCcbObjectCreateCallbackT_2)(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId,
+    const SaImmClassNameT className, const SaNameT *parentName,
+    const SaImmAttrValuesT_2 **attr);
+typedef SaAisErrorT (*SaImmOiCcbObjectDeleteCallbackT)(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId,
+    const SaNameT *objectName);
+typedef SaAisErrorT (*SaImmOiCcbObjectModifyCallbackT_2)(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId,
+    const SaNameT *objectName, const SaImmAttrModificationT_2 **attrMods);
+typedef SaAisErrorT (*SaImmOiRtAttrUpdateCallbackT)(
+    SaImmOiHandleT immOiHandle, const SaNameT *objectName,
+    const SaImmAttrNameT *attributeNames);
+
+typedef struct {
+  SaImmOiAdminOperationCallbackT_2 saImmOiAdminOperationCallback;
+  SaImmOiCcbAbortCallbackT saImmOiCcbAbortCallback;
+  SaImmOiCcbApplyCallbackT saImmOiCcbApplyCallback;
+  SaImmOiCcbCompletedCallbackT saImmOiCcbCompletedCallback;
+  SaImmOiCcbObjectCreateCallbackT_2 saImmOiCcbObjectCreateCallback;
+  SaImmOiCcbObjectDeleteCallbackT saImmOiCcbObjectDeleteCallback;
+  SaImmOiCcbObjectModifyCallbackT_2 saImmOiCcbObjectModifyCallback;
+  SaImmOiRtAttrUpdateCallbackT saImmOiRtAttrUpdateCallback;
+} SaImmOiCallbacksT_2;
+
+typedef void (*SaImmOiAdminOperationCallbackT_o3)(
+    SaImmOiHandleT immOiHandle, SaInvocationT invocation,
+    SaConstStringT objectName, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params);
+typedef SaAisErrorT (*SaImmOiCcbObjectCreateCallbackT_o3)(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId,
+    const SaImmClassNameT className, SaConstStringT objectName,
+    const SaImmAttrValuesT_2 **attr);
+typedef SaAisErrorT (*SaImmOiCcbObjectDeleteCallbackT_o3)(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId,
+    SaConstStringT objectName);
+typedef SaAisErrorT (*SaImmOiCcbObjectModifyCallbackT_o3)(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId,
+    SaConstStringT objectName, const SaImmAttrModificationT_2 **attrMods);
+typedef SaAisErrorT (*SaImmOiRtAttrUpdateCallbackT_o3)(
+    SaImmOiHandleT immOiHandle, SaConstStringT objectName,
+    const SaImmAttrNameT *attributeNames);
+
+typedef struct {
+  SaImmOiAdminOperationCallbackT_o3 saImmOiAdminOperationCallback;
+  SaImmOiCcbAbortCallbackT saImmOiCcbAbortCallback;
+  SaImmOiCcbApplyCallbackT saImmOiCcbApplyCallback;
+  SaImmOiCcbCompletedCallbackT saImmOiCcbCompletedCallback;
+  SaImmOiCcbObjectCreateCallbackT_o3 saImmOiCcbObjectCreateCallback;
+  SaImmOiCcbObjectDeleteCallbackT_o3 saImmOiCcbObjectDeleteCallback;
+  SaImmOiCcbObjectModifyCallbackT_o3 saImmOiCcbObjectModifyCallback;
+  SaImmOiRtAttrUpdateCallbackT_o3 saImmOiRtAttrUpdateCallback;
+} SaImmOiCallbacksT_o3;
+
+extern SaAisErrorT saImmOiInitialize_2(SaImmOiHandleT *immOiHandle,
+                                       const SaImmOiCallbacksT_2 *callbacks,
+                                       SaVersionT *version);
+extern SaAisErrorT saImmOiInitialize_o3(SaImmOiHandleT *immOiHandle,
+                                        const SaImmOiCallbacksT_o3 *callbacks,
+                                        SaVersionT *version);
+extern SaAisErrorT saImmOiSelectionObjectGet(
+    SaImmOiHandleT immOiHandle, SaSelectionObjectT *selectionObject);
+extern SaAisErrorT saImmOiDispatch(SaImmOiHandleT immOiHandle,
+                                   SaDispatchFlagsT dispatchFlags);
+extern SaAisErrorT saImmOiFinalize(SaImmOiHandleT immOiHandle);
+
+extern SaAisErrorT saImmOiImplementerSet(
+    SaImmOiHandleT immOiHandle, const SaImmOiImplementerNameT implementerName);
+extern SaAisErrorT saImmOiImplementerClear(SaImmOiHandleT immOiHandle);
+extern SaAisErrorT saImmOiClassImplementerSet(SaImmOiHandleT immOiHandle,
+                                              const SaImmClassNameT className);
+extern SaAisErrorT saImmOiClassImplementerRelease(
+    SaImmOiHandleT immOiHandle, const SaImmClassNameT className);
+extern SaAisErrorT saImmOiObjectImplementerSet(SaImmOiHandleT immOiHandle,
+                                               const SaNameT *objectName,
+                                               SaImmScopeT scope);
+extern SaAisErrorT saImmOiObjectImplementerSet_o3(SaImmOiHandleT immOiHandle,
+                                                  SaConstStringT objectName,
+                                                  SaImmScopeT scope);
+extern SaAisErrorT saImmOiObjectImplementerRelease(SaImmOiHandleT immOiHandle,
+                                                   const SaNameT *objectName,
+                                                   SaImmScopeT scope);
+extern SaAisErrorT saImmOiObjectImplementerRelease_o3(
+    SaImmOiHandleT immOiHandle, SaConstStringT objectName, SaImmScopeT scope);
+
+extern SaAisErrorT saImmOiRtObjectCreate_2(
+    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
+    const SaNameT *parentName, const SaImmAttrValuesT_2 **attrValues);
+extern SaAisErrorT saImmOiRtObjectCreate_o3(
+    SaImmOiHandleT immOiHandle, const SaImmClassNameT className,
+    SaConstStringT objectName, const SaImmAttrValuesT_2 **attrValues);
+extern SaAisErrorT saImmOiRtObjectDelete(SaImmOiHandleT immOiHandle,
+                                         const SaNameT *objectName);
+extern SaAisErrorT saImmOiRtObjectDelete_o3(SaImmOiHandleT immOiHandle,
+                                            SaConstStringT objectName);
+extern SaAisErrorT saImmOiRtObjectUpdate_2(
+    SaImmOiHandleT immOiHandle, const SaNameT *objectName,
+    const SaImmAttrModificationT_2 **attrMods);
+extern SaAisErrorT saImmOiRtObjectUpdate_o3(
+    SaImmOiHandleT immOiHandle, SaConstStringT objectName,
+    const SaImmAttrModificationT_2 **attrMods);
+
+extern SaAisErrorT saImmOiAdminOperationResult(SaImmOiHandleT immOiHandle,
+                                               SaInvocationT invocation,
+                                               SaAisErrorT result);
+extern SaAisErrorT saImmOiAdminOperationResult_o2(
+    SaImmOiHandleT immOiHandle, SaInvocationT invocation, SaAisErrorT result,
+    const SaImmAdminOperationParamsT_2 **returnParams);
+extern SaAisErrorT saImmOiAugmentCcbInitialize(
+    SaImmOiHandleT immOiHandle, SaImmOiCcbIdT ccbId,
+    SaImmCcbHandleT *ccbHandle, SaImmAdminOwnerHandleT *ownerHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMMUTIL_TESTS_STUB_SAIMMOI_H */
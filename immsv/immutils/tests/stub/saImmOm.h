@@ -0,0 +1,292 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The subset of saImmOm.h used by immutil, for building the immutil tests
+ * against the stub IMM in tests/imm_stub.c. The types and prototypes match
+ * the SAF IMM A.02.11 headers with the OpenSAF extensions.
+ */
+
+#ifndef IMMUTIL_TESTS_STUB_SAIMMOM_H
+#define IMMUTIL_TESTS_STUB_SAIMMOM_H
+
+#include "saAis.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef SaUint64T SaImmHandleT;
+typedef SaUint64T SaImmAdminOwnerHandleT;
+typedef SaUint64T SaImmCcbHandleT;
+typedef SaUint64T SaImmSearchHandleT;
+typedef SaUint64T SaImmAccessorHandleT;
+
+typedef SaStringT SaImmClassNameT;
+typedef SaStringT SaImmAttrNameT;
+typedef SaStringT SaImmAdminOwnerNameT;
+
+typedef void *SaImmAttrValueT;
+
+typedef enum {
+  SA_IMM_ATTR_SAINT32T = 1,
+  SA_IMM_ATTR_SAUINT32T = 2,
+  SA_IMM_ATTR_SAINT64T = 3,
+  SA_IMM_ATTR_SAUINT64T = 4,
+  SA_IMM_ATTR_SATIMET = 5,
+  SA_IMM_ATTR_SANAMET = 6,
+  SA_IMM_ATTR_SAFLOATT = 7,
+  SA_IMM_ATTR_SADOUBLET = 8,
+  SA_IMM_ATTR_SASTRINGT = 9,
+  SA_IMM_ATTR_SAANYT = 10
+} SaImmValueTypeT;
+
+typedef enum {
+  SA_IMM_CLASS_CONFIG = 1,
+  SA_IMM_CLASS_RUNTIME = 2
+} SaImmClassCategoryT;
+
+typedef SaUint64T SaImmAttrFlagsT;
+#define SA_IMM_ATTR_MULTI_VALUE 0x00000001
+#define SA_IMM_ATTR_RDN 0x00000002
+#define SA_IMM_ATTR_CONFIG 0x00000100
+#define SA_IMM_ATTR_WRITABLE 0x00000200
+#define SA_IMM_ATTR_INITIALIZED 0x00000400
+#define SA_IMM_ATTR_RUNTIME 0x00010000
+#define SA_IMM_ATTR_PERSISTENT 0x00020000
+#define SA_IMM_ATTR_CACHED 0x00040000
+
+#define SA_IMM_ATTR_CLASS_NAME "SaImmAttrClassName"
+#define SA_IMM_ATTR_ADMIN_OWNER_NAME "SaImmAttrAdminOwnerName"
+#define SA_IMM_ATTR_IMPLEMENTER_NAME "SaImmAttrImplementerName"
+
+typedef struct {
+  SaImmAttrNameT attrName;
+  SaImmValueTypeT attrValueType;
+  SaImmAttrFlagsT attrFlags;
+  SaImmAttrValueT attrDefaultValue;
+} SaImmAttrDefinitionT_2;
+
+typedef struct {
+  SaImmAttrNameT attrName;
+  SaImmValueTypeT attrValueType;
+  SaUint32T attrValuesNumber;
+  SaImmAttrValueT *attrValues;
+} SaImmAttrValuesT_2;
+
+typedef enum {
+  SA_IMM_ATTR_VALUES_ADD = 1,
+  SA_IMM_ATTR_VALUES_DELETE = 2,
+  SA_IMM_ATTR_VALUES_REPLACE = 3
+} SaImmAttrModificationTypeT;
+
+typedef struct {
+  SaImmAttrModificationTypeT modType;
+  SaImmAttrValuesT_2 modAttr;
+} SaImmAttrModificationT_2;
+
+typedef enum {
+  SA_IMM_ONE = 1,
+  SA_IMM_SUBLEVEL = 2,
+  SA_IMM_SUBTREE = 3
+} SaImmScopeT;
+
+typedef SaUint64T SaImmSearchOptionsT;
+#define SA_IMM_SEARCH_ONE_ATTR 0x0001
+#define SA_IMM_SEARCH_GET_ALL_ATTR 0x0100
+#define SA_IMM_SEARCH_GET_NO_ATTR 0x0200
+#define SA_IMM_SEARCH_GET_SOME_ATTR 0x0400
+#define SA_IMM_SEARCH_GET_CONFIG_ATTR 0x0010
+
+typedef struct {
+  SaImmAttrNameT attrName;
+  SaImmValueTypeT attrValueType;
+  SaImmAttrValueT attrValue;
+} SaImmSearchOneAttrT_2;
+
+typedef union {
+  SaImmSearchOneAttrT_2 searchOneAttr;
+} SaImmSearchParametersT_2;
+
+typedef SaUint64T SaImmCcbFlagsT;
+#define SA_IMM_CCB_REGISTERED_OI 0x00000001
+#define SA_IMM_CCB_ALLOW_NULL_OI 0x00000100
+
+typedef SaUint64T SaImmContinuationIdT;
+typedef SaUint64T SaImmAdminOperationIdT;
+
+typedef struct {
+  SaStringT paramName;
+  SaImmValueTypeT paramType;
+  SaImmAttrValueT paramBuffer;
+} SaImmAdminOperationParamsT_2;
+
+typedef void (*SaImmOmAdminOperationInvokeCallbackT)(
+    SaInvocationT invocation, SaAisErrorT operationReturnValue,
+    SaAisErrorT error);
+
+typedef void (*SaImmOmAdminOperationInvokeCallbackT_o2)(
+    SaInvocationT invocation, SaAisErrorT operationReturnValue,
+    SaAisErrorT error, const SaImmAdminOperationParamsT_2 **returnParams);
+
+typedef struct {
+  SaImmOmAdminOperationInvokeCallbackT saImmOmAdminOperationInvokeCallback;
+} SaImmCallbacksT;
+
+typedef struct {
+  SaImmOmAdminOperationInvokeCallbackT_o2 saImmOmAdminOperationInvokeCallback;
+} SaImmCallbacksT_o2;
+
+extern SaAisErrorT saImmOmInitialize(SaImmHandleT *immHandle,
+                                     const SaImmCallbacksT *immCallbacks,
+                                     SaVersionT *version);
+extern SaAisErrorT saImmOmInitialize_o2(SaImmHandleT *immHandle,
+                                        const SaImmCallbacksT_o2 *immCallbacks,
+                                        SaVersionT *version);
+extern SaAisErrorT saImmOmSelectionObjectGet(
+    SaImmHandleT immHandle, SaSelectionObjectT *selectionObject);
+extern SaAisErrorT saImmOmDispatch(SaImmHandleT immHandle,
+                                   SaDispatchFlagsT dispatchFlags);
+extern SaAisErrorT saImmOmFinalize(SaImmHandleT immHandle);
+
+extern SaAisErrorT saImmOmClassCreate_2(
+    SaImmHandleT immHandle, const SaImmClassNameT className,
+    SaImmClassCategoryT classCategory,
+    const SaImmAttrDefinitionT_2 **attrDefinitions);
+extern SaAisErrorT saImmOmClassDescriptionGet_2(
+    SaImmHandleT immHandle, const SaImmClassNameT className,
+    SaImmClassCategoryT *classCategory,
+    SaImmAttrDefinitionT_2 ***attrDefinitions);
+extern SaAisErrorT saImmOmClassDescriptionMemoryFree_2(
+    SaImmHandleT immHandle, SaImmAttrDefinitionT_2 **attrDefinitions);
+extern SaAisErrorT saImmOmClassDelete(SaImmHandleT immHandle,
+                                      const SaImmClassNameT className);
+
+extern SaAisErrorT saImmOmSearchInitialize_2(
+    SaImmHandleT immHandle, const SaNameT *rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT searchOptions,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle);
+extern SaAisErrorT saImmOmSearchInitialize_o3(
+    SaImmHandleT immHandle, SaConstStringT rootName, SaImmScopeT scope,
+    SaImmSearchOptionsT searchOptions,
+    const SaImmSearchParametersT_2 *searchParam,
+    const SaImmAttrNameT *attributeNames, SaImmSearchHandleT *searchHandle);
+extern SaAisErrorT saImmOmSearchNext_2(SaImmSearchHandleT searchHandle,
+                                       SaNameT *objectName,
+                                       SaImmAttrValuesT_2 ***attributes);
+extern SaAisErrorT saImmOmSearchNext_o3(SaImmSearchHandleT searchHandle,
+                                        SaStringT *objectName,
+                                        SaImmAttrValuesT_2 ***attributes);
+extern SaAisErrorT saImmOmSearchFinalize(SaImmSearchHandleT searchHandle);
+
+extern SaAisErrorT saImmOmAccessorInitialize(
+    SaImmHandleT immHandle, SaImmAccessorHandleT *accessorHandle);
+extern SaAisErrorT saImmOmAccessorGet_2(SaImmAccessorHandleT accessorHandle,
+                                        const SaNameT *objectName,
+                                        const SaImmAttrNameT *attributeNames,
+                                        SaImmAttrValuesT_2 ***attributes);
+extern SaAisErrorT saImmOmAccessorGet_o3(SaImmAccessorHandleT accessorHandle,
+                                         SaConstStringT objectName,
+                                         const SaImmAttrNameT *attributeNames,
+                                         SaImmAttrValuesT_2 ***attributes);
+extern SaAisErrorT saImmOmAccessorFinalize(
+    SaImmAccessorHandleT accessorHandle);
+
+extern SaAisErrorT saImmOmAdminOwnerInitialize(
+    SaImmHandleT immHandle, const SaImmAdminOwnerNameT adminOwnerName,
+    SaBoolT releaseOwnershipOnFinalize, SaImmAdminOwnerHandleT *ownerHandle);
+extern SaAisErrorT saImmOmAdminOwnerSet(SaImmAdminOwnerHandleT ownerHandle,
+                                        const SaNameT **objectNames,
+                                        SaImmScopeT scope);
+extern SaAisErrorT saImmOmAdminOwnerSet_o3(SaImmAdminOwnerHandleT ownerHandle,
+                                           SaConstStringT *objectNames,
+                                           SaImmScopeT scope);
+extern SaAisErrorT saImmOmAdminOwnerRelease(
+    SaImmAdminOwnerHandleT ownerHandle, const SaNameT **objectNames,
+    SaImmScopeT scope);
+extern SaAisErrorT saImmOmAdminOwnerRelease_o3(
+    SaImmAdminOwnerHandleT ownerHandle, SaConstStringT *objectNames,
+    SaImmScopeT scope);
+extern SaAisErrorT saImmOmAdminOwnerFinalize(
+    SaImmAdminOwnerHandleT ownerHandle);
+extern SaAisErrorT saImmOmAdminOwnerClear(SaImmHandleT immHandle,
+                                          const SaNameT **objectNames,
+                                          SaImmScopeT scope);
+extern SaAisErrorT saImmOmAdminOwnerClear_o3(SaImmHandleT immHandle,
+                                             SaConstStringT *objectNames,
+                                             SaImmScopeT scope);
+
+extern SaAisErrorT saImmOmCcbInitialize(SaImmAdminOwnerHandleT ownerHandle,
+                                        SaImmCcbFlagsT ccbFlags,
+                                        SaImmCcbHandleT *ccbHandle);
+extern SaAisErrorT saImmOmCcbObjectCreate_2(
+    SaImmCcbHandleT ccbHandle, const SaImmClassNameT className,
+    const SaNameT *parentName, const SaImmAttrValuesT_2 **attrValues);
+extern SaAisErrorT saImmOmCcbObjectCreate_o3(
+    SaImmCcbHandleT ccbHandle, const SaImmClassNameT className,
+    SaConstStringT objectName, const SaImmAttrValuesT_2 **attrValues);
+extern SaAisErrorT saImmOmCcbObjectDelete(SaImmCcbHandleT ccbHandle,
+                                          const SaNameT *objectName);
+extern SaAisErrorT saImmOmCcbObjectDelete_o3(SaImmCcbHandleT ccbHandle,
+                                             SaConstStringT objectName);
+extern SaAisErrorT saImmOmCcbObjectModify_2(
+    SaImmCcbHandleT ccbHandle, const SaNameT *objectName,
+    const SaImmAttrModificationT_2 **attrMods);
+extern SaAisErrorT saImmOmCcbObjectModify_o3(
+    SaImmCcbHandleT ccbHandle, SaConstStringT objectName,
+    const SaImmAttrModificationT_2 **attrMods);
+extern SaAisErrorT saImmOmCcbObjectRead(SaImmCcbHandleT ccbHandle,
+                                        SaConstStringT objectName,
+                                        const SaImmAttrNameT *attributeNames,
+                                        SaImmAttrValuesT_2 ***attributes);
+extern SaAisErrorT saImmOmCcbApply(SaImmCcbHandleT ccbHandle);
+extern SaAisErrorT saImmOmCcbValidate(SaImmCcbHandleT ccbHandle);
+extern SaAisErrorT saImmOmCcbAbort(SaImmCcbHandleT ccbHandle);
+extern SaAisErrorT saImmOmCcbFinalize(SaImmCcbHandleT ccbHandle);
+
+extern SaAisErrorT saImmOmAdminOperationInvoke_2(
+    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout);
+extern SaAisErrorT saImmOmAdminOperationInvoke_o2(
+    SaImmAdminOwnerHandleT ownerHandle, const SaNameT *objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout,
+    SaImmAdminOperationParamsT_2 ***returnParams);
+extern SaAisErrorT saImmOmAdminOperationInvoke_o3(
+    SaImmAdminOwnerHandleT ownerHandle, SaConstStringT objectName,
+    SaImmContinuationIdT continuationId, SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params,
+    SaAisErrorT *operationReturnValue, SaTimeT timeout,
+    SaImmAdminOperationParamsT_2 ***returnParams);
+extern SaAisErrorT saImmOmAdminOperationInvokeAsync_2(
+    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT invocation,
+    const SaNameT *objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params);
+extern SaAisErrorT saImmOmAdminOperationInvokeAsync_o3(
+    SaImmAdminOwnerHandleT ownerHandle, SaInvocationT invocation,
+    SaConstStringT objectName, SaImmContinuationIdT continuationId,
+    SaImmAdminOperationIdT operationId,
+    const SaImmAdminOperationParamsT_2 **params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMMUTIL_TESTS_STUB_SAIMMOM_H */
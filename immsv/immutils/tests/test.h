@@ -0,0 +1,105 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+#ifndef IMMUTIL_TESTS_TEST_H
+#define IMMUTIL_TESTS_TEST_H
+/**
+ * @file test.h
+ * @brief A minimal unit test runner for immutil.
+ *
+ *    Each TEST() is run in a child process with a fresh immutil and stub IMM,
+ *    so a test may abort, e.g. through immutilError, without affecting the
+ *    others. Run "make check", or tests/immutil_test with substrings of test
+ *    names to run a subset.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imm_stub.h"
+#include "immutil.h"
+
+/* Defined in immutil.c, immutil.h leaves the declarations to the user */
+extern struct ImmutilWrapperProfile immutilWrapperProfile;
+extern ImmutilErrorFnT immutilError;
+
+typedef void (*TestFnT)(void);
+
+/**
+ * Register a test, called by the TEST() constructors.
+ */
+extern void testRegister(const char *name, TestFnT fn, const char *file);
+
+/**
+ * Fail the running test.
+ */
+extern void testFail(const char *file, int line, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4), noreturn));
+
+/**
+ * Return the monotonic time in nanoseconds.
+ */
+extern SaTimeT testNow(void);
+
+/**
+ * Create the test classes: the config class "TestConfig" with the RDN
+ * "testConfigId" and the attributes "int32" (SaInt32T), "uint32"
+ * (SaUint32T), "str" (SaStringT), "name" (SaNameT, multi-value) and "time"
+ * (SaTimeT), and the runtime class "TestRuntime" with the RDN "testRtId"
+ * and the cached attribute "counter" (SaUint64T).
+ */
+extern void testClassesCreate(void);
+
+/**
+ * Create a TestConfig object without a CCB, with the str attribute set to
+ * str if not NULL.
+ */
+extern void testObjectCreate(const char *dn, const char *str);
+
+#define TEST(name)                                                             \
+	static void name(void);                                                \
+	__attribute__((constructor)) static void name##Register(void)          \
+	{                                                                      \
+		testRegister(#name, name, __FILE__);                           \
+	}                                                                      \
+	static void name(void)
+
+#define CHECK(cond)                                                            \
+	do {                                                                   \
+		if (!(cond))                                                   \
+			testFail(__FILE__, __LINE__, "%s", #cond);             \
+	} while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+	do {                                                                   \
+		long long a_ = (long long)(a), b_ = (long long)(b);            \
+		if (a_ != b_)                                                  \
+			testFail(__FILE__, __LINE__, "%s == %s: %lld != %lld", \
+				 #a, #b, a_, b_);                              \
+	} while (0)
+
+#define CHECK_STR(a, b)                                                        \
+	do {                                                                   \
+		const char *a_ = (a), *b_ = (b);                               \
+		if (a_ == NULL || b_ == NULL || strcmp(a_, b_) != 0)           \
+			testFail(__FILE__, __LINE__,                           \
+				 "%s == %s: \"%s\" != \"%s\"", #a, #b,         \
+				 a_ != NULL ? a_ : "(null)",                   \
+				 b_ != NULL ? b_ : "(null)");                  \
+	} while (0)
+
+#endif /* IMMUTIL_TESTS_TEST_H */
@@ -0,0 +1,166 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The asynchronous executor: retries on the timer wheel without blocking,
+ * and the order of the calls on one handle.
+ */
+
+#include <poll.h>
+
+#include "test.h"
+
+#define MS(ms) ((SaTimeT)(ms)*1000000)
+
+static SaVersionT immVersion = {'A', 2, 11};
+static SaImmAttrNameT strAttr[] = {(SaImmAttrNameT) "str", NULL};
+
+struct Done {
+	unsigned int n;
+	char str[8][8];
+	struct ImmutilAsyncResult result[8];
+};
+
+static void getDone(const struct ImmutilAsyncResult *result, void *arg)
+{
+	struct Done *done = arg;
+	const char *str = NULL;
+
+	if (result->rc == SA_AIS_OK)
+		str = immutil_getStringAttr(
+		    (const SaImmAttrValuesT_2 **)result->attributes, "str", 0);
+	snprintf(done->str[done->n], sizeof(done->str[0]), "%s",
+		 str != NULL ? str : "");
+	done->result[done->n++] = *result;
+}
+
+static void asyncGet(ImmutilAsync_t *async, SaImmAccessorHandleT accessor,
+		     const char *dn, struct Done *done)
+{
+	SaNameT name;
+
+	saAisNameLend(dn, &name);
+	CHECK_EQ(immutil_asyncAccessorGet_2(async, accessor, &name, strAttr,
+					    getDone, done),
+		 SA_AIS_OK);
+}
+
+/*
+ * Poll the selection object and dispatch until nothing is pending, return
+ * the longest dispatch.
+ */
+static SaTimeT asyncRun(ImmutilAsync_t *async, SaTimeT limit)
+{
+	SaSelectionObjectT fd;
+	SaTimeT start = testNow(), longest = 0;
+
+	CHECK_EQ(immutil_asyncSelectionObjectGet(async, &fd), SA_AIS_OK);
+	while (immutil_asyncPending(async) > 0) {
+		struct pollfd pfd = {(int)fd, POLLIN, 0};
+		SaTimeT t;
+		CHECK(testNow() - start < limit);
+		if (poll(&pfd, 1, 1000) <= 0)
+			continue;
+		t = testNow();
+		CHECK_EQ(immutil_asyncDispatch(async), SA_AIS_OK);
+		t = testNow() - t;
+		if (t > longest)
+			longest = t;
+	}
+	return longest;
+}
+
+static SaImmAccessorHandleT accessorSetUp(void)
+{
+	SaImmAccessorHandleT accessor;
+	SaImmHandleT om;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	testObjectCreate("top=2", "b");
+	testObjectCreate("top=3", "c");
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	return accessor;
+}
+
+/*
+ * Through 200 ms of SA_AIS_ERR_TRY_AGAIN a dispatch only makes the calls
+ * that are due and returns, and the calls on one accessor complete in
+ * order once IMM answers.
+ */
+TEST(asyncTryAgainInOrder)
+{
+	struct ImmutilRetryProfile profile = {5, 20, 5000};
+	SaImmAccessorHandleT accessor = accessorSetUp();
+	ImmutilAsync_t *async = immutil_asyncCreate();
+	struct Done done;
+	unsigned long calls;
+	SaTimeT start, longest;
+
+	memset(&done, 0, sizeof(done));
+	immutil_setRetryProfile(IMMUTIL_RETRY_READ, &profile);
+	calls = immStubCalls("saImmOmAccessorGet_2");
+	start = testNow();
+	immStubOutage(SA_AIS_ERR_TRY_AGAIN, MS(200));
+	asyncGet(async, accessor, "top=1", &done);
+	asyncGet(async, accessor, "top=2", &done);
+	asyncGet(async, accessor, "top=3", &done);
+	CHECK_EQ(immutil_asyncPending(async), 3);
+
+	longest = asyncRun(async, MS(5000));
+	CHECK(testNow() - start >= MS(200));
+	CHECK(longest < MS(5));
+	CHECK_EQ(immutil_asyncPending(async), 0);
+	CHECK_EQ(done.n, 3);
+	CHECK_STR(done.str[0], "a");
+	CHECK_STR(done.str[1], "b");
+	CHECK_STR(done.str[2], "c");
+	CHECK_EQ(done.result[0].rc, SA_AIS_OK);
+	CHECK_EQ(done.result[1].rc, SA_AIS_OK);
+	CHECK_EQ(done.result[2].rc, SA_AIS_OK);
+
+	/* Only the first one on the handle was tried during the outage */
+	CHECK(done.result[0].tries > 1);
+	CHECK_EQ(done.result[1].tries, 1);
+	CHECK_EQ(done.result[2].tries, 1);
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2") - calls,
+		 done.result[0].tries + 2);
+	immutil_asyncDelete(async);
+}
+
+/* A call still getting SA_AIS_ERR_TRY_AGAIN at the deadline completes */
+TEST(asyncTryAgainDeadline)
+{
+	struct ImmutilRetryProfile profile = {5, 20, 100};
+	SaImmAccessorHandleT accessor = accessorSetUp();
+	ImmutilAsync_t *async = immutil_asyncCreate();
+	struct Done done;
+	SaTimeT start;
+
+	memset(&done, 0, sizeof(done));
+	immutil_setRetryProfile(IMMUTIL_RETRY_READ, &profile);
+	start = testNow();
+	immStubOutage(SA_AIS_ERR_TRY_AGAIN, MS(60000));
+	asyncGet(async, accessor, "top=1", &done);
+	CHECK(asyncRun(async, MS(5000)) < MS(5));
+	CHECK(testNow() - start >= MS(100));
+	CHECK(testNow() - start < MS(1000));
+	CHECK_EQ(done.n, 1);
+	CHECK_EQ(done.result[0].rc, SA_AIS_ERR_TRY_AGAIN);
+	CHECK(done.result[0].tries > 2);
+	CHECK_EQ(immutil_asyncPending(async), 0);
+	immutil_asyncDelete(async);
+}
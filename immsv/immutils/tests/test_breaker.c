@@ -0,0 +1,204 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The circuit breaker through an IMM outage in the stub.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "test.h"
+
+#define MS(ms) ((SaTimeT)(ms)*1000000)
+
+static SaVersionT immVersion = {'A', 2, 11};
+static SaImmHandleT om;
+static SaImmAccessorHandleT accessor;
+
+static void accessorSetUp(void)
+{
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+}
+
+static SaAisErrorT accessorGetOn(SaImmAccessorHandleT accessorHandle,
+				 const char *dn)
+{
+	SaImmAttrValuesT_2 **attrs;
+	return immutil_saImmOmAccessorGet_o2(accessorHandle, dn, NULL, &attrs);
+}
+
+static SaAisErrorT accessorGet(const char *dn)
+{
+	return accessorGetOn(accessor, dn);
+}
+
+#define THREADS 8
+#define OUTAGE MS(10000)
+
+static SaTimeT outageStart;
+
+/* A get result is only valid until the next get on the accessor */
+struct OutageThread {
+	SaImmAccessorHandleT accessor;
+	SaTimeT done;
+};
+
+static void *outageThread(void *arg)
+{
+	struct OutageThread *t = arg;
+
+	if (accessorGetOn(t->accessor, "top=1") != SA_AIS_OK)
+		testFail(__FILE__, __LINE__, "accessor get failed");
+	t->done = testNow() - outageStart;
+	return NULL;
+}
+
+/*
+ * Calls that start during a 10 s outage wait for the breaker, while only
+ * the probes reach IMM, and all succeed soon after the outage.
+ */
+TEST(breakerQueueOutage10s)
+{
+	struct ImmutilBreakerConfig config = {IMMUTIL_BREAKER_QUEUE, 5, 500,
+					      100};
+	struct ImmutilRetryProfile patient = {1, 50, 15000};
+	struct ImmutilBreakerState state;
+	pthread_t threads[THREADS];
+	struct OutageThread t[THREADS];
+	unsigned long calls;
+	int i;
+
+	accessorSetUp();
+	for (i = 0; i < THREADS; i++)
+		CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &t[i].accessor),
+			 SA_AIS_OK);
+	immutil_setRetryProfile(IMMUTIL_RETRY_READ, &patient);
+	immutil_setBreakerConfig(&config);
+	calls = immStubCalls("saImmOmAccessorGet_2");
+	outageStart = testNow();
+	immStubOutage(SA_AIS_ERR_TRY_AGAIN, OUTAGE);
+	for (i = 0; i < THREADS; i++)
+		CHECK_EQ(pthread_create(&threads[i], NULL, outageThread, &t[i]),
+			 0);
+	for (i = 0; i < THREADS; i++)
+		CHECK_EQ(pthread_join(threads[i], NULL), 0);
+
+	calls = immStubCalls("saImmOmAccessorGet_2") - calls;
+	immutil_getBreakerState(&state);
+	printf("  %lu IMM calls, %llu probes, %llu queued\n", calls,
+	       (unsigned long long)state.probes,
+	       (unsigned long long)state.queued);
+	for (i = 0; i < THREADS; i++) {
+		CHECK(t[i].done >= OUTAGE);
+		CHECK(t[i].done < OUTAGE + MS(500 + 100 + 200));
+	}
+	CHECK_EQ(state.status, IMMUTIL_BREAKER_CLOSED);
+	CHECK_EQ(state.opened, 1);
+	CHECK(state.probes >= 15 && state.probes <= 22);
+	CHECK(state.queued >= THREADS - 1);
+	/* Backoff until it opened, the probes and one try per thread */
+	CHECK(calls < 5 + THREADS + state.probes + THREADS + 10);
+}
+
+/* An open FAIL_FAST breaker returns SA_AIS_ERR_TRY_AGAIN without a call */
+TEST(breakerFailFast)
+{
+	struct ImmutilBreakerConfig config = {IMMUTIL_BREAKER_FAIL_FAST, 3,
+					      100, 0};
+	struct ImmutilBreakerState state;
+	unsigned long calls;
+	SaUint64T rejected;
+	SaTimeT start;
+
+	accessorSetUp();
+	immutilWrapperProfile.errorsAreFatal = 0;
+	immutil_setBreakerConfig(&config);
+	immStubOutage(SA_AIS_ERR_TRY_AGAIN, MS(60000));
+	CHECK_EQ(accessorGet("top=1"), SA_AIS_ERR_TRY_AGAIN);
+	immutil_getBreakerState(&state);
+	CHECK_EQ(state.status, IMMUTIL_BREAKER_OPEN);
+	rejected = state.rejected;
+
+	calls = immStubCalls(NULL);
+	start = testNow();
+	CHECK_EQ(accessorGet("top=1"), SA_AIS_ERR_TRY_AGAIN);
+	CHECK(testNow() - start < MS(5));
+	CHECK_EQ(immStubCalls(NULL), calls);
+	immutil_getBreakerState(&state);
+	CHECK_EQ(state.rejected, rejected + 1);
+}
+
+/* Only a probe that returns SA_AIS_OK closes the breaker */
+TEST(breakerClosesOnProbeOk)
+{
+	struct ImmutilBreakerConfig config = {IMMUTIL_BREAKER_FAIL_FAST, 3, 50,
+					      0};
+	struct ImmutilBreakerState state;
+
+	accessorSetUp();
+	immutilWrapperProfile.errorsAreFatal = 0;
+	immutil_setBreakerConfig(&config);
+	immStubOutage(SA_AIS_ERR_TRY_AGAIN, MS(60000));
+	CHECK_EQ(accessorGet("top=1"), SA_AIS_ERR_TRY_AGAIN);
+	immStubOutageEnd();
+
+	/* IMM answers the probe, but not with SA_AIS_OK */
+	usleep(60000);
+	CHECK_EQ(accessorGet("top=2"), SA_AIS_ERR_NOT_EXIST);
+	immutil_getBreakerState(&state);
+	CHECK_EQ(state.probes, 1);
+	CHECK_EQ(state.status, IMMUTIL_BREAKER_OPEN);
+	CHECK_EQ(accessorGet("top=1"), SA_AIS_ERR_TRY_AGAIN);
+
+	usleep(60000);
+	CHECK_EQ(accessorGet("top=1"), SA_AIS_OK);
+	immutil_getBreakerState(&state);
+	CHECK_EQ(state.probes, 2);
+	CHECK_EQ(state.status, IMMUTIL_BREAKER_CLOSED);
+	CHECK_EQ(accessorGet("top=2"), SA_AIS_ERR_NOT_EXIST);
+	CHECK_EQ(accessorGet("top=1"), SA_AIS_OK);
+}
+
+/* Internal reads on pooled handles are failed fast like the wrappers */
+TEST(breakerFailFastClassName)
+{
+	struct ImmutilBreakerConfig config = {IMMUTIL_BREAKER_FAIL_FAST, 3,
+					      100, 0};
+	unsigned long calls;
+	SaNameT name;
+	char *className;
+
+	accessorSetUp();
+	testObjectCreate("top=2", "a");
+	immutilWrapperProfile.errorsAreFatal = 0;
+	immutil_setBreakerConfig(&config);
+
+	/* Leaves a pool owned handle behind */
+	saAisNameLend("top=2", &name);
+	className = immutil_get_className(&name);
+	CHECK_STR(className, "TestConfig");
+	free(className);
+
+	immStubOutage(SA_AIS_ERR_TRY_AGAIN, MS(60000));
+	CHECK_EQ(accessorGet("top=1"), SA_AIS_ERR_TRY_AGAIN);
+	calls = immStubCalls(NULL);
+	saAisNameLend("top=1", &name);
+	CHECK(immutil_get_className(&name) == NULL);
+	CHECK_EQ(immStubCalls(NULL), calls);
+}
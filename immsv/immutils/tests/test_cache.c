@@ -0,0 +1,176 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The AccessorGet object cache: hits, invalidation by the applier and
+ * eviction.
+ */
+
+#include "test.h"
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static SaImmAttrNameT strAttr[] = {(SaImmAttrNameT) "str", NULL};
+
+/* Get the str attribute of an object through the cache */
+static const char *cachedStr(ImmutilObjectCache_t *cache, const char *dn)
+{
+	SaImmAttrValuesT_2 **attrs;
+	SaNameT name;
+
+	saAisNameLend(dn, &name);
+	if (immutil_objectCacheGet(cache, &name, strAttr, &attrs) != SA_AIS_OK)
+		return NULL;
+	return immutil_getStringAttr((const SaImmAttrValuesT_2 **)attrs, "str",
+				     0);
+}
+
+/* Apply a CCB that sets str of an object, or deletes it if str is NULL */
+static void ccbApply(const char *dn, const char *str)
+{
+	SaImmHandleT om;
+	SaImmAdminOwnerHandleT owner;
+	SaImmCcbHandleT ccb;
+	SaImmAttrValueT value = &str;
+	SaImmAttrModificationT_2 mod = {
+	    SA_IMM_ATTR_VALUES_REPLACE,
+	    {(SaImmAttrNameT) "str", SA_IMM_ATTR_SASTRINGT, 1, &value}};
+	const SaImmAttrModificationT_2 *mods[] = {&mod, NULL};
+
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAdminOwnerInitialize(om, (char *)"test",
+						     SA_TRUE, &owner),
+		 SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbInitialize(owner, 0, &ccb), SA_AIS_OK);
+	if (str != NULL)
+		CHECK_EQ(immutil_saImmOmCcbObjectModify_o2(ccb, dn, mods),
+			 SA_AIS_OK);
+	else
+		CHECK_EQ(immutil_saImmOmCcbObjectDelete_o2(ccb, dn), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbApply(ccb), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+}
+
+/* An object is cached once the applier watches its class */
+TEST(objectCacheHit)
+{
+	struct ImmutilObjectCacheStats stats;
+	ImmutilObjectCache_t *cache;
+	unsigned long reads;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	CHECK_EQ(immutil_objectCacheCreate("cacheTest", 0, 0, &cache),
+		 SA_AIS_OK);
+	CHECK_STR(cachedStr(cache, "top=1"), "a");
+	CHECK_STR(cachedStr(cache, "top=1"), "a");
+	reads = immStubCalls("saImmOmAccessorGet_2");
+	CHECK_STR(cachedStr(cache, "top=1"), "a");
+	CHECK_STR(cachedStr(cache, "top=1"), "a");
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2"), reads);
+
+	immutil_objectCacheGetStats(cache, &stats);
+	CHECK_EQ(stats.hits, 2);
+	CHECK_EQ(stats.misses, 2);
+	CHECK_EQ(stats.objects, 1);
+	CHECK(stats.bytes > 0);
+	CHECK(stats.hitAgeMax > 0);
+	immutil_objectCacheDelete(cache);
+}
+
+/* An applied CCB drops the modified and deleted objects on dispatch */
+TEST(objectCacheInvalidatedByApplier)
+{
+	struct ImmutilObjectCacheStats stats;
+	ImmutilObjectCache_t *cache;
+	SaImmAttrValuesT_2 **attrs;
+	SaNameT name;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	testObjectCreate("top=2", "a");
+	CHECK_EQ(immutil_objectCacheCreate("cacheTest", 0, 0, &cache),
+		 SA_AIS_OK);
+	CHECK_STR(cachedStr(cache, "top=1"), "a");
+	CHECK_STR(cachedStr(cache, "top=1"), "a");
+	CHECK_STR(cachedStr(cache, "top=2"), "a");
+
+	/* Stale until the apply callback is dispatched */
+	ccbApply("top=1", "b");
+	CHECK_STR(cachedStr(cache, "top=1"), "a");
+	CHECK_EQ(immutil_objectCacheDispatch(cache), SA_AIS_OK);
+	CHECK_STR(cachedStr(cache, "top=1"), "b");
+	immutil_objectCacheGetStats(cache, &stats);
+	CHECK(stats.invalidations > 0);
+
+	/* Cached again after the read */
+	CHECK_STR(cachedStr(cache, "top=1"), "b");
+	immutil_objectCacheGetStats(cache, &stats);
+	CHECK_EQ(stats.hits, 2);
+
+	ccbApply("top=2", NULL);
+	CHECK_EQ(immutil_objectCacheDispatch(cache), SA_AIS_OK);
+	saAisNameLend("top=2", &name);
+	CHECK_EQ(immutil_objectCacheGet(cache, &name, strAttr, &attrs),
+		 SA_AIS_ERR_NOT_EXIST);
+	immutil_objectCacheDelete(cache);
+}
+
+/* The cache stays within maxBytes, evicted objects are read again */
+TEST(objectCacheEviction)
+{
+	struct ImmutilObjectCacheStats stats;
+	ImmutilObjectCache_t *cache;
+	size_t maxBytes;
+	unsigned long reads;
+	char dn[32];
+	int i;
+
+	testClassesCreate();
+	for (i = 0; i < 64; i++) {
+		snprintf(dn, sizeof(dn), "top=%d", i);
+		testObjectCreate(dn, dn);
+	}
+
+	/* The size of one object */
+	CHECK_EQ(immutil_objectCacheCreate("cacheTest", 0, 0, &cache),
+		 SA_AIS_OK);
+	CHECK_STR(cachedStr(cache, "top=0"), "top=0");
+	CHECK_STR(cachedStr(cache, "top=0"), "top=0");
+	immutil_objectCacheGetStats(cache, &stats);
+	CHECK_EQ(stats.objects, 1);
+	maxBytes = 8 * stats.bytes;
+	immutil_objectCacheDelete(cache);
+
+	CHECK_EQ(immutil_objectCacheCreate("cacheTest", maxBytes, 0, &cache),
+		 SA_AIS_OK);
+	CHECK_STR(cachedStr(cache, "top=0"), "top=0");
+	for (i = 0; i < 64; i++) {
+		snprintf(dn, sizeof(dn), "top=%d", i);
+		CHECK_STR(cachedStr(cache, dn), dn);
+		immutil_objectCacheGetStats(cache, &stats);
+		CHECK(stats.bytes <= maxBytes);
+	}
+	CHECK(stats.evictions >= 56);
+	CHECK(stats.objects <= 8);
+
+	/* The most recent object is still cached, the first one not */
+	reads = immStubCalls("saImmOmAccessorGet_2");
+	CHECK_STR(cachedStr(cache, "top=63"), "top=63");
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2"), reads);
+	CHECK_STR(cachedStr(cache, "top=0"), "top=0");
+	CHECK(immStubCalls("saImmOmAccessorGet_2") > reads);
+	immutil_objectCacheDelete(cache);
+}
@@ -0,0 +1,216 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The CCB store: the DN index and concurrent use.
+ */
+
+#include "test.h"
+#include <pthread.h>
+
+static const SaImmAttrModificationT_2 *noMods[] = {NULL};
+
+TEST(ccbOpByDnMultiple)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	CcbUtilOperationData_t *op;
+	SaNameT a, b;
+
+	saAisNameLend("safSu=a,safSg=1", &a);
+	saAisNameLend("safSu=b,safSg=1", &b);
+	ccbutil_ccbAddModifyOperation(ccb, &a, noMods);
+	ccbutil_ccbAddModifyOperation(ccb, &b, noMods);
+	ccbutil_ccbAddDeleteOperation(ccb, &a);
+	op = ccbutil_getCcbOpDataByDN(1, &a);
+	CHECK(op != NULL);
+	CHECK_EQ(op->operationType, CCBUTIL_MODIFY);
+	op = ccbutil_getNextCcbOpByDN(op);
+	CHECK(op != NULL);
+	CHECK_EQ(op->operationType, CCBUTIL_DELETE);
+	CHECK(ccbutil_getNextCcbOpByDN(op) == NULL);
+	op = ccbutil_getCcbOpDataByDN(1, &b);
+	CHECK(op != NULL && ccbutil_getNextCcbOpByDN(op) == NULL);
+	ccbutil_deleteCcbData(ccb);
+}
+
+/* A create without object name is indexed on parent and RDN attribute */
+TEST(ccbOpByDnCreateRdn)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	const char *rdn = "safSu=a";
+	SaImmAttrValueT rdnValue = &rdn;
+	SaImmAttrValuesT_2 rdnAttr = {(SaImmAttrNameT) "safSu",
+				      SA_IMM_ATTR_SASTRINGT, 1, &rdnValue};
+	const SaImmAttrValuesT_2 *attrs[] = {&rdnAttr, NULL};
+	CcbUtilOperationData_t *create, *op;
+	SaNameT parent, name, top;
+
+	saAisNameLend("safSg=1", &parent);
+	saAisNameLend("safSu=a,safSg=1", &name);
+	saAisNameLend("safSu=a", &top);
+	create = ccbutil_ccbAddCreateOperation(ccb, (SaImmClassNameT) "SaAmfSU",
+					       &parent, attrs);
+	CHECK_STR(saAisNameBorrow(&create->objectName), "");
+	ccbutil_ccbAddModifyOperation(ccb, &name, noMods);
+	op = ccbutil_getCcbOpDataByDN(1, &name);
+	CHECK(op == create);
+	op = ccbutil_getNextCcbOpByDN(op);
+	CHECK(op != NULL);
+	CHECK_EQ(op->operationType, CCBUTIL_MODIFY);
+
+	/* A top level object */
+	create = ccbutil_ccbAddCreateOperation(ccb, (SaImmClassNameT) "SaAmfSU",
+					       NULL, attrs);
+	CHECK(ccbutil_getCcbOpDataByDN(1, &top) == create);
+	ccbutil_deleteCcbData(ccb);
+}
+
+/* Without RDN attribute a create is found once the user has named it */
+TEST(ccbOpByDnCreateNamedLater)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	const char *value = "no rdn";
+	SaImmAttrValueT values[] = {&value};
+	SaImmAttrValuesT_2 attr = {(SaImmAttrNameT) "safSu",
+				   SA_IMM_ATTR_SASTRINGT, 1, values};
+	const SaImmAttrValuesT_2 *attrs[] = {&attr, NULL};
+	CcbUtilOperationData_t *create, *other, *op;
+	SaNameT parent, name, empty;
+
+	saAisNameLend("safSg=1", &parent);
+	saAisNameLend("safSu=a,safSg=1", &name);
+	saAisNameLend("", &empty);
+	ccbutil_ccbAddDeleteOperation(ccb, &name);
+	create = ccbutil_ccbAddCreateOperation(ccb, (SaImmClassNameT) "SaAmfSU",
+					       &parent, attrs);
+	other = ccbutil_ccbAddCreateOperation(ccb, (SaImmClassNameT) "SaAmfSU",
+					      &parent, attrs);
+	ccbutil_ccbAddModifyOperation(ccb, &name, noMods);
+	CHECK(ccbutil_getCcbOpDataByDN(1, &empty) == create);
+
+	saAisNameLend("safSu=a,safSg=1", &create->objectName);
+	op = ccbutil_getCcbOpDataByDN(1, &name);
+	CHECK(op != NULL);
+	CHECK_EQ(op->operationType, CCBUTIL_DELETE);
+	op = ccbutil_getNextCcbOpByDN(op);
+	CHECK(op == create);
+	op = ccbutil_getNextCcbOpByDN(op);
+	CHECK(op != NULL);
+	CHECK_EQ(op->operationType, CCBUTIL_MODIFY);
+	CHECK(ccbutil_getNextCcbOpByDN(op) == NULL);
+
+	/* The other one is still found on "" */
+	op = ccbutil_getCcbOpDataByDN(1, &empty);
+	CHECK(op == other);
+	CHECK(ccbutil_getNextCcbOpByDN(op) == NULL);
+	ccbutil_ccbAddCreateOperation(ccb, (SaImmClassNameT) "SaAmfSU",
+				      &parent, attrs);
+	CHECK(ccbutil_getNextCcbOpByDN(other) != NULL);
+	ccbutil_deleteCcbData(ccb);
+}
+
+/*
+ * 16 threads create, fill and delete CCBs of their own, append to CCBs
+ * shared by all threads and walk them while the others append.
+ */
+
+#define STRESS_THREADS 16
+#define STRESS_ROUNDS 2000
+#define STRESS_SHARED 4
+
+static void *stressThread(void *arg)
+{
+	unsigned long t = (unsigned long)arg;
+	const char *str = "value";
+	SaImmAttrValueT values[] = {&str};
+	SaImmAttrValuesT_2 attr = {(SaImmAttrNameT) "attr",
+				   SA_IMM_ATTR_SASTRINGT, 1, values};
+	SaImmAttrModificationT_2 mod = {SA_IMM_ATTR_VALUES_REPLACE, attr};
+	const SaImmAttrModificationT_2 *mods[] = {&mod, NULL};
+	char dn[64];
+	SaNameT name;
+	unsigned long i;
+
+	snprintf(dn, sizeof(dn), "thread=%lu", t);
+	saAisNameLend(dn, &name);
+	for (i = 0; i < STRESS_ROUNDS; i++) {
+		SaImmOiCcbIdT own = 1000 + t * STRESS_ROUNDS + i;
+		SaImmOiCcbIdT shared = 1 + i % STRESS_SHARED;
+		struct CcbUtilCcbData *ccb = ccbutil_getCcbData(own);
+		CcbUtilOperationData_t *op = NULL;
+		unsigned int n = 0;
+
+		if (ccbutil_findCcbData(own) != ccb)
+			testFail(__FILE__, __LINE__, "own CCB not found");
+		ccbutil_ccbAddModifyOperation(ccb, &name, mods);
+		ccbutil_ccbAddDeleteOperation(ccb, &name);
+		if (ccbutil_getCcbOpDataByDN(own, &name) == NULL)
+			testFail(__FILE__, __LINE__, "own op not found");
+		ccbutil_deleteCcbData(ccb);
+
+		ccbutil_ccbAddModifyOperation(ccbutil_getCcbData(shared),
+					      &name, mods);
+		while ((op = ccbutil_getNextCcbOp(shared, op)) != NULL) {
+			if (op->operationType != CCBUTIL_MODIFY ||
+			    strncmp(saAisNameBorrow(&op->objectName),
+				    "thread=", 7) != 0 ||
+			    op->param.modify.attrMods[0] == NULL)
+				testFail(__FILE__, __LINE__, "bad operation");
+			n++;
+		}
+		if (n == 0)
+			testFail(__FILE__, __LINE__, "shared CCB empty");
+	}
+	return NULL;
+}
+
+TEST(ccbStress16Threads)
+{
+	pthread_t threads[STRESS_THREADS];
+	unsigned long t, total = 0;
+	SaImmOiCcbIdT id;
+
+	for (t = 0; t < STRESS_THREADS; t++)
+		CHECK_EQ(pthread_create(&threads[t], NULL, stressThread,
+					(void *)t),
+			 0);
+	for (t = 0; t < STRESS_THREADS; t++)
+		CHECK_EQ(pthread_join(threads[t], NULL), 0);
+
+	for (t = 0; t < STRESS_THREADS * STRESS_ROUNDS; t++)
+		CHECK(ccbutil_findCcbData(1000 + t) == NULL);
+	for (id = 1; id <= STRESS_SHARED; id++) {
+		CcbUtilOperationData_t *op = NULL;
+		while ((op = ccbutil_getNextCcbOp(id, op)) != NULL)
+			total++;
+	}
+	CHECK_EQ(total, STRESS_THREADS * STRESS_ROUNDS);
+	for (t = 0; t < STRESS_THREADS; t++) {
+		CcbUtilOperationData_t *op;
+		char dn[64];
+		SaNameT name;
+		unsigned long n = 0;
+		snprintf(dn, sizeof(dn), "thread=%lu", t);
+		saAisNameLend(dn, &name);
+		for (id = 1; id <= STRESS_SHARED; id++)
+			for (op = ccbutil_getCcbOpDataByDN(id, &name);
+			     op != NULL; op = ccbutil_getNextCcbOpByDN(op))
+				n++;
+		CHECK_EQ(n, STRESS_ROUNDS);
+	}
+	for (id = 1; id <= STRESS_SHARED; id++)
+		ccbutil_deleteCcbData(ccbutil_findCcbData(id));
+	CHECK(ccbutil_EmptyCcbExists());
+}
@@ -0,0 +1,142 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * Class name lookup with the pooled OM handles and the class name cache.
+ */
+
+#include <pthread.h>
+
+#include "test.h"
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static char *className(const char *dn)
+{
+	SaNameT name;
+
+	saAisNameLend(dn, &name);
+	return immutil_get_className(&name);
+}
+
+TEST(classNameNotExist)
+{
+	char *name;
+
+	testClassesCreate();
+	testObjectCreate("top=1", NULL);
+	CHECK(className("top=2") == NULL);
+	name = className("top=1");
+	CHECK_STR(name, "TestConfig");
+	free(name);
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2"), 2);
+
+	/* Found in the cache */
+	name = className("top=1");
+	CHECK_STR(name, "TestConfig");
+	free(name);
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2"), 2);
+}
+
+static void *classNameThread(void *arg)
+{
+	free(className(arg));
+	return NULL;
+}
+
+/*
+ * After SA_AIS_ERR_BAD_HANDLE all idle pool owned handles are finalized,
+ * also those behind a caller's handle in the pool, so the retry with new
+ * handles succeeds.
+ */
+TEST(classNameBadHandlePurgesPool)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	pthread_t threads[2];
+	SaImmHandleT om;
+	SaNameT name;
+	char *cname;
+
+	testClassesCreate();
+	testObjectCreate("top=1", NULL);
+	testObjectCreate("top=2", NULL);
+	testObjectCreate("top=3", NULL);
+	testObjectCreate("top=4", NULL);
+
+	/* Two pool owned entries, by two concurrent lookups */
+	immStubSetLatency(20000000);
+	CHECK_EQ(pthread_create(&threads[0], NULL, classNameThread,
+				(void *)"top=1"),
+		 0);
+	CHECK_EQ(pthread_create(&threads[1], NULL, classNameThread,
+				(void *)"top=2"),
+		 0);
+	CHECK_EQ(pthread_join(threads[0], NULL), 0);
+	CHECK_EQ(pthread_join(threads[1], NULL), 0);
+	immStubSetLatency(0);
+	CHECK_EQ(immStubCalls("saImmOmInitialize"), 2);
+
+	/* An entry for the caller's handle in front of them */
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	saAisNameLend("top=3", &name);
+	CHECK_STR(immutil_getClassName(ccb, om, &name), "TestConfig");
+
+	immStubInvalidateHandles();
+	cname = className("top=4");
+	CHECK_STR(cname, "TestConfig");
+	free(cname);
+	CHECK_EQ(immStubCalls("saImmOmInitialize"), 4);
+	ccbutil_deleteCcbData(ccb);
+}
+
+/*
+ * Entries on caller handles that were finalized since do not take up the
+ * room of the pool owned ones.
+ */
+TEST(classNameCallerHandlesEvicted)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	unsigned long inits;
+	SaImmHandleT om;
+	SaNameT name;
+	char dn[32];
+	char *cname;
+	int i;
+
+	testClassesCreate();
+	for (i = 0; i < 40; i++) {
+		snprintf(dn, sizeof(dn), "top=%d", i);
+		testObjectCreate(dn, NULL);
+	}
+	for (i = 0; i < 20; i++) {
+		CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion),
+			 SA_AIS_OK);
+		snprintf(dn, sizeof(dn), "top=%d", i);
+		saAisNameLend(dn, &name);
+		CHECK_STR(immutil_getClassName(ccb, om, &name), "TestConfig");
+		CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+	}
+
+	/* One pool owned handle serves all sequential lookups */
+	inits = immStubCalls("saImmOmInitialize");
+	for (i = 20; i < 40; i++) {
+		snprintf(dn, sizeof(dn), "top=%d", i);
+		cname = className(dn);
+		CHECK_STR(cname, "TestConfig");
+		free(cname);
+	}
+	CHECK_EQ(immStubCalls("saImmOmInitialize"), inits + 1);
+	ccbutil_deleteCcbData(ccb);
+}
@@ -0,0 +1,220 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * Modify coalescing: a coalesced CCB must leave the objects as the same CCB
+ * does uncoalesced.
+ */
+
+#include "test.h"
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static const char *dn = "testConfigId=1";
+
+/* A modification of "name" (multi-value) or "int32" */
+struct Step {
+	SaImmAttrModificationTypeT modType;
+	const char *attrName;
+	const char *values[3];
+};
+
+static const struct Step steps[] = {
+    {SA_IMM_ATTR_VALUES_ADD, "name", {"z"}},
+    {SA_IMM_ATTR_VALUES_DELETE, "name", {"x", "w"}},
+    {SA_IMM_ATTR_VALUES_ADD, "name", {"x", "v"}},
+    {SA_IMM_ATTR_VALUES_REPLACE, "int32", {"1"}},
+    {SA_IMM_ATTR_VALUES_DELETE, "name", {"v"}},
+    {SA_IMM_ATTR_VALUES_REPLACE, "int32", {"2"}},
+    {SA_IMM_ATTR_VALUES_ADD, "name", {"c"}},
+    {SA_IMM_ATTR_VALUES_DELETE, "name", {"a"}},
+    {SA_IMM_ATTR_VALUES_ADD, "name", {"a", "d"}},
+    {SA_IMM_ATTR_VALUES_DELETE, "name", {"d", "c"}},
+};
+
+#define NSTEPS (sizeof(steps) / sizeof(steps[0]))
+
+struct StepMod {
+	SaNameT names[3];
+	SaInt32T int32;
+	SaImmAttrValueT values[3];
+	SaImmAttrModificationT_2 mod;
+	const SaImmAttrModificationT_2 *mods[2];
+};
+
+static const SaImmAttrModificationT_2 **stepMods(const struct Step *step,
+						 struct StepMod *m)
+{
+	SaUint32T n = 0;
+
+	memset(m, 0, sizeof(*m));
+	for (n = 0; n < 3 && step->values[n] != NULL; n++) {
+		if (strcmp(step->attrName, "int32") == 0) {
+			m->int32 = atoi(step->values[n]);
+			m->values[n] = &m->int32;
+		} else {
+			saAisNameLend(step->values[n], &m->names[n]);
+			m->values[n] = &m->names[n];
+		}
+	}
+	m->mod.modType = step->modType;
+	m->mod.modAttr.attrName = (SaImmAttrNameT)step->attrName;
+	m->mod.modAttr.attrValueType = strcmp(step->attrName, "int32") == 0
+					   ? SA_IMM_ATTR_SAINT32T
+					   : SA_IMM_ATTR_SANAMET;
+	m->mod.modAttr.attrValuesNumber = n;
+	m->mod.modAttr.attrValues = m->values;
+	m->mods[0] = &m->mod;
+	m->mods[1] = NULL;
+	return m->mods;
+}
+
+static int nameCmp(const void *a, const void *b)
+{
+	return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* The object as "int32=<v> name=<sorted values>" */
+static void objectState(SaImmHandleT om, char *buf, size_t size)
+{
+	SaImmAccessorHandleT accessor;
+	SaImmAttrValuesT_2 **attrs;
+	const SaImmAttrValuesT_2 *name = NULL;
+	const char *values[16];
+	SaInt32T int32 = 0;
+	SaUint32T i;
+	int len;
+
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorGet_o2(accessor, dn, NULL, &attrs),
+		 SA_AIS_OK);
+	(void)immutil_getAttr("int32", (const SaImmAttrValuesT_2 **)attrs, 0,
+			      &int32);
+	for (i = 0; attrs[i] != NULL; i++) {
+		if (strcmp(attrs[i]->attrName, "name") == 0)
+			name = attrs[i];
+	}
+	CHECK(name != NULL && name->attrValuesNumber <= 16);
+	for (i = 0; i < name->attrValuesNumber; i++)
+		values[i] = saAisNameBorrow((SaNameT *)name->attrValues[i]);
+	qsort(values, name->attrValuesNumber, sizeof(values[0]), nameCmp);
+	len = snprintf(buf, size, "int32=%d name=", int32);
+	for (i = 0; i < name->attrValuesNumber; i++)
+		len += snprintf(buf + len, size - len, "%s,", values[i]);
+	CHECK_EQ(immutil_saImmOmAccessorFinalize(accessor), SA_AIS_OK);
+}
+
+/*
+ * Run the steps through the CCB store and apply the resulting operations
+ * to an object with the names x and y.
+ */
+static void runSteps(bool coalesce, unsigned int *ops, char *buf,
+		     size_t size)
+{
+	static const struct Step init = {SA_IMM_ATTR_VALUES_REPLACE,
+					 "name",
+					 {"x", "y"}};
+	struct StepMod stepMod[NSTEPS], initMod;
+	SaImmHandleT om;
+	SaImmAdminOwnerHandleT owner;
+	SaImmCcbHandleT ccbHandle;
+	struct CcbUtilCcbData *ccb;
+	CcbUtilOperationData_t *op = NULL;
+	SaNameT name;
+	size_t i;
+
+	immStubReset();
+	testClassesCreate();
+	testObjectCreate(dn, NULL);
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAdminOwnerInitialize(om, (char *)"test",
+						     SA_TRUE, &owner),
+		 SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbInitialize(owner, 0, &ccbHandle), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbObjectModify_o2(ccbHandle, dn,
+						   stepMods(&init, &initMod)),
+		 SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbApply(ccbHandle), SA_AIS_OK);
+
+	ccbutil_setModifyCoalescing(coalesce);
+	ccb = ccbutil_getCcbData(1);
+	saAisNameLend(dn, &name);
+	for (i = 0; i < NSTEPS; i++)
+		CHECK_EQ(ccbutil_ccbAddModifyOperation(
+			     ccb, &name, stepMods(&steps[i], &stepMod[i])),
+			 0);
+	*ops = 0;
+	while ((op = ccbutil_getNextCcbOp(1, op)) != NULL) {
+		CHECK_EQ(immutil_saImmOmCcbObjectModify_o2(
+			     ccbHandle, dn, op->param.modify.attrMods),
+			 SA_AIS_OK);
+		(*ops)++;
+	}
+	CHECK_EQ(immutil_saImmOmCcbApply(ccbHandle), SA_AIS_OK);
+	ccbutil_deleteCcbData(ccb);
+	ccbutil_setModifyCoalescing(false);
+
+	objectState(om, buf, size);
+	CHECK_EQ(immutil_saImmOmCcbFinalize(ccbHandle), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAdminOwnerFinalize(owner), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+}
+
+TEST(coalesceEquivalent)
+{
+	char plain[256], coalesced[256];
+	unsigned int plainOps, coalescedOps;
+
+	runSteps(false, &plainOps, plain, sizeof(plain));
+	runSteps(true, &coalescedOps, coalesced, sizeof(coalesced));
+	CHECK_EQ(plainOps, NSTEPS);
+	CHECK_EQ(coalescedOps, 1);
+	CHECK_STR(coalesced, plain);
+	CHECK_STR(plain, "int32=2 name=a,x,y,z,");
+}
+
+/* A merge must not change the attrMods array a reader already has */
+TEST(coalesceKeepsPublishedMods)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(1);
+	struct StepMod m1, m2;
+	const SaImmAttrModificationT_2 **before;
+	const SaImmAttrModificationT_2 *first;
+	SaImmAttrModificationT_2 copy;
+	CcbUtilOperationData_t *op;
+	SaNameT name;
+
+	ccbutil_setModifyCoalescing(true);
+	saAisNameLend(dn, &name);
+	ccbutil_ccbAddModifyOperation(ccb, &name, stepMods(&steps[0], &m1));
+	ccbutil_ccbAddModifyOperation(ccb, &name, stepMods(&steps[2], &m2));
+	op = ccbutil_getNextCcbOp(1, NULL);
+	before = op->param.modify.attrMods;
+	first = before[0];
+	copy = *first;
+	CHECK(before[1] == NULL);
+	CHECK_EQ(copy.modAttr.attrValuesNumber, 3);
+
+	ccbutil_ccbAddModifyOperation(ccb, &name, stepMods(&steps[1], &m1));
+	CHECK(ccbutil_getNextCcbOp(1, op) == NULL);
+	CHECK(op->param.modify.attrMods != before);
+	CHECK(before[0] == first && before[1] == NULL);
+	CHECK_EQ(first->modType, copy.modType);
+	CHECK_EQ(first->modAttr.attrValuesNumber, 3);
+	CHECK(first->modAttr.attrValues == copy.modAttr.attrValues);
+	CHECK_STR(saAisNameBorrow((SaNameT *)first->modAttr.attrValues[2]),
+		  "v");
+	ccbutil_deleteCcbData(ccb);
+}
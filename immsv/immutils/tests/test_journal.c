@@ -0,0 +1,227 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The CCB journal: a compacted journal must replay to the same objects as
+ * the journal it was compacted from.
+ */
+
+#include <unistd.h>
+
+#include "test.h"
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static const char *dn = "testDefaultId=1,top=1";
+
+/* A class where "name" has the default value "dflt" */
+static void defaultClassCreate(void)
+{
+	static SaNameT dflt;
+	SaImmAttrDefinitionT_2 str = {(SaImmAttrNameT) "str",
+				      SA_IMM_ATTR_SASTRINGT,
+				      SA_IMM_ATTR_CONFIG | SA_IMM_ATTR_WRITABLE,
+				      NULL};
+	SaImmAttrDefinitionT_2 name = {
+	    (SaImmAttrNameT) "name", SA_IMM_ATTR_SANAMET,
+	    SA_IMM_ATTR_CONFIG | SA_IMM_ATTR_WRITABLE | SA_IMM_ATTR_MULTI_VALUE,
+	    &dflt};
+	const SaImmAttrDefinitionT_2 *defs[] = {&str, &name, NULL};
+
+	saAisNameLend("dflt", &dflt);
+	testClassesCreate();
+	immStubClassCreate("TestDefault", SA_IMM_CLASS_CONFIG, "testDefaultId",
+			   defs);
+	testObjectCreate("top=1", NULL);
+}
+
+static const SaImmAttrModificationT_2 **
+modsMake(SaImmAttrModificationT_2 mods[2],
+	 const SaImmAttrModificationT_2 *attrMods[3], const char **str,
+	 SaImmAttrValueT *strValue, SaNameT *name, SaImmAttrValueT *nameValue)
+{
+	*strValue = str;
+	*nameValue = name;
+	mods[0].modType = SA_IMM_ATTR_VALUES_REPLACE;
+	mods[0].modAttr = (SaImmAttrValuesT_2){
+	    (SaImmAttrNameT) "str", SA_IMM_ATTR_SASTRINGT, 1, strValue};
+	mods[1].modType = SA_IMM_ATTR_VALUES_ADD;
+	mods[1].modAttr = (SaImmAttrValuesT_2){
+	    (SaImmAttrNameT) "name", SA_IMM_ATTR_SANAMET, 1, nameValue};
+	attrMods[0] = &mods[0];
+	attrMods[1] = &mods[1];
+	attrMods[2] = NULL;
+	return attrMods;
+}
+
+/*
+ * Journal a CCB creating the object with str "a" and setting str to "b" and
+ * adding "x" to name, and a CCB setting str to "c" and adding "y".
+ */
+static void journalWrite(CcbUtilJournal_t *journal)
+{
+	const char *a = "a", *rdn = "testDefaultId=1", *b = "b", *c = "c";
+	SaImmAttrValueT aValue = &a, rdnValue = &rdn, strValue, nameValue;
+	SaImmAttrValuesT_2 str = {(SaImmAttrNameT) "str",
+				  SA_IMM_ATTR_SASTRINGT, 1, &aValue};
+	SaImmAttrValuesT_2 rdnAttr = {(SaImmAttrNameT) "testDefaultId",
+				      SA_IMM_ATTR_SASTRINGT, 1, &rdnValue};
+	const SaImmAttrValuesT_2 *attrs[] = {&rdnAttr, &str, NULL};
+	SaImmAttrModificationT_2 mods[2];
+	const SaImmAttrModificationT_2 *attrMods[3];
+	struct CcbUtilCcbData *ccb;
+	SaNameT parent, name, x, y;
+
+	saAisNameLend("top=1", &parent);
+	saAisNameLend(dn, &name);
+	saAisNameLend("x", &x);
+	saAisNameLend("y", &y);
+	ccb = ccbutil_getCcbData(1);
+	ccbutil_ccbAddCreateOperation_2(ccb, &name,
+					(SaImmClassNameT) "TestDefault",
+					&parent, attrs);
+	ccbutil_ccbAddModifyOperation(
+	    ccb, &name, modsMake(mods, attrMods, &b, &strValue, &x, &nameValue));
+	CHECK_EQ(ccbutil_journalAppend(journal, ccb), 0);
+	ccbutil_deleteCcbData(ccb);
+
+	ccb = ccbutil_getCcbData(2);
+	ccbutil_ccbAddModifyOperation(
+	    ccb, &name, modsMake(mods, attrMods, &c, &strValue, &y, &nameValue));
+	CHECK_EQ(ccbutil_journalAppend(journal, ccb), 0);
+	ccbutil_deleteCcbData(ccb);
+}
+
+static void journalDelete(CcbUtilJournal_t *journal)
+{
+	struct CcbUtilCcbData *ccb = ccbutil_getCcbData(3);
+	SaNameT name;
+
+	saAisNameLend(dn, &name);
+	ccbutil_ccbAddDeleteOperation(ccb, &name);
+	CHECK_EQ(ccbutil_journalAppend(journal, ccb), 0);
+	ccbutil_deleteCcbData(ccb);
+}
+
+/* Apply each replayed operation in one IMM CCB */
+static void replayFn(const CcbUtilOperationData_t *op, void *arg)
+{
+	SaImmCcbHandleT ccb = *(SaImmCcbHandleT *)arg;
+	const char *dn = saAisNameBorrow(&op->objectName);
+
+	switch (op->operationType) {
+	case CCBUTIL_CREATE:
+		CHECK_EQ(immutil_saImmOmCcbObjectCreate_2(
+			     ccb, op->param.create.className,
+			     op->param.create.parentName,
+			     op->param.create.attrValues),
+			 SA_AIS_OK);
+		break;
+	case CCBUTIL_MODIFY:
+		CHECK_EQ(immutil_saImmOmCcbObjectModify_o2(
+			     ccb, dn, op->param.modify.attrMods),
+			 SA_AIS_OK);
+		break;
+	case CCBUTIL_DELETE:
+		CHECK_EQ(immutil_saImmOmCcbObjectDelete_o2(ccb, dn), SA_AIS_OK);
+		break;
+	}
+}
+
+static int nameCmp(const void *a, const void *b)
+{
+	return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/*
+ * Replay the journal into a fresh IMM and return the object as
+ * "str=<v> name=<sorted values>", or "none", in buf.
+ */
+static SaUint64T replay(CcbUtilJournal_t *journal, char *buf, size_t size)
+{
+	SaImmHandleT om;
+	SaImmAdminOwnerHandleT owner;
+	SaImmCcbHandleT ccb;
+	SaImmAccessorHandleT accessor;
+	SaImmAttrValuesT_2 **attrs;
+	const char *values[8];
+	SaUint64T n;
+	SaUint32T i, nValues = 0;
+	int len;
+
+	immStubReset();
+	defaultClassCreate();
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAdminOwnerInitialize(om, (char *)"test",
+						     SA_TRUE, &owner),
+		 SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbInitialize(owner, 0, &ccb), SA_AIS_OK);
+	n = ccbutil_journalReplay(journal, replayFn, &ccb);
+	CHECK_EQ(immutil_saImmOmCcbApply(ccb), SA_AIS_OK);
+
+	immutilWrapperProfile.errorsAreFatal = 0;
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	if (immutil_saImmOmAccessorGet_o2(accessor, dn, NULL, &attrs) !=
+	    SA_AIS_OK) {
+		snprintf(buf, size, "none");
+		immutilWrapperProfile.errorsAreFatal = 1;
+		return n;
+	}
+	immutilWrapperProfile.errorsAreFatal = 1;
+	len = snprintf(buf, size, "str=%s name=",
+		       immutil_getStringAttr((const SaImmAttrValuesT_2 **)attrs,
+					     "str", 0));
+	for (i = 0; attrs[i] != NULL; i++) {
+		SaUint32T j;
+		if (strcmp(attrs[i]->attrName, "name") != 0)
+			continue;
+		for (j = 0; j < attrs[i]->attrValuesNumber && nValues < 8; j++)
+			values[nValues++] = saAisNameBorrow(
+			    (SaNameT *)attrs[i]->attrValues[j]);
+	}
+	qsort(values, nValues, sizeof(values[0]), nameCmp);
+	for (i = 0; i < nValues; i++)
+		len += snprintf(buf + len, size - len, "%s,", values[i]);
+	return n;
+}
+
+TEST(journalCompactKeepsModifyOfDefault)
+{
+	char path[64], before[128], after[128];
+	CcbUtilJournal_t *journal;
+
+	snprintf(path, sizeof(path), "/tmp/immutil_test_journal.%d",
+		 (int)getpid());
+	unlink(path);
+	journal = ccbutil_journalOpen(path, false);
+	CHECK(journal != NULL);
+	journalWrite(journal);
+	CHECK_EQ(replay(journal, before, sizeof(before)), 3);
+	CHECK_STR(before, "str=c name=dflt,x,y,");
+
+	/* str is folded into the create, name stays a modify */
+	CHECK_EQ(ccbutil_journalCompact(journal), 0);
+	CHECK_EQ(replay(journal, after, sizeof(after)), 2);
+	CHECK_STR(after, before);
+
+	/* A delete drops the create and the modify kept after it */
+	journalDelete(journal);
+	CHECK_EQ(ccbutil_journalCompact(journal), 0);
+	CHECK_EQ(replay(journal, after, sizeof(after)), 0);
+	CHECK_STR(after, "none");
+
+	ccbutil_journalClose(journal);
+	unlink(path);
+}
@@ -0,0 +1,169 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The test runner, see test.h. Tests are run in the order they were
+ * registered, which within a file is the order of definition.
+ */
+
+#define _GNU_SOURCE
+#include "test.h"
+#include <stdarg.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_TIMEOUT 300 /* Seconds */
+
+struct Test {
+	const char *name;
+	TestFnT fn;
+	const char *file;
+};
+
+static struct Test *tests;
+static size_t nTests;
+
+void testRegister(const char *name, TestFnT fn, const char *file)
+{
+	tests = realloc(tests, (nTests + 1) * sizeof(*tests));
+	if (tests == NULL)
+		abort();
+	tests[nTests].name = name;
+	tests[nTests].fn = fn;
+	tests[nTests].file = file;
+	nTests++;
+}
+
+void testFail(const char *file, int line, const char *fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "%s:%d: check failed: ", file, line);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	fflush(stderr);
+	_exit(1);
+}
+
+SaTimeT testNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (SaTimeT)ts.tv_sec * SA_TIME_ONE_SECOND + ts.tv_nsec;
+}
+
+void testClassesCreate(void)
+{
+	SaImmAttrDefinitionT_2 int32 = {(SaImmAttrNameT) "int32",
+					SA_IMM_ATTR_SAINT32T,
+					SA_IMM_ATTR_CONFIG | SA_IMM_ATTR_WRITABLE,
+					NULL};
+	SaImmAttrDefinitionT_2 uint32 = {
+	    (SaImmAttrNameT) "uint32", SA_IMM_ATTR_SAUINT32T,
+	    SA_IMM_ATTR_CONFIG | SA_IMM_ATTR_WRITABLE, NULL};
+	SaImmAttrDefinitionT_2 str = {(SaImmAttrNameT) "str",
+				      SA_IMM_ATTR_SASTRINGT,
+				      SA_IMM_ATTR_CONFIG | SA_IMM_ATTR_WRITABLE,
+				      NULL};
+	SaImmAttrDefinitionT_2 name = {
+	    (SaImmAttrNameT) "name", SA_IMM_ATTR_SANAMET,
+	    SA_IMM_ATTR_CONFIG | SA_IMM_ATTR_WRITABLE | SA_IMM_ATTR_MULTI_VALUE,
+	    NULL};
+	SaImmAttrDefinitionT_2 time = {(SaImmAttrNameT) "time",
+				       SA_IMM_ATTR_SATIMET,
+				       SA_IMM_ATTR_CONFIG | SA_IMM_ATTR_WRITABLE,
+				       NULL};
+	SaImmAttrDefinitionT_2 counter = {
+	    (SaImmAttrNameT) "counter", SA_IMM_ATTR_SAUINT64T,
+	    SA_IMM_ATTR_RUNTIME | SA_IMM_ATTR_CACHED, NULL};
+	const SaImmAttrDefinitionT_2 *config[] = {&int32, &uint32, &str,
+						  &name, &time, NULL};
+	const SaImmAttrDefinitionT_2 *runtime[] = {&counter, NULL};
+
+	immStubClassCreate("TestConfig", SA_IMM_CLASS_CONFIG, "testConfigId",
+			   config);
+	immStubClassCreate("TestRuntime", SA_IMM_CLASS_RUNTIME, "testRtId",
+			   runtime);
+}
+
+void testObjectCreate(const char *dn, const char *str)
+{
+	SaImmAttrValueT value = &str;
+	SaImmAttrValuesT_2 attr = {(SaImmAttrNameT) "str",
+				   SA_IMM_ATTR_SASTRINGT, 1, &value};
+	const SaImmAttrValuesT_2 *attrs[] = {&attr, NULL};
+
+	if (immStubObjectCreate("TestConfig", dn,
+				str != NULL ? attrs : NULL) != SA_AIS_OK)
+		testFail(__FILE__, __LINE__, "create %s failed", dn);
+}
+
+static bool selected(const struct Test *t, int argc, char **argv)
+{
+	int i;
+
+	if (argc < 2)
+		return true;
+	for (i = 1; i < argc; i++)
+		if (strstr(t->name, argv[i]) != NULL ||
+		    strstr(t->file, argv[i]) != NULL)
+			return true;
+	return false;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int run = 0, failed = 0;
+	size_t i;
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	for (i = 0; i < nTests; i++) {
+		const struct Test *t = &tests[i];
+		SaTimeT start = testNow();
+		int status;
+		pid_t pid;
+
+		if (!selected(t, argc, argv))
+			continue;
+		run++;
+		if ((pid = fork()) == 0) {
+			alarm(TEST_TIMEOUT);
+			immStubReset();
+			t->fn();
+			fflush(stdout);
+			_exit(0);
+		}
+		if (pid < 0 || waitpid(pid, &status, 0) != pid) {
+			perror("fork");
+			return 2;
+		}
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+			printf("PASS %s (%.3f s)\n", t->name,
+			       (double)(testNow() - start) / SA_TIME_ONE_SECOND);
+		} else {
+			failed++;
+			if (WIFSIGNALED(status))
+				printf("FAIL %s (signal %d)\n", t->name,
+				       WTERMSIG(status));
+			else
+				printf("FAIL %s\n", t->name);
+		}
+	}
+	printf("%u tests, %u failed\n", run, failed);
+	return failed != 0 ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The retry engine: replay injected SA_AIS_ERR_TRY_AGAIN sequences through
+ * the wrappers and check the latency they add.
+ */
+
+#include "test.h"
+
+#define MS(ms) ((SaTimeT)(ms)*1000000)
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static SaImmAccessorHandleT accessorSetUp(void)
+{
+	SaImmHandleT om;
+	SaImmAccessorHandleT accessor;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	return accessor;
+}
+
+/* Make an accessor get after tryAgain SA_AIS_ERR_TRY_AGAIN, return the time */
+static SaTimeT accessorGet(SaImmAccessorHandleT accessor, unsigned int tryAgain,
+			   SaAisErrorT expected)
+{
+	SaImmAttrValuesT_2 **attrs;
+	unsigned long calls = immStubCalls("saImmOmAccessorGet_2");
+	SaTimeT start;
+
+	if (tryAgain > 0)
+		immStubFail("saImmOmAccessorGet_2", SA_AIS_ERR_TRY_AGAIN,
+			    tryAgain);
+	start = testNow();
+	CHECK_EQ(immutil_saImmOmAccessorGet_o2(accessor, "top=1", NULL, &attrs),
+		 expected);
+	if (expected == SA_AIS_OK)
+		CHECK_EQ(immStubCalls("saImmOmAccessorGet_2") - calls,
+			 tryAgain + 1);
+	return testNow() - start;
+}
+
+static int timeCmp(const void *a, const void *b)
+{
+	SaTimeT ta = *(const SaTimeT *)a, tb = *(const SaTimeT *)b;
+	return ta < tb ? -1 : ta > tb;
+}
+
+#define CALLS 20
+
+/*
+ * The READ profile {1, 50, 0} retries after 1 to 50 ms, so k TRY_AGAIN add
+ * at least k ms and at most k * 50 ms.
+ */
+TEST(retryTryAgainLatency)
+{
+	static const unsigned int sequences[] = {0, 1, 2, 4, 8};
+	SaImmAccessorHandleT accessor = accessorSetUp();
+	size_t s;
+
+	for (s = 0; s < sizeof(sequences) / sizeof(sequences[0]); s++) {
+		unsigned int k = sequences[s];
+		SaTimeT latency[CALLS];
+		int i;
+		for (i = 0; i < CALLS; i++)
+			latency[i] = accessorGet(accessor, k, SA_AIS_OK);
+		qsort(latency, CALLS, sizeof(latency[0]), timeCmp);
+		printf("  %u TRY_AGAIN: min %.2f p50 %.2f p90 %.2f max %.2f ms\n",
+		       k, latency[0] / 1e6, latency[CALLS / 2] / 1e6,
+		       latency[CALLS * 9 / 10] / 1e6, latency[CALLS - 1] / 1e6);
+		CHECK(latency[0] >= MS(k));
+		CHECK(latency[CALLS - 1] <= MS(50 * k + 20));
+		/* Jitter; 8 delays of exactly 1 ms each time is no backoff */
+		if (k == 8)
+			CHECK(latency[CALLS / 2] > MS(9));
+	}
+}
+
+/* A profile timeout stops the retries, however many are injected */
+TEST(retryDeadline)
+{
+	struct ImmutilRetryProfile profile = {5, 5, 30};
+	SaImmAccessorHandleT accessor = accessorSetUp();
+	SaTimeT latency;
+
+	immutilWrapperProfile.errorsAreFatal = 0;
+	immutil_setRetryProfile(IMMUTIL_RETRY_READ, &profile);
+	latency = accessorGet(accessor, 100, SA_AIS_ERR_TRY_AGAIN);
+	CHECK(latency >= MS(30) && latency < MS(60));
+	CHECK(immStubCalls("saImmOmAccessorGet_2") <= 8);
+}
+
+/* With retryInterval 0, nTries tries are made without sleeping */
+TEST(retryTryCountWithoutInterval)
+{
+	struct ImmutilRetryProfile none = {0, 0, 0};
+	SaImmAccessorHandleT accessor = accessorSetUp();
+	unsigned long calls;
+
+	immutilWrapperProfile.errorsAreFatal = 0;
+	immutilWrapperProfile.nTries = 4;
+	immutilWrapperProfile.retryInterval = 0;
+	immutil_setRetryProfile(IMMUTIL_RETRY_READ, &none);
+
+	CHECK(accessorGet(accessor, 3, SA_AIS_OK) < MS(5));
+	calls = immStubCalls("saImmOmAccessorGet_2");
+	CHECK(accessorGet(accessor, 10, SA_AIS_ERR_TRY_AGAIN) < MS(5));
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2") - calls, 4);
+
+	/* One try only */
+	immStubReset();
+	accessor = accessorSetUp();
+	immutilWrapperProfile.nTries = 1;
+	calls = immStubCalls("saImmOmAccessorGet_2");
+	accessorGet(accessor, 2, SA_AIS_ERR_TRY_AGAIN);
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2") - calls, 1);
+}
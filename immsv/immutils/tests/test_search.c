@@ -0,0 +1,174 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * Parallel subtree search with the pooled OM handles.
+ */
+
+#include <unistd.h>
+
+#include "test.h"
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static bool countObject(const SaNameT *objectName,
+			const SaImmAttrValuesT_2 **attributes, void *arg)
+{
+	(void)objectName;
+	(void)attributes;
+	__atomic_add_fetch((unsigned long *)arg, 1, __ATOMIC_RELAXED);
+	return true;
+}
+
+/* Pooled handles that went stale since the last search are set up again */
+TEST(parallelSearchBadHandle)
+{
+	SaImmAttrNameT noAttrs[] = {NULL};
+	unsigned long found = 0;
+	SaNameT root;
+	char dn[64];
+	int i, j;
+
+	testClassesCreate();
+	testObjectCreate("top=1", NULL);
+	for (i = 0; i < 4; i++) {
+		snprintf(dn, sizeof(dn), "sub=%d,top=1", i);
+		testObjectCreate(dn, NULL);
+		for (j = 0; j < 4; j++) {
+			snprintf(dn, sizeof(dn), "leaf=%d,sub=%d,top=1", j, i);
+			testObjectCreate(dn, NULL);
+		}
+	}
+	saAisNameLend("top=1", &root);
+	CHECK_EQ(immutil_parallelSearch(&root, NULL, noAttrs, 4, countObject,
+					&found),
+		 SA_AIS_OK);
+	CHECK_EQ(found, 21);
+
+	immStubInvalidateHandles();
+	found = 0;
+	CHECK_EQ(immutil_parallelSearch(&root, NULL, noAttrs, 4, countObject,
+					&found),
+		 SA_AIS_OK);
+	CHECK_EQ(found, 21);
+	CHECK(immStubCalls("saImmOmInitialize") > 1);
+}
+
+/* A tree of 1 + 5 + 5 * 9 = 51 objects with str set to the DN */
+static void treeCreate(void)
+{
+	char dn[64];
+	int i, j;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "top=1");
+	for (i = 0; i < 5; i++) {
+		snprintf(dn, sizeof(dn), "sub=%d,top=1", i);
+		testObjectCreate(dn, dn);
+		for (j = 0; j < 9; j++) {
+			snprintf(dn, sizeof(dn), "leaf=%d,sub=%d,top=1", j, i);
+			testObjectCreate(dn, dn);
+		}
+	}
+}
+
+static ImmutilSearchIter_t *searchIter(SaImmHandleT *om,
+				       const SaImmAttrNameT *attributeNames,
+				       size_t batchSize, size_t prefetch)
+{
+	ImmutilSearchIter_t *it;
+	SaNameT root;
+
+	treeCreate();
+	CHECK_EQ(immutil_saImmOmInitialize(om, NULL, &immVersion), SA_AIS_OK);
+	saAisNameLend("top=1", &root);
+	CHECK_EQ(immutil_searchIterCreate(*om, &root, SA_IMM_SUBTREE, NULL,
+					  attributeNames, batchSize, prefetch,
+					  &it),
+		 SA_AIS_OK);
+	return it;
+}
+
+/*
+ * The batches hold each object once and at most batchSize objects, and the
+ * thread reads no more than prefetch objects ahead of the caller.
+ */
+TEST(searchIterBatches)
+{
+	SaImmAttrNameT strAttr[] = {(SaImmAttrNameT) "str", NULL};
+	const struct ImmutilSearchBatch *batch;
+	ImmutilSearchIter_t *it;
+	SaImmHandleT om;
+	unsigned long calls, seen = 0;
+	char found[51][32];
+	size_t i, j;
+
+	it = searchIter(&om, strAttr, 4, 8);
+	usleep(50000);
+	CHECK_EQ(immStubCalls("saImmOmSearchNext_2"), 8);
+
+	while (immutil_searchIterNext(it, &batch) == SA_AIS_OK) {
+		CHECK(batch->n >= 1 && batch->n <= 4);
+		for (i = 0; i < batch->n; i++) {
+			const struct ImmutilSearchRecord *r = &batch->records[i];
+			const char *dn = saAisNameBorrow(r->objectName);
+			CHECK(seen < 51);
+			/* Only the asked attribute, SA_IMM_SEARCH_GET_SOME_ATTR */
+			CHECK(r->attributes[0] != NULL);
+			CHECK_STR(r->attributes[0]->attrName, "str");
+			CHECK(r->attributes[1] == NULL);
+			CHECK_STR(immutil_getStringAttr(r->attributes, "str", 0),
+				  dn);
+			snprintf(found[seen++], sizeof(found[0]), "%s", dn);
+		}
+		/* The batch the caller has, and up to prefetch more */
+		calls = immStubCalls("saImmOmSearchNext_2");
+		CHECK(calls <= seen + 8 + 1);
+	}
+	CHECK_EQ(seen, 51);
+	for (i = 0; i < seen; i++)
+		for (j = 0; j < i; j++)
+			CHECK(strcmp(found[i], found[j]) != 0);
+
+	/* The search is over */
+	CHECK_EQ(immutil_searchIterNext(it, &batch), SA_AIS_ERR_NOT_EXIST);
+	CHECK(batch == NULL);
+	immutil_searchIterDelete(it);
+	CHECK_EQ(immStubCalls("saImmOmSearchFinalize"), 1);
+	CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+}
+
+/* Deleting an iterator midway stops the thread and finalizes the search */
+TEST(searchIterDeleteMidway)
+{
+	const struct ImmutilSearchBatch *batch;
+	ImmutilSearchIter_t *it;
+	SaImmHandleT om;
+	unsigned long calls;
+
+	it = searchIter(&om, NULL, 4, 8);
+	CHECK_EQ(immutil_searchIterNext(it, &batch), SA_AIS_OK);
+	CHECK_EQ(batch->n, 4);
+	CHECK_EQ(immutil_searchIterNext(it, &batch), SA_AIS_OK);
+	immutil_searchIterDelete(it);
+	CHECK_EQ(immStubCalls("saImmOmSearchFinalize"), 1);
+
+	/* The thread is gone */
+	calls = immStubCalls("saImmOmSearchNext_2");
+	CHECK(calls < 51);
+	usleep(20000);
+	CHECK_EQ(immStubCalls("saImmOmSearchNext_2"), calls);
+	CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+}
@@ -0,0 +1,140 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * IMM snapshot files.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "test.h"
+
+#define SNAPSHOT_PATH "/tmp/immutil_test_snapshot"
+
+/* The start of the file header as laid out in immutil.c */
+struct Header {
+	SaUint32T magic;
+	SaUint32T version;
+	SaUint32T nObjects;
+	SaUint32T nClasses;
+	SaUint32T indexSize;
+	SaUint32T reserved;
+	SaUint64T objects;
+	SaUint64T index;
+};
+
+static void snapshotSave(const char *path, unsigned int nObjects)
+{
+	ImmutilSnapshotWriter_t *w = immutil_snapshotWriterCreate();
+	const SaImmAttrValuesT_2 *noAttrs[] = {NULL};
+	unsigned int i;
+	SaNameT name;
+	char dn[64];
+
+	for (i = 0; i < nObjects; i++) {
+		snprintf(dn, sizeof(dn), "top=%u", i);
+		saAisNameLend(dn, &name);
+		immutil_snapshotWriterAdd(w, &name, noAttrs);
+	}
+	CHECK_EQ(immutil_snapshotWriterSave(w, path), 0);
+	immutil_snapshotWriterDelete(w);
+}
+
+TEST(snapshotFind)
+{
+	ImmutilSnapshot_t *s;
+	SaUint32T o;
+
+	snapshotSave(SNAPSHOT_PATH, 100);
+	s = immutil_snapshotOpen(SNAPSHOT_PATH);
+	unlink(SNAPSHOT_PATH);
+	CHECK(s != NULL);
+	CHECK_EQ(immutil_snapshotObjects(s), 100);
+	o = immutil_snapshotFind(s, "top=42");
+	CHECK(o != IMMUTIL_SNAPSHOT_NONE);
+	CHECK_STR(immutil_snapshotDn(s, o), "top=42");
+	CHECK_EQ(immutil_snapshotFind(s, "top=100"), IMMUTIL_SNAPSHOT_NONE);
+	immutil_snapshotClose(s);
+}
+
+/* Objects of many classes, the string table grows while they are added */
+TEST(snapshotClassNames)
+{
+	ImmutilSnapshotWriter_t *w = immutil_snapshotWriterCreate();
+	char dn[64], className[64];
+	SaImmAttrValueT classValue;
+	SaImmAttrValuesT_2 classAttr = {(SaImmAttrNameT)SA_IMM_ATTR_CLASS_NAME,
+					SA_IMM_ATTR_SASTRINGT, 1, &classValue};
+	const SaImmAttrValuesT_2 *attrs[] = {&classAttr, NULL};
+	const char *str = className;
+	ImmutilSnapshot_t *s;
+	SaNameT name;
+	unsigned int i;
+
+	classValue = &str;
+	for (i = 0; i < 20000; i++) {
+		snprintf(dn, sizeof(dn), "top=%u", i);
+		snprintf(className, sizeof(className), "Class%u", i / 2);
+		saAisNameLend(dn, &name);
+		immutil_snapshotWriterAdd(w, &name, attrs);
+	}
+	CHECK_EQ(immutil_snapshotWriterSave(w, SNAPSHOT_PATH), 0);
+	immutil_snapshotWriterDelete(w);
+
+	s = immutil_snapshotOpen(SNAPSHOT_PATH);
+	unlink(SNAPSHOT_PATH);
+	CHECK(s != NULL);
+	for (i = 0; i < 20000; i++) {
+		SaUint32T o;
+		snprintf(dn, sizeof(dn), "top=%u", i);
+		snprintf(className, sizeof(className), "Class%u", i / 2);
+		o = immutil_snapshotFind(s, dn);
+		CHECK(o != IMMUTIL_SNAPSHOT_NONE);
+		CHECK_STR(immutil_snapshotClassName(s, o), className);
+	}
+	immutil_snapshotClose(s);
+}
+
+/* A damaged DN index without a free slot ends the probe after each slot */
+TEST(snapshotFindFullIndex)
+{
+	struct Header hdr;
+	ImmutilSnapshot_t *s;
+	SaUint32T *index;
+	SaUint32T i;
+	int fd;
+
+	snapshotSave(SNAPSHOT_PATH, 1);
+	fd = open(SNAPSHOT_PATH, O_RDWR);
+	CHECK(fd >= 0);
+	CHECK_EQ(pread(fd, &hdr, sizeof(hdr), 0), sizeof(hdr));
+	index = malloc(hdr.indexSize * sizeof(SaUint32T));
+	CHECK(index != NULL);
+	for (i = 0; i < hdr.indexSize; i++)
+		index[i] = 1;
+	CHECK_EQ(pwrite(fd, index, hdr.indexSize * sizeof(SaUint32T),
+			hdr.index),
+		 hdr.indexSize * sizeof(SaUint32T));
+	close(fd);
+	free(index);
+
+	s = immutil_snapshotOpen(SNAPSHOT_PATH);
+	unlink(SNAPSHOT_PATH);
+	CHECK(s != NULL);
+	CHECK_EQ(immutil_snapshotFind(s, "top=0"), 0);
+	CHECK_EQ(immutil_snapshotFind(s, "top=1"), IMMUTIL_SNAPSHOT_NONE);
+	immutil_snapshotClose(s);
+}
@@ -0,0 +1,154 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * The stub IMM through the immutil wrappers.
+ */
+
+#include "test.h"
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+TEST(stubCcbApply)
+{
+	SaImmHandleT om;
+	SaImmAdminOwnerHandleT owner;
+	SaImmCcbHandleT ccb;
+	SaImmAccessorHandleT accessor;
+	SaImmAttrValuesT_2 **attrs;
+	const char *str = "hello", *rdn = "testConfigId=1";
+	SaImmAttrValueT strValue = &str, rdnValue = &rdn;
+	SaImmAttrValuesT_2 strAttr = {(SaImmAttrNameT) "str",
+				      SA_IMM_ATTR_SASTRINGT, 1, &strValue};
+	SaImmAttrValuesT_2 rdnAttr = {(SaImmAttrNameT) "testConfigId",
+				      SA_IMM_ATTR_SASTRINGT, 1, &rdnValue};
+	const SaImmAttrValuesT_2 *create[] = {&rdnAttr, &strAttr, NULL};
+	SaInt32T int32 = -5;
+	SaImmAttrValueT int32Value = &int32;
+	SaImmAttrModificationT_2 mod = {
+	    SA_IMM_ATTR_VALUES_REPLACE,
+	    {(SaImmAttrNameT) "int32", SA_IMM_ATTR_SAINT32T, 1, &int32Value}};
+	const SaImmAttrModificationT_2 *mods[] = {&mod, NULL};
+	SaInt32T value = 0;
+
+	testClassesCreate();
+	testObjectCreate("top=1", NULL);
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAdminOwnerInitialize(om, (char *)"test",
+						     SA_TRUE, &owner),
+		 SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbInitialize(owner, 0, &ccb), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbObjectCreate_o2(ccb, (char *)"TestConfig",
+						   "top=1", create),
+		 SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbObjectModify_o2(ccb, "testConfigId=1,top=1",
+						   mods),
+		 SA_AIS_OK);
+	CHECK_EQ(immStubObjects(), 1);
+	CHECK_EQ(immutil_saImmOmCcbApply(ccb), SA_AIS_OK);
+	CHECK_EQ(immStubObjects(), 2);
+
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorGet_o2(accessor, "testConfigId=1,top=1",
+					       NULL, &attrs),
+		 SA_AIS_OK);
+	CHECK_STR(immutil_getStringAttr((const SaImmAttrValuesT_2 **)attrs,
+					"str", 0),
+		  "hello");
+	CHECK_STR(immutil_getStringAttr((const SaImmAttrValuesT_2 **)attrs,
+					SA_IMM_ATTR_CLASS_NAME, 0),
+		  "TestConfig");
+	CHECK_EQ(immutil_getAttr("int32", (const SaImmAttrValuesT_2 **)attrs, 0,
+				 &value),
+		 SA_AIS_OK);
+	CHECK_EQ(value, -5);
+
+	CHECK_EQ(immutil_saImmOmCcbObjectDelete_o2(ccb, "top=1"), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmCcbApply(ccb), SA_AIS_OK);
+	CHECK_EQ(immStubObjects(), 0);
+	CHECK_EQ(immutil_saImmOmCcbFinalize(ccb), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+}
+
+TEST(stubSearchSubtree)
+{
+	SaImmHandleT om;
+	SaImmSearchHandleT search;
+	SaImmAttrValuesT_2 **attrs;
+	SaNameT name;
+	const char *str = "b";
+	SaImmSearchParametersT_2 param = {{(SaImmAttrNameT) "str",
+					   SA_IMM_ATTR_SASTRINGT, &str}};
+	unsigned int n = 0;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	testObjectCreate("mid=1,top=1", "b");
+	testObjectCreate("leaf=1,mid=1,top=1", "b");
+	testObjectCreate("top=2", "b");
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmSearchInitialize_o2(
+		     om, "top=1", SA_IMM_SUBTREE,
+		     SA_IMM_SEARCH_ONE_ATTR | SA_IMM_SEARCH_GET_NO_ATTR, &param,
+		     NULL, &search),
+		 SA_AIS_OK);
+	while (immutil_saImmOmSearchNext_2(search, &name, &attrs) ==
+	       SA_AIS_OK) {
+		CHECK(strstr(saAisNameBorrow(&name), "top=1") != NULL);
+		n++;
+	}
+	CHECK_EQ(n, 2);
+	CHECK_EQ(immutil_saImmOmSearchFinalize(search), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+}
+
+TEST(stubInjectedTryAgainIsRetried)
+{
+	SaImmHandleT om;
+	SaImmAccessorHandleT accessor;
+	SaImmAttrValuesT_2 **attrs;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	immStubFail("saImmOmAccessorGet_2", SA_AIS_ERR_TRY_AGAIN, 2);
+	CHECK_EQ(immutil_saImmOmAccessorGet_o2(accessor, "top=1", NULL, &attrs),
+		 SA_AIS_OK);
+	CHECK_EQ(immStubCalls("saImmOmAccessorGet_2"), 3);
+	CHECK_STR(immutil_getStringAttr((const SaImmAttrValuesT_2 **)attrs,
+					"str", 0),
+		  "a");
+}
+
+TEST(stubInvalidatedHandle)
+{
+	SaImmHandleT om;
+	SaImmAccessorHandleT accessor;
+	SaImmAttrValuesT_2 **attrs;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	immutilWrapperProfile.errorsAreFatal = 0;
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	immStubInvalidateHandles();
+	CHECK_EQ(immutil_saImmOmAccessorGet_o2(accessor, "top=1", NULL, &attrs),
+		 SA_AIS_ERR_BAD_HANDLE);
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorGet_o2(accessor, "top=1", NULL, &attrs),
+		 SA_AIS_OK);
+}
@@ -0,0 +1,74 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * Wrapper telemetry, recorded only when turned on.
+ */
+
+#include "test.h"
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static void accessorGets(unsigned int n, unsigned int tryAgain)
+{
+	SaImmHandleT om;
+	SaImmAccessorHandleT accessor;
+	SaImmAttrValuesT_2 **attrs;
+	unsigned int i;
+
+	CHECK_EQ(immutil_saImmOmInitialize(&om, NULL, &immVersion), SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmAccessorInitialize(om, &accessor), SA_AIS_OK);
+	if (tryAgain > 0)
+		immStubFail("saImmOmAccessorGet_2", SA_AIS_ERR_TRY_AGAIN,
+			    tryAgain);
+	for (i = 0; i < n; i++)
+		CHECK_EQ(immutil_saImmOmAccessorGet_o2(accessor, "top=1", NULL,
+						       &attrs),
+			 SA_AIS_OK);
+	CHECK_EQ(immutil_saImmOmFinalize(om), SA_AIS_OK);
+}
+
+TEST(telemetryOptIn)
+{
+	struct ImmutilCallStats stats[IMMUTIL_OP_COUNT];
+	const struct ImmutilCallStats *get =
+	    &stats[IMMUTIL_OP_OM_ACCESSOR_GET_2];
+	SaUint64T latency = 0;
+	int i;
+
+	testClassesCreate();
+	testObjectCreate("top=1", "a");
+	accessorGets(3, 0);
+	immutil_telemetrySnapshot(stats);
+	CHECK_EQ(get->calls, 0);
+	CHECK_EQ(stats[IMMUTIL_OP_OM_INITIALIZE].calls, 0);
+
+	immutil_telemetryEnable(true);
+	accessorGets(3, 2);
+	immutil_telemetrySnapshot(stats);
+	CHECK_EQ(get->calls, 3);
+	CHECK_EQ(get->errors, 0);
+	CHECK_EQ(get->attempts[0], 2);
+	CHECK_EQ(get->attempts[2], 1); /* 3 tries */
+	CHECK(get->retrySleep > 0);
+	for (i = 0; i < IMMUTIL_TELEMETRY_LATENCY_BUCKETS; i++)
+		latency += get->latency[i];
+	CHECK_EQ(latency, 3);
+
+	immutil_telemetryEnable(false);
+	accessorGets(1, 0);
+	immutil_telemetrySnapshot(stats);
+	CHECK_EQ(get->calls, 3);
+}
@@ -0,0 +1,216 @@
+/*      -*- OpenSAF  -*-
+ *
+ * (C) Copyright 2008 The OpenSAF Foundation
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. This file and program are licensed
+ * under the GNU Lesser General Public License Version 2.1, February 1999.
+ * The complete license can be accessed from the following location:
+ * http://opensource.org/licenses/lgpl-license.php
+ * See the Copying file included with the OpenSAF distribution for full
+ * licensing terms.
+ *
+ */
+
+/*
+ * immsnapshot: save an IMM subtree to a snapshot file and query it offline.
+ *
+ *   immsnapshot save FILE [ROOT]       save ROOT and its subtree, or all
+ *   immsnapshot list FILE [DN]         DN and class of DN and its subtree
+ *   immsnapshot get FILE DN ATTR...    values of attributes of an object
+ *
+ * Only save connects to IMM.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "immutil.h"
+
+/* Defined in immutil.c, immutil.h leaves the declaration to the user */
+extern struct ImmutilWrapperProfile immutilWrapperProfile;
+
+static SaVersionT immVersion = {'A', 2, 11};
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: immsnapshot save FILE [ROOT]\n"
+			"       immsnapshot list FILE [DN]\n"
+			"       immsnapshot get FILE DN ATTR...\n");
+	exit(2);
+}
+
+static int save(const char *path, const char *root)
+{
+	ImmutilSnapshotWriter_t *w = immutil_snapshotWriterCreate();
+	SaImmHandleT om;
+	SaNameT rootName;
+	SaAisErrorT rc;
+
+	if (root != NULL)
+		saAisNameLend(root, &rootName);
+	immutilWrapperProfile.errorsAreFatal = 0;
+	if ((rc = immutil_saImmOmInitialize(&om, NULL, &immVersion)) !=
+	    SA_AIS_OK) {
+		fprintf(stderr, "immsnapshot: saImmOmInitialize: %d\n", rc);
+		return 1;
+	}
+	rc = immutil_snapshotWriterAddSearch(
+	    w, om, root != NULL ? &rootName : NULL, SA_IMM_SUBTREE, NULL, NULL);
+	(void)immutil_saImmOmFinalize(om);
+	if (rc != SA_AIS_OK) {
+		fprintf(stderr, "immsnapshot: search: %d\n", rc);
+		immutil_snapshotWriterDelete(w);
+		return 1;
+	}
+	if (immutil_snapshotWriterSave(w, path) != 0) {
+		fprintf(stderr, "immsnapshot: %s: %s\n", path, strerror(errno));
+		immutil_snapshotWriterDelete(w);
+		return 1;
+	}
+	immutil_snapshotWriterDelete(w);
+	return 0;
+}
+
+static void listObject(const ImmutilSnapshot_t *s, SaUint32T object)
+{
+	SaUint32T child;
+
+	printf("%s %s\n", immutil_snapshotDn(s, object),
+	       immutil_snapshotClassName(s, object));
+	for (child = immutil_snapshotFirstChild(s, object);
+	     child != IMMUTIL_SNAPSHOT_NONE;
+	     child = immutil_snapshotNextSibling(s, child))
+		listObject(s, child);
+}
+
+/* The size of a packed value, see struct ImmutilSnapshotAttr */
+static size_t valueSize(SaImmValueTypeT type)
+{
+	switch (type) {
+	case SA_IMM_ATTR_SAINT32T:
+	case SA_IMM_ATTR_SAUINT32T:
+	case SA_IMM_ATTR_SAFLOATT:
+	case SA_IMM_ATTR_SASTRINGT:
+	case SA_IMM_ATTR_SANAMET:
+		return 4;
+	default:
+		return 8;
+	}
+}
+
+static void printValue(const ImmutilSnapshot_t *s, SaImmValueTypeT type,
+		       const void *value)
+{
+	const SaUint32T *u32 = value;
+	SaUint32T i;
+
+	switch (type) {
+	case SA_IMM_ATTR_SAINT32T:
+		printf("%d", *(const SaInt32T *)value);
+		break;
+	case SA_IMM_ATTR_SAUINT32T:
+		printf("%u", *(const SaUint32T *)value);
+		break;
+	case SA_IMM_ATTR_SAINT64T:
+		printf("%lld", (long long)*(const SaInt64T *)value);
+		break;
+	case SA_IMM_ATTR_SAUINT64T:
+	case SA_IMM_ATTR_SATIMET:
+		printf("%llu", (unsigned long long)*(const SaUint64T *)value);
+		break;
+	case SA_IMM_ATTR_SAFLOATT:
+		printf("%g", *(const SaFloatT *)value);
+		break;
+	case SA_IMM_ATTR_SADOUBLET:
+		printf("%g", *(const SaDoubleT *)value);
+		break;
+	case SA_IMM_ATTR_SASTRINGT:
+	case SA_IMM_ATTR_SANAMET:
+		printf("%s", immutil_snapshotString(s, *u32));
+		break;
+	case SA_IMM_ATTR_SAANYT:
+		/* Offset and size, printed in hex */
+		for (i = 0; i < u32[1]; i++)
+			printf("%02x", (unsigned char)immutil_snapshotString(
+					   s, u32[0])[i]);
+		break;
+	default:
+		break;
+	}
+}
+
+static int get(const ImmutilSnapshot_t *s, SaUint32T object, int nAttrs,
+	       char **attrNames)
+{
+	struct ImmutilSnapshotAttr attr;
+	int i, rc = 0;
+	SaUint32T v;
+
+	for (i = 0; i < nAttrs; i++) {
+		const char *value;
+		if (!immutil_snapshotGetAttr(s, object, attrNames[i], &attr)) {
+			fprintf(stderr, "immsnapshot: %s: no such attribute\n",
+				attrNames[i]);
+			rc = 1;
+			continue;
+		}
+		printf("%s", attrNames[i]);
+		value = attr.values;
+		for (v = 0; v < attr.nValues; v++) {
+			putchar(v == 0 ? '=' : ',');
+			printValue(s, attr.type, value);
+			value += valueSize(attr.type);
+		}
+		putchar('\n');
+	}
+	return rc;
+}
+
+int main(int argc, char **argv)
+{
+	ImmutilSnapshot_t *s;
+	SaUint32T object = IMMUTIL_SNAPSHOT_NONE;
+	int rc = 0;
+
+	if (argc < 3)
+		usage();
+	if (strcmp(argv[1], "save") == 0) {
+		if (argc > 4)
+			usage();
+		return save(argv[2], argc == 4 ? argv[3] : NULL);
+	}
+	if (strcmp(argv[1], "list") == 0) {
+		if (argc > 4)
+			usage();
+	} else if (strcmp(argv[1], "get") != 0 || argc < 5) {
+		usage();
+	}
+
+	if ((s = immutil_snapshotOpen(argv[2])) == NULL) {
+		fprintf(stderr, "immsnapshot: %s: %s\n", argv[2],
+			strerror(errno));
+		return 1;
+	}
+	if (argc > 3 &&
+	    (object = immutil_snapshotFind(s, argv[3])) ==
+		IMMUTIL_SNAPSHOT_NONE) {
+		fprintf(stderr, "immsnapshot: %s: no such object\n", argv[3]);
+		immutil_snapshotClose(s);
+		return 1;
+	}
+	if (argv[1][0] == 'g') {
+		rc = get(s, object, argc - 4, argv + 4);
+	} else if (object != IMMUTIL_SNAPSHOT_NONE) {
+		listObject(s, object);
+	} else {
+		for (object = 0; object < immutil_snapshotObjects(s); object++)
+			printf("%s %s\n", immutil_snapshotDn(s, object),
+			       immutil_snapshotClassName(s, object));
+	}
+	immutil_snapshotClose(s);
+	return rc;
+}